@@ -0,0 +1,96 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "generate.h"
+#include "willmore.h"
+#include "arena.h"
+
+#include <string.h>
+
+#define LEVELS 8         // default subdivisions of the icosphere (about 1.3 million faces)
+#define VECTORS 5        // temporaries of a conjugate gradient solve
+#define RUNS 50          // scratch rounds per allocator
+#define STEPS 20         // MCF steps per run
+#define WILLMORE_STEPS 5 // Willmore steps (below WILLMORE_REFRESH, so only solves allocate)
+#define DELTA_TIME 1e-4f // time step of each flow step
+
+// Writes every temporary once, as a solve would before reading it
+static void touch(double **vectors, size_t n)
+{
+    for (int k = 0; k < VECTORS; k++)
+        memset(vectors[k], 0, n * sizeof(double));
+}
+
+// Flows a fresh icosphere with or without huge pages behind its arrays, returning its positions
+static Mesh *flowIcosphere(size_t levels, bool huge, const char *name)
+{
+    useHugePages(huge);
+    Mesh *mesh = createIcosphere(levels);
+    double start = benchTime();
+    for (size_t i = 0; i < STEPS; i++)
+        mcfVBM(mesh, DELTA_TIME, NULL);
+    benchReport(name, benchTime() - start, STEPS);
+    return mesh;
+}
+
+int main(int argc, char **argv)
+{
+    size_t levels = argc > 1 ? (size_t)atoi(argv[1]) : LEVELS;
+    Mesh *mesh = createIcosphere(levels);
+    size_t n = mesh->numVertices;
+    printf("icosphere of %zu levels, %zu vertices, %zu faces\n", levels, n - 1, mesh->numIndices / 3);
+
+    // Per-step temporaries of a solve: fresh from malloc (large ones are mapped and faulted in every time), or
+    // from a frame of an arena (mapped once)
+    double *vectors[VECTORS];
+    double start = benchTime();
+    for (size_t run = 0; run < RUNS; run++)
+    {
+        for (int k = 0; k < VECTORS; k++)
+            vectors[k] = malloc(n * sizeof(double));
+        touch(vectors, n);
+        for (int k = 0; k < VECTORS; k++)
+            free(vectors[k]);
+    }
+    benchReport("scratch from malloc", benchTime() - start, RUNS);
+
+    Arena *arena = createArena();
+    start = benchTime();
+    for (size_t run = 0; run < RUNS; run++)
+    {
+        ArenaFrame frame = pushFrame(arena);
+        for (int k = 0; k < VECTORS; k++)
+            vectors[k] = arenaAlloc(arena, n * sizeof(double));
+        touch(vectors, n);
+        popFrame(arena, frame);
+    }
+    benchReport("scratch from arena frames", benchTime() - start, RUNS);
+    printf("%-28s %12zu bytes reserved\n", "", arena->reserved);
+    destroyArena(arena);
+
+    // Willmore steps take every solve's vectors from the mesh's arena, which stops growing after the first
+    Willmore *willmore = mesh->willmore = createWillmore(mesh);
+    size_t reserved = 0;
+    start = benchTime();
+    for (size_t i = 0; i < WILLMORE_STEPS; i++)
+    {
+        stepWillmore(willmore, mesh);
+        reserved = i == 0 ? mesh->arena->reserved : reserved;
+    }
+    benchReport("Willmore step", benchTime() - start, WILLMORE_STEPS);
+    printf("%-28s %12zu bytes reserved after first step, %zu after last\n", "", reserved, mesh->arena->reserved);
+    destroyMesh(mesh);
+
+    // Huge pages must not change a bit of the flow
+    Mesh *small = flowIcosphere(levels, false, "MCF, 4 KB pages");
+    Mesh *huge = flowIcosphere(levels, true, "MCF, huge pages");
+    bool same = true;
+    for (size_t i = 0; i < small->numVertices; i++)
+        same &= !memcmp(small->vertices[i].position, huge->vertices[i].position, sizeof(vec3));
+    if (!same)
+        printf("MISMATCH\n");
+    destroyMesh(small);
+    destroyMesh(huge);
+    return EXIT_SUCCESS;
+}
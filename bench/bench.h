@@ -0,0 +1,59 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "model.h"
+#include "generate.h"
+#include "threadpool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Benchmark helpers shared by the programs in ./bench (built with "make bench").
+ */
+
+/**
+ * @brief Wall clock time in seconds (does not require GLFW to be initialized).
+ *
+ * @return Current time.
+ */
+static inline double benchTime(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Prints one result line in a common format.
+ *
+ * @param name    What was measured.
+ * @param seconds Total time taken.
+ * @param runs    Number of runs included in total.
+ */
+static inline void benchReport(const char *name, double seconds, size_t runs)
+{
+    printf("%-28s %12.3f us/run  (%zu runs, %.3f s)\n", name, seconds / runs * 1e6, runs, seconds);
+}
+
+/**
+ * @brief Loads or generates the mesh a benchmark runs on (exits if it cannot).
+ *
+ * Every benchmark taking a mesh takes a specification (see generateMesh), so each kernel can be swept across
+ * sizes, e.g. "models/hand.obj:1e6" or "torus:1e7".
+ *
+ * @param spec .obj file, optionally with a triangle count to subdivide it to, or a generated shape.
+ * @return Initialized mesh.
+ */
+static inline Mesh *benchMesh(const char *spec)
+{
+    ThreadPool *pool = createThreadPool(0);
+    Mesh *mesh = generateMesh(spec, pool);
+    destroyThreadPool(pool);
+    if (!mesh)
+        exit(EXIT_FAILURE);
+    return mesh;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "bvh.h"
+
+#include <cglm/cglm.h>
+
+#define MESH "models/hand.obj" // default mesh to benchmark
+#define QUERIES 100000         // rays per measurement
+#define REFITS 100             // flow steps (and refits) per measurement
+
+// Random ray from a sphere around the mesh towards a random point near its center
+static void randomRay(vec3 center, float radius, Ray *ray)
+{
+    vec3 dir = {rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f};
+    glm_vec3_normalize(dir);
+    glm_vec3_scale(dir, radius, ray->origin);
+    glm_vec3_add(ray->origin, center, ray->origin);
+
+    vec3 target = {rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX - 0.5f};
+    glm_vec3_scale(target, radius * 0.5f, target);
+    glm_vec3_add(target, center, target);
+    glm_vec3_sub(target, ray->origin, ray->direction);
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+
+    Mesh *mesh = benchMesh(filename);
+    size_t numFaces = mesh->numIndices / 3;
+    printf("%s: %zu vertices, %zu triangles\n", filename, mesh->numVertices, numFaces);
+
+    // Bounding sphere for ray generation
+    vec3 min = {1e30f, 1e30f, 1e30f}, max = {-1e30f, -1e30f, -1e30f}, center;
+    for (size_t i = 1; i < mesh->numVertices; i++)
+    {
+        glm_vec3_minv(min, mesh->vertices[i].position, min);
+        glm_vec3_maxv(max, mesh->vertices[i].position, max);
+    }
+    glm_vec3_center(min, max, center);
+    float radius = glm_vec3_distance(min, max);
+
+    // Build
+    double start = benchTime();
+    BVH *bvh = createBVH(mesh);
+    benchReport("build (SAH)", benchTime() - start, 1);
+    printf("%zu nodes\n", bvh->numNodes);
+
+    // Queries
+    srand(1);
+    size_t hits = 0;
+    start = benchTime();
+    for (size_t i = 0; i < QUERIES; i++)
+    {
+        Ray ray;
+        RayHit hit;
+        randomRay(center, radius, &ray);
+        hits += intersectBVH(bvh, mesh, &ray, &hit);
+    }
+    benchReport("query", benchTime() - start, QUERIES);
+    printf("%zu / %d rays hit\n", hits, QUERIES);
+
+    // Brute force reference on a subset of the same rays
+    srand(1);
+    size_t bruteQueries = QUERIES / 100, mismatches = 0;
+    start = benchTime();
+    for (size_t i = 0; i < bruteQueries; i++)
+    {
+        Ray ray;
+        RayHit best = {0, 1e30f, 0.0f, 0.0f}, candidate;
+        randomRay(center, radius, &ray);
+        for (size_t f = 0; f < numFaces; f++)
+        {
+            const uint32_t *face = &mesh->indices[3 * f];
+            if (intersectTriangle(&ray, mesh->vertices[face[0]].position, mesh->vertices[face[1]].position,
+                                  mesh->vertices[face[2]].position, &candidate) &&
+                candidate.t < best.t)
+                best = candidate;
+        }
+
+        RayHit hit;
+        bool found = intersectBVH(bvh, mesh, &ray, &hit);
+        if (found != (best.t < 1e30f) || (found && fabsf(hit.t - best.t) > 1e-5f))
+            mismatches++;
+    }
+    benchReport("query (brute force)", benchTime() - start, bruteQueries);
+    printf("%zu mismatches against brute force\n", mismatches);
+
+    // Refit after each flow step
+    double flowTime = 0.0, refitTime = 0.0;
+    for (size_t i = 0; i < REFITS; i++)
+    {
+        start = benchTime();
+        mcfVBM(mesh, 0.001f, NULL);
+        flowTime += benchTime() - start;
+
+        start = benchTime();
+        refitBVH(bvh, mesh);
+        refitTime += benchTime() - start;
+    }
+    benchReport("flow step (MCF VBM)", flowTime, REFITS);
+    benchReport("refit", refitTime, REFITS);
+
+    // Queries on refit hierarchy
+    srand(2);
+    start = benchTime();
+    for (size_t i = 0; i < QUERIES; i++)
+    {
+        Ray ray;
+        RayHit hit;
+        randomRay(center, radius, &ray);
+        intersectBVH(bvh, mesh, &ray, &hit);
+    }
+    benchReport("query (after refits)", benchTime() - start, QUERIES);
+
+    destroyBVH(bvh);
+    return EXIT_SUCCESS;
+}
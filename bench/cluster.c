@@ -0,0 +1,94 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "cluster.h"
+
+#include <string.h>
+
+#define MESH "models/hand.obj"                // default mesh to benchmark
+#define CLUSTER_FILE "bench_clusters.gfoc"    // cluster file written (and removed) in the working directory
+#define CONVERTED_FILE "bench_converted.gfoc" // cluster file converted straight from the .obj file (and removed)
+#define STEPS 20                              // MCF steps per run
+#define DELTA_TIME 0.01f                      // time step of each flow step
+
+// Whether two files hold the same bytes
+static bool sameFiles(const char *a, const char *b)
+{
+    FILE *x = fopen(a, "rb"), *y = fopen(b, "rb");
+    bool same = x && y;
+    while (same)
+    {
+        int c = fgetc(x);
+        same = c == fgetc(y);
+        if (c == EOF)
+            break;
+    }
+    if (x)
+        fclose(x);
+    if (y)
+        fclose(y);
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+    Mesh *mesh = benchMesh(filename);
+    printf("%s, %zu vertices, %zu faces, %d MCF steps\n", filename, mesh->numVertices - 1, mesh->numIndices / 3, STEPS);
+
+    // Reference: the whole mesh flowed in memory
+    float(*loaded)[3] = malloc(mesh->numVertices * sizeof(*loaded));
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        glm_vec3_copy(mesh->vertices[i].position, loaded[i]);
+    double start = benchTime();
+    for (size_t i = 0; i < STEPS; i++)
+        mcfVBM(mesh, DELTA_TIME, NULL);
+    benchReport("in core", benchTime() - start, STEPS);
+
+    // Cluster sizes from many small clusters up to the default; every one must match the in-core flow bit for bit
+    size_t sizes[] = {1024, 4096, 16384, CLUSTER_VERTICES};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        Mesh original = *mesh;
+        original.vertices = malloc(mesh->numVertices * sizeof(Vertex));
+        for (size_t i = 0; i < mesh->numVertices; i++)
+            glm_vec3_copy(loaded[i], original.vertices[i].position);
+        start = benchTime();
+        writeClusters(&original, CLUSTER_FILE, sizes[s]);
+        double written = benchTime() - start;
+        free(original.vertices);
+
+        // The streamed conversion must write the same file (the mesh is not welded on the way)
+        start = benchTime();
+        bool converted = convertClusters(filename, CONVERTED_FILE, sizes[s]);
+        double conversion = benchTime() - start;
+        converted = converted && sameFiles(CLUSTER_FILE, CONVERTED_FILE);
+        remove(CONVERTED_FILE);
+
+        ClusteredMesh *clustered = openClusters(CLUSTER_FILE, MCF_VBM, PRECISION_FLOAT);
+        start = benchTime();
+        for (size_t i = 0; i < STEPS; i++)
+            stepClusters(clustered, DELTA_TIME, NULL);
+        double seconds = benchTime() - start;
+
+        const ClusterHeader *header = clustered->header;
+        const float(*positions)[3] = (const float(*)[3])(clustered->base + header->positionOffsets[header->current]);
+        const uint32_t *renumber = (const uint32_t *)(clustered->base + header->renumberOffset);
+        bool same = true;
+        for (size_t i = 0; i < mesh->numVertices; i++)
+            same &= !memcmp(positions[renumber[i]], mesh->vertices[i].position, sizeof(vec3));
+
+        char name[64];
+        snprintf(name, sizeof(name), "out of core, %zu vertices", sizes[s]);
+        benchReport(name, seconds, STEPS);
+        printf("%-28s %12zu clusters, written in %.3f s%s, converted in %.3f s%s\n", "", (size_t)header->numClusters,
+               written, same ? "" : "  MISMATCH", conversion, converted ? "" : "  DIFFERS");
+        closeClusters(clustered);
+        remove(CLUSTER_FILE);
+    }
+
+    free(loaded);
+    destroyMesh(mesh);
+    return EXIT_SUCCESS;
+}
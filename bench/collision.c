@@ -0,0 +1,56 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "collision.h"
+
+#define MESH "models/hand.obj" // default mesh to benchmark
+#define STEPS 200              // flow steps to run
+#define STEP_SIZE 0.01f        // flow step size
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+
+    Mesh *mesh = benchMesh(filename);
+    printf("%s: %zu vertices, %zu triangles\n", filename, mesh->numVertices, mesh->numIndices / 3);
+
+    // Initial binning
+    double start = benchTime();
+    SpatialHash *hash = createSpatialHash(mesh);
+    size_t collisions = detectSelfIntersections(hash, mesh);
+    benchReport("build + first check", benchTime() - start, 1);
+    printf("cell size %.5f, %zu buckets, %zu candidate pairs, %zu colliding faces\n",
+           hash->cellSize, hash->numBuckets, hash->numPairs, collisions);
+
+    // Flow with a check after every step
+    double flowTime = 0.0, checkTime = 0.0;
+    size_t rebinned = 0, firstStep = 0, fullChecks = 0;
+    for (size_t i = 1; i <= STEPS; i++)
+    {
+        start = benchTime();
+        mcfVBM(mesh, STEP_SIZE, NULL);
+        flowTime += benchTime() - start;
+
+        start = benchTime();
+        collisions = detectSelfIntersections(hash, mesh);
+        checkTime += benchTime() - start;
+
+        rebinned += hash->numRebinned;
+        fullChecks += hash->skips == CHECK_INTERVAL - 1;
+        if (collisions && !firstStep)
+            firstStep = i;
+    }
+
+    benchReport("flow step (MCF VBM)", flowTime, STEPS);
+    benchReport("self-intersection check", checkTime, STEPS);
+    printf("%.2f%% of faces rebinned per step, %zu candidate pairs, %zu full checks\n",
+           100.0 * rebinned / STEPS / (mesh->numIndices / 3), hash->numPairs, fullChecks);
+    if (firstStep)
+        printf("first self-intersection at step %zu, %zu colliding faces after %d steps\n", firstStep, collisions, STEPS);
+    else
+        printf("no self-intersections in %d steps\n", STEPS);
+
+    destroySpatialHash(hash);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "selection.h"
+
+#include <cglm/cglm.h>
+#include <math.h>
+
+#define MESH "models/hand.obj" // default mesh to benchmark
+#define RUNS 200               // sweeps per measurement
+#define STEP_SIZE 0.001f       // flow step size
+#define SEED 100               // center vertex of localized flow
+#define RADIUS 0.3f            // radius of localized flow
+#define BUMPY "torus:2e4:0.3"  // mesh with bumps that Gaussian curvature flow should flatten
+#define FLATTEN_STEPS 200      // Gaussian curvature flow steps checked for flattening
+#define FLATTEN_STEP 0.01f     // their step size (the default of the app)
+#define MAX_GROWTH 1.001f      // largest factor the bounding box diagonal may grow by while flattening
+
+// Umbrella Laplacian alone, as a baseline for the fused sweep
+static void umbrellaSweep(Mesh *mesh)
+{
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        glm_vec3_zero(mesh->vertices[i].curvature);
+
+    for (size_t i = 0; i < mesh->numIndices; i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t v0 = mesh->indices[i + k];
+            uint32_t v1 = mesh->indices[i + (k + 1) % 3];
+
+            vec3 diff;
+            glm_vec3_sub(mesh->vertices[v1].position, mesh->vertices[v0].position, diff);
+            glm_vec3_add(mesh->vertices[v0].curvature, diff, mesh->vertices[v0].curvature);
+            glm_vec3_sub(mesh->vertices[v1].curvature, diff, mesh->vertices[v1].curvature);
+        }
+    }
+}
+
+// Area-weighted vertex normals in their own sweep, as a baseline for fusing them into the curvature sweep
+static void normalSweep(Mesh *mesh)
+{
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        glm_vec3_zero(mesh->vertices[i].normal);
+
+    for (size_t i = 0; i < mesh->numIndices; i += 3)
+    {
+        const uint32_t *face = &mesh->indices[i];
+        vec3 a, b, cross;
+        glm_vec3_sub(mesh->vertices[face[1]].position, mesh->vertices[face[0]].position, a);
+        glm_vec3_sub(mesh->vertices[face[2]].position, mesh->vertices[face[0]].position, b);
+        glm_vec3_cross(a, b, cross);
+        for (int k = 0; k < 3; k++)
+            glm_vec3_add(mesh->vertices[face[k]].normal, cross, mesh->vertices[face[k]].normal);
+    }
+}
+
+// Mean curvature flow step on the umbrella Laplacian alone, as a baseline for the step of the fused sweep
+static void umbrellaStep(Mesh *mesh, float deltaTime)
+{
+    umbrellaSweep(mesh);
+    for (size_t i = 0; i < mesh->numVertices; i++)
+    {
+        vec3 update;
+        glm_vec3_scale(mesh->vertices[i].curvature, deltaTime * 10.0f, update);
+        glm_vec3_add(mesh->vertices[i].position, update, mesh->vertices[i].position);
+        glm_vec3_scale(mesh->vertices[i].curvature, 100.0f, mesh->vertices[i].curvature);
+    }
+}
+
+// Umbrella Laplacian followed by a separate angle defect sweep, each computing its own edges
+static void separateSweeps(Mesh *mesh)
+{
+    umbrellaSweep(mesh);
+
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        mesh->vertices[i].gaussian = mesh->areas[i] = 0.0f;
+
+    for (size_t i = 0; i < mesh->numIndices; i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t v0 = mesh->indices[i + k];
+            uint32_t v1 = mesh->indices[i + (k + 1) % 3];
+            uint32_t v2 = mesh->indices[i + (k + 2) % 3];
+
+            vec3 a, b, cross;
+            glm_vec3_sub(mesh->vertices[v1].position, mesh->vertices[v0].position, a);
+            glm_vec3_sub(mesh->vertices[v2].position, mesh->vertices[v0].position, b);
+            glm_vec3_cross(a, b, cross);
+            mesh->vertices[v0].gaussian += atan2f(glm_vec3_norm(cross), glm_vec3_dot(a, b));
+            mesh->areas[v0] += glm_vec3_norm(cross) / 6.0f;
+        }
+    }
+
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        mesh->vertices[i].gaussian = mesh->areas[i] > 0.0f ? (2.0f * GLM_PIf - mesh->vertices[i].gaussian) / mesh->areas[i] : 0.0f;
+}
+
+// Total absolute angle defect, which only Gauss-Bonnet's 2 pi times Euler characteristic remains of once bumps are gone
+static double totalDefect(Mesh *mesh)
+{
+    computeCurvature(mesh);
+    double total = 0.0;
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        total += fabs(mesh->vertices[i].gaussian * mesh->areas[i]);
+    return total;
+}
+
+// Length of the bounding box diagonal (vertex 0 is a dummy)
+static float diagonal(const Mesh *mesh)
+{
+    vec3 lo, hi;
+    glm_vec3_copy(mesh->vertices[1].position, lo);
+    glm_vec3_copy(mesh->vertices[1].position, hi);
+    for (size_t i = 2; i < mesh->numVertices; i++)
+    {
+        glm_vec3_minv(lo, mesh->vertices[i].position, lo);
+        glm_vec3_maxv(hi, mesh->vertices[i].position, hi);
+    }
+    return glm_vec3_distance(lo, hi);
+}
+
+// Checks that Gaussian curvature flow stays bounded (no growth of the diagonal) and, if asked, flattens bumps (less total defect)
+static bool checkFlattening(const char *filename, bool bumpy)
+{
+    Mesh *mesh = benchMesh(filename);
+    double before = totalDefect(mesh);
+    float size = diagonal(mesh);
+    for (size_t i = 0; i < FLATTEN_STEPS; i++)
+        gcf(mesh, FLATTEN_STEP, NULL);
+    double after = totalDefect(mesh);
+    float grown = diagonal(mesh);
+    destroyMesh(mesh);
+
+    bool passed = grown <= size * MAX_GROWTH && (!bumpy || after < before);
+    printf("GCF on %s, %d steps: total |defect| %.4f -> %.4f, diagonal %.4f -> %.4f%s\n", filename, FLATTEN_STEPS, before,
+           after, size, grown, passed ? "" : "  FAILED");
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+
+    Mesh *mesh = benchMesh(filename);
+    printf("%s: %zu vertices, %zu triangles\n", filename, mesh->numVertices, mesh->numIndices / 3);
+
+    // Gauss-Bonnet: total angle defect is 2 pi times Euler characteristic
+    double total = 0.0;
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        total += mesh->vertices[i].gaussian * mesh->areas[i];
+    printf("total Gaussian curvature %.5f (%.3f x 2 pi)\n", total, total / (2.0 * GLM_PI));
+    bool flattened = checkFlattening(BUMPY, true);
+    flattened &= checkFlattening(filename, false);
+
+    double start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        umbrellaSweep(mesh);
+    benchReport("umbrella Laplacian only", benchTime() - start, RUNS);
+
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        normalSweep(mesh);
+    benchReport("normals only", benchTime() - start, RUNS);
+
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        separateSweeps(mesh);
+    benchReport("separate H and K sweeps", benchTime() - start, RUNS);
+
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+    {
+        separateSweeps(mesh);
+        normalSweep(mesh);
+    }
+    benchReport("separate H, K, and normals", benchTime() - start, RUNS);
+
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        computeCurvature(mesh);
+    benchReport("fused H, K, area, normals", benchTime() - start, RUNS);
+
+    // Normals come with the flow step's sweep, so it should cost about the umbrella step, not that plus normals
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        umbrellaStep(mesh, STEP_SIZE);
+    benchReport("umbrella step", benchTime() - start, RUNS);
+
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+    {
+        umbrellaStep(mesh, STEP_SIZE);
+        normalSweep(mesh);
+    }
+    benchReport("umbrella step, then normals", benchTime() - start, RUNS);
+
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        mcfVBM(mesh, STEP_SIZE, NULL);
+    benchReport("flow step (MCF VBM)", benchTime() - start, RUNS);
+
+    // Heat map of Gaussian curvature makes MCF take the fused sweep
+    mesh->showGaussian = true;
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        mcfVBM(mesh, STEP_SIZE, NULL);
+    benchReport("flow step (MCF VBM, K shown)", benchTime() - start, RUNS);
+    mesh->showGaussian = false;
+
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        gcf(mesh, STEP_SIZE, NULL);
+    benchReport("flow step (GCF)", benchTime() - start, RUNS);
+
+    // Localized flow only revisits faces touching the selection, normals included
+    selectRegion(mesh, SEED, RADIUS);
+    printf("selection: %zu active vertices, %zu faces\n", mesh->selection->numActive, mesh->selection->numFaces);
+    start = benchTime();
+    for (size_t i = 0; i < RUNS; i++)
+        mcfVBM(mesh, STEP_SIZE, NULL);
+    benchReport("flow step (MCF VBM, local)", benchTime() - start, RUNS);
+
+    return flattened ? EXIT_SUCCESS : EXIT_FAILURE;
+}
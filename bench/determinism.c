@@ -0,0 +1,67 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "scene.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define MESH "models/hand.obj" // default mesh to benchmark
+#define STEPS 20               // flow steps per measurement
+#define DELTA_TIME 0.001f      // time step of each flow step
+
+// FNV-1a hash of the bits of every position (equal hashes mean bitwise equal meshes, for all practical purposes)
+static uint64_t hashPositions(const Mesh *mesh)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < mesh->numVertices; i++)
+    {
+        unsigned char bytes[sizeof(vec3)];
+        memcpy(bytes, mesh->vertices[i].position, sizeof(bytes));
+        for (size_t j = 0; j < sizeof(bytes); j++)
+            hash = (hash ^ bytes[j]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+    size_t processors = countProcessors();
+    printf("%s, %zu processors\n", filename, processors);
+
+    // One large mesh: a single thread sweeps it face by face, more threads split it into fixed vertex chunks.
+    // Hashes must match across every thread count; comparing against a "make bench-fast" build shows what
+    // the reproducible build costs (and that its hashes differ).
+    GEOMETRIC_FLOW flows[] = {MCF_VBM, GCF};
+    const char *names[] = {"mean curvature flow", "Gaussian curvature flow"};
+    for (size_t f = 0; f < sizeof(flows) / sizeof(flows[0]); f++)
+    {
+        double serial = 0.0;
+        uint64_t reference = 0;
+        for (size_t threads = 1; threads <= 2 * processors || threads <= 4; threads *= 2)
+        {
+            Scene *scene = createScene(threads);
+            addModel(scene, createModel(benchMesh(filename)), flows[f])->flowing = true;
+
+            double start = benchTime();
+            for (size_t i = 0; i < STEPS; i++)
+                stepScene(scene, DELTA_TIME);
+            double seconds = benchTime() - start;
+            serial = threads == 1 ? seconds : serial;
+
+            uint64_t hash = hashPositions(scene->entries[0].model->mesh);
+            reference = threads == 1 ? hash : reference;
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s, %zu thread%s", names[f], threads, threads > 1 ? "s" : "");
+            benchReport(name, seconds, STEPS);
+            printf("%-28s %12.2fx  hash %016llx%s\n", "speedup", serial / seconds, (unsigned long long)hash,
+                   hash == reference ? "" : "  MISMATCH");
+            destroyScene(scene);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
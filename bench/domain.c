@@ -0,0 +1,78 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "generate.h"
+#include "domain.h"
+#include "threadpool.h"
+
+#include <string.h>
+
+#define LEVELS 7         // default subdivisions of the icosphere (about 330k faces); weak scaling starts there
+#define STEPS 20         // MCF steps per run
+#define DELTA_TIME 1e-4f // time step of each flow step
+
+// Flows a fresh icosphere in domains, returning seconds per step (and its positions, if asked for)
+static double flowIcosphere(size_t levels, size_t domains, Mesh **flowed, DomainReport *report)
+{
+    Mesh *mesh = createIcosphere(levels);
+    flowDomains(mesh, MCF_VBM, PRECISION_FLOAT, DELTA_TIME, STEPS, domains, report);
+    if (flowed)
+        *flowed = mesh;
+    else
+        destroyMesh(mesh);
+    return report->flowTime / STEPS;
+}
+
+int main(int argc, char **argv)
+{
+    size_t levels = argc > 1 ? (size_t)atoi(argv[1]) : LEVELS;
+    size_t processors = countProcessors();
+
+    // Reference: the same icosphere flowed in this process
+    Mesh *reference = createIcosphere(levels);
+    printf("icosphere of %zu levels, %zu vertices, %zu faces, %d MCF steps, %zu processors\n", levels,
+           reference->numVertices - 1, reference->numIndices / 3, STEPS, processors);
+    double start = benchTime();
+    for (size_t i = 0; i < STEPS; i++)
+        mcfVBM(reference, DELTA_TIME, NULL);
+    double serial = (benchTime() - start) / STEPS;
+    benchReport("in process", serial * STEPS, STEPS);
+
+    // Strong scaling: one mesh split ever finer; every split must flow it exactly as the reference
+    printf("strong scaling\n");
+    for (size_t domains = 1; domains <= 2 * processors || domains <= 4; domains *= 2)
+    {
+        Mesh *mesh;
+        DomainReport report;
+        double seconds = flowIcosphere(levels, domains, &mesh, &report);
+        bool same = true;
+        for (size_t i = 0; i < mesh->numVertices; i++)
+            same &= !memcmp(mesh->vertices[i].position, reference->vertices[i].position, sizeof(vec3));
+        destroyMesh(mesh);
+
+        char name[64];
+        snprintf(name, sizeof(name), "%zu domain%s", domains, domains > 1 ? "s" : "");
+        benchReport(name, seconds * STEPS, STEPS);
+        printf("%-28s %12.2fx  efficiency %3.0f%%, %zu cut edges, %zu halo vertices%s\n", "speedup", serial / seconds,
+               100.0 * serial / seconds / domains, report.cutEdges, report.haloVertices, same ? "" : "  MISMATCH");
+    }
+    destroyMesh(reference);
+
+    // Weak scaling: four times the domains for every extra level keeps vertices per domain constant
+    printf("weak scaling\n");
+    double base = 0.0;
+    for (size_t domains = 1, level = levels; domains <= 4 * processors || domains <= 4; domains *= 4, level++)
+    {
+        DomainReport report;
+        double seconds = flowIcosphere(level, domains, NULL, &report);
+        base = domains == 1 ? seconds : base;
+
+        char name[64];
+        snprintf(name, sizeof(name), "%zu domain%s, %zu levels", domains, domains > 1 ? "s" : "", level);
+        benchReport(name, seconds * STEPS, STEPS);
+        printf("%-28s %12.0f%%  %zu cut edges, %zu halo vertices\n", "efficiency", 100.0 * base / seconds,
+               report.cutEdges, report.haloVertices);
+    }
+    return EXIT_SUCCESS;
+}
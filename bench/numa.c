@@ -0,0 +1,63 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "generate.h"
+#include "numa.h"
+
+#include <string.h>
+
+#define LEVELS 8         // default subdivisions of the icosphere (about 1.3 million faces)
+#define STEPS 20         // MCF steps per run
+#define DELTA_TIME 1e-4f // time step of each flow step
+
+// Flows an icosphere with its sweeps split across pool, placed first or left where the generating thread put it
+static Mesh *flowIcosphere(size_t levels, ThreadPool *pool, bool place, const char *name)
+{
+    Mesh *mesh = createIcosphere(levels);
+    if (place)
+        placeMesh(mesh, pool);
+    NumaReport report = measurePlacement(mesh, pool);
+
+    double start = benchTime();
+    for (size_t i = 0; i < STEPS; i++)
+        mcfVBM(mesh, DELTA_TIME, pool);
+    benchReport(name, benchTime() - start, STEPS);
+
+    size_t known = report.localPages + report.remotePages;
+    printf("%-28s %12zu local, %zu remote, %zu unknown pages (%.1f%% local)\n", "", report.localPages,
+           report.remotePages, report.unknownPages, known ? 100.0 * report.localPages / known : 0.0);
+    return mesh;
+}
+
+int main(int argc, char **argv)
+{
+    size_t levels = argc > 1 ? (size_t)atoi(argv[1]) : LEVELS;
+    size_t processors = countProcessors(), nodes = countNodes();
+    size_t threads = processors > SWEEP_THREADS ? processors : SWEEP_THREADS; // enough to split sweeps
+    printf("icosphere of %zu levels, %d MCF steps, %zu threads, %zu processors on %zu node%s\n", levels, STEPS,
+           threads, processors, nodes, nodes > 1 ? "s" : "");
+
+    // Unpinned, then pinned; placement must not change a bit of the flow
+    for (int pinned = 0; pinned < 2; pinned++)
+    {
+        // Ranges are kept for both meshes, as placement keeps them, so only where their pages lie differs
+        ThreadPool *pool = createThreadPool(threads);
+        pool->keepRanges = true;
+        if (pinned && !pinThreadPool(pool))
+            printf("(threads could not be pinned)\n");
+
+        Mesh *touched = flowIcosphere(levels, pool, false, pinned ? "pinned, first touch by loader" : "first touch by loader");
+        Mesh *placed = flowIcosphere(levels, pool, true, pinned ? "pinned, placed by sweepers" : "placed by sweepers");
+        bool same = true;
+        for (size_t i = 0; i < touched->numVertices; i++)
+            same &= !memcmp(touched->vertices[i].position, placed->vertices[i].position, sizeof(vec3));
+        if (!same)
+            printf("MISMATCH\n");
+
+        destroyMesh(touched);
+        destroyMesh(placed);
+        destroyThreadPool(pool);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,89 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "selection.h"
+
+#include <math.h>
+
+#define MESH "models/icosphere.obj" // default mesh to benchmark
+#define STEPS 10000                 // flow steps per run
+#define DELTA_TIME 1e-4f            // time step of each flow step
+#define OFFSET 1000.0f              // distance mesh is moved from the origin (along every axis)
+
+// Flows a copy of the mesh moved by offset (through a selection of every vertex if asked for), returning its
+// positions moved back (caller frees)
+static double (*flowMesh(const char *filename, PRECISION precision, float offset, bool selected, double *seconds))[3]
+{
+    Mesh *mesh = benchMesh(filename);
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        glm_vec3_adds(mesh->vertices[i].position, offset, mesh->vertices[i].position);
+    mesh->precision = precision;
+    for (size_t i = 1; selected && i < mesh->numVertices; i++)
+        selectVertex(mesh, (uint32_t)i);
+    if (selected)
+        updateSelection(mesh);
+
+    double start = benchTime();
+    for (size_t i = 0; i < STEPS; i++)
+        mcfVBM(mesh, DELTA_TIME, NULL);
+    *seconds = benchTime() - start;
+
+    double(*positions)[3] = malloc(mesh->numVertices * sizeof(*positions));
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        for (int d = 0; d < 3; d++)
+            positions[i][d] = (precision == PRECISION_DOUBLE ? mesh->precise[i][d] : mesh->vertices[i].position[d]) - offset;
+    destroyMesh(mesh);
+    return positions;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+    Mesh *mesh = benchMesh(filename);
+    size_t numVertices = mesh->numVertices;
+    vec3 low = {INFINITY, INFINITY, INFINITY}, high = {-INFINITY, -INFINITY, -INFINITY};
+    for (size_t i = 1; i < numVertices; i++)
+    {
+        glm_vec3_minv(low, mesh->vertices[i].position, low);
+        glm_vec3_maxv(high, mesh->vertices[i].position, high);
+    }
+    double diagonal = glm_vec3_distance(low, high);
+    destroyMesh(mesh);
+    printf("%s, %zu vertices, %d MCF steps, offset %g\n", filename, numVertices, STEPS, OFFSET);
+
+    // Reference: double precision at the origin (the flow itself doesn't care where the mesh is)
+    double seconds;
+    double(*reference)[3] = flowMesh(filename, PRECISION_DOUBLE, 0.0f, false, &seconds);
+
+    // Cost of every precision against its drift from the reference (relative to the bounding box diagonal), for
+    // the whole mesh and for a selection of all of it (which must drift no more)
+    PRECISION precisions[] = {PRECISION_FLOAT, PRECISION_MIXED, PRECISION_DOUBLE};
+    const char *names[] = {"float", "mixed", "double"};
+    float offsets[] = {0.0f, OFFSET, OFFSET};
+    for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++)
+        for (size_t p = 0; p < sizeof(precisions) / sizeof(precisions[0]); p++)
+        {
+            bool selected = o == 2;
+            double(*positions)[3] = flowMesh(filename, precisions[p], offsets[o], selected, &seconds);
+            double maxDrift = 0.0, sumDrift = 0.0;
+            for (size_t i = 1; i < numVertices; i++)
+            {
+                double drift = sqrt((positions[i][0] - reference[i][0]) * (positions[i][0] - reference[i][0]) +
+                                    (positions[i][1] - reference[i][1]) * (positions[i][1] - reference[i][1]) +
+                                    (positions[i][2] - reference[i][2]) * (positions[i][2] - reference[i][2]));
+                maxDrift = drift > maxDrift ? drift : maxDrift;
+                sumDrift += drift * drift;
+            }
+            free(positions);
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s, offset %g%s", names[p], offsets[o], selected ? ", selected" : "");
+            benchReport(name, seconds, STEPS);
+            printf("%-28s %12.3e max  %.3e rms (of diagonal)\n", "drift", maxDrift / diagonal,
+                   sqrt(sumDrift / (numVertices - 1)) / diagonal);
+        }
+
+    free(reference);
+    return EXIT_SUCCESS;
+}
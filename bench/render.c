@@ -0,0 +1,49 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "scene.h"
+#include "camera.h"
+#include "render.h"
+
+#define MESH "models/voronoi_sphere.obj" // default mesh to benchmark
+#define NUM_MODELS 4                     // models in scene
+#define FRAMES 20                        // frames per measurement
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+    size_t processors = countProcessors();
+    printf("%s, %d models, %dx%d, %zu processors\n", filename, NUM_MODELS, RENDER_WIDTH, RENDER_HEIGHT, processors);
+
+    // Scaling of frames along the rotate camera's path with the number of threads rasterizing tiles
+    double serial = 0.0;
+    for (size_t threads = 1; threads <= 2 * processors; threads *= 2)
+    {
+        Scene *scene = createScene(threads);
+        for (size_t i = 0; i < NUM_MODELS; i++)
+            addModel(scene, createModel(benchMesh(filename)), MCF_VBM);
+        Renderer *renderer = createRenderer(RENDER_WIDTH, RENDER_HEIGHT);
+
+        Camera camera = {.fov = INIT_FOV};
+        mat4 projection, view;
+        double start = benchTime();
+        for (size_t i = 0; i < FRAMES; i++)
+        {
+            orbitCamera(&camera, scene->center, INIT_RADIUS, (double)i / RENDER_FPS,
+                        (float)RENDER_WIDTH / RENDER_HEIGHT, projection, view);
+            renderScene(renderer, scene, view, projection);
+        }
+        double seconds = benchTime() - start;
+        serial = threads == 1 ? seconds : serial;
+
+        char name[64];
+        snprintf(name, sizeof(name), "render, %zu thread%s", threads, threads > 1 ? "s" : "");
+        benchReport(name, seconds, FRAMES);
+        printf("%-28s %12.2fx\n", "speedup", serial / seconds);
+        destroyRenderer(renderer);
+        destroyScene(scene);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#include "bench.h"
+
+#include "model.h"
+#include "ricci.h"
+
+#include <math.h>
+
+#define MESH "models/hand.obj" // default mesh to benchmark
+#define MAX_STEPS 50           // Newton steps before giving up
+#define MAX_LENGTH_ERROR 1e-5  // largest relative edge length error of a passing layout
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+
+    Mesh *mesh = benchMesh(filename);
+    printf("%s: %zu vertices, %zu triangles\n", filename, mesh->numVertices, mesh->numIndices / 3);
+
+    double start = benchTime();
+    Ricci *ricci = createRicci(mesh);
+    benchReport("setup", benchTime() - start, 1);
+    printf("%zu edges, %zu disks, initial error %.3e\n", ricci->numEdges, ricci->numComponents, ricci->error);
+
+    // Newton iterations with their error and linear solver cost
+    double total = 0.0;
+    size_t solverIterations = 0;
+    while (!ricci->converged && !ricci->stalled && ricci->iterations < MAX_STEPS)
+    {
+        start = benchTime();
+        stepRicci(ricci, mesh);
+        double seconds = benchTime() - start;
+        total += seconds;
+        solverIterations += ricci->solverIterations;
+        printf("step %2zu: error %.3e, %4zu CG iterations, %8.3f ms\n", ricci->iterations, ricci->error, ricci->solverIterations, seconds * 1e3);
+    }
+    printf("%s after %zu steps\n", ricci->converged ? "converged" : ricci->stalled ? "stalled" : "stopped", ricci->iterations);
+    if (ricci->iterations)
+    {
+        benchReport("Newton step", total, ricci->iterations);
+        benchReport("CG iteration", total, solverIterations ? solverIterations : 1);
+    }
+
+    start = benchTime();
+    embedRicci(ricci, mesh);
+    benchReport("embedding", benchTime() - start, 1);
+
+    // Quality of layout: relative edge length error and flipped faces (of faces left in the metric)
+    double worst = 0.0;
+    size_t flipped = 0, punctured = 0;
+    for (size_t f = 0; f < mesh->numIndices / 3; f++)
+    {
+        const uint32_t *face = &mesh->indices[3 * f];
+        if (ricci->punctured[f])
+        {
+            punctured++;
+            continue;
+        }
+        for (int k = 0; k < 3; k++)
+        {
+            const double *a = ricci->uvs[face[k]], *b = ricci->uvs[face[(k + 1) % 3]];
+            double length = ricci->lengths[ricci->faceEdges[3 * f + k]];
+            worst = fmax(worst, fabs(hypot(b[0] - a[0], b[1] - a[1]) - length) / length);
+        }
+        const double *a = ricci->uvs[face[0]], *b = ricci->uvs[face[1]], *c = ricci->uvs[face[2]];
+        double area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+        flipped += ricci->mirrored[f] ? area >= 0.0 : area <= 0.0;
+    }
+    printf("largest edge length error %.2e, %zu flipped faces, %zu faces punctured or cut\n", worst, flipped, punctured);
+
+    bool passed = ricci->converged && !flipped && worst <= MAX_LENGTH_ERROR;
+    destroyRicci(ricci);
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
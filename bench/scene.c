@@ -0,0 +1,53 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "scene.h"
+
+#define MESH "models/voronoi_sphere.obj" // default mesh to benchmark
+#define NUM_MODELS 8                     // models in scene
+#define STEPS 20                         // flow steps per measurement
+#define DELTA_TIME 0.001f                // time step of each flow step
+
+// Builds a scene of copies of one mesh, all flowing
+static Scene *createFlowingScene(const char *filename, size_t numThreads, GEOMETRIC_FLOW flow)
+{
+    Scene *scene = createScene(numThreads);
+    for (size_t i = 0; i < NUM_MODELS; i++)
+        addModel(scene, createModel(benchMesh(filename)), flow)->flowing = true;
+    return scene;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+    size_t processors = countProcessors();
+    printf("%s, %d models, %zu processors\n", filename, NUM_MODELS, processors);
+
+    // Scaling of one step of every model with the number of threads (stepping is GL-free, so no context is needed)
+    GEOMETRIC_FLOW flows[] = {MCF_VBM, WILLMORE};
+    const char *names[] = {"mean curvature flow", "Willmore flow"};
+    for (size_t f = 0; f < sizeof(flows) / sizeof(flows[0]); f++)
+    {
+        double serial = 0.0;
+        for (size_t threads = 1; threads <= 2 * processors && threads <= NUM_MODELS; threads *= 2)
+        {
+            Scene *scene = createFlowingScene(filename, threads, flows[f]);
+            stepScene(scene, DELTA_TIME); // first step sets up flow state (e.g. Willmore's factorization)
+
+            double start = benchTime();
+            for (size_t i = 0; i < STEPS; i++)
+                stepScene(scene, DELTA_TIME);
+            double seconds = benchTime() - start;
+            serial = threads == 1 ? seconds : serial;
+
+            char name[64];
+            snprintf(name, sizeof(name), "%s, %zu thread%s", names[f], threads, threads > 1 ? "s" : "");
+            benchReport(name, seconds, STEPS);
+            printf("%-28s %12.2fx\n", "speedup", serial / seconds);
+            destroyScene(scene);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#include "bench.h"
+
+#include "model.h"
+#include "geometry.h"
+#include "generate.h"
+#include "bvh.h"
+#include "collision.h"
+#include "partition.h"
+#include "threadpool.h"
+
+#define MESH "models/icosphere.obj" // default mesh to subdivide (or shape to generate) at every size
+#define SMALLEST 1e4                // triangles of the first size
+#define LARGEST 1e7                 // default triangles of the last size (every size has four times the last)
+#define STEPS 5                     // flow steps per measurement
+#define DELTA_TIME 1e-4f            // time step of each flow step
+#define PARTS 8                     // parts of each partition
+
+// Reports a kernel's time per run and its throughput in triangles per second
+static void reportKernel(const char *name, double seconds, size_t runs, size_t triangles)
+{
+    benchReport(name, seconds, runs);
+    printf("%-28s %12.1f M triangles/s\n", "", triangles * (double)runs / seconds * 1e-6);
+}
+
+int main(int argc, char **argv)
+{
+    const char *name = argc > 1 ? argv[1] : MESH;
+    double largest = argc > 2 ? atof(argv[2]) : LARGEST;
+    ThreadPool *pool = createThreadPool(0);
+    printf("%s from %.0f to %.0f triangles, %zu threads\n", name, SMALLEST, largest, pool->numThreads + 1);
+
+    for (double triangles = SMALLEST; triangles <= largest; triangles *= 4.0)
+    {
+        char spec[512];
+        snprintf(spec, sizeof(spec), "%s:%.0f", name, triangles);
+        double start = benchTime();
+        Mesh *mesh = generateMesh(spec, pool);
+        if (!mesh)
+            return EXIT_FAILURE;
+        size_t numFaces = mesh->numIndices / 3;
+        printf("%zu triangles, %zu vertices\n", numFaces, mesh->numVertices - 1);
+        reportKernel("generate", benchTime() - start, 1, numFaces);
+
+        // Explicit flows, with their sweeps split across the pool
+        start = benchTime();
+        for (size_t i = 0; i < STEPS; i++)
+            mcfVBM(mesh, DELTA_TIME, pool);
+        reportKernel("MCF step", benchTime() - start, STEPS, numFaces);
+        start = benchTime();
+        for (size_t i = 0; i < STEPS; i++)
+            gcf(mesh, DELTA_TIME, pool);
+        reportKernel("GCF step", benchTime() - start, STEPS, numFaces);
+
+        // Hierarchies and partitions built from scratch
+        start = benchTime();
+        BVH *bvh = createBVH(mesh);
+        reportKernel("BVH build", benchTime() - start, 1, numFaces);
+        start = benchTime();
+        refitBVH(bvh, mesh);
+        reportKernel("BVH refit", benchTime() - start, 1, numFaces);
+        destroyBVH(bvh);
+        start = benchTime();
+        SpatialHash *hash = createSpatialHash(mesh);
+        reportKernel("spatial hash build", benchTime() - start, 1, numFaces);
+        destroySpatialHash(hash);
+        start = benchTime();
+        free(partitionMesh(mesh, PARTS));
+        reportKernel("partition", benchTime() - start, 1, numFaces);
+
+        destroyMesh(mesh);
+    }
+    destroyThreadPool(pool);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+#include "bench.h"
+
+#include "model.h"
+#include "weld.h"
+
+#include <string.h>
+
+#define MESH "models/voronoi_sphere.obj" // default mesh to benchmark
+#define RUNS 20                          // welds per measurement
+
+// Splits every face of mesh into its own three vertices (the worst case of an export with split seams)
+static Mesh splitFaces(const Mesh *mesh)
+{
+    Mesh split = {0};
+    split.numIndices = mesh->numIndices;
+    split.numVertices = mesh->numIndices + 1;
+    split.vertices = malloc(split.numVertices * sizeof(Vertex));
+    split.indices = malloc(split.numIndices * sizeof(uint32_t));
+    split.vertices[0] = mesh->vertices[0];
+    for (size_t i = 0; i < mesh->numIndices; i++)
+    {
+        split.vertices[i + 1] = mesh->vertices[mesh->indices[i]];
+        split.indices[i] = (uint32_t)i + 1;
+    }
+    return split;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+    Mesh *mesh = benchMesh(filename);
+    Mesh split = splitFaces(mesh);
+    size_t processors = countProcessors();
+    printf("%s, %zu vertices, %zu split into %zu, %zu processors\n", filename, mesh->numVertices - 1,
+           mesh->numIndices / 3, split.numVertices - 1, processors);
+
+    // Weld fresh copies of the split mesh; every thread count must weld it back to the same mesh
+    Mesh welded = {0};
+    double serial = 0.0;
+    for (size_t threads = 1; threads <= 2 * processors || threads <= 4; threads *= 2)
+    {
+        ThreadPool *pool = threads > 1 ? createThreadPool(threads - 1) : NULL;
+        double seconds = 0.0;
+        WeldReport report;
+        for (size_t run = 0; run < RUNS; run++)
+        {
+            free(welded.vertices);
+            free(welded.indices);
+            welded = split;
+            welded.vertices = malloc(split.numVertices * sizeof(Vertex));
+            welded.indices = malloc(split.numIndices * sizeof(uint32_t));
+            memcpy(welded.vertices, split.vertices, split.numVertices * sizeof(Vertex));
+            memcpy(welded.indices, split.indices, split.numIndices * sizeof(uint32_t));
+
+            double start = benchTime();
+            report = weldMesh(&welded, WELD_EPSILON, pool);
+            seconds += benchTime() - start;
+        }
+        destroyThreadPool(pool);
+        serial = threads == 1 ? seconds : serial;
+
+        bool same = welded.numVertices == mesh->numVertices && welded.numIndices == mesh->numIndices;
+        char name[64];
+        snprintf(name, sizeof(name), "weld, %zu thread%s", threads, threads > 1 ? "s" : "");
+        benchReport(name, seconds, RUNS);
+        printf("%-28s %12.2fx  merged %zu vertices, dropped %zu faces%s\n", "speedup", serial / seconds,
+               report.mergedVertices, report.degenerateFaces + report.duplicateFaces, same ? "" : "  MISMATCH");
+    }
+
+    free(welded.vertices);
+    free(welded.indices);
+    free(split.vertices);
+    free(split.indices);
+    destroyMesh(mesh);
+    return EXIT_SUCCESS;
+}
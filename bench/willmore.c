@@ -0,0 +1,69 @@
+#include "bench.h"
+
+#include "model.h"
+#include "sparse.h"
+#include "willmore.h"
+
+#define MESH "models/voronoi_sphere.obj" // default mesh to benchmark
+#define WINDOWS 4                        // refresh intervals to flow through (all but the first start with a refresh)
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : MESH;
+
+    Mesh *mesh = benchMesh(filename);
+    printf("%s: %zu vertices, %zu triangles\n", filename, mesh->numVertices, mesh->numIndices / 3);
+
+    double start = benchTime();
+    Willmore *willmore = createWillmore(mesh);
+    benchReport("setup (patterns + refresh)", benchTime() - start, 1);
+    printf("system: %zu nonzeros (%.1f per row), factor: %zu nonzeros\n", willmore->system->numValues,
+           (double)willmore->system->numValues / mesh->numVertices, willmore->factor->numValues);
+
+    start = benchTime();
+    for (size_t i = 0; i < 10; i++)
+        refreshWillmore(willmore, mesh);
+    benchReport("refresh (assemble + factor)", benchTime() - start, 10);
+
+    // One coordinate solved with each preconditioner from the same start
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        willmore->rhs[i] = willmore->mass[i] * mesh->vertices[i].position[0];
+    for (int preconditioned = 0; preconditioned < 2; preconditioned++)
+    {
+        for (size_t i = 0; i < mesh->numVertices; i++)
+            willmore->solution[i] = mesh->vertices[i].position[0];
+        start = benchTime();
+        size_t iterations = solveConjugateGradient(willmore->system, preconditioned ? willmore->factor : NULL, willmore->rhs,
+                                                   willmore->solution, WILLMORE_CG_TOLERANCE, WILLMORE_CG_ITERATIONS, meshArena(mesh));
+        double seconds = benchTime() - start;
+        printf("%-28s %12.3f us/run  (%zu CG iterations)\n", preconditioned ? "solve x (incomplete Cholesky)" : "solve x (Jacobi)",
+               seconds * 1e6, iterations);
+    }
+
+    // Throughput of the flow itself, through several refreshes of a deforming mesh
+    size_t iterations = 0;
+    double seconds = 0.0;
+    for (size_t w = 0; w < WINDOWS; w++)
+    {
+        size_t windowIterations = 0;
+        start = benchTime();
+        for (size_t i = 0; i < WILLMORE_REFRESH; i++)
+        {
+            stepWillmore(willmore, mesh);
+            windowIterations += willmore->solverIterations;
+        }
+        double windowSeconds = benchTime() - start;
+        printf("steps %3zu-%3zu %16.3f us/step  (%.1f CG iterations per step)\n", w * WILLMORE_REFRESH,
+               (w + 1) * WILLMORE_REFRESH - 1, windowSeconds * 1e6 / WILLMORE_REFRESH,
+               (double)windowIterations / WILLMORE_REFRESH);
+        iterations += windowIterations;
+        seconds += windowSeconds;
+    }
+    size_t steps = WINDOWS * WILLMORE_REFRESH, unconverged = willmore->unconverged;
+    benchReport("flow step (with refreshes)", seconds, steps);
+    printf("%.1f CG iterations per step (3 coordinates), %zu steps unconverged\n", (double)iterations / steps,
+           unconverged);
+
+    destroyWillmore(willmore);
+    return unconverged ? EXIT_FAILURE : EXIT_SUCCESS;
+}
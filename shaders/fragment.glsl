@@ -2,11 +2,20 @@
 
 in vec3 fragNormal;
 in vec3 fragCurvature;
+in float fragGaussian;
 
 out vec4 color; // red : high curvature | blue : low curvature
 
+uniform bool highlight; // draw highlighted faces (e.g. self-intersections) in a flat color
+uniform int heatMap;    // 0 : mean curvature | 1 : Gaussian curvature (red : positive | blue : negative)
+
 void main() {
-	float flowMagnitude = length(fragCurvature);
+	if (highlight) {
+		color = vec4(1.0, 1.0, 0.0, 1.0);
+		return;
+	}
+
+	float flowMagnitude = heatMap == 1 ? 0.5 + atan(fragGaussian) / 3.14159265 : length(fragCurvature);
 	vec3 fragColor = mix(vec3(0.0, 0.0, 1.0), vec3(1.0, 0.0, 0.0), flowMagnitude);
 	color = vec4(fragColor, 1.0);
 }
\ No newline at end of file
@@ -3,16 +3,31 @@
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec3 aCurvature;
+layout(location = 3) in float aGaussian;
 
 out vec3 fragNormal;
 out vec3 fragCurvature;
+out float fragGaussian;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout(std140, binding = 0) uniform Matrices { // see MatrixBlock (shader.h)
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+};
+
+struct ModelMatrices { // see ModelBlock (shader.h)
+	mat4 model;
+	mat4 normalMatrix;
+};
+
+layout(std430, binding = 1) readonly buffer Models {
+	ModelMatrices models[]; // indexed by base instance of draw (one draw per model)
+};
 
 void main() {
-	gl_Position = projection * view * model * vec4(aPosition, 1.0);
-	fragNormal = aNormal;
+	ModelMatrices matrices = models[gl_BaseInstance];
+	gl_Position = viewProjection * matrices.model * vec4(aPosition, 1.0);
+	fragNormal = normalize(mat3(matrices.normalMatrix) * aNormal); // normals are uploaded as area-weighted sums
 	fragCurvature = aCurvature;
+	fragGaussian = aGaussian;
 }
\ No newline at end of file
@@ -8,12 +8,25 @@
 #include "camera.h"
 #include "model.h"
 #include "geometry.h"
+#include "selection.h"
+#include "bvh.h"
+#include "collision.h"
+#include "scene.h"
+#include "job.h"
+#include "batch.h"
+#include "loader.h"
+#include "checkpoint.h"
+#include "recording.h"
+#include "numa.h"
+#include "arena.h"
 
 #include <cglm/cglm.h>
 
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 
 // TODO: Add window icon
 
@@ -29,7 +42,12 @@
 #define MINOR_VERION 6                            // OpenGL minor version
 #define VERTEX_SHADER "./shaders/vertex.glsl"     // location of vertex shader
 #define FRAGMENT_SHADER "./shaders/fragment.glsl" // location of fragment shader
-#define MESH "models/voronoi_cube.obj"            // location of mesh to load (REPLACE FILENAME HERE)
+#define MESH "models/voronoi_cube.obj"            // location of mesh to load when none is given on the command line
+#define SELECT_RADIUS 0.15f                       // radius of region selected by clicking (model space)
+#define IDLE_TIMEOUT 1.0                          // longest wait for events while nothing changes (seconds)
+#define LOADING_TIMEOUT 0.05                      // longest wait for events while meshes load (seconds, paces progress updates)
+#define MAX_TITLE 256                             // longest window title
+#define NUM_MODELS 1                              // copies of default mesh shown side by side (each starts on the next flow)
 
 /*
  * Enums
@@ -47,19 +65,52 @@ typedef enum
  */
 
 void error_callback(int error, const char *description);
+static GEOMETRIC_FLOW nextFlow(GEOMETRIC_FLOW flow);
 static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
+static void window_refresh_callback(GLFWwindow *window);
+static void updateTitle(GLFWwindow *window, const Loader *loader, bool loading, size_t index, float progress, const Scene *scene,
+                        const Player *player);
 
 /*
  * Globals
  */
 
-CAMERA_MODE cMode = FREE;      // initial camera mode
-GEOMETRIC_FLOW flow = MCF_VBM; // geometric flow to compute
-bool flowing = false;          // flow pause state
-
-int main(void)
+CAMERA_MODE cMode = FREE;          // initial camera mode
+HEAT_MAP heatMap = MEAN_CURVATURE; // quantity shown by heat map
+bool pausing = false;              // whether flows are waiting to be paused (or unpaused if all are paused)
+bool cycling = false;              // whether flows are waiting to advance to the next flow
+bool picking = false;              // whether a click is waiting to be picked
+bool clearing = false;             // whether selection is waiting to be cleared
+bool detecting = false;            // self-intersection detection state
+bool halting = true;               // whether self-intersections pause flow
+bool redraw = true;                // whether frame must be redrawn (set by input and window events)
+
+int main(int argc, char **argv)
 {
+    /*
+     * Command Line
+     */
+
+    Options options;
+    parseArguments(argc, argv, &options);
+    useHugePages(options.hugePages);
+
+    // Run jobs back to back without a window (sharing one scene, and so one thread pool); batches spread files over threads instead
+    if (options.headless)
+    {
+        Scene *scene = createScene(options.threads);
+        if (options.pin)
+            pinThreadPool(scene->pool);
+        bool succeeded = true;
+        for (size_t i = 0; i < options.numJobs; i++)
+            succeeded &= i == 0 && options.batch ? runBatch(&options.jobs[0], options.threads) : runJob(scene, &options.jobs[i]);
+        destroyScene(scene);
+        destroyOptions(&options);
+        exit(succeeded ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     /*
      * GLFW Setup
      */
@@ -92,7 +143,9 @@ int main(void)
     // GLFW settings
     glfwMakeContextCurrent(window);                                    // make the window's context current
     glfwSetKeyCallback(window, key_callback);                          // set close on escape
+    glfwSetMouseButtonCallback(window, mouse_button_callback);         // set vertex picking on click
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback); // callback function for frame resizing
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);     // redraw when window contents are damaged
     glfwSwapInterval(1);                                               // set buffer swap timing (vsync enabled)
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);         // set cursor to hidden
 
@@ -119,35 +172,178 @@ int main(void)
      * Initialization
      */
 
-    // Shaders and meshes
+    // Shaders and scene (a recording's models, resumed from the first job's checkpoint, or filled by a loader thread
+    // with its meshes or copies of default mesh side by side)
     GLuint shaderProgram = createShaderProgram(VERTEX_SHADER, FRAGMENT_SHADER);
-    Mesh *mesh = createMesh(MESH);
-    Model *model = createModel(mesh);
-
-    // Transformations
+    Scene *scene = createScene(options.threads);
+    if (options.pin)
+        pinThreadPool(scene->pool);
+    const Job *job = options.numJobs ? &options.jobs[0] : NULL;
+    Player *player = options.play ? openPlayer(options.play) : NULL;
+    if (options.play && (!player || !seekPlayer(player, 0)))
+        exit(EXIT_FAILURE);
+    for (size_t i = 0; player && i < player->numModels; i++)
+        addModel(scene, createModel(createPlayerMesh(player, i)), MCF_VBM);
+    bool resumed = job && job->checkpoint && restoreCheckpoint(scene, job->checkpoint, job->steps);
+    for (size_t i = 0; i < scene->numEntries; i++)
+        scene->entries[i].flowing = false; // start paused
+    char *defaults[NUM_MODELS];
+    for (size_t i = 0; i < NUM_MODELS; i++)
+        defaults[i] = MESH;
+    Loader *loader = resumed || player ? createLoader(NULL, 0) : job ? createLoader(job->inputs, job->numInputs) : createLoader(defaults, NUM_MODELS);
+    Checkpointer *checkpointer = job && job->checkpoint ? createCheckpointer(job->checkpoint) : NULL;
+    Recorder *recorder = NULL;
+    bool recording = job && job->record; // whether a recording should start once every mesh is in
+    size_t flowSteps = 0;
+    bool playing = false;
+    double playTime = 0.0;
+    GEOMETRIC_FLOW initFlow = job ? job->flow : MCF_VBM;
+
+    // Transformations (last ones drawn are kept to notice camera movement)
     Camera *camera = createCamera(window);
-    mat4 m, v, p;
+    mat4 v = GLM_MAT4_IDENTITY_INIT, p = GLM_MAT4_IDENTITY_INIT;
+    mat4 lastV = GLM_MAT4_ZERO_INIT, lastP = GLM_MAT4_ZERO_INIT;
+
+    // Uniforms (program is never switched; matrices live in a uniform buffer bound once)
+    glUseProgram(shaderProgram);
+    GLuint matrixBuffer = createUniformBuffer(sizeof(MatrixBlock), MATRIX_BINDING);
+    GLint heatMapLocation = glGetUniformLocation(shaderProgram, "heatMap");
+    GLint highlightLocation = glGetUniformLocation(shaderProgram, "highlight");
 
     /*
      * Rendering Loop
      */
 
+    double lastTime = glfwGetTime();
     while (!glfwWindowShouldClose(window))
     {
-        // Dynamically update geometry
-        computeGeometry(window, model, flow, flowing);
+        // Calculate change in time
+        double currentTime = glfwGetTime();
+        float deltaTime = job && job->step > 0.0f ? job->step : glm_min((float)(currentTime - lastTime), MAX_FLOW_TIME);
+        lastTime = currentTime;
+
+        // Add meshes as the loader finishes them (paused; copies of the default mesh each start on the next flow)
+        size_t loaded;
+        Mesh *mesh;
+        while (pollLoader(loader, &loaded, &mesh))
+        {
+            if (!mesh)
+                continue; // loader already reported why
+
+            SceneEntry *entry = addModel(scene, createModel(mesh), initFlow);
+            mesh->precision = job ? job->precision : PRECISION_FLOAT;
+            entry->flowing = false;
+            entry->maxSteps = job ? job->steps : 0;
+            if (!job)
+                initFlow = nextFlow(initFlow);
+            redraw = true;
+        }
+        float loadProgress;
+        bool loading = queryLoader(loader, &loaded, &loadProgress);
+        updateTitle(window, loader, loading, loaded, loadProgress, scene, player);
 
-        // Clear
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Playback (f pauses and resumes it, looping at the end; recorded models never flow)
+        if (player)
+        {
+            if (pausing)
+                playing = !playing;
+            pausing = cycling = false;
+
+            size_t frame = player->frame;
+            if (playing)
+            {
+                playTime += deltaTime;
+                double start = player->times[0];
+                while (frame + 1 < player->numFrames && player->times[frame + 1] - start <= playTime)
+                    frame++;
+                if (frame + 1 == player->numFrames && playTime > player->times[frame] - start)
+                {
+                    frame = 0;
+                    playTime = 0.0;
+                }
+            }
+            if (frame != player->frame && seekPlayer(player, frame))
+            {
+                for (size_t i = 0; i < scene->numEntries; i++)
+                    applyFrame(player, i, scene->entries[i].model->mesh);
+                redraw = true;
+            }
+        }
 
-        // Shaders
-        glUseProgram(shaderProgram);
+        // Record starting state once every mesh is in
+        if (recording && !loading)
+        {
+            recorder = createRecorder(job->record, scene);
+            if (recorder)
+                recordFrame(recorder, scene);
+            recording = false;
+        }
+
+        // Apply flow and detection toggles to every model
+        bool anyFlowing = false;
+        for (size_t i = 0; i < scene->numEntries; i++)
+            anyFlowing |= scene->entries[i].flowing;
+        for (size_t i = 0; i < scene->numEntries; i++)
+        {
+            SceneEntry *entry = &scene->entries[i];
+            Mesh *mesh = entry->model->mesh;
+            if (pausing)
+                entry->flowing = !anyFlowing;
+            if (cycling)
+                entry->flow = nextFlow(entry->flow);
+            mesh->showGaussian = heatMap == GAUSSIAN_CURVATURE;
+
+            if (detecting && !mesh->spatialHash)
+            {
+                mesh->spatialHash = createSpatialHash(mesh);
+                detectSelfIntersections(mesh->spatialHash, mesh);
+            }
+            else if (!detecting && mesh->spatialHash)
+            {
+                destroySpatialHash(mesh->spatialHash);
+                mesh->spatialHash = NULL;
+            }
+        }
+        pausing = cycling = false;
+
+        // Dynamically update geometry (models flow in parallel)
+        bool flowing = stepScene(scene, deltaTime);
+        if (flowing)
+            redraw = true;
+
+        // Record every step, and checkpoint every interval steps (once every mesh is in, so resuming never drops one)
+        if (flowing && recorder)
+            recordFrame(recorder, scene);
+        if (flowing && checkpointer && !loading && ++flowSteps % job->interval == 0)
+            saveCheckpoint(checkpointer, scene);
+
+        // Report self-intersections (and stop flow if desired)
+        for (size_t i = 0; i < scene->numEntries; i++)
+        {
+            SceneEntry *entry = &scene->entries[i];
+            SpatialHash *hash = entry->model->mesh->spatialHash;
+            size_t numCollisions = hash ? hash->numCollisions : 0;
+            if (numCollisions == entry->numCollisions)
+                continue;
+
+            if (hash)
+                printf("Self-intersecting faces (model %zu): %zu\n", i, numCollisions);
+            if (numCollisions && halting)
+                entry->flowing = false;
+            entry->numCollisions = numCollisions;
+            redraw = true;
+        }
+
+        // Upload part of new models, changed vertices, and model matrices
+        bool uploading = scene->numResident < scene->numEntries;
+        if (uploadScene(scene))
+            redraw = true;
 
         // Camera
         switch (cMode)
         {
         case ROTATE:
-            updateRotationCamera(window, camera, model, p, v);
+            updateRotationCamera(window, camera, scene->center, p, v);
             break;
         case FREE:
             updateCamera(window, camera, p, v);
@@ -155,28 +351,129 @@ int main(void)
         case LOCK:
             break;
         }
+        bool moving = memcmp(v, lastV, sizeof(mat4)) || memcmp(p, lastP, sizeof(mat4));
+        if (moving)
+        {
+            glm_mat4_copy(v, lastV);
+            glm_mat4_copy(p, lastP);
+            updateMatrixBlock(matrixBuffer, v, p);
+            redraw = true;
+        }
 
-        // MVP
-        computeModelMatrix(model, &m);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, &m[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &v[0][0]);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &p[0][0]);
+        // Selection (closest hit over all models; ray parameters are comparable as every model's ray spans the same view segment)
+        if (picking)
+        {
+            double xpos, ypos;
+            glfwGetCursorPos(window, &xpos, &ypos);
+
+            Mesh *picked = NULL;
+            Ray pickedRay;
+            float closest = INFINITY;
+            for (size_t i = 0; i < scene->numEntries; i++)
+            {
+                Mesh *mesh = scene->entries[i].model->mesh;
+                if (!mesh->bvh)
+                    mesh->bvh = createBVH(mesh);
+
+                mat4 m;
+                Ray ray;
+                RayHit hit;
+                computeModelMatrix(scene->entries[i].model, &m);
+                computeCameraRay(window, p, v, m, xpos, ypos, &ray);
+                if (intersectBVH(mesh->bvh, mesh, &ray, &hit) && hit.t < closest)
+                {
+                    closest = hit.t;
+                    picked = mesh;
+                    pickedRay = ray;
+                }
+            }
+
+            uint32_t vertex;
+            if (picked && pickVertex(picked->bvh, picked, &pickedRay, &vertex))
+                selectRegion(picked, vertex, SELECT_RADIUS);
+            picking = false;
+        }
+        if (clearing)
+        {
+            for (size_t i = 0; i < scene->numEntries; i++)
+                clearSelection(scene->entries[i].model->mesh);
+            clearing = false;
+        }
 
-        // Draw
-        glBindVertexArray(model->mesh->VAO);
-        glDrawElements(model->renderMethod, model->mesh->numIndices, GL_UNSIGNED_INT, NULL);
+        // Skip drawing entirely if nothing changed
+        if (redraw)
+        {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glUniform1i(heatMapLocation, heatMap);
+
+            // Draw every model at once
+            drawScene(scene);
+
+            // Highlight self-intersecting faces
+            glUniform1i(highlightLocation, GL_TRUE);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            drawHighlights(scene);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            glUniform1i(highlightLocation, GL_FALSE);
+
+            glfwSwapBuffers(window);
+            redraw = false;
+        }
 
-        // Buffer swapping and event handling
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Keep polling while anything animates or uploads (vsync paces the loop), check in on loading meshes regularly,
+        // otherwise sleep until an event arrives
+        if (flowing || moving || uploading || playing)
+            glfwPollEvents();
+        else if (loading)
+            glfwWaitEventsTimeout(LOADING_TIMEOUT);
+        else
+            glfwWaitEventsTimeout(IDLE_TIMEOUT);
     }
 
-    // Exit
-    destroyModel(model);
+    // Exit (writing flowed meshes and final state if asked to, once every input has loaded so that outputs keep their names)
+    size_t loading;
+    float loadProgress;
+    bool complete = !queryLoader(loader, &loading, &loadProgress) && scene->numEntries == (job ? job->numInputs : NUM_MODELS);
+    destroyLoader(loader);
+    if (checkpointer && complete)
+        saveCheckpoint(checkpointer, scene);
+    destroyCheckpointer(checkpointer);
+    closeRecorder(recorder);
+    closePlayer(player);
+    if (job && complete)
+        exportJob(scene, job);
+    else if (job && job->output)
+        fprintf(stderr, "Not every input was loaded, skipping output\n");
+    glDeleteBuffers(1, &matrixBuffer);
+    destroyScene(scene);
+    destroyOptions(&options);
     glfwTerminate();
     exit(EXIT_SUCCESS);
 }
 
+/**
+ * @brief Gives the flow following a flow in the cycle of the g key.
+ *
+ * @param flow Current flow.
+ * @return Next flow.
+ */
+static GEOMETRIC_FLOW nextFlow(GEOMETRIC_FLOW flow)
+{
+    switch (flow)
+    {
+    case MCF_VBM:
+        return GCF;
+    case GCF:
+        return WILLMORE;
+    case WILLMORE:
+        return RICCI;
+    case MCF_ITI: // not implemented yet
+    case RICCI:
+        break;
+    }
+    return MCF_VBM;
+}
+
 /**
  * @brief GLFW error callback function.
  *
@@ -199,11 +496,28 @@ void error_callback(int error, const char *description)
  */
 static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods)
 {
+    redraw = true; // most keys change what is shown
+
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) // close on escape
         glfwSetWindowShouldClose(window, GLFW_TRUE);
 
-    if (key == GLFW_KEY_F && action == GLFW_PRESS) // pause/unpause flow
-        flowing = !flowing;
+    if (key == GLFW_KEY_F && action == GLFW_PRESS) // pause/unpause flows
+        pausing = true;
+
+    if (key == GLFW_KEY_G && action == GLFW_PRESS) // cycle geometric flows
+        cycling = true;
+
+    if (key == GLFW_KEY_K && action == GLFW_PRESS) // switch heat map between mean and Gaussian curvature
+        heatMap = heatMap == MEAN_CURVATURE ? GAUSSIAN_CURVATURE : MEAN_CURVATURE;
+
+    if (key == GLFW_KEY_X && action == GLFW_PRESS) // clear selection
+        clearing = true;
+
+    if (key == GLFW_KEY_I && action == GLFW_PRESS) // turn self-intersection detection on/off
+        detecting = !detecting;
+
+    if (key == GLFW_KEY_H && action == GLFW_PRESS) // turn halting on self-intersection on/off
+        halting = !halting;
 
     if (key == GLFW_KEY_C && action == GLFW_PRESS) // turn camera mode on/off
     {
@@ -225,6 +539,20 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
     }
 }
 
+/**
+ * @brief GLFW mouse button callback function.
+ *
+ * @param window The window that received the event.
+ * @param button The mouse button that was pressed or released.
+ * @param action The button action.
+ * @param mods   Bit field describing which modifier keys were held down.
+ */
+static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
+{
+    if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS && cMode == LOCK) // select region under cursor
+        picking = true;
+}
+
 /**
  * @brief GLFW framebuffer size callback; called on frame resize.
  *
@@ -235,4 +563,55 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
     glViewport(0, 0, width, height); // set viewport to new window dimensions
-}
\ No newline at end of file
+    redraw = true;
+}
+
+/**
+ * @brief GLFW window refresh callback; called when window contents need to be redrawn (e.g. after being uncovered).
+ *
+ * @param window The window whose contents need to be redrawn.
+ */
+static void window_refresh_callback(GLFWwindow *window)
+{
+    redraw = true;
+}
+/**
+ * @brief Shows loading or upload progress, or the frame played back, in the window title (restoring the title once done).
+ *
+ * The title is only set when its text changes, as setting it can be slow on some platforms.
+ *
+ * @param window   Window to title.
+ * @param loader   Loader meshes come from.
+ * @param loading  Whether loader is still loading.
+ * @param index    Index of file being loaded.
+ * @param progress Progress of file being loaded.
+ * @param scene    Scene meshes are uploaded to.
+ * @param player   Recording being played back (NULL for none).
+ */
+static void updateTitle(GLFWwindow *window, const Loader *loader, bool loading, size_t index, float progress, const Scene *scene,
+                        const Player *player)
+{
+    static char shown[MAX_TITLE] = TITLE;
+    char title[MAX_TITLE];
+    if (loading)
+    {
+        const char *name = loader->filenames[index];
+        for (const char *c = name; *c; c++)
+            if (*c == '/' || *c == '\\')
+                name = c + 1;
+        snprintf(title, sizeof(title), "%s - loading %s (%zu/%zu, %d%%)", TITLE, name, index + 1, loader->numFiles, (int)(progress * 100.0f));
+    }
+    else if (scene->numResident < scene->numEntries)
+        snprintf(title, sizeof(title), "%s - uploading (%zu/%zu)", TITLE, scene->numResident + 1, scene->numEntries);
+    else if (player)
+        snprintf(title, sizeof(title), "%s - frame %zu/%zu (step %llu)", TITLE, player->frame + 1, player->numFrames,
+                 (unsigned long long)player->steps[player->frame]);
+    else
+        snprintf(title, sizeof(title), "%s", TITLE);
+
+    if (strcmp(title, shown))
+    {
+        glfwSetWindowTitle(window, title);
+        memcpy(shown, title, sizeof(title));
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE // madvise, MADV_HUGEPAGE
+#endif
+
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+// Block of an arena (its memory follows the struct, aligned)
+struct ArenaBlock
+{
+    ArenaBlock *next;    // block used after this one
+    size_t size;         // usable bytes
+    unsigned char *data; // first usable byte (ARENA_ALIGN aligned)
+};
+
+static bool hugePages = false; // whether adviseHugePages takes effect
+
+/*
+ * Arenas
+ */
+
+Arena *createArena(void)
+{
+    return calloc(1, sizeof(Arena));
+}
+
+void destroyArena(Arena *arena)
+{
+    if (!arena)
+        return;
+    for (ArenaBlock *block = arena->first, *next; block; block = next)
+    {
+        next = block->next;
+        free(block);
+    }
+    free(arena);
+}
+
+static ArenaBlock *createBlock(size_t size)
+{
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + size + ARENA_ALIGN - 1);
+    block->next = NULL;
+    block->size = size;
+    block->data = (unsigned char *)(((uintptr_t)(block + 1) + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN);
+    adviseHugePages(block->data, size);
+    return block;
+}
+
+void *arenaAlloc(Arena *arena, size_t bytes)
+{
+    bytes = bytes ? (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN : ARENA_ALIGN;
+    if (arena->current && arena->used + bytes <= arena->current->size)
+    {
+        void *memory = arena->current->data + arena->used;
+        arena->used += bytes;
+        return memory;
+    }
+
+    // Next kept block if it fits, or a fresh one slotted in before it (so the next step finds it in place)
+    ArenaBlock **link = arena->current ? &arena->current->next : &arena->first;
+    if (!*link || (*link)->size < bytes)
+    {
+        ArenaBlock *block = createBlock(bytes > ARENA_BLOCK ? bytes : ARENA_BLOCK);
+        block->next = *link;
+        *link = block;
+        arena->reserved += block->size;
+    }
+    arena->current = *link;
+    arena->used = bytes;
+    return arena->current->data;
+}
+
+void *arenaCalloc(Arena *arena, size_t count, size_t size)
+{
+    void *memory = arenaAlloc(arena, count * size);
+    memset(memory, 0, count * size);
+    return memory;
+}
+
+ArenaFrame pushFrame(const Arena *arena)
+{
+    return (ArenaFrame){arena->current, arena->used};
+}
+
+void popFrame(Arena *arena, ArenaFrame frame)
+{
+    arena->current = frame.block;
+    arena->used = frame.used;
+}
+
+/*
+ * Huge Pages
+ */
+
+void useHugePages(bool enabled)
+{
+    hugePages = enabled;
+}
+
+bool adviseHugePages(void *data, size_t bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    uintptr_t begin = ((uintptr_t)data + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    uintptr_t end = ((uintptr_t)data + bytes) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    return hugePages && begin < end && madvise((void *)begin, end - begin, MADV_HUGEPAGE) == 0;
+#else
+    (void)data;
+    (void)bytes;
+    return false;
+#endif
+}
@@ -0,0 +1,116 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Arena settings
+#define ARENA_BLOCK (1 << 20)    // smallest block an arena grows by (bigger allocations get a block of their own)
+#define ARENA_ALIGN 64           // alignment of every allocation (a cache line, so temporaries never share one)
+#define HUGE_PAGE_SIZE (2 << 20) // size of the huge pages big arrays are backed by (when enabled)
+
+/*
+ * Structs
+ */
+
+typedef struct ArenaBlock ArenaBlock; // block of an arena (private to arena.c)
+typedef struct Arena Arena;
+
+/**
+ * @brief Bump allocator for temporaries of a step.
+ *
+ * Allocations come off the end of the current block and are only given back by popping the frame they were
+ * made in. Blocks are kept when frames pop, in the order they were used, so a step making the same allocations
+ * as the last one reuses the same blocks and never reaches malloc.
+ */
+struct Arena
+{
+    ArenaBlock *first;   // blocks in order of use
+    ArenaBlock *current; // block allocations come from (NULL before the first)
+    size_t used;         // bytes of current block in use
+    size_t reserved;     // bytes of every block (stops growing once steps repeat)
+};
+
+/**
+ * @brief Point to roll an arena back to, freeing everything allocated since.
+ */
+typedef struct
+{
+    ArenaBlock *block; // current block when frame was pushed
+    size_t used;       // bytes of it in use
+} ArenaFrame;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates an empty arena (blocks are allocated on first use).
+ *
+ * @return Initialized arena.
+ */
+Arena *createArena(void);
+
+/**
+ * @brief Destroys arena, freeing every block.
+ *
+ * @param arena Arena to destroy (may be NULL).
+ */
+void destroyArena(Arena *arena);
+
+/**
+ * @brief Allocates ARENA_ALIGN aligned, uninitialized memory from arena.
+ *
+ * @param arena Arena to allocate from.
+ * @param bytes Size of allocation.
+ * @return Memory, valid until the innermost frame pushed before this call pops.
+ */
+void *arenaAlloc(Arena *arena, size_t bytes);
+
+/**
+ * @brief Allocates ARENA_ALIGN aligned, zeroed memory for count elements from arena.
+ *
+ * @param arena Arena to allocate from.
+ * @param count Number of elements.
+ * @param size  Size of each element.
+ * @return Memory, valid until the innermost frame pushed before this call pops.
+ */
+void *arenaCalloc(Arena *arena, size_t count, size_t size);
+
+/**
+ * @brief Marks the point everything allocated from here on is freed back to.
+ *
+ * @param arena Arena to mark.
+ * @return Frame to pop.
+ */
+ArenaFrame pushFrame(const Arena *arena);
+
+/**
+ * @brief Frees everything allocated from arena since frame was pushed (frames pop innermost first).
+ *
+ * @param arena Arena to roll back.
+ * @param frame Frame pushed on arena.
+ */
+void popFrame(Arena *arena, ArenaFrame frame);
+
+/**
+ * @brief Sets whether big arrays ask for huge pages (process wide; off by default).
+ *
+ * @param enabled Whether adviseHugePages takes effect.
+ */
+void useHugePages(bool enabled);
+
+/**
+ * @brief Asks the system to back the whole huge pages inside an array with huge pages, cutting TLB misses of
+ * sweeps over it. Does nothing unless enabled with useHugePages, or for arrays spanning no whole huge page.
+ *
+ * Memory keeps being freed however it was allocated. Only Linux (transparent huge pages) honors the advice;
+ * Windows only gives large pages to locked allocations made with a privilege, which malloc'd arrays are not.
+ *
+ * @param data  Array.
+ * @param bytes Size of array.
+ * @return True if some of array was advised.
+ */
+bool adviseHugePages(void *data, size_t bytes);
+
+#endif
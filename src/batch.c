@@ -0,0 +1,217 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // opendir
+#endif
+
+#include "batch.h"
+#include "job.h"
+#include "model.h"
+#include "geometry.h"
+#include "threadpool.h"
+
+#include <dirent.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Listing
+ */
+
+// Compares strings for qsort
+static int compareNames(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Adds every BATCH_EXTENSION file of directory, in name order (so runs are reproducible)
+static void listDirectory(DIR *directory, const char *path, Job *job)
+{
+    char **names = NULL;
+    size_t numNames = 0;
+    size_t extension = strlen(BATCH_EXTENSION);
+    struct dirent *entry;
+    while ((entry = readdir(directory)))
+    {
+        size_t length = strlen(entry->d_name);
+        if (length <= extension || strcmp(entry->d_name + length - extension, BATCH_EXTENSION))
+            continue;
+
+        names = realloc(names, (numNames + 1) * sizeof(char *));
+        names[numNames] = malloc(strlen(path) + length + 2);
+        sprintf(names[numNames++], "%s/%s", path, entry->d_name);
+    }
+    closedir(directory);
+
+    qsort(names, numNames, sizeof(char *), compareNames);
+    job->inputs = realloc(job->inputs, (job->numInputs + numNames) * sizeof(char *));
+    memcpy(&job->inputs[job->numInputs], names, numNames * sizeof(char *));
+    job->numInputs += numNames;
+    free(names);
+}
+
+// Adds every path listed in manifest
+static void listManifest(FILE *file, Job *job)
+{
+    char line[MAX_LINE];
+    while (fgets(line, sizeof(line), file))
+    {
+        // Strip comment and surrounding space
+        line[strcspn(line, "#")] = '\0';
+        char *begin = line;
+        while (isspace((unsigned char)*begin))
+            begin++;
+        size_t length = strlen(begin);
+        while (length && isspace((unsigned char)begin[length - 1]))
+            begin[--length] = '\0';
+        if (!length)
+            continue;
+
+        job->inputs = realloc(job->inputs, (job->numInputs + 1) * sizeof(char *));
+        job->inputs[job->numInputs] = malloc(length + 1);
+        memcpy(job->inputs[job->numInputs++], begin, length + 1);
+    }
+    fclose(file);
+}
+
+void listBatch(const char *path, Job *job)
+{
+    DIR *directory = opendir(path);
+    if (directory)
+    {
+        listDirectory(directory, path, job);
+        return;
+    }
+
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Error opening batch directory or manifest: %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+    listManifest(file, job);
+}
+
+/*
+ * Running
+ */
+
+typedef struct
+{
+    long size;    // file size in bytes (-1 if unreadable)
+    size_t input; // index of input
+} SizedInput;
+
+// Orders inputs by decreasing size (ties by input order)
+static int compareSizes(const void *a, const void *b)
+{
+    const SizedInput *x = a, *y = b;
+    if (x->size != y->size)
+        return x->size < y->size ? 1 : -1;
+    return x->input < y->input ? -1 : x->input > y->input;
+}
+
+static long fileSize(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        return -1;
+    long size = fseek(file, 0, SEEK_END) ? -1 : ftell(file);
+    fclose(file);
+    return size;
+}
+
+// Loads, flows, writes, and frees one file (run on worker threads)
+static void runFile(void *data, size_t index)
+{
+    Batch *batch = data;
+    const Job *job = batch->job;
+    size_t input = batch->order[index];
+    BatchResult *result = &batch->results[input];
+    *result = (BatchResult){0, 0, 0.0, 0.0, 0.0, false};
+
+    // Load
+    double start = wallTime();
+    Mesh *mesh = malloc(sizeof(Mesh));
+    bool loaded = loadOBJ(job->inputs[input], mesh);
+    double loadedTime = wallTime();
+    result->load = loadedTime - start;
+
+    if (loaded)
+    {
+        // Flow
+        result->triangles = mesh->numIndices / 3;
+        mesh->precision = job->precision;
+        float step = job->step > 0.0f ? job->step : DEFAULT_STEP;
+        for (; result->steps < job->steps; result->steps++)
+            stepFlow(mesh, job->flow, step, NULL);
+        double flowedTime = wallTime();
+        result->flow = flowedTime - loadedTime;
+
+        // Write
+        char *path = outputPath(job, input);
+        result->succeeded = !path || exportOBJ(mesh, path);
+        free(path);
+        result->write = wallTime() - flowedTime;
+
+        destroyMesh(mesh);
+    }
+    else
+        free(mesh);
+
+    // Report (one line per file, in completion order)
+    pthread_mutex_lock(&batch->lock);
+    batch->finished++;
+    printf("[%zu/%zu] %s: %zu triangles, load %.1f ms, flow %.1f ms, write %.1f ms, latency %.1f ms%s\n", batch->finished,
+           job->numInputs, job->inputs[input], result->triangles, result->load * 1e3, result->flow * 1e3, result->write * 1e3,
+           (result->load + result->flow + result->write) * 1e3, result->succeeded ? "" : " (FAILED)");
+    fflush(stdout);
+    pthread_mutex_unlock(&batch->lock);
+}
+
+bool runBatch(const Job *job, size_t threads)
+{
+    // Largest files first, so that a huge file found late does not hold up the end of the run
+    SizedInput *sized = malloc(job->numInputs * sizeof(SizedInput));
+    for (size_t i = 0; i < job->numInputs; i++)
+        sized[i] = (SizedInput){fileSize(job->inputs[i]), i};
+    qsort(sized, job->numInputs, sizeof(SizedInput), compareSizes);
+
+    Batch batch;
+    batch.job = job;
+    batch.order = malloc(job->numInputs * sizeof(size_t));
+    batch.results = malloc(job->numInputs * sizeof(BatchResult));
+    batch.finished = 0;
+    pthread_mutex_init(&batch.lock, NULL);
+    for (size_t i = 0; i < job->numInputs; i++)
+        batch.order[i] = sized[i].input;
+    free(sized);
+
+    ThreadPool *pool = createThreadPool(threads);
+    double start = wallTime();
+    runTasks(pool, runFile, &batch, job->numInputs);
+    double seconds = wallTime() - start;
+
+    // Aggregate throughput and latency
+    size_t failed = 0;
+    double work = 0.0, latency = 0.0, maxLatency = 0.0;
+    for (size_t i = 0; i < job->numInputs; i++)
+    {
+        const BatchResult *result = &batch.results[i];
+        double fileLatency = result->load + result->flow + result->write;
+        failed += !result->succeeded;
+        work += (double)result->triangles * result->steps;
+        latency += fileLatency;
+        maxLatency = fileLatency > maxLatency ? fileLatency : maxLatency;
+    }
+    printf("%zu files (%zu failed) on %zu thread%s in %.3f s: %.3g triangle-steps/s, %.2f files/s, latency %.1f ms mean, %.1f ms max\n",
+           job->numInputs, failed, pool->numThreads + 1, pool->numThreads ? "s" : "", seconds, seconds > 0.0 ? work / seconds : 0.0,
+           seconds > 0.0 ? job->numInputs / seconds : 0.0, job->numInputs ? latency / job->numInputs * 1e3 : 0.0, maxLatency * 1e3);
+
+    destroyThreadPool(pool);
+    pthread_mutex_destroy(&batch.lock);
+    free(batch.order);
+    free(batch.results);
+    return failed == 0;
+}
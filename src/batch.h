@@ -0,0 +1,69 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "job.h"
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Batch settings
+#define BATCH_EXTENSION ".obj" // extension of meshes picked up from batch directories
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Outcome of one file of a batch.
+ */
+typedef struct
+{
+    size_t triangles; // triangles of mesh
+    size_t steps;     // flow steps taken
+    double load;      // time spent loading (seconds)
+    double flow;      // time spent flowing (seconds)
+    double write;     // time spent writing (seconds)
+    bool succeeded;   // whether file was loaded (and written, if asked to)
+} BatchResult;
+
+/**
+ * @brief State shared by the tasks of a batch.
+ *
+ * Every file is one task of the thread pool (loaded, flowed, written, and freed by the same worker), so
+ * loading, flowing, and writing of different files overlap, and workers done with small files steal
+ * from those still stuck on large ones.
+ */
+typedef struct
+{
+    const Job *job;       // job whose inputs are flowed independently
+    size_t *order;        // inputs by decreasing file size (largest go first)
+    BatchResult *results; // result of each input
+    pthread_mutex_t lock; // guards progress below and output
+    size_t finished;      // files finished so far
+} Batch;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Adds meshes of a batch to job's inputs (exits on errors).
+ *
+ * @param path Directory (every BATCH_EXTENSION file in it) or manifest (one path per line, # for comments).
+ * @param job  Job to add inputs to.
+ */
+void listBatch(const char *path, Job *job);
+
+/**
+ * @brief Flows every input of job on its own, spread across a thread pool, reporting per-file latency
+ * and aggregate throughput.
+ *
+ * @param job     Job whose inputs to flow (needs a step limit; output must be a directory if given).
+ * @param threads Threads to use, including the caller (0 for one per processor).
+ * @return True if every file succeeded.
+ */
+bool runBatch(const Job *job, size_t threads);
+
+#endif
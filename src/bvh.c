@@ -0,0 +1,393 @@
+#include "bvh.h"
+#include "model.h"
+
+#include <cglm/cglm.h>
+
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
+
+#define BVH_MAX_DEPTH 64 // deeper nodes are kept as leaves (bounds traversal stack)
+
+/*
+ * Helpers
+ */
+
+static void resetBounds(vec3 min, vec3 max)
+{
+    glm_vec3_fill(min, FLT_MAX);
+    glm_vec3_fill(max, -FLT_MAX);
+}
+
+static void growBounds(vec3 min, vec3 max, const vec3 pMin, const vec3 pMax)
+{
+    glm_vec3_minv(min, (float *)pMin, min);
+    glm_vec3_maxv(max, (float *)pMax, max);
+}
+
+static float surfaceArea(const vec3 min, const vec3 max)
+{
+    vec3 d;
+    glm_vec3_sub((float *)max, (float *)min, d);
+    if (d[0] < 0.0f)
+        return 0.0f; // empty
+    return 2.0f * (d[0] * d[1] + d[1] * d[2] + d[2] * d[0]);
+}
+
+static void triangleBounds(const Mesh *mesh, uint32_t face, vec3 min, vec3 max)
+{
+    const uint32_t *f = &mesh->indices[3 * face];
+    resetBounds(min, max);
+    for (int k = 0; k < 3; k++)
+        growBounds(min, max, mesh->vertices[f[k]].position, mesh->vertices[f[k]].position);
+}
+
+// Entry distance of ray into box, or FLT_MAX if it misses or enters beyond tMax
+static float intersectBounds(const BVHNode *node, const Ray *ray, const vec3 invDir, float tMax)
+{
+    float tNear = 0.0f, tFar = tMax;
+    for (int a = 0; a < 3; a++)
+    {
+        float t0 = (node->min[a] - ray->origin[a]) * invDir[a];
+        float t1 = (node->max[a] - ray->origin[a]) * invDir[a];
+        if (t0 > t1)
+        {
+            float temp = t0;
+            t0 = t1;
+            t1 = temp;
+        }
+        tNear = t0 > tNear ? t0 : tNear;
+        tFar = t1 < tFar ? t1 : tFar;
+        if (tNear > tFar)
+            return FLT_MAX;
+    }
+    return tNear;
+}
+
+/*
+ * Construction
+ */
+
+BVH *createBVH(const Mesh *mesh)
+{
+    size_t numFaces = mesh->numIndices / 3;
+
+    BVH *bvh = malloc(sizeof(BVH));
+    bvh->nodes = malloc((numFaces ? 2 * numFaces - 1 : 1) * sizeof(BVHNode));
+    bvh->triangles = malloc((numFaces ? numFaces : 1) * sizeof(uint32_t));
+
+    // Per-triangle bounds and centroids
+    vec3 *triMin = malloc((numFaces ? numFaces : 1) * sizeof(vec3));
+    vec3 *triMax = malloc((numFaces ? numFaces : 1) * sizeof(vec3));
+    vec3 *centroids = malloc((numFaces ? numFaces : 1) * sizeof(vec3));
+    for (size_t f = 0; f < numFaces; f++)
+    {
+        bvh->triangles[f] = (uint32_t)f;
+        triangleBounds(mesh, (uint32_t)f, triMin[f], triMax[f]);
+        glm_vec3_center(triMin[f], triMax[f], centroids[f]);
+    }
+
+    // Root
+    bvh->numNodes = 1;
+    bvh->nodes[0].first = 0;
+    bvh->nodes[0].count = (uint32_t)numFaces;
+    resetBounds(bvh->nodes[0].min, bvh->nodes[0].max);
+
+    // Split nodes top-down (explicit stack of node index and depth)
+    uint32_t stack[2 * BVH_MAX_DEPTH][2];
+    size_t top = 0;
+    stack[top][0] = 0;
+    stack[top++][1] = 0;
+    while (top > 0)
+    {
+        top--;
+        BVHNode *node = &bvh->nodes[stack[top][0]];
+        uint32_t depth = stack[top][1];
+        uint32_t first = node->first, count = node->count;
+
+        // Node and centroid bounds
+        vec3 cMin, cMax;
+        resetBounds(node->min, node->max);
+        resetBounds(cMin, cMax);
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            uint32_t t = bvh->triangles[i];
+            growBounds(node->min, node->max, triMin[t], triMax[t]);
+            growBounds(cMin, cMax, centroids[t], centroids[t]);
+        }
+        if (count <= BVH_LEAF_SIZE || depth + 1 >= BVH_MAX_DEPTH)
+            continue;
+
+        // Find cheapest binned split over all axes
+        float bestCost = FLT_MAX;
+        int bestAxis = -1, bestSplit = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float extent = cMax[axis] - cMin[axis];
+            if (extent <= 0.0f)
+                continue;
+
+            vec3 binMin[BVH_BINS], binMax[BVH_BINS];
+            uint32_t binCount[BVH_BINS] = {0};
+            for (int b = 0; b < BVH_BINS; b++)
+                resetBounds(binMin[b], binMax[b]);
+
+            float scale = BVH_BINS / extent;
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                uint32_t t = bvh->triangles[i];
+                int b = (int)((centroids[t][axis] - cMin[axis]) * scale);
+                b = b < BVH_BINS ? b : BVH_BINS - 1;
+                binCount[b]++;
+                growBounds(binMin[b], binMax[b], triMin[t], triMax[t]);
+            }
+
+            // Sweep from the right, then evaluate splits from the left
+            float rightArea[BVH_BINS];
+            uint32_t rightCount[BVH_BINS];
+            vec3 sMin, sMax;
+            resetBounds(sMin, sMax);
+            uint32_t sCount = 0;
+            for (int b = BVH_BINS - 1; b > 0; b--)
+            {
+                growBounds(sMin, sMax, binMin[b], binMax[b]);
+                sCount += binCount[b];
+                rightArea[b] = surfaceArea(sMin, sMax);
+                rightCount[b] = sCount;
+            }
+
+            resetBounds(sMin, sMax);
+            sCount = 0;
+            for (int b = 0; b < BVH_BINS - 1; b++)
+            {
+                growBounds(sMin, sMax, binMin[b], binMax[b]);
+                sCount += binCount[b];
+                if (sCount == 0 || rightCount[b + 1] == 0)
+                    continue;
+
+                float cost = sCount * surfaceArea(sMin, sMax) + rightCount[b + 1] * rightArea[b + 1];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+
+        // Keep as leaf if splitting doesn't pay off
+        if (bestAxis < 0 || bestCost >= count * surfaceArea(node->min, node->max))
+            continue;
+
+        // Partition triangles in place
+        float scale = BVH_BINS / (cMax[bestAxis] - cMin[bestAxis]);
+        uint32_t i = first, j = first + count;
+        while (i < j)
+        {
+            uint32_t t = bvh->triangles[i];
+            int b = (int)((centroids[t][bestAxis] - cMin[bestAxis]) * scale);
+            b = b < BVH_BINS ? b : BVH_BINS - 1;
+            if (b < bestSplit)
+                i++;
+            else
+            {
+                bvh->triangles[i] = bvh->triangles[--j];
+                bvh->triangles[j] = t;
+            }
+        }
+
+        // Children
+        uint32_t left = (uint32_t)bvh->numNodes;
+        bvh->numNodes += 2;
+        bvh->nodes[left].first = first;
+        bvh->nodes[left].count = i - first;
+        bvh->nodes[left + 1].first = i;
+        bvh->nodes[left + 1].count = first + count - i;
+        node->first = left;
+        node->count = 0;
+
+        stack[top][0] = left;
+        stack[top++][1] = depth + 1;
+        stack[top][0] = left + 1;
+        stack[top++][1] = depth + 1;
+    }
+
+    free(triMin);
+    free(triMax);
+    free(centroids);
+
+    return bvh;
+}
+
+void destroyBVH(BVH *bvh)
+{
+    if (!bvh)
+        return;
+
+    free(bvh->nodes);
+    free(bvh->triangles);
+    free(bvh);
+}
+
+void refitBVH(BVH *bvh, const Mesh *mesh)
+{
+    // Children always follow their parent, so a reverse sweep visits them first
+    for (size_t n = bvh->numNodes; n-- > 0;)
+    {
+        BVHNode *node = &bvh->nodes[n];
+
+        // Accumulate in locals (node bounds could alias vertex data as far as the compiler knows)
+        float min0 = FLT_MAX, min1 = FLT_MAX, min2 = FLT_MAX;
+        float max0 = -FLT_MAX, max1 = -FLT_MAX, max2 = -FLT_MAX;
+        if (node->count)
+        {
+            const uint32_t *triangles = &bvh->triangles[node->first];
+            for (uint32_t i = 0; i < node->count; i++)
+            {
+                const uint32_t *f = &mesh->indices[3 * triangles[i]];
+                for (int k = 0; k < 3; k++)
+                {
+                    const float *p = mesh->vertices[f[k]].position;
+                    min0 = p[0] < min0 ? p[0] : min0;
+                    min1 = p[1] < min1 ? p[1] : min1;
+                    min2 = p[2] < min2 ? p[2] : min2;
+                    max0 = p[0] > max0 ? p[0] : max0;
+                    max1 = p[1] > max1 ? p[1] : max1;
+                    max2 = p[2] > max2 ? p[2] : max2;
+                }
+            }
+        }
+        else
+        {
+            const BVHNode *left = &bvh->nodes[node->first], *right = left + 1;
+            min0 = glm_min(left->min[0], right->min[0]);
+            min1 = glm_min(left->min[1], right->min[1]);
+            min2 = glm_min(left->min[2], right->min[2]);
+            max0 = glm_max(left->max[0], right->max[0]);
+            max1 = glm_max(left->max[1], right->max[1]);
+            max2 = glm_max(left->max[2], right->max[2]);
+        }
+
+        node->min[0] = min0;
+        node->min[1] = min1;
+        node->min[2] = min2;
+        node->max[0] = max0;
+        node->max[1] = max1;
+        node->max[2] = max2;
+    }
+}
+
+/*
+ * Queries
+ */
+
+bool intersectTriangle(const Ray *ray, const vec3 v0, const vec3 v1, const vec3 v2, RayHit *hit)
+{
+    vec3 e1, e2, p, s, q;
+    glm_vec3_sub((float *)v1, (float *)v0, e1);
+    glm_vec3_sub((float *)v2, (float *)v0, e2);
+    glm_vec3_cross((float *)ray->direction, e2, p);
+
+    float det = glm_vec3_dot(e1, p);
+    if (fabsf(det) < FLT_EPSILON * FLT_EPSILON)
+        return false; // parallel
+    float invDet = 1.0f / det;
+
+    glm_vec3_sub((float *)ray->origin, (float *)v0, s);
+    float u = glm_vec3_dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    glm_vec3_cross(s, e1, q);
+    float v = glm_vec3_dot((float *)ray->direction, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    float t = glm_vec3_dot(e2, q) * invDet;
+    if (t < 0.0f)
+        return false;
+
+    hit->t = t;
+    hit->u = u;
+    hit->v = v;
+    return true;
+}
+
+bool intersectBVH(const BVH *bvh, const Mesh *mesh, const Ray *ray, RayHit *hit)
+{
+    vec3 invDir = {1.0f / ray->direction[0], 1.0f / ray->direction[1], 1.0f / ray->direction[2]};
+
+    hit->t = FLT_MAX;
+    bool found = false;
+
+    uint32_t stack[2 * BVH_MAX_DEPTH];
+    size_t top = 0;
+    if (intersectBounds(&bvh->nodes[0], ray, invDir, hit->t) != FLT_MAX)
+        stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const BVHNode *node = &bvh->nodes[stack[--top]];
+        if (node->count)
+        {
+            for (uint32_t i = node->first; i < node->first + node->count; i++)
+            {
+                uint32_t face = bvh->triangles[i];
+                const uint32_t *f = &mesh->indices[3 * face];
+
+                RayHit candidate;
+                if (intersectTriangle(ray,
+                                      mesh->vertices[f[0]].position,
+                                      mesh->vertices[f[1]].position,
+                                      mesh->vertices[f[2]].position,
+                                      &candidate) &&
+                    candidate.t < hit->t)
+                {
+                    *hit = candidate;
+                    hit->face = face;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        // Visit nearer child first
+        uint32_t near = node->first, far = node->first + 1;
+        float tNear = intersectBounds(&bvh->nodes[near], ray, invDir, hit->t);
+        float tFar = intersectBounds(&bvh->nodes[far], ray, invDir, hit->t);
+        if (tFar < tNear)
+        {
+            uint32_t temp = near;
+            near = far;
+            far = temp;
+            float tTemp = tNear;
+            tNear = tFar;
+            tFar = tTemp;
+        }
+        if (tFar != FLT_MAX)
+            stack[top++] = far;
+        if (tNear != FLT_MAX)
+            stack[top++] = near;
+    }
+
+    return found;
+}
+
+bool pickVertex(const BVH *bvh, const Mesh *mesh, const Ray *ray, uint32_t *vertex)
+{
+    RayHit hit;
+    if (!intersectBVH(bvh, mesh, ray, &hit))
+        return false;
+
+    // Vertex with largest barycentric weight
+    const uint32_t *f = &mesh->indices[3 * hit.face];
+    float w0 = 1.0f - hit.u - hit.v;
+    if (w0 >= hit.u && w0 >= hit.v)
+        *vertex = f[0];
+    else if (hit.u >= hit.v)
+        *vertex = f[1];
+    else
+        *vertex = f[2];
+
+    return true;
+}
@@ -0,0 +1,121 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "model.h"
+
+#include <cglm/cglm.h>
+
+#include <stdint.h>
+
+// Build settings
+#define BVH_BINS 16     // SAH candidate splits per axis
+#define BVH_LEAF_SIZE 4 // maximum triangles per leaf
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Ray in model space.
+ */
+typedef struct
+{
+    vec3 origin;    // start of ray
+    vec3 direction; // direction of ray (need not be normalized)
+} Ray;
+
+/**
+ * @brief Closest intersection of a ray with a mesh.
+ */
+typedef struct
+{
+    uint32_t face; // index of hit face
+    float t;       // distance along ray (in multiples of direction)
+    float u, v;    // barycentric coordinates of hit point (weights of face's 2nd and 3rd vertices)
+} RayHit;
+
+/**
+ * @brief Node of bounding volume hierarchy; children always follow their parent.
+ */
+typedef struct
+{
+    vec3 min, max;  // bounds
+    uint32_t first; // first triangle (leaf) or left child (inner node, right child is first + 1)
+    uint32_t count; // number of triangles (0 for inner nodes)
+} BVHNode;
+
+/**
+ * @brief Bounding volume hierarchy over mesh triangles.
+ *
+ * Topology is built once with the surface area heuristic; as the mesh deforms only the bounds are
+ * refit, which keeps queries correct at the cost of slowly degrading tree quality.
+ */
+struct BVH
+{
+    BVHNode *nodes;      // nodes (root first)
+    uint32_t *triangles; // face indices referenced by leaves
+    size_t numNodes;     // number of nodes
+};
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Builds bounding volume hierarchy over mesh's triangles using binned SAH.
+ *
+ * @param mesh Mesh to build hierarchy for.
+ * @return Initialized hierarchy.
+ */
+BVH *createBVH(const Mesh *mesh);
+
+/**
+ * @brief Destroys hierarchy and frees space.
+ *
+ * @param bvh Hierarchy to destroy (may be NULL).
+ */
+void destroyBVH(BVH *bvh);
+
+/**
+ * @brief Recomputes node bounds from current vertex positions, keeping topology.
+ *
+ * @param bvh  Hierarchy to refit.
+ * @param mesh Mesh hierarchy was built for.
+ */
+void refitBVH(BVH *bvh, const Mesh *mesh);
+
+/**
+ * @brief Finds closest intersection of ray with mesh.
+ *
+ * @param bvh  Hierarchy of mesh.
+ * @param mesh Mesh to intersect.
+ * @param ray  Ray in model space.
+ * @param hit  Destination of closest hit.
+ * @return True if ray hits mesh.
+ */
+bool intersectBVH(const BVH *bvh, const Mesh *mesh, const Ray *ray, RayHit *hit);
+
+/**
+ * @brief Intersects ray with a single triangle (Möller–Trumbore).
+ *
+ * @param ray Ray to intersect.
+ * @param v0  First vertex of triangle.
+ * @param v1  Second vertex of triangle.
+ * @param v2  Third vertex of triangle.
+ * @param hit Destination of hit (t, u, v only), written on success.
+ * @return True if ray hits triangle.
+ */
+bool intersectTriangle(const Ray *ray, const vec3 v0, const vec3 v1, const vec3 v2, RayHit *hit);
+
+/**
+ * @brief Picks the vertex closest to where a ray hits the mesh.
+ *
+ * @param bvh    Hierarchy of mesh.
+ * @param mesh   Mesh to pick from.
+ * @param ray    Ray in model space.
+ * @param vertex Destination of picked vertex index.
+ * @return True if ray hits mesh.
+ */
+bool pickVertex(const BVH *bvh, const Mesh *mesh, const Ray *ray, uint32_t *vertex);
+
+#endif
@@ -55,7 +55,7 @@ void updateCamera(GLFWwindow *window, Camera *camera, mat4 pDest, mat4 vDest)
     if (lastTime == 0.0)
         lastTime = glfwGetTime();
     double currentTime = glfwGetTime();
-    float deltaTime = (float)(currentTime - lastTime);
+    float deltaTime = glm_min((float)(currentTime - lastTime), MAX_DELTA_TIME);
 
     // Get mouse position
     double xpos, ypos;
@@ -134,50 +134,81 @@ void updateCamera(GLFWwindow *window, Camera *camera, mat4 pDest, mat4 vDest)
     lastTime = currentTime; // update last time taken
 }
 
-void updateRotationCamera(GLFWwindow *window, Camera *camera, Model *model, mat4 pDest, mat4 vDest)
+void orbitCamera(Camera *camera, vec3 target, float radius, double time, float aspect, mat4 pDest, mat4 vDest)
 {
-    static float radius = INIT_RADIUS; // init radius
-
-    // Calculate change in time
-    static double lastTime = 0.0;
-    if (lastTime == 0.0)
-        lastTime = glfwGetTime();
-    double currentTime = glfwGetTime();
-    float deltaTime = (float)(currentTime - lastTime);
-
     // Stabilize camera
     camera->pitch = 0.0f;
     camera->yaw = 0.0f;
 
-    // Rotate camera
-    glm_vec3_add(model->position, (vec3){radius * cos(currentTime / 4.0f), 1.0f, radius * sin(currentTime / 4.0f)}, camera->position);
+    // Circle target once every 8 pi seconds, slightly above it
+    glm_vec3_add(target, (vec3){radius * cos(time / 4.0f), 1.0f, radius * sin(time / 4.0f)}, camera->position);
     updateVectors(camera); // compute front, right, and up
 
-    // Zoom movement
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) // in
-        radius -= ZOOM_SPEED * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) // out
-        radius += ZOOM_SPEED * deltaTime;
-
-    // Clamp zoom
-    if (radius < 0.001f)
-        radius = 0.001f;
-
     mat4 projection, view; // projection matrix, camera matrix
 
     glm_perspective(glm_rad(camera->fov), // fov
-                    ASPECT_RATIO,         // aspect ratio
+                    aspect,               // aspect ratio
                     NEAR_Z,               // near value
                     FAR_Z,                // far value
                     projection);          // destination
     glm_lookat(camera->position,          // camera position (world space)
-               model->position,           // direction
+               target,                    // direction
                camera->up,                // up
                view);                     // destination
 
     // Copy over matrices
     glm_mat4_copy(projection, pDest);
     glm_mat4_copy(view, vDest);
+}
+
+void updateRotationCamera(GLFWwindow *window, Camera *camera, vec3 target, mat4 pDest, mat4 vDest)
+{
+    static float radius = INIT_RADIUS; // init radius
+
+    // Calculate change in time
+    static double lastTime = 0.0;
+    if (lastTime == 0.0)
+        lastTime = glfwGetTime();
+    double currentTime = glfwGetTime();
+    float deltaTime = glm_min((float)(currentTime - lastTime), MAX_DELTA_TIME);
+
+    // Rotate camera
+    orbitCamera(camera, target, radius, currentTime, ASPECT_RATIO, pDest, vDest);
+
+    // Zoom movement
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) // in
+        radius -= ZOOM_SPEED * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) // out
+        radius += ZOOM_SPEED * deltaTime;
+
+    // Clamp zoom
+    if (radius < 0.001f)
+        radius = 0.001f;
 
     lastTime = currentTime;
+}
+
+void computeCameraRay(GLFWwindow *window, mat4 p, mat4 v, mat4 m, double x, double y, Ray *dest)
+{
+    // Window position to normalized device coordinates
+    int winWidth, winHeight;
+    glfwGetWindowSize(window, &winWidth, &winHeight);
+    float ndcX = 2.0f * (float)x / winWidth - 1.0f;
+    float ndcY = 1.0f - 2.0f * (float)y / winHeight;
+
+    // Inverse MVP
+    mat4 mvp, inverse;
+    glm_mat4_mul(p, v, mvp);
+    glm_mat4_mul(mvp, m, mvp);
+    glm_mat4_inv(mvp, inverse);
+
+    // Unproject near and far plane points
+    vec4 nearPoint, farPoint;
+    glm_mat4_mulv(inverse, (vec4){ndcX, ndcY, -1.0f, 1.0f}, nearPoint);
+    glm_mat4_mulv(inverse, (vec4){ndcX, ndcY, 1.0f, 1.0f}, farPoint);
+    glm_vec4_scale(nearPoint, 1.0f / nearPoint[3], nearPoint);
+    glm_vec4_scale(farPoint, 1.0f / farPoint[3], farPoint);
+
+    glm_vec3(nearPoint, dest->origin);
+    glm_vec3_sub(farPoint, nearPoint, dest->direction);
 }
\ No newline at end of file
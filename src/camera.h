@@ -5,6 +5,7 @@
 #include <GLFW/glfw3.h>
 
 #include "model.h"
+#include "bvh.h"
 
 #include <cglm/cglm.h>
 
@@ -23,6 +24,7 @@
 #define MOVEMENT_SPEED 0.1f      // camera movement speed increment
 #define MOUSE_SPEED 0.0025f      // turn / look increment
 #define ZOOM_SPEED 5.0f          // change of radius increment (rotate mode)
+#define MAX_DELTA_TIME 0.1f      // longest time step of movement (first frame after waiting for events)
 
 // Other settings
 #define ASPECT_RATIO 4.0f / 3.0f // camera aspect ratio
@@ -78,14 +80,42 @@ void updateVectors(Camera *camera);
 void updateCamera(GLFWwindow *window, Camera *camera, mat4 pDest, mat4 vDest);
 
 /**
- * @brief Recomputes VP based on user input, time, and model info.
+ * @brief Places camera on its orbit around a target at a given time (the path of the rotate camera mode).
+ *
+ * Needs no window, so headless renders can follow the same path.
+ *
+ * @param camera Camera to place.
+ * @param target Point orbited (world space).
+ * @param radius Distance from target (horizontally).
+ * @param time   Time along orbit (seconds).
+ * @param aspect Aspect ratio of image.
+ * @param pDest  Destination of projection matrix.
+ * @param vDest  Destination of view matrix.
+ */
+void orbitCamera(Camera *camera, vec3 target, float radius, double time, float aspect, mat4 pDest, mat4 vDest);
+
+/**
+ * @brief Recomputes VP based on user input, time, and the point to rotate around.
  *
  * @param window GLFW window.
  * @param camera Camera to update and read from.
- * @param model  Model to rotate around.
+ * @param target Point to rotate around (e.g. center of scene).
  * @param pDest  Mat4 to output projection matrix to.
  * @param vDest  Mat4 to ouput view matrix to.
  */
-void updateRotationCamera(GLFWwindow *window, Camera *camera, Model *model, mat4 pDest, mat4 vDest);
+void updateRotationCamera(GLFWwindow *window, Camera *camera, vec3 target, mat4 pDest, mat4 vDest);
+
+/**
+ * @brief Computes the ray through a window position, in model space.
+ *
+ * @param window GLFW window.
+ * @param p      Projection matrix.
+ * @param v      View matrix.
+ * @param m      Model matrix.
+ * @param x      Horizontal window position (e.g. of cursor).
+ * @param y      Vertical window position (e.g. of cursor).
+ * @param dest   Destination ray.
+ */
+void computeCameraRay(GLFWwindow *window, mat4 p, mat4 v, mat4 m, double x, double y, Ray *dest);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,442 @@
+#include "checkpoint.h"
+#include "scene.h"
+#include "model.h"
+#include "selection.h"
+#include "ricci.h"
+#include "willmore.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Snapshots
+ */
+
+// Growable byte buffer a snapshot is serialized into
+typedef struct
+{
+    unsigned char *data;
+    size_t size, capacity;
+} Buffer;
+
+// Cursor over a checkpoint file's bytes
+typedef struct
+{
+    const unsigned char *data;
+    size_t size, offset;
+} Reader;
+
+static void put(Buffer *buffer, const void *source, size_t bytes)
+{
+    if (buffer->size + bytes > buffer->capacity)
+    {
+        buffer->capacity = buffer->size + bytes > 2 * buffer->capacity ? buffer->size + bytes : 2 * buffer->capacity;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+    if (bytes)
+        memcpy(buffer->data + buffer->size, source, bytes);
+    buffer->size += bytes;
+}
+
+static void putCount(Buffer *buffer, size_t count)
+{
+    uint64_t value = count;
+    put(buffer, &value, sizeof(value));
+}
+
+static bool take(Reader *reader, void *dest, size_t bytes)
+{
+    if (bytes > reader->size - reader->offset)
+        return false;
+    memcpy(dest, reader->data + reader->offset, bytes);
+    reader->offset += bytes;
+    return true;
+}
+
+static bool takeCount(Reader *reader, size_t *count)
+{
+    uint64_t value;
+    if (!take(reader, &value, sizeof(value)) || value > SIZE_MAX)
+        return false;
+    *count = (size_t)value;
+    return true;
+}
+
+// Reads count elements into a new array (NULL if the file is too short)
+static void *takeArray(Reader *reader, size_t count, size_t size)
+{
+    if (count > (reader->size - reader->offset) / size)
+        return NULL;
+    void *array = malloc(count ? count * size : 1);
+    take(reader, array, count * size);
+    return array;
+}
+
+// Values of a sparse matrix (its pattern follows from the mesh)
+static void putMatrix(Buffer *buffer, const SparseMatrix *matrix)
+{
+    putCount(buffer, matrix->numValues);
+    put(buffer, matrix->values, matrix->numValues * sizeof(double));
+}
+
+static bool takeMatrix(Reader *reader, SparseMatrix *matrix)
+{
+    size_t numValues;
+    return takeCount(reader, &numValues) && numValues == matrix->numValues &&
+           take(reader, matrix->values, numValues * sizeof(double));
+}
+
+// Serializes everything a model's flow reads from one step to the next
+static void putEntry(Buffer *buffer, const SceneEntry *entry)
+{
+    const Mesh *mesh = entry->model->mesh;
+    uint32_t flow = entry->flow;
+    uint8_t flowing = entry->flowing;
+    put(buffer, &flow, sizeof(flow));
+    put(buffer, &flowing, sizeof(flowing));
+    putCount(buffer, entry->steps);
+    putCount(buffer, entry->maxSteps);
+    put(buffer, &entry->time, sizeof(entry->time));
+
+    // Geometry (adjacency is rebuilt from faces)
+    putCount(buffer, mesh->numVertices);
+    putCount(buffer, mesh->numIndices);
+    put(buffer, mesh->vertices, mesh->numVertices * sizeof(Vertex));
+    put(buffer, mesh->indices, mesh->numIndices * sizeof(uint32_t));
+    put(buffer, mesh->areas, mesh->numVertices * sizeof(float));
+    put(buffer, mesh->faceNormals, mesh->numIndices / 3 * sizeof(vec3));
+
+    // Precision (double positions carry what the float ones rounded away)
+    uint8_t precision = mesh->precision, hasPrecise = mesh->precision == PRECISION_DOUBLE && mesh->precise;
+    put(buffer, &precision, sizeof(precision));
+    put(buffer, &hasPrecise, sizeof(hasPrecise));
+    if (hasPrecise)
+        put(buffer, mesh->precise, mesh->numVertices * sizeof(*mesh->precise));
+
+    // Selected vertices in selection order (halo and faces follow from them)
+    size_t numActive = mesh->selection ? mesh->selection->numActive : 0;
+    putCount(buffer, numActive);
+    put(buffer, numActive ? mesh->selection->active : NULL, numActive * sizeof(uint32_t));
+
+    // Ricci flow (metric and progress; everything else is recomputed every step)
+    uint8_t hasRicci = mesh->ricci != NULL;
+    put(buffer, &hasRicci, sizeof(hasRicci));
+    if (hasRicci)
+    {
+        const Ricci *ricci = mesh->ricci;
+        uint8_t progress = (uint8_t)(ricci->converged | ricci->stalled << 1); // converged in bit 0, stalled in bit 1
+        putCount(buffer, ricci->numEdges);
+        putCount(buffer, ricci->iterations);
+        put(buffer, &ricci->error, sizeof(ricci->error));
+        put(buffer, &ricci->norm, sizeof(ricci->norm));
+        put(buffer, &progress, sizeof(progress));
+        put(buffer, ricci->u, mesh->numVertices * sizeof(double));
+        put(buffer, ricci->target, mesh->numVertices * sizeof(double));
+        put(buffer, ricci->inversive, ricci->numEdges * sizeof(double));
+    }
+
+    // Willmore flow (operator as last refreshed, which may lag behind current positions)
+    uint8_t hasWillmore = mesh->willmore != NULL;
+    put(buffer, &hasWillmore, sizeof(hasWillmore));
+    if (hasWillmore)
+    {
+        const Willmore *willmore = mesh->willmore;
+        put(buffer, &willmore->timeStep, sizeof(willmore->timeStep));
+        putCount(buffer, willmore->steps);
+        put(buffer, willmore->mass, mesh->numVertices * sizeof(double));
+        putMatrix(buffer, willmore->laplacian);
+        putMatrix(buffer, willmore->system);
+        putMatrix(buffer, willmore->factor);
+        uint8_t factored = willmore->factored;
+        put(buffer, &factored, sizeof(factored));
+    }
+}
+
+// Rebuilds a model and its flow state (NULL if the data is invalid)
+static Model *takeEntry(Reader *reader, SceneEntry *state)
+{
+    uint32_t flow;
+    uint8_t flowing;
+    if (!take(reader, &flow, sizeof(flow)) || flow > WILLMORE || !take(reader, &flowing, sizeof(flowing)) ||
+        !takeCount(reader, &state->steps) || !takeCount(reader, &state->maxSteps) || !take(reader, &state->time, sizeof(state->time)))
+        return NULL;
+    state->flow = (GEOMETRIC_FLOW)flow;
+    state->flowing = flowing;
+
+    // Geometry (every pointer starts out NULL, so a partial mesh can be destroyed)
+    Mesh *mesh = calloc(1, sizeof(Mesh));
+    bool valid = takeCount(reader, &mesh->numVertices) && takeCount(reader, &mesh->numIndices) && mesh->numIndices % 3 == 0 &&
+                 mesh->numVertices <= UINT32_MAX &&
+                 (mesh->vertices = takeArray(reader, mesh->numVertices, sizeof(Vertex))) &&
+                 (mesh->indices = takeArray(reader, mesh->numIndices, sizeof(uint32_t))) &&
+                 (mesh->areas = takeArray(reader, mesh->numVertices, sizeof(float))) &&
+                 (mesh->faceNormals = takeArray(reader, mesh->numIndices / 3, sizeof(vec3)));
+    for (size_t i = 0; valid && i < mesh->numIndices; i++)
+        valid = mesh->indices[i] < mesh->numVertices;
+    if (valid)
+        buildAdjacency(mesh);
+
+    // Precision
+    uint8_t precision = 0, hasPrecise = 0;
+    valid = valid && take(reader, &precision, sizeof(precision)) && precision <= PRECISION_DOUBLE &&
+            take(reader, &hasPrecise, sizeof(hasPrecise)) &&
+            (!hasPrecise || (mesh->precise = takeArray(reader, mesh->numVertices, sizeof(*mesh->precise))));
+    mesh->precision = (PRECISION)precision;
+
+    // Selection
+    size_t numActive = 0;
+    uint32_t *active = NULL;
+    valid = valid && takeCount(reader, &numActive) && (active = takeArray(reader, numActive, sizeof(uint32_t)));
+    for (size_t i = 0; valid && i < numActive; i++)
+        valid = active[i] < mesh->numVertices;
+    for (size_t i = 0; valid && i < numActive; i++)
+        selectVertex(mesh, active[i]);
+    if (valid && numActive)
+        updateSelection(mesh);
+    free(active);
+
+    // Ricci flow (static data is rebuilt from the mesh, then overwritten by what it was built from originally)
+    uint8_t hasRicci = 0;
+    valid = valid && take(reader, &hasRicci, sizeof(hasRicci));
+    if (valid && hasRicci)
+    {
+        Ricci *ricci = mesh->ricci = createRicci(mesh);
+        size_t numEdges;
+        uint8_t progress = 0;
+        valid = takeCount(reader, &numEdges) && numEdges == ricci->numEdges && takeCount(reader, &ricci->iterations) &&
+                take(reader, &ricci->error, sizeof(ricci->error)) && take(reader, &ricci->norm, sizeof(ricci->norm)) &&
+                take(reader, &progress, sizeof(progress)) &&
+                take(reader, ricci->u, mesh->numVertices * sizeof(double)) &&
+                take(reader, ricci->target, mesh->numVertices * sizeof(double)) &&
+                take(reader, ricci->inversive, numEdges * sizeof(double));
+        ricci->converged = progress & 1;
+        ricci->stalled = progress >> 1 & 1;
+    }
+
+    // Willmore flow
+    uint8_t hasWillmore = 0;
+    valid = valid && take(reader, &hasWillmore, sizeof(hasWillmore));
+    if (valid && hasWillmore)
+    {
+        Willmore *willmore = mesh->willmore = createWillmore(mesh);
+        uint8_t factored = 0;
+        valid = take(reader, &willmore->timeStep, sizeof(willmore->timeStep)) && takeCount(reader, &willmore->steps) &&
+                take(reader, willmore->mass, mesh->numVertices * sizeof(double)) &&
+                takeMatrix(reader, willmore->laplacian) && takeMatrix(reader, willmore->system) &&
+                takeMatrix(reader, willmore->factor) && take(reader, &factored, sizeof(factored));
+        willmore->factored = factored;
+    }
+
+    if (!valid)
+    {
+        destroyMesh(mesh);
+        return NULL;
+    }
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+    return createModel(mesh);
+}
+
+/*
+ * Writing
+ */
+
+// Writes data to a temporary file and renames it over filename
+static bool writeFile(const char *filename, const unsigned char *data, size_t size)
+{
+    size_t length = strlen(filename);
+    char *temporary = malloc(length + 5);
+    memcpy(temporary, filename, length);
+    memcpy(temporary + length, ".tmp", 5);
+
+    FILE *file = fopen(temporary, "wb");
+    bool written = file && fwrite(data, 1, size, file) == size;
+    written &= file && !fclose(file);
+    if (written && rename(temporary, filename))
+    {
+        // Windows refuses to rename over an existing file
+        remove(filename);
+        written = !rename(temporary, filename);
+    }
+    if (!written)
+    {
+        fprintf(stderr, "Error writing checkpoint: %s\n", filename);
+        remove(temporary);
+    }
+
+    free(temporary);
+    return written;
+}
+
+static void *checkpointMain(void *argument)
+{
+    Checkpointer *checkpointer = argument;
+    pthread_mutex_lock(&checkpointer->lock);
+    while (true)
+    {
+        while (!checkpointer->pending && !checkpointer->stopping)
+            pthread_cond_wait(&checkpointer->wake, &checkpointer->lock);
+        if (!checkpointer->pending)
+            break;
+
+        // Write without holding the lock, so newer snapshots can be queued meanwhile
+        unsigned char *data = checkpointer->pending;
+        size_t size = checkpointer->pendingSize;
+        checkpointer->pending = NULL;
+        checkpointer->writing = true;
+        pthread_mutex_unlock(&checkpointer->lock);
+
+        bool written = writeFile(checkpointer->filename, data, size);
+        free(data);
+
+        pthread_mutex_lock(&checkpointer->lock);
+        checkpointer->writing = false;
+        checkpointer->numWritten += written;
+        if (!checkpointer->pending)
+            pthread_cond_broadcast(&checkpointer->idle);
+    }
+    pthread_mutex_unlock(&checkpointer->lock);
+
+    return NULL;
+}
+
+Checkpointer *createCheckpointer(const char *filename)
+{
+    Checkpointer *checkpointer = malloc(sizeof(Checkpointer));
+    size_t length = strlen(filename) + 1;
+    checkpointer->filename = malloc(length);
+    memcpy(checkpointer->filename, filename, length);
+    checkpointer->pending = NULL;
+    checkpointer->pendingSize = 0;
+    checkpointer->writing = checkpointer->stopping = false;
+    checkpointer->numWritten = 0;
+
+    pthread_mutex_init(&checkpointer->lock, NULL);
+    pthread_cond_init(&checkpointer->wake, NULL);
+    pthread_cond_init(&checkpointer->idle, NULL);
+    pthread_create(&checkpointer->thread, NULL, checkpointMain, checkpointer);
+
+    return checkpointer;
+}
+
+void destroyCheckpointer(Checkpointer *checkpointer)
+{
+    if (!checkpointer)
+        return;
+
+    // Writer drains what is pending before it exits
+    pthread_mutex_lock(&checkpointer->lock);
+    checkpointer->stopping = true;
+    pthread_cond_signal(&checkpointer->wake);
+    pthread_mutex_unlock(&checkpointer->lock);
+    pthread_join(checkpointer->thread, NULL);
+
+    pthread_mutex_destroy(&checkpointer->lock);
+    pthread_cond_destroy(&checkpointer->wake);
+    pthread_cond_destroy(&checkpointer->idle);
+    free(checkpointer->filename);
+    free(checkpointer);
+}
+
+void saveCheckpoint(Checkpointer *checkpointer, const Scene *scene)
+{
+    // Snapshot on the calling thread (a copy, so flows may move on as soon as this returns)
+    Buffer buffer = {NULL, 0, 0};
+    uint32_t version = CHECKPOINT_VERSION;
+    put(&buffer, CHECKPOINT_MAGIC, 4);
+    put(&buffer, &version, sizeof(version));
+    putCount(&buffer, scene->numEntries);
+    for (size_t i = 0; i < scene->numEntries; i++)
+        putEntry(&buffer, &scene->entries[i]);
+
+    // Queue it, superseding a snapshot the writer hasn't started on
+    pthread_mutex_lock(&checkpointer->lock);
+    free(checkpointer->pending);
+    checkpointer->pending = buffer.data;
+    checkpointer->pendingSize = buffer.size;
+    pthread_cond_signal(&checkpointer->wake);
+    pthread_mutex_unlock(&checkpointer->lock);
+}
+
+void flushCheckpoint(Checkpointer *checkpointer)
+{
+    pthread_mutex_lock(&checkpointer->lock);
+    while (checkpointer->pending || checkpointer->writing)
+        pthread_cond_wait(&checkpointer->idle, &checkpointer->lock);
+    pthread_mutex_unlock(&checkpointer->lock);
+}
+
+/*
+ * Restoring
+ */
+
+bool restoreCheckpoint(Scene *scene, const char *filename, size_t maxSteps)
+{
+    // Whole file at once
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char *data = size > 0 ? malloc((size_t)size) : NULL;
+    bool read = data && fread(data, 1, (size_t)size, file) == (size_t)size;
+    fclose(file);
+
+    Reader reader = {data, read ? (size_t)size : 0, 0};
+    char magic[4];
+    uint32_t version;
+    size_t numModels;
+    if (!take(&reader, magic, 4) || memcmp(magic, CHECKPOINT_MAGIC, 4) || !take(&reader, &version, sizeof(version)) ||
+        version != CHECKPOINT_VERSION || !takeCount(&reader, &numModels) || numModels > reader.size)
+    {
+        fprintf(stderr, "Error reading checkpoint: %s\n", filename);
+        free(data);
+        return false;
+    }
+
+    // Models are only added once all of them were read, so a bad file leaves the scene as it was
+    Model **models = malloc((numModels ? numModels : 1) * sizeof(Model *));
+    SceneEntry *states = malloc((numModels ? numModels : 1) * sizeof(SceneEntry));
+    size_t numRead = 0;
+    while (numRead < numModels && (models[numRead] = takeEntry(&reader, &states[numRead])))
+        numRead++;
+    free(data);
+
+    bool restored = numRead == numModels && reader.offset == reader.size;
+    if (restored)
+    {
+        clearScene(scene);
+        for (size_t i = 0; i < numModels; i++)
+        {
+            SceneEntry *entry = addModel(scene, models[i], states[i].flow);
+            entry->flowing = states[i].flowing;
+            entry->steps = states[i].steps;
+            entry->maxSteps = maxSteps ? maxSteps : states[i].maxSteps;
+            entry->time = states[i].time;
+
+            // A given step limit replaces the file's: flows stopped at the old limit go on, and ones past it stop
+            if (maxSteps && maxSteps != states[i].maxSteps)
+            {
+                if (states[i].maxSteps && entry->steps >= states[i].maxSteps)
+                    entry->flowing = true;
+                entry->flowing &= entry->steps < maxSteps;
+                if (i == 0)
+                    printf("%s: running to %zu steps instead of the checkpoint's %zu\n", filename, maxSteps,
+                           states[i].maxSteps);
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "Error reading checkpoint: %s\n", filename);
+        for (size_t i = 0; i < numRead; i++)
+            destroyModel(models[i]);
+    }
+
+    free(models);
+    free(states);
+    return restored;
+}
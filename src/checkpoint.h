@@ -0,0 +1,89 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "scene.h"
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Checkpoint settings
+#define CHECKPOINT_MAGIC "GFCK"   // first bytes of every checkpoint file
+#define CHECKPOINT_VERSION 3      // format version (files of other versions are rejected)
+#define CHECKPOINT_INTERVAL 100   // default steps between checkpoints
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Background thread writing checkpoints of a scene to one file.
+ *
+ * A checkpoint is a compact binary snapshot of every model's flow state: vertices, faces, precision
+ * (with double positions), selection, step count and flow time, and the solver state of Ricci and
+ * Willmore flows. Saving only copies that
+ * state into a buffer, so the flow keeps running while the thread writes the buffer out. Files are
+ * written next to their destination and renamed over it, so a crash mid-write leaves the previous
+ * checkpoint intact. Values are stored as raw native (little-endian IEEE) bytes, which makes restored
+ * flows continue bit for bit as if they had never stopped.
+ */
+typedef struct
+{
+    pthread_t thread;         // writing thread
+    pthread_mutex_t lock;     // guards everything below
+    pthread_cond_t wake;      // signaled when a snapshot is queued or the writer should stop
+    pthread_cond_t idle;      // signaled when the writer has nothing left to write
+    char *filename;           // checkpoint file (copy)
+    unsigned char *pending;   // snapshot waiting to be written (NULL for none)
+    size_t pendingSize;       // bytes of pending snapshot
+    bool writing;             // whether a snapshot is being written
+    bool stopping;            // whether writer should exit once nothing is pending
+    size_t numWritten;        // checkpoints written successfully
+} Checkpointer;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Starts a thread writing checkpoints to a file.
+ *
+ * @param filename Checkpoint file.
+ * @return Checkpointer (idle).
+ */
+Checkpointer *createCheckpointer(const char *filename);
+
+/**
+ * @brief Finishes any pending write, stops the thread, and frees space.
+ *
+ * @param checkpointer Checkpointer to destroy (may be NULL).
+ */
+void destroyCheckpointer(Checkpointer *checkpointer);
+
+/**
+ * @brief Snapshots scene and queues the snapshot for writing (replacing one still waiting, if any).
+ *
+ * @param checkpointer Checkpointer to write with.
+ * @param scene        Scene to snapshot (not stepping).
+ */
+void saveCheckpoint(Checkpointer *checkpointer, const Scene *scene);
+
+/**
+ * @brief Waits until every queued snapshot has been written.
+ *
+ * @param checkpointer Checkpointer to wait for.
+ */
+void flushCheckpoint(Checkpointer *checkpointer);
+
+/**
+ * @brief Replaces scene's models by those of a checkpoint file, in the state they were saved in.
+ *
+ * @param scene    Scene to restore into (left untouched if the file cannot be read).
+ * @param filename Checkpoint file.
+ * @param maxSteps Steps after which flows stop, replacing the file's limit (0 keeps the file's).
+ * @return True if checkpoint was restored.
+ */
+bool restoreCheckpoint(Scene *scene, const char *filename, size_t maxSteps);
+
+#endif
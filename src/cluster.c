@@ -0,0 +1,1081 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE // madvise
+#endif
+
+#include "cluster.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Mapping
+ */
+
+// Maps filename for reading and writing (NULL if it cannot be opened or is empty)
+static unsigned char *mapFile(const char *filename, size_t *size, void **mapping)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER length;
+    HANDLE view = NULL;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0)
+        view = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, 0, NULL);
+    CloseHandle(file);
+    if (!view)
+        return NULL;
+    unsigned char *base = MapViewOfFile(view, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!base)
+    {
+        CloseHandle(view);
+        return NULL;
+    }
+    *size = (size_t)length.QuadPart;
+    *mapping = view;
+    return base;
+#else
+    int file = open(filename, O_RDWR);
+    if (file < 0)
+        return NULL;
+    struct stat status;
+    void *base = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+        base = mmap(NULL, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (base == MAP_FAILED)
+        return NULL;
+    *size = (size_t)status.st_size;
+    *mapping = NULL;
+    return base;
+#endif
+}
+
+// Writes back and unmaps a mapped file
+static void unmapFile(unsigned char *base, size_t size, void *mapping)
+{
+#ifdef _WIN32
+    FlushViewOfFile(base, 0);
+    UnmapViewOfFile(base);
+    CloseHandle(mapping);
+    (void)size;
+#else
+    msync(base, size, MS_SYNC);
+    munmap(base, size);
+    (void)mapping;
+#endif
+}
+
+// Widens [offset, offset + bytes) of a mapping to whole pages
+static void pageRange(size_t offset, size_t bytes, size_t *begin, size_t *length)
+{
+#ifdef _WIN32
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    size_t page = system.dwPageSize;
+#else
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    *begin = offset / page * page;
+    *length = (offset + bytes + page - 1) / page * page - *begin;
+}
+
+// Hints that a range of the mapping is about to be read
+static void prefetchPages(ClusteredMesh *clustered, size_t offset, size_t bytes)
+{
+    size_t begin, length;
+    pageRange(offset, bytes, &begin, &length);
+#ifdef _WIN32
+    WIN32_MEMORY_RANGE_ENTRY range = {clustered->base + begin, length};
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    madvise(clustered->base + begin, length, MADV_WILLNEED);
+#endif
+}
+
+// Drops a range of the mapping from resident memory (the file keeps its contents, and pages that are still
+// needed, such as ones shared with a neighboring range, are simply read back in)
+static void releasePages(ClusteredMesh *clustered, size_t offset, size_t bytes)
+{
+    size_t begin, length;
+    pageRange(offset, bytes, &begin, &length);
+#ifdef _WIN32
+    VirtualUnlock(clustered->base + begin, length);
+#else
+    msync(clustered->base + begin, length, MS_ASYNC);
+    madvise(clustered->base + begin, length, MADV_DONTNEED);
+#endif
+}
+
+/*
+ * Writing
+ */
+
+// Vertex and its position along the Morton curve
+typedef struct
+{
+    uint64_t code;
+    uint32_t vertex;
+} MortonKey;
+
+static int compareKeys(const void *a, const void *b)
+{
+    const MortonKey *x = a, *y = b;
+    if (x->code != y->code)
+        return x->code < y->code ? -1 : 1;
+    return (x->vertex > y->vertex) - (x->vertex < y->vertex);
+}
+
+static int compareIndices(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Spreads the low MORTON_BITS bits of value three bits apart
+static uint64_t spreadBits(uint64_t value)
+{
+    value &= (1ull << MORTON_BITS) - 1;
+    value = (value | value << 32) & 0x1f00000000ffffull;
+    value = (value | value << 16) & 0x1f0000ff0000ffull;
+    value = (value | value << 8) & 0x100f00f00f00f00full;
+    value = (value | value << 4) & 0x10c30c30c30c30c3ull;
+    value = (value | value << 2) & 0x1249249249249249ull;
+    return value;
+}
+
+// Position along the Morton curve over the box [lower, upper]
+static uint64_t mortonCode(const float *position, const float *lower, const float *upper)
+{
+    float cells = (float)((1u << MORTON_BITS) - 1);
+    uint64_t code = 0;
+    for (int d = 0; d < 3; d++)
+    {
+        float extent = upper[d] - lower[d];
+        float cell = extent > 0.0f ? (position[d] - lower[d]) / extent * cells : 0.0f;
+        code |= spreadBits((uint64_t)cell) << d;
+    }
+    return code;
+}
+
+// Clustered index of every vertex: vertex 0 first, then the others along a Morton curve over the bounding box
+static uint32_t *orderVertices(const Mesh *mesh)
+{
+    vec3 lower = {INFINITY, INFINITY, INFINITY}, upper = {-INFINITY, -INFINITY, -INFINITY};
+    for (size_t v = 1; v < mesh->numVertices; v++)
+    {
+        glm_vec3_minv(lower, mesh->vertices[v].position, lower);
+        glm_vec3_maxv(upper, mesh->vertices[v].position, upper);
+    }
+
+    MortonKey *keys = malloc((mesh->numVertices ? mesh->numVertices : 1) * sizeof(MortonKey));
+    for (size_t v = 1; v < mesh->numVertices; v++)
+        keys[v - 1] = (MortonKey){mortonCode(mesh->vertices[v].position, lower, upper), (uint32_t)v};
+    size_t count = mesh->numVertices ? mesh->numVertices - 1 : 0;
+    qsort(keys, count, sizeof(MortonKey), compareKeys);
+
+    uint32_t *renumber = malloc((mesh->numVertices ? mesh->numVertices : 1) * sizeof(uint32_t));
+    renumber[0] = 0;
+    for (size_t i = 0; i < count; i++)
+        renumber[keys[i].vertex] = (uint32_t)i + 1;
+    free(keys);
+    return renumber;
+}
+
+// Sorts indices and drops repeats, returning how many are left
+static size_t sortUnique(uint32_t *indices, size_t count)
+{
+    qsort(indices, count, sizeof(uint32_t), compareIndices);
+    size_t unique = 0;
+    for (size_t i = 0; i < count; i++)
+        if (!unique || indices[i] != indices[unique - 1])
+            indices[unique++] = indices[i];
+    return unique;
+}
+
+// Mesh of faces with an owned corner given their corners' clustered indices: owned vertices first, then halo vertices
+// (ascending, returned in halo), with faces in local numbering and adjacency built but positions left at zero
+static Mesh *assembleCluster(const uint32_t *corners, size_t numFaces, size_t begin, size_t end, uint32_t **halo,
+                             size_t *numHalo)
+{
+    // Halo vertices (in new order), numbered after owned vertices
+    *halo = malloc((numFaces ? 3 * numFaces : 1) * sizeof(uint32_t));
+    *numHalo = 0;
+    for (size_t i = 0; i < 3 * numFaces; i++)
+        if (corners[i] < begin || corners[i] >= end)
+            (*halo)[(*numHalo)++] = corners[i];
+    *numHalo = sortUnique(*halo, *numHalo);
+
+    // Faces in local numbering, and their adjacency
+    Mesh *cluster = calloc(1, sizeof(Mesh));
+    size_t numOwned = end - begin;
+    cluster->numVertices = numOwned + *numHalo;
+    cluster->numIndices = 3 * numFaces;
+    cluster->vertices = calloc(cluster->numVertices ? cluster->numVertices : 1, sizeof(Vertex));
+    cluster->indices = malloc((cluster->numIndices ? cluster->numIndices : 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < cluster->numIndices; i++)
+    {
+        uint32_t v = corners[i];
+        if (v >= begin && v < end)
+            cluster->indices[i] = (uint32_t)(v - begin);
+        else
+        {
+            const uint32_t *found = bsearch(&v, *halo, *numHalo, sizeof(uint32_t), compareIndices);
+            cluster->indices[i] = (uint32_t)(numOwned + (size_t)(found - *halo));
+        }
+    }
+    buildAdjacency(cluster);
+    cluster->areas = calloc(cluster->numVertices ? cluster->numVertices : 1, sizeof(float));
+    cluster->faceNormals = calloc(numFaces ? numFaces : 1, sizeof(vec3));
+    cluster->dirtyEnd = cluster->numVertices;
+    return cluster;
+}
+
+Mesh *cutCluster(const Mesh *mesh, const uint32_t *renumber, const uint32_t *original, size_t begin, size_t end,
+                 uint32_t **halo, size_t *numHalo)
+{
+    // Faces with an owned corner, in the whole mesh's order
+    size_t count = 0;
+    for (size_t v = begin; v < end; v++)
+        count += mesh->faceOffsets[original[v] + 1] - mesh->faceOffsets[original[v]];
+    uint32_t *faces = malloc((count ? count : 1) * sizeof(uint32_t));
+    count = 0;
+    for (size_t v = begin; v < end; v++)
+        for (uint32_t i = mesh->faceOffsets[original[v]]; i < mesh->faceOffsets[original[v] + 1]; i++)
+            faces[count++] = mesh->faces[i];
+    count = sortUnique(faces, count);
+
+    uint32_t *corners = malloc((count ? 3 * count : 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < 3 * count; i++)
+        corners[i] = renumber[mesh->indices[3 * faces[i / 3] + i % 3]];
+    Mesh *cluster = assembleCluster(corners, count, begin, end, halo, numHalo);
+    free(corners);
+    free(faces);
+
+    // Owned then halo positions
+    size_t numOwned = end - begin;
+    for (size_t i = 0; i < cluster->numVertices; i++)
+    {
+        uint32_t v = i < numOwned ? original[begin + i] : original[(*halo)[i - numOwned]];
+        glm_vec3_copy(mesh->vertices[v].position, cluster->vertices[i].position);
+    }
+    cluster->precision = mesh->precision;
+    return cluster;
+}
+
+// Writes bytes and pads them to 8 bytes, returning the offset they were written at
+static uint64_t writeSection(FILE *file, const void *data, size_t bytes, uint64_t *offset)
+{
+    static const unsigned char zeros[8] = {0};
+    uint64_t start = *offset;
+    size_t padding = (8 - bytes % 8) % 8;
+    if (bytes)
+        fwrite(data, 1, bytes, file);
+    fwrite(zeros, 1, padding, file);
+    *offset += bytes + padding;
+    return start;
+}
+
+// Writes a cluster's record: halo, faces, and adjacency, with the ring starting (and the record ending) 8-byte aligned
+static ClusterInfo writeRecord(FILE *file, const Mesh *cluster, const uint32_t *halo, size_t numHalo, size_t begin,
+                               size_t end, uint64_t *offset)
+{
+    size_t numRing = cluster->ringOffsets[cluster->numVertices];
+    size_t words = numHalo + 2 * cluster->numIndices + 2 * (cluster->numVertices + 1);
+    ClusterInfo info = {(uint32_t)begin, (uint32_t)(end - begin), (uint32_t)numHalo,
+                        (uint32_t)(cluster->numIndices / 3), (uint32_t)numRing, 0, *offset};
+    fwrite(halo, sizeof(uint32_t), numHalo, file);
+    fwrite(cluster->indices, sizeof(uint32_t), cluster->numIndices, file);
+    fwrite(cluster->faceOffsets, sizeof(uint32_t), cluster->numVertices + 1, file);
+    fwrite(cluster->faces, sizeof(uint32_t), cluster->numIndices, file);
+    fwrite(cluster->ringOffsets, sizeof(uint32_t), cluster->numVertices + 1, file);
+    if (words % 2)
+        fwrite(&(uint32_t){0}, sizeof(uint32_t), 1, file);
+    *offset += (words + words % 2) * sizeof(uint32_t);
+    writeSection(file, cluster->ring, numRing * sizeof(uint32_t), offset);
+    return info;
+}
+
+bool writeClusters(const Mesh *mesh, const char *filename, size_t clusterVertices)
+{
+    size_t numVertices = mesh->numVertices, numFaces = mesh->numIndices / 3;
+    if (numVertices > UINT32_MAX || clusterVertices == 0)
+    {
+        fprintf(stderr, "Error writing cluster file: %s\n", filename);
+        return false;
+    }
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error writing cluster file: %s\n", filename);
+        return false;
+    }
+
+    // Placeholder header (rewritten once every section's offset is known)
+    size_t numClusters = (numVertices + clusterVertices - 1) / clusterVertices;
+    ClusterHeader header = {.version = CLUSTER_VERSION, .numVertices = numVertices, .numFaces = numFaces,
+                            .numClusters = numClusters};
+    memcpy(header.magic, CLUSTER_MAGIC, sizeof(header.magic));
+    uint64_t offset = 0;
+    writeSection(file, &header, sizeof(header), &offset);
+
+    // Both position buffers start at the loaded positions, in clustered order
+    uint32_t *renumber = orderVertices(mesh);
+    uint32_t *original = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t));
+    for (size_t v = 0; v < numVertices; v++)
+        original[renumber[v]] = (uint32_t)v;
+    float(*positions)[3] = malloc((numVertices ? numVertices : 1) * sizeof(*positions));
+    for (size_t v = 0; v < numVertices; v++)
+        glm_vec3_copy(mesh->vertices[original[v]].position, positions[v]);
+    for (int i = 0; i < 2; i++)
+        header.positionOffsets[i] = writeSection(file, positions, numVertices * sizeof(*positions), &offset);
+    free(positions);
+    header.renumberOffset = writeSection(file, renumber, numVertices * sizeof(uint32_t), &offset);
+    header.faceOffset = writeSection(file, mesh->indices, mesh->numIndices * sizeof(uint32_t), &offset);
+
+    // Records
+    ClusterInfo *clusters = malloc((numClusters ? numClusters : 1) * sizeof(ClusterInfo));
+    for (size_t c = 0; c < numClusters; c++)
+    {
+        size_t begin = c * clusterVertices;
+        size_t end = begin + clusterVertices < numVertices ? begin + clusterVertices : numVertices;
+        uint32_t *halo;
+        size_t numHalo;
+        Mesh *cluster = cutCluster(mesh, renumber, original, begin, end, &halo, &numHalo);
+        clusters[c] = writeRecord(file, cluster, halo, numHalo, begin, end, &offset);
+        free(halo);
+        destroyMesh(cluster);
+    }
+    free(original);
+    free(renumber);
+
+    // Cluster table last, then the header now that offsets are known
+    header.clusterOffset = writeSection(file, clusters, numClusters * sizeof(ClusterInfo), &offset);
+    free(clusters);
+    rewind(file);
+    fwrite(&header, sizeof(header), 1, file);
+
+    bool written = !ferror(file);
+    if (fclose(file) != 0 || !written)
+    {
+        fprintf(stderr, "Error writing cluster file: %s\n", filename);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Converting
+ */
+
+// Morton key of a vertex, together with its position (sorted in runs that are spilled to disk)
+typedef struct
+{
+    MortonKey key;
+    vec3 position;
+} SpilledKey;
+
+static int compareSpilled(const void *a, const void *b)
+{
+    return compareKeys(&((const SpilledKey *)a)->key, &((const SpilledKey *)b)->key);
+}
+
+// Scratch files of a conversion, and what the .obj file held
+typedef struct
+{
+    FILE *positions;      // vertex positions in file order
+    FILE *polygons;       // polygons in file order (corner count, then corners)
+    FILE *runs;           // sorted runs of vertices
+    FILE *buckets;        // faces of clusters spilled from their buffers
+    char *paths[4];       // paths of scratch files (removed once converted)
+    vec3 lower, upper;    // bounding box of vertices
+    size_t numVertices;   // vertices (including the dummy vertex 0)
+    size_t numTriangles;  // triangles polygons split into
+    size_t maxCorners;    // most corners of a polygon
+} Conversion;
+
+// Sorted run of vertices being merged, buffered from its scratch file
+typedef struct
+{
+    SpilledKey *keys;      // buffered keys
+    size_t next, count;    // next buffered key, keys buffered
+    uint64_t offset, end;  // next key to buffer and one past the run's last key (keys into the file)
+} SortedRun;
+
+// Faces of every cluster, in ascending order: buffered in memory, and spilled in blocks (the previous block's
+// offset, then CONVERT_BUCKET_FACES faces) once a buffer fills
+typedef struct
+{
+    uint32_t (*buffered)[CONVERT_BUCKET_FACES]; // faces not yet spilled
+    uint32_t *numBuffered;                      // number of faces not yet spilled
+    uint64_t *last;                             // offset of last spilled block (UINT64_MAX if none)
+    size_t *counts;                             // faces of each cluster
+    uint64_t size;                              // bytes spilled
+} FaceBuckets;
+
+// Moves to an offset of file (which may lie past 2 GiB)
+static bool seekFile(FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+// Writes zeros padded to 8 bytes, returning the offset they were written at
+static uint64_t writeZeros(FILE *file, size_t bytes, uint64_t *offset)
+{
+    static const unsigned char zeros[4096] = {0};
+    uint64_t start = *offset;
+    size_t padded = bytes + (8 - bytes % 8) % 8;
+    for (size_t i = 0; i < padded; i += sizeof(zeros))
+        fwrite(zeros, 1, padded - i < sizeof(zeros) ? padded - i : sizeof(zeros), file);
+    *offset += padded;
+    return start;
+}
+
+// Opens a scratch file next to filename for writing and reading back
+static FILE *openScratch(Conversion *conversion, int which, const char *filename, const char *suffix)
+{
+    size_t length = strlen(filename);
+    conversion->paths[which] = malloc(length + strlen(suffix) + 1);
+    memcpy(conversion->paths[which], filename, length);
+    strcpy(conversion->paths[which] + length, suffix);
+    return fopen(conversion->paths[which], "w+b");
+}
+
+static void spillVertex(void *data, const float position[3])
+{
+    Conversion *conversion = data;
+    vec3 copy = {position[0], position[1], position[2]};
+    fwrite(copy, sizeof(float), 3, conversion->positions);
+    glm_vec3_minv(conversion->lower, copy, conversion->lower);
+    glm_vec3_maxv(conversion->upper, copy, conversion->upper);
+    conversion->numVertices++;
+}
+
+static void spillPolygon(void *data, const uint32_t *corners, size_t count)
+{
+    Conversion *conversion = data;
+    uint32_t numCorners = (uint32_t)count;
+    fwrite(&numCorners, sizeof(uint32_t), 1, conversion->polygons);
+    fwrite(corners, sizeof(uint32_t), count, conversion->polygons);
+    conversion->numTriangles += count - 2;
+    conversion->maxCorners = count > conversion->maxCorners ? count : conversion->maxCorners;
+}
+
+// Sorts spilled vertices along the Morton curve in runs of CONVERT_SORT_KEYS, returning the number of runs (SIZE_MAX if
+// the vertices cannot be read back)
+static size_t sortRuns(Conversion *conversion)
+{
+    SpilledKey *keys = malloc(CONVERT_SORT_KEYS * sizeof(SpilledKey));
+    size_t numRuns = 0;
+    rewind(conversion->positions);
+    for (size_t first = 1; first < conversion->numVertices; first += CONVERT_SORT_KEYS, numRuns++)
+    {
+        size_t left = conversion->numVertices - first, count = left < CONVERT_SORT_KEYS ? left : CONVERT_SORT_KEYS;
+        size_t read = 0;
+        for (; read < count && fread(keys[read].position, sizeof(float), 3, conversion->positions) == 3; read++)
+            keys[read].key = (MortonKey){mortonCode(keys[read].position, conversion->lower, conversion->upper),
+                                         (uint32_t)(first + read)};
+        if (read < count)
+        {
+            numRuns = SIZE_MAX;
+            break;
+        }
+        qsort(keys, count, sizeof(SpilledKey), compareSpilled);
+        fwrite(keys, sizeof(SpilledKey), count, conversion->runs);
+    }
+    free(keys);
+    return numRuns;
+}
+
+// Buffers a run's next keys from file (false once the run is used up)
+static bool refillRun(SortedRun *run, FILE *file)
+{
+    size_t count = run->end - run->offset < CONVERT_MERGE_KEYS ? (size_t)(run->end - run->offset) : CONVERT_MERGE_KEYS;
+    if (!count || !seekFile(file, run->offset * sizeof(SpilledKey)) ||
+        fread(run->keys, sizeof(SpilledKey), count, file) != count)
+        return false;
+    run->offset += count;
+    run->next = 0;
+    run->count = count;
+    return true;
+}
+
+// Restores the heap of runs (ordered by their next keys) below position i
+static void siftRuns(const SortedRun *runs, size_t *heap, size_t count, size_t i)
+{
+    for (;;)
+    {
+        size_t first = i;
+        for (size_t child = 2 * i + 1; child < 2 * i + 3 && child < count; child++)
+            if (compareSpilled(&runs[heap[child]].keys[runs[heap[child]].next],
+                               &runs[heap[first]].keys[runs[heap[first]].next]) < 0)
+                first = child;
+        if (first == i)
+            return;
+        size_t swap = heap[i];
+        heap[i] = heap[first];
+        heap[first] = swap;
+        i = first;
+    }
+}
+
+// Merges sorted runs into both position buffers (in clustered order) and the renumbering, returning whether every
+// vertex was merged
+static bool mergeRuns(Conversion *conversion, size_t numRuns, float (*positions)[3], float (*copy)[3],
+                      uint32_t *renumber)
+{
+    SortedRun *runs = calloc(numRuns ? numRuns : 1, sizeof(SortedRun));
+    size_t *heap = malloc((numRuns ? numRuns : 1) * sizeof(size_t));
+    size_t count = 0;
+    for (size_t r = 0; r < numRuns; r++)
+    {
+        runs[r].keys = malloc(CONVERT_MERGE_KEYS * sizeof(SpilledKey));
+        runs[r].offset = (uint64_t)r * CONVERT_SORT_KEYS;
+        runs[r].end = runs[r].offset + CONVERT_SORT_KEYS < conversion->numVertices - 1 ? runs[r].offset + CONVERT_SORT_KEYS
+                                                                                          : conversion->numVertices - 1;
+        if (refillRun(&runs[r], conversion->runs))
+            heap[count++] = r;
+    }
+    for (size_t i = count / 2; i-- > 0;)
+        siftRuns(runs, heap, count, i);
+
+    size_t v = 1;
+    while (count)
+    {
+        SortedRun *run = &runs[heap[0]];
+        const SpilledKey *key = &run->keys[run->next++];
+        memcpy(positions[v], key->position, sizeof(positions[v]));
+        memcpy(copy[v], key->position, sizeof(copy[v]));
+        renumber[key->key.vertex] = (uint32_t)v++;
+        if (run->next == run->count && !refillRun(run, conversion->runs))
+            heap[0] = heap[--count];
+        siftRuns(runs, heap, count, 0);
+    }
+
+    for (size_t r = 0; r < numRuns; r++)
+        free(runs[r].keys);
+    free(runs);
+    free(heap);
+    return v == conversion->numVertices;
+}
+
+// Adds a face to a cluster's bucket, spilling the bucket's buffer first if it is full
+static void bucketFace(FaceBuckets *buckets, FILE *file, size_t c, uint32_t face)
+{
+    if (buckets->numBuffered[c] == CONVERT_BUCKET_FACES)
+    {
+        fwrite(&buckets->last[c], sizeof(uint64_t), 1, file);
+        fwrite(buckets->buffered[c], sizeof(uint32_t), CONVERT_BUCKET_FACES, file);
+        buckets->last[c] = buckets->size;
+        buckets->size += sizeof(uint64_t) + CONVERT_BUCKET_FACES * sizeof(uint32_t);
+        buckets->numBuffered[c] = 0;
+    }
+    buckets->buffered[c][buckets->numBuffered[c]++] = face;
+    buckets->counts[c]++;
+}
+
+// Faces of a cluster's bucket in ascending order (NULL if its spilled blocks cannot be read back)
+static uint32_t *gatherBucket(const FaceBuckets *buckets, FILE *file, size_t c)
+{
+    size_t count = buckets->counts[c], filled = count - buckets->numBuffered[c];
+    uint32_t *faces = malloc((count ? count : 1) * sizeof(uint32_t));
+    memcpy(faces + filled, buckets->buffered[c], buckets->numBuffered[c] * sizeof(uint32_t));
+
+    // Spilled blocks are chained from the last one back
+    for (uint64_t block = buckets->last[c]; block != UINT64_MAX; filled -= CONVERT_BUCKET_FACES)
+        if (!seekFile(file, block) || fread(&block, sizeof(uint64_t), 1, file) != 1 ||
+            fread(faces + filled - CONVERT_BUCKET_FACES, sizeof(uint32_t), CONVERT_BUCKET_FACES, file) !=
+                CONVERT_BUCKET_FACES)
+        {
+            free(faces);
+            return NULL;
+        }
+    return faces;
+}
+
+// Splits spilled polygons into triangles as loadOBJ does (dropping ones with a repeated corner, as welding does) into
+// the face section, bucketing each triangle into the clusters owning its corners; returns the number of faces, or
+// SIZE_MAX if a polygon has a corner that isn't a vertex
+static size_t splitPolygons(Conversion *conversion, const float (*positions)[3], const uint32_t *renumber,
+                            uint32_t *indices, size_t clusterVertices, FaceBuckets *buckets)
+{
+    size_t maxCorners = conversion->maxCorners ? conversion->maxCorners : 3;
+    uint32_t *corners = malloc(maxCorners * sizeof(uint32_t));
+    uint32_t *triangles = malloc(3 * maxCorners * sizeof(uint32_t));
+    float(*polygon)[3] = malloc(maxCorners * sizeof(*polygon));
+    float(*points)[2] = malloc(maxCorners * sizeof(*points));
+    uint32_t *remaining = malloc(maxCorners * sizeof(uint32_t));
+
+    size_t numFaces = 0;
+    uint32_t count;
+    rewind(conversion->polygons);
+    while (numFaces != SIZE_MAX && fread(&count, sizeof(uint32_t), 1, conversion->polygons) == 1)
+    {
+        if (count > maxCorners || fread(corners, sizeof(uint32_t), count, conversion->polygons) != count)
+        {
+            numFaces = SIZE_MAX;
+            break;
+        }
+        for (size_t k = 0; k < count; k++)
+            if (corners[k] == 0 || corners[k] >= conversion->numVertices)
+                numFaces = SIZE_MAX;
+        if (numFaces == SIZE_MAX)
+            break;
+
+        const uint32_t *end = triangles + 3;
+        if (count == 3)
+            memcpy(triangles, corners, 3 * sizeof(uint32_t));
+        else
+        {
+            for (size_t k = 0; k < count; k++)
+                memcpy(polygon[k], positions[renumber[corners[k]]], sizeof(polygon[k]));
+            end = triangulatePolygon((const float(*)[3])polygon, corners, count, triangles, points, remaining);
+        }
+
+        for (const uint32_t *t = triangles; t < end; t += 3)
+        {
+            if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0])
+                continue;
+            memcpy(&indices[3 * numFaces], t, 3 * sizeof(uint32_t));
+
+            // Every cluster owning a corner, once
+            size_t owners[3];
+            for (int k = 0; k < 3; k++)
+            {
+                owners[k] = renumber[t[k]] / clusterVertices;
+                if ((k < 1 || owners[k] != owners[0]) && (k < 2 || owners[k] != owners[1]))
+                    bucketFace(buckets, conversion->buckets, owners[k], (uint32_t)numFaces);
+            }
+            numFaces++;
+        }
+    }
+    free(corners);
+    free(triangles);
+    free(polygon);
+    free(points);
+    free(remaining);
+    return numFaces;
+}
+
+// Cuts every cluster from the buckets of their faces and appends its record, then the cluster table
+static bool appendRecords(Conversion *conversion, FILE *file, const ClusterHeader *header, const unsigned char *base,
+                          size_t clusterVertices, const FaceBuckets *buckets, uint64_t *offset, uint64_t *clusterOffset)
+{
+    const float(*positions)[3] = (const float(*)[3])(base + header->positionOffsets[0]);
+    const uint32_t *renumber = (const uint32_t *)(base + header->renumberOffset);
+    const uint32_t *indices = (const uint32_t *)(base + header->faceOffset);
+    size_t numVertices = header->numVertices, numClusters = header->numClusters;
+
+    ClusterInfo *clusters = malloc((numClusters ? numClusters : 1) * sizeof(ClusterInfo));
+    bool appended = true;
+    for (size_t c = 0; appended && c < numClusters; c++)
+    {
+        size_t begin = c * clusterVertices;
+        size_t end = begin + clusterVertices < numVertices ? begin + clusterVertices : numVertices;
+        uint32_t *faces = gatherBucket(buckets, conversion->buckets, c);
+        if (!faces)
+        {
+            appended = false;
+            break;
+        }
+
+        size_t count = buckets->counts[c];
+        uint32_t *corners = malloc((count ? 3 * count : 1) * sizeof(uint32_t));
+        for (size_t i = 0; i < 3 * count; i++)
+            corners[i] = renumber[indices[3 * (size_t)faces[i / 3] + i % 3]];
+        uint32_t *halo;
+        size_t numHalo;
+        Mesh *cluster = assembleCluster(corners, count, begin, end, &halo, &numHalo);
+        for (size_t i = 0; i < cluster->numVertices; i++)
+        {
+            size_t v = i < end - begin ? begin + i : halo[i - (end - begin)];
+            memcpy(cluster->vertices[i].position, positions[v], sizeof(vec3));
+        }
+        clusters[c] = writeRecord(file, cluster, halo, numHalo, begin, end, offset);
+
+        free(halo);
+        destroyMesh(cluster);
+        free(corners);
+        free(faces);
+        appended = !ferror(file);
+    }
+    *clusterOffset = writeSection(file, clusters, numClusters * sizeof(ClusterInfo), offset);
+    free(clusters);
+    return appended;
+}
+
+// Writes the cluster file of spilled vertices and polygons: the sections of the whole mesh are mapped and filled in
+// place, then the records are appended and the header written last (so a partly written file is rejected)
+static bool writeConversion(Conversion *conversion, const char *filename, size_t clusterVertices)
+{
+    size_t numVertices = conversion->numVertices, numClusters = (numVertices + clusterVertices - 1) / clusterVertices;
+    ClusterHeader header = {.version = CLUSTER_VERSION, .numVertices = numVertices, .numClusters = numClusters};
+    memcpy(header.magic, CLUSTER_MAGIC, sizeof(header.magic));
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+        return false;
+    uint64_t offset = 0;
+    writeZeros(file, sizeof(header), &offset);
+    for (int i = 0; i < 2; i++)
+        header.positionOffsets[i] = writeZeros(file, numVertices * 3 * sizeof(float), &offset);
+    header.renumberOffset = writeZeros(file, numVertices * sizeof(uint32_t), &offset);
+    header.faceOffset = writeZeros(file, conversion->numTriangles * 3 * sizeof(uint32_t), &offset);
+    bool written = !ferror(file);
+    if (fclose(file) != 0 || !written)
+        return false;
+
+    size_t size;
+    void *mapping;
+    unsigned char *base = mapFile(filename, &size, &mapping);
+    if (!base)
+        return false;
+
+    // Vertices along the Morton curve, then faces split and bucketed by cluster
+    float(*positions)[3] = (float(*)[3])(base + header.positionOffsets[0]);
+    uint32_t *renumber = (uint32_t *)(base + header.renumberOffset);
+    size_t numRuns = sortRuns(conversion);
+    written = numRuns != SIZE_MAX && !ferror(conversion->runs) &&
+              mergeRuns(conversion, numRuns, positions, (float(*)[3])(base + header.positionOffsets[1]), renumber);
+    FaceBuckets buckets = {malloc((numClusters ? numClusters : 1) * sizeof(*buckets.buffered)),
+                           calloc(numClusters ? numClusters : 1, sizeof(uint32_t)),
+                           malloc((numClusters ? numClusters : 1) * sizeof(uint64_t)),
+                           calloc(numClusters ? numClusters : 1, sizeof(size_t)), 0};
+    for (size_t c = 0; c < numClusters; c++)
+        buckets.last[c] = UINT64_MAX;
+    if (written)
+    {
+        size_t numFaces = splitPolygons(conversion, (const float(*)[3])positions, renumber,
+                                        (uint32_t *)(base + header.faceOffset), clusterVertices, &buckets);
+        header.numFaces = numFaces;
+        written = numFaces != SIZE_MAX && !ferror(conversion->buckets);
+    }
+
+    // Records and cluster table after the mapped sections, then the header
+    file = written ? fopen(filename, "ab") : NULL;
+    if (file)
+    {
+        written = appendRecords(conversion, file, &header, base, clusterVertices, &buckets, &offset,
+                                &header.clusterOffset);
+        written &= !ferror(file);
+        written &= !fclose(file);
+    }
+    else
+        written = false;
+    if (written)
+        memcpy(base, &header, sizeof(header));
+    unmapFile(base, size, mapping);
+
+    free(buckets.buffered);
+    free(buckets.numBuffered);
+    free(buckets.last);
+    free(buckets.counts);
+    return written;
+}
+
+bool convertClusters(const char *objFilename, const char *filename, size_t clusterVertices)
+{
+    // Scratch files live next to the cluster file, where there is room for it
+    Conversion conversion = {.lower = {INFINITY, INFINITY, INFINITY}, .upper = {-INFINITY, -INFINITY, -INFINITY},
+                             .numVertices = 1};
+    conversion.positions = openScratch(&conversion, 0, filename, ".positions");
+    conversion.polygons = openScratch(&conversion, 1, filename, ".polygons");
+    conversion.runs = openScratch(&conversion, 2, filename, ".runs");
+    conversion.buckets = openScratch(&conversion, 3, filename, ".buckets");
+    bool scratch = conversion.positions && conversion.polygons && conversion.runs && conversion.buckets;
+
+    bool loaded = scratch && streamOBJ(objFilename, spillVertex, spillPolygon, &conversion);
+    bool converted = loaded && !ferror(conversion.positions) && !ferror(conversion.polygons) && clusterVertices &&
+                     conversion.numVertices <= UINT32_MAX && conversion.numTriangles <= UINT32_MAX / 3 &&
+                     writeConversion(&conversion, filename, clusterVertices);
+
+    FILE *files[] = {conversion.positions, conversion.polygons, conversion.runs, conversion.buckets};
+    for (int i = 0; i < 4; i++)
+    {
+        if (files[i])
+            fclose(files[i]);
+        if (conversion.paths[i])
+            remove(conversion.paths[i]);
+        free(conversion.paths[i]);
+    }
+    if (!converted && loaded)
+        remove(filename);
+    if (!converted && (loaded || !scratch))
+        fprintf(stderr, "Error writing cluster file: %s\n", filename);
+    return converted;
+}
+
+/*
+ * Flowing
+ */
+
+// Bytes of a cluster's record
+static size_t recordSize(const ClusterInfo *cluster)
+{
+    size_t numLocal = (size_t)cluster->numOwned + cluster->numHalo;
+    size_t words = cluster->numHalo + 6 * (size_t)cluster->numFaces + 2 * (numLocal + 1);
+    return (words + words % 2) * sizeof(uint32_t) + ((size_t)cluster->numRing * sizeof(uint32_t) + 7) / 8 * 8;
+}
+
+static float (*positionBuffer(const ClusteredMesh *clustered, uint32_t which))[3]
+{
+    return (float(*)[3])(clustered->base + clustered->header->positionOffsets[which]);
+}
+
+// Gathers a cluster's positions from the latest position buffer into buffer, pointing its faces and adjacency
+// into the cluster's record
+static void gatherCluster(ClusteredMesh *clustered, size_t c, ClusterBuffer *buffer)
+{
+    const ClusterInfo *cluster = &clustered->clusters[c];
+    size_t numOwned = cluster->numOwned, numLocal = numOwned + cluster->numHalo;
+    prefetchPages(clustered, cluster->offset, recordSize(cluster));
+
+    Mesh *mesh = &buffer->mesh;
+    uint32_t *halo = (uint32_t *)(clustered->base + cluster->offset);
+    mesh->numVertices = numLocal;
+    mesh->numIndices = 3 * (size_t)cluster->numFaces;
+    mesh->indices = halo + cluster->numHalo;
+    mesh->faceOffsets = mesh->indices + mesh->numIndices;
+    mesh->faces = mesh->faceOffsets + numLocal + 1;
+    mesh->ringOffsets = mesh->faces + mesh->numIndices;
+    mesh->ring = mesh->ringOffsets + numLocal + 1;
+    mesh->ring += (mesh->ring - halo) % 2; // ring starts 8-byte aligned
+    mesh->precision = clustered->precision;
+
+    const float(*positions)[3] = positionBuffer(clustered, clustered->header->current);
+    for (size_t i = 0; i < numOwned; i++)
+        glm_vec3_copy((float *)positions[cluster->begin + i], mesh->vertices[i].position);
+    for (size_t i = numOwned; i < numLocal; i++)
+        glm_vec3_copy((float *)positions[halo[i - numOwned]], mesh->vertices[i].position);
+
+    // Fault in the rest of the record so the flow does not stall on it
+    volatile unsigned char touched = 0;
+    const unsigned char *record = clustered->base + cluster->offset;
+    for (size_t i = 0; i < recordSize(cluster); i += 4096)
+        touched ^= record[i];
+    (void)touched;
+}
+
+// Gathers requested clusters until told to stop
+static void *prefetchClusters(void *argument)
+{
+    ClusteredMesh *clustered = argument;
+    pthread_mutex_lock(&clustered->lock);
+    while (true)
+    {
+        while (clustered->requested == SIZE_MAX && !clustered->stopping)
+            pthread_cond_wait(&clustered->wake, &clustered->lock);
+        if (clustered->requested == SIZE_MAX)
+            break;
+
+        size_t c = clustered->requested;
+        ClusterBuffer *buffer = clustered->target;
+        pthread_mutex_unlock(&clustered->lock);
+        gatherCluster(clustered, c, buffer);
+        pthread_mutex_lock(&clustered->lock);
+
+        clustered->requested = SIZE_MAX;
+        pthread_cond_broadcast(&clustered->done);
+    }
+    pthread_mutex_unlock(&clustered->lock);
+    return NULL;
+}
+
+static void requestCluster(ClusteredMesh *clustered, size_t c, ClusterBuffer *buffer)
+{
+    pthread_mutex_lock(&clustered->lock);
+    clustered->requested = c;
+    clustered->target = buffer;
+    pthread_cond_signal(&clustered->wake);
+    pthread_mutex_unlock(&clustered->lock);
+}
+
+static void waitForCluster(ClusteredMesh *clustered)
+{
+    pthread_mutex_lock(&clustered->lock);
+    while (clustered->requested != SIZE_MAX)
+        pthread_cond_wait(&clustered->done, &clustered->lock);
+    pthread_mutex_unlock(&clustered->lock);
+}
+
+// Checks that header, cluster table, and every section lie within the mapping
+static bool validClusters(const ClusteredMesh *clustered)
+{
+    const ClusterHeader *header = clustered->header;
+    size_t size = clustered->size;
+    if (size < sizeof(ClusterHeader) || memcmp(header->magic, CLUSTER_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != CLUSTER_VERSION || header->current > 1 || header->numVertices > UINT32_MAX ||
+        header->numFaces > UINT32_MAX / 3 || header->numClusters > header->numVertices)
+        return false;
+
+    uint64_t sections[][2] = {{header->positionOffsets[0], header->numVertices * 3 * sizeof(float)},
+                              {header->positionOffsets[1], header->numVertices * 3 * sizeof(float)},
+                              {header->renumberOffset, header->numVertices * sizeof(uint32_t)},
+                              {header->faceOffset, header->numFaces * 3 * sizeof(uint32_t)},
+                              {header->clusterOffset, header->numClusters * sizeof(ClusterInfo)}};
+    for (size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); i++)
+        if (sections[i][0] % 8 || sections[i][0] > size || sections[i][1] > size - sections[i][0])
+            return false;
+
+    const ClusterInfo *clusters = (const ClusterInfo *)(clustered->base + header->clusterOffset);
+    for (size_t c = 0; c < header->numClusters; c++)
+        if (clusters[c].offset % 8 || clusters[c].offset > size || recordSize(&clusters[c]) > size - clusters[c].offset ||
+            (uint64_t)clusters[c].begin + clusters[c].numOwned > header->numVertices)
+            return false;
+    return true;
+}
+
+ClusteredMesh *openClusters(const char *filename, GEOMETRIC_FLOW flow, PRECISION precision)
+{
+    ClusteredMesh *clustered = calloc(1, sizeof(ClusteredMesh));
+    clustered->base = mapFile(filename, &clustered->size, &clustered->mapping);
+    if (!clustered->base)
+    {
+        free(clustered);
+        return NULL;
+    }
+    clustered->header = (ClusterHeader *)clustered->base;
+    if (!validClusters(clustered))
+    {
+        unmapFile(clustered->base, clustered->size, clustered->mapping);
+        free(clustered);
+        return NULL;
+    }
+    clustered->clusters = (const ClusterInfo *)(clustered->base + clustered->header->clusterOffset);
+    clustered->flow = flow;
+    clustered->precision = precision;
+
+    // Size both buffers for the largest cluster
+    size_t capacity = 1, faceCapacity = 1;
+    for (size_t c = 0; c < clustered->header->numClusters; c++)
+    {
+        const ClusterInfo *cluster = &clustered->clusters[c];
+        size_t numLocal = (size_t)cluster->numOwned + cluster->numHalo;
+        capacity = numLocal > capacity ? numLocal : capacity;
+        faceCapacity = cluster->numFaces > faceCapacity ? cluster->numFaces : faceCapacity;
+    }
+    for (int i = 0; i < 2; i++)
+    {
+        ClusterBuffer *buffer = &clustered->buffers[i];
+        buffer->capacity = capacity;
+        buffer->faceCapacity = faceCapacity;
+        buffer->mesh.vertices = calloc(capacity, sizeof(Vertex));
+        buffer->mesh.areas = calloc(capacity, sizeof(float));
+        buffer->mesh.faceNormals = calloc(faceCapacity, sizeof(vec3));
+    }
+
+    clustered->requested = SIZE_MAX;
+    pthread_mutex_init(&clustered->lock, NULL);
+    pthread_cond_init(&clustered->wake, NULL);
+    pthread_cond_init(&clustered->done, NULL);
+    pthread_create(&clustered->prefetcher, NULL, prefetchClusters, clustered);
+    return clustered;
+}
+
+void closeClusters(ClusteredMesh *clustered)
+{
+    if (!clustered)
+        return;
+
+    pthread_mutex_lock(&clustered->lock);
+    clustered->stopping = true;
+    pthread_cond_signal(&clustered->wake);
+    pthread_mutex_unlock(&clustered->lock);
+    pthread_join(clustered->prefetcher, NULL);
+    pthread_mutex_destroy(&clustered->lock);
+    pthread_cond_destroy(&clustered->wake);
+    pthread_cond_destroy(&clustered->done);
+
+    for (int i = 0; i < 2; i++)
+    {
+        free(clustered->buffers[i].mesh.vertices);
+        free(clustered->buffers[i].mesh.areas);
+        free(clustered->buffers[i].mesh.faceNormals);
+    }
+    unmapFile(clustered->base, clustered->size, clustered->mapping);
+    free(clustered);
+}
+
+void stepClusters(ClusteredMesh *clustered, float deltaTime, ThreadPool *pool)
+{
+    ClusterHeader *header = clustered->header;
+    uint32_t read = header->current, write = 1 - read;
+    float(*positions)[3] = positionBuffer(clustered, write);
+    if (header->numClusters)
+        requestCluster(clustered, 0, &clustered->buffers[0]);
+
+    for (size_t c = 0; c < header->numClusters; c++)
+    {
+        // Flow this cluster while the next one is gathered into the other buffer
+        const ClusterInfo *cluster = &clustered->clusters[c];
+        ClusterBuffer *buffer = &clustered->buffers[c % 2];
+        waitForCluster(clustered);
+        if (c + 1 < header->numClusters)
+            requestCluster(clustered, c + 1, &clustered->buffers[(c + 1) % 2]);
+        stepFlow(&buffer->mesh, clustered->flow, deltaTime, pool);
+
+        // Owned positions go to the other buffer (halo positions were only read)
+        for (size_t i = 0; i < cluster->numOwned; i++)
+            glm_vec3_copy(buffer->mesh.vertices[i].position, positions[cluster->begin + i]);
+
+        // Nothing of a finished cluster is needed again this step
+        size_t bytes = cluster->numOwned * sizeof(*positions);
+        releasePages(clustered, cluster->offset, recordSize(cluster));
+        releasePages(clustered, header->positionOffsets[read] + cluster->begin * sizeof(*positions), bytes);
+        releasePages(clustered, header->positionOffsets[write] + cluster->begin * sizeof(*positions), bytes);
+    }
+
+    // Latest positions are in the other buffer now (written last, so a killed step leaves the previous one)
+    header->steps++;
+    header->time += deltaTime;
+    header->current = write;
+}
+
+bool exportClusters(const ClusteredMesh *clustered, const char *filename)
+{
+    FILE *file = fopen(filename, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Error writing OBJ file: %s\n", filename);
+        return false;
+    }
+
+    // Vertices in loaded order (skipping fast_obj's dummy vertex, so that indices stay 1-based as loaded)
+    const ClusterHeader *header = clustered->header;
+    const float(*positions)[3] = positionBuffer(clustered, header->current);
+    const uint32_t *renumber = (const uint32_t *)(clustered->base + header->renumberOffset);
+    for (size_t i = 1; i < header->numVertices; i++)
+    {
+        const float *position = positions[renumber[i]];
+        fprintf(file, "v %.9g %.9g %.9g\n", position[0], position[1], position[2]);
+    }
+
+    // Faces
+    const uint32_t *indices = (const uint32_t *)(clustered->base + header->faceOffset);
+    for (size_t i = 0; i < 3 * header->numFaces; i += 3)
+        fprintf(file, "f %u %u %u\n", indices[i], indices[i + 1], indices[i + 2]);
+
+    bool written = !ferror(file);
+    if (fclose(file) != 0 || !written)
+    {
+        fprintf(stderr, "Error writing OBJ file: %s\n", filename);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,199 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "model.h"
+#include "geometry.h"
+#include "threadpool.h"
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Out-of-core settings
+#define CLUSTER_MAGIC "GFOC"         // first bytes of every cluster file
+#define CLUSTER_VERSION 1            // format version (files of other versions are rejected)
+#define CLUSTER_VERTICES 65536       // default vertices owned by each cluster (resident memory is about two clusters' worth)
+#define MORTON_BITS 21               // bits per axis of the Morton codes vertices are ordered by
+#define CONVERT_SORT_KEYS (1 << 20)  // vertices sorted in memory at once while converting (sorted runs are merged from disk)
+#define CONVERT_MERGE_KEYS 4096      // vertices read from each sorted run at once while merging
+#define CONVERT_BUCKET_FACES 1024    // faces each cluster buffers while converting before spilling them to disk
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Start of a cluster file, mapped in place (sections are 8-byte aligned and stored as native
+ * little-endian bytes, like checkpoints).
+ */
+typedef struct
+{
+    char magic[4];                // CLUSTER_MAGIC
+    uint32_t version;             // CLUSTER_VERSION
+    uint64_t numVertices;         // vertices (including fast_obj's dummy vertex 0)
+    uint64_t numFaces;            // faces
+    uint64_t numClusters;         // clusters
+    uint64_t steps;               // steps flowed so far
+    double time;                  // flow time so far
+    uint32_t current;             // position buffer holding the latest positions (0 or 1)
+    uint32_t padding;             // keeps the offsets below aligned
+    uint64_t positionOffsets[2];  // two float[3] position buffers (clustered order)
+    uint64_t renumberOffset;      // clustered index of every loaded vertex (uint32_t each)
+    uint64_t faceOffset;          // faces as loaded (3 uint32_t loaded indices each, for export)
+    uint64_t clusterOffset;       // ClusterInfo of every cluster
+} ClusterHeader;
+
+/**
+ * @brief Cluster of a cluster file: a range of vertices it owns, the halo vertices around them, and every
+ * face with an owned corner.
+ *
+ * The record of a cluster holds its halo (clustered indices), then its faces with corners numbered locally
+ * (owned vertices first, then halo vertices), and their vertex-face and one-ring adjacency, in the layout
+ * of Mesh. Faces are kept in ascending order of the whole mesh's faces, so owned vertices sum their faces
+ * exactly as an in-core sweep does.
+ */
+typedef struct
+{
+    uint32_t begin, numOwned; // owned vertices (a range of clustered indices)
+    uint32_t numHalo;         // vertices of other clusters sharing a face with an owned vertex
+    uint32_t numFaces;        // faces with an owned corner
+    uint32_t numRing;         // entries of one-ring adjacency
+    uint32_t padding;         // keeps the offset below aligned
+    uint64_t offset;          // file offset of record
+} ClusterInfo;
+
+/**
+ * @brief One cluster gathered into memory, in the shape of a mesh (adjacency points into the mapping).
+ */
+typedef struct
+{
+    Mesh mesh;           // owned then halo vertices, and faces with an owned corner
+    size_t capacity;     // vertices allocated
+    size_t faceCapacity; // faces allocated
+} ClusterBuffer;
+
+/**
+ * @brief Mesh flowed out of core from a memory-mapped cluster file.
+ *
+ * Vertices are ordered along a Morton curve and split into clusters of CLUSTER_VERTICES, so each cluster is
+ * spatially coherent and has a thin halo. Each step flows the clusters one by one: a cluster's owned and
+ * halo positions are gathered from one position buffer, flowed in memory, and its owned positions written
+ * to the other buffer, so halos always see the previous step and the buffers swap roles between steps.
+ * A prefetch thread gathers the next cluster while the current one flows, and pages of finished clusters
+ * are released, so resident memory stays near two clusters' buffers however large the mesh. The file holds
+ * the flow's whole state, so a run that stops (or is killed) continues where the last full step left off.
+ */
+typedef struct
+{
+    unsigned char *base;          // mapped file
+    size_t size;                  // bytes mapped
+    void *mapping;                // mapping handle (Windows only)
+    ClusterHeader *header;        // header (in mapping)
+    const ClusterInfo *clusters;  // clusters (in mapping)
+    GEOMETRIC_FLOW flow;          // flow computed
+    PRECISION precision;          // arithmetic of curvature sweeps and updates
+    ClusterBuffer buffers[2];     // cluster being flowed, and cluster being prefetched
+
+    pthread_t prefetcher;         // thread gathering the next cluster
+    pthread_mutex_t lock;         // guards everything below
+    pthread_cond_t wake;          // signaled when a cluster is requested or the prefetcher should stop
+    pthread_cond_t done;          // signaled when a requested cluster is gathered
+    size_t requested;             // cluster to gather (SIZE_MAX for none)
+    ClusterBuffer *target;        // buffer to gather requested cluster into
+    bool stopping;                // whether prefetcher should exit
+} ClusteredMesh;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Cuts one cluster out of mesh: the vertices a renumbering places in [begin, end) (owned), the vertices of
+ * other clusters sharing a face with them (halo), and every face with an owned corner.
+ *
+ * Faces keep the mesh's order, so owned vertices of the cluster sum their faces exactly as a sweep of the whole
+ * mesh does.
+ *
+ * @param mesh     Mesh to cut from (with adjacency).
+ * @param renumber New index of every vertex of mesh.
+ * @param original Vertex of mesh at every new index.
+ * @param begin    First new index owned.
+ * @param end      One past last new index owned.
+ * @param halo     Destination of halo vertices (new indices in ascending order; caller frees).
+ * @param numHalo  Destination of number of halo vertices.
+ * @return Mesh of owned vertices then halo vertices (positions copied, adjacency built, curvature not computed).
+ */
+Mesh *cutCluster(const Mesh *mesh, const uint32_t *renumber, const uint32_t *original, size_t begin, size_t end,
+                 uint32_t **halo, size_t *numHalo);
+
+/**
+ * @brief Partitions mesh into clusters and writes them to a cluster file (with the mesh's positions as step 0).
+ *
+ * Needs the mesh in memory once; convertClusters writes the same file straight from an .obj file.
+ *
+ * @param mesh            Mesh to write.
+ * @param filename        Cluster file.
+ * @param clusterVertices Vertices owned by each cluster.
+ * @return True if file was written.
+ */
+bool writeClusters(const Mesh *mesh, const char *filename, size_t clusterVertices);
+
+/**
+ * @brief Partitions an .obj file into clusters and writes them to a cluster file without loading the mesh.
+ *
+ * The file is streamed once, spilling vertices and polygons to scratch files next to the cluster file. Vertices
+ * are sorted along the Morton curve in runs of CONVERT_SORT_KEYS that are merged straight into the mapped
+ * position and renumbering sections; polygons are then split into triangles (as loadOBJ splits them) into the
+ * face section, and each triangle is bucketed by the clusters owning its corners, so every cluster's record is
+ * cut from its bucket alone. Memory stays near one sorted run, a buffer per run and per cluster, and one
+ * cluster however large the mesh.
+ *
+ * Vertices are not welded, and only triangles with a repeated corner are dropped (duplicate faces are kept), so
+ * the file matches writeClusters of the loaded mesh byte for byte whenever loading welds and drops nothing; meshes
+ * with split seams should be welded first (e.g. by exporting them once from an in-memory run).
+ *
+ * @param objFilename     .obj file to convert.
+ * @param filename        Cluster file.
+ * @param clusterVertices Vertices owned by each cluster.
+ * @return True if file was written.
+ */
+bool convertClusters(const char *objFilename, const char *filename, size_t clusterVertices);
+
+/**
+ * @brief Maps a cluster file and starts its prefetch thread.
+ *
+ * @param filename  Cluster file.
+ * @param flow      Flow to compute (mean or Gaussian curvature flow; the others solve over the whole mesh).
+ * @param precision Arithmetic of curvature sweeps and updates (float or mixed).
+ * @return Clustered mesh, or NULL if the file cannot be mapped or is not a cluster file.
+ */
+ClusteredMesh *openClusters(const char *filename, GEOMETRIC_FLOW flow, PRECISION precision);
+
+/**
+ * @brief Stops prefetch thread, writes back and unmaps the file, and frees space.
+ *
+ * @param clustered Clustered mesh to close (may be NULL).
+ */
+void closeClusters(ClusteredMesh *clustered);
+
+/**
+ * @brief Flows every cluster by one step, giving the same positions as an in-core step of the whole mesh.
+ *
+ * @param clustered Clustered mesh to step.
+ * @param deltaTime Time step.
+ * @param pool      Idle pool to split each cluster's curvature sweep across (NULL to stay on calling thread).
+ */
+void stepClusters(ClusteredMesh *clustered, float deltaTime, ThreadPool *pool);
+
+/**
+ * @brief Writes latest positions and faces to an .obj file, in the order they were loaded.
+ *
+ * @param clustered Clustered mesh to write.
+ * @param filename  Name of file to write.
+ * @return True if file was written.
+ */
+bool exportClusters(const ClusteredMesh *clustered, const char *filename);
+
+#endif
@@ -0,0 +1,608 @@
+#include "collision.h"
+#include "model.h"
+#include "bvh.h"
+
+#include <cglm/cglm.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+// Placements of faces
+#define GRID 0      // in the buckets of its cell range
+#define OVERSIZED 1 // in the oversized list (its bounds span too many cells)
+#define UNBOUND 2   // nowhere (its bounds are not finite)
+
+#define CELL_LIMIT 1073741824.0f // largest cell coordinate (far away faces are clamped onto the outermost cells)
+
+/*
+ * Helpers
+ */
+
+static size_t hashCell(int32_t x, int32_t y, int32_t z, size_t numBuckets)
+{
+    uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+    return h & (numBuckets - 1);
+}
+
+// Cell of coordinate, clamped so that huge coordinates never overflow the conversion
+static int32_t cellOf(float coordinate, float cellSize)
+{
+    return (int32_t)glm_clamp(floorf(coordinate / cellSize), -CELL_LIMIT, CELL_LIMIT);
+}
+
+static bool boundsOverlap(const float *a, const float *b)
+{
+    return a[0] <= b[3] && b[0] <= a[3] &&
+           a[1] <= b[4] && b[1] <= a[4] &&
+           a[2] <= b[5] && b[2] <= a[5];
+}
+
+// Index of first entry in bucket of a face not below given face (buckets are kept sorted)
+static uint32_t bucketLowerBound(const HashBucket *bucket, uint32_t face)
+{
+    uint32_t lo = 0, hi = bucket->count;
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (bucket->entries[mid].face < face)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void bucketInsert(HashBucket *bucket, uint32_t face, const float *bounds)
+{
+    uint32_t i = bucketLowerBound(bucket, face);
+    if (i < bucket->count && bucket->entries[i].face == face)
+    {
+        memcpy(bucket->entries[i].bounds, bounds, sizeof(bucket->entries[i].bounds));
+        return; // already here, only bounds changed
+    }
+
+    if (bucket->count == bucket->capacity)
+    {
+        bucket->capacity = bucket->capacity ? 2 * bucket->capacity : 4;
+        bucket->entries = realloc(bucket->entries, bucket->capacity * sizeof(HashEntry));
+    }
+    memmove(&bucket->entries[i + 1], &bucket->entries[i], (bucket->count - i) * sizeof(HashEntry));
+    bucket->entries[i].face = face;
+    memcpy(bucket->entries[i].bounds, bounds, sizeof(bucket->entries[i].bounds));
+    bucket->count++;
+}
+
+static void bucketRemove(HashBucket *bucket, uint32_t face)
+{
+    uint32_t i = bucketLowerBound(bucket, face);
+    if (i == bucket->count || bucket->entries[i].face != face)
+        return;
+
+    memmove(&bucket->entries[i], &bucket->entries[i + 1], (bucket->count - i - 1) * sizeof(HashEntry));
+    bucket->count--;
+}
+
+// Removes face from the oversized list
+static void removeOversized(SpatialHash *hash, uint32_t face)
+{
+    for (size_t i = 0; i < hash->numOversized; i++)
+    {
+        if (hash->oversized[i] != face)
+            continue;
+        hash->oversized[i] = hash->oversized[--hash->numOversized];
+        return;
+    }
+}
+
+// Computes bounds of face from its vertices, stretched along their last motion and inflated, and rebins it
+static void bindFace(SpatialHash *hash, const Mesh *mesh, uint32_t face)
+{
+    const uint32_t *f = &mesh->indices[3 * face];
+
+    // Margin and stretch scale with face size, so dense regions don't collect huge numbers of pairs
+    vec3 motion[3];
+    float longest2 = 0.0f, motion2 = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        longest2 = glm_max(longest2, glm_vec3_distance2(mesh->vertices[f[k]].position, mesh->vertices[f[(k + 1) % 3]].position));
+        glm_vec3_sub(mesh->vertices[f[k]].position, hash->previous[f[k]], motion[k]);
+        motion2 = glm_max(motion2, glm_vec3_norm2(motion[k]));
+    }
+    float longest = sqrtf(longest2);
+    float margin = MARGIN_SCALE * longest;
+    float steps = SWEEP_STEPS;
+    if (motion2 * steps * steps > SWEEP_SCALE * SWEEP_SCALE * longest2)
+        steps = SWEEP_SCALE * longest / sqrtf(motion2);
+
+    // Bounds of the face now and where its last motion takes it
+    float *bounds = hash->bounds[face];
+    bool finite = isfinite(margin);
+    for (int a = 0; a < 3; a++)
+    {
+        bounds[a] = FLT_MAX;
+        bounds[a + 3] = -FLT_MAX;
+        for (int k = 0; k < 3; k++)
+        {
+            float now = mesh->vertices[f[k]].position[a], ahead = now + steps * motion[k][a];
+            bounds[a] = glm_min(bounds[a], glm_min(now, ahead));
+            bounds[a + 3] = glm_max(bounds[a + 3], glm_max(now, ahead));
+        }
+        bounds[a] -= margin;
+        bounds[a + 3] += margin;
+        finite &= isfinite(bounds[a]) && isfinite(bounds[a + 3]);
+    }
+
+    hash->longestSum -= hash->longest[face];
+    hash->numLongest -= hash->longest[face] > 0.0f;
+    hash->longest[face] = finite ? longest : 0.0f;
+    hash->longestSum += hash->longest[face];
+    hash->numLongest += hash->longest[face] > 0.0f;
+
+    // Faces with bounds spanning too many cells go in the oversized list, and ones without finite bounds nowhere
+    int32_t cells[6] = {0, 0, 0, -1, -1, -1};
+    uint8_t placement = finite ? GRID : UNBOUND;
+    for (int a = 0; a < 3 && placement == GRID; a++)
+    {
+        cells[a] = cellOf(bounds[a], hash->cellSize);
+        cells[a + 3] = cellOf(bounds[a + 3], hash->cellSize);
+        if (cells[a + 3] - cells[a] >= MAX_CELL_SPAN)
+            placement = OVERSIZED;
+    }
+    if (placement != GRID)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            cells[a] = 0;
+            cells[a + 3] = -1;
+        }
+    }
+    if (placement == UNBOUND)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            bounds[a] = FLT_MAX;
+            bounds[a + 3] = -FLT_MAX;
+        }
+    }
+
+    if (hash->placement[face] == OVERSIZED && placement != OVERSIZED)
+        removeOversized(hash, face);
+    else if (hash->placement[face] != OVERSIZED && placement == OVERSIZED)
+        hash->oversized[hash->numOversized++] = face;
+    hash->placement[face] = placement;
+
+    // Remove from cells it left, then insert into (or update bounds in) current ones
+    int32_t *old = hash->cells[face];
+    for (int32_t x = old[0]; x <= old[3]; x++)
+        for (int32_t y = old[1]; y <= old[4]; y++)
+            for (int32_t z = old[2]; z <= old[5]; z++)
+                if (x < cells[0] || x > cells[3] || y < cells[1] || y > cells[4] || z < cells[2] || z > cells[5])
+                    bucketRemove(&hash->buckets[hashCell(x, y, z, hash->numBuckets)], face);
+    for (int32_t x = cells[0]; x <= cells[3]; x++)
+        for (int32_t y = cells[1]; y <= cells[4]; y++)
+            for (int32_t z = cells[2]; z <= cells[5]; z++)
+                bucketInsert(&hash->buckets[hashCell(x, y, z, hash->numBuckets)], face, bounds);
+    memcpy(old, cells, sizeof(cells));
+}
+
+// Intersects bounds of vertex's faces
+static void fitInner(SpatialHash *hash, const Mesh *mesh, uint32_t vertex)
+{
+    float *inner = hash->inner[vertex];
+    for (int a = 0; a < 3; a++)
+    {
+        inner[a] = -FLT_MAX;
+        inner[a + 3] = FLT_MAX;
+    }
+    for (uint32_t i = mesh->faceOffsets[vertex]; i < mesh->faceOffsets[vertex + 1]; i++)
+    {
+        const float *bounds = hash->bounds[mesh->faces[i]];
+        for (int a = 0; a < 3; a++)
+        {
+            inner[a] = glm_max(inner[a], bounds[a]);
+            inner[a + 3] = glm_min(inner[a + 3], bounds[a + 3]);
+        }
+    }
+}
+
+static bool insideBounds(const float *bounds, const vec3 point)
+{
+    return point[0] >= bounds[0] && point[0] <= bounds[3] &&
+           point[1] >= bounds[1] && point[1] <= bounds[4] &&
+           point[2] >= bounds[2] && point[2] <= bounds[5];
+}
+
+// Whether any edge of triangle a crosses triangle b (coplanar overlaps are not reported)
+static bool edgesCross(const Mesh *mesh, const uint32_t *a, const uint32_t *b)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        Ray edge;
+        RayHit hit;
+        glm_vec3_copy(mesh->vertices[a[k]].position, edge.origin);
+        glm_vec3_sub(mesh->vertices[a[(k + 1) % 3]].position, edge.origin, edge.direction);
+        if (intersectTriangle(&edge,
+                              mesh->vertices[b[0]].position,
+                              mesh->vertices[b[1]].position,
+                              mesh->vertices[b[2]].position,
+                              &hit) &&
+            hit.t <= 1.0f)
+            return true;
+    }
+    return false;
+}
+
+// Gap between the projections of triangles a and b onto axis (negative if they overlap)
+static float projectedGap(const Mesh *mesh, const uint32_t *a, const uint32_t *b, vec3 axis)
+{
+    float minA = FLT_MAX, maxA = -FLT_MAX, minB = FLT_MAX, maxB = -FLT_MAX;
+    for (int k = 0; k < 3; k++)
+    {
+        float pa = glm_vec3_dot(axis, mesh->vertices[a[k]].position);
+        float pb = glm_vec3_dot(axis, mesh->vertices[b[k]].position);
+        minA = glm_min(minA, pa);
+        maxA = glm_max(maxA, pa);
+        minB = glm_min(minB, pb);
+        maxB = glm_max(maxB, pb);
+    }
+    return glm_max(minB - maxA, minA - maxB);
+}
+
+// Finds the direction triangles are furthest apart along among the axes that separate any two disjoint
+// triangles, returning whether they are apart along it
+static bool separatingAxis(const Mesh *mesh, const uint32_t *a, const uint32_t *b, vec3 axis)
+{
+    vec3 edgesA[3], edgesB[3];
+    for (int k = 0; k < 3; k++)
+    {
+        glm_vec3_sub(mesh->vertices[a[(k + 1) % 3]].position, mesh->vertices[a[k]].position, edgesA[k]);
+        glm_vec3_sub(mesh->vertices[b[(k + 1) % 3]].position, mesh->vertices[b[k]].position, edgesB[k]);
+    }
+
+    // Normals, cross products of an edge of each, and the normals' cross products with edges (for coplanar faces)
+    vec3 axes[17];
+    glm_vec3_cross(edgesA[0], edgesA[1], axes[0]);
+    glm_vec3_cross(edgesB[0], edgesB[1], axes[1]);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            glm_vec3_cross(edgesA[i], edgesB[j], axes[2 + 3 * i + j]);
+        glm_vec3_cross(axes[0], edgesA[i], axes[11 + i]);
+        glm_vec3_cross(axes[1], edgesB[i], axes[14 + i]);
+    }
+
+    float best = 0.0f;
+    for (int k = 0; k < 17; k++)
+    {
+        float length = glm_vec3_norm(axes[k]);
+        float gap = length > 0.0f ? projectedGap(mesh, a, b, axes[k]) / length : 0.0f;
+        if (gap <= best)
+            continue;
+        best = gap;
+        glm_vec3_scale(axes[k], 1.0f / length, axis);
+    }
+    return best > 0.0f;
+}
+
+// Adds pair of face with another face overlapping it, unless already seen by this query, too close, or collected
+// by the other face
+static void addPair(SpatialHash *hash, uint32_t fi, uint32_t fj)
+{
+    if (hash->stamps[fj] == hash->stamp)
+        return;
+    hash->stamps[fj] = hash->stamp;
+
+    // Pairs of two rebinned faces are collected by the lower one
+    if (fj < fi && hash->moved[fj])
+        return;
+
+    if (hash->numPairs == hash->pairCapacity)
+    {
+        hash->pairCapacity = 2 * hash->pairCapacity + 1024;
+        hash->pairs = realloc(hash->pairs, hash->pairCapacity * sizeof(CandidatePair));
+    }
+    hash->pairs[hash->numPairs++] = (CandidatePair){{fi, fj}, {0.0f, 0.0f, 0.0f}};
+}
+
+// Collects candidate pairs of face with faces not queried themselves in this check
+static void queryFace(SpatialHash *hash, const Mesh *mesh, uint32_t fi)
+{
+    if (hash->placement[fi] == UNBOUND)
+        return;
+    if (++hash->stamp == 0)
+    {
+        memset(hash->stamps, 0, mesh->numIndices / 3 * sizeof(uint32_t));
+        hash->stamp = 1;
+    }
+
+    // Stamp faces touching the face's vertices or their one-rings (these are too close to report)
+    const uint32_t *face = &mesh->indices[3 * fi];
+    for (int k = 0; k < 3; k++)
+    {
+        for (uint32_t i = mesh->faceOffsets[face[k]]; i < mesh->faceOffsets[face[k] + 1]; i++)
+            hash->stamps[mesh->faces[i]] = hash->stamp;
+        for (uint32_t r = mesh->ringOffsets[face[k]]; r < mesh->ringOffsets[face[k] + 1]; r++)
+        {
+            uint32_t neighbor = mesh->ring[r];
+            for (uint32_t i = mesh->faceOffsets[neighbor]; i < mesh->faceOffsets[neighbor + 1]; i++)
+                hash->stamps[mesh->faces[i]] = hash->stamp;
+        }
+    }
+
+    // Oversized faces are not in any bucket, so they check every face
+    const float *bounds = hash->bounds[fi];
+    if (hash->placement[fi] == OVERSIZED)
+    {
+        for (uint32_t fj = 0; fj < mesh->numIndices / 3; fj++)
+            if (boundsOverlap(bounds, hash->bounds[fj]))
+                addPair(hash, fi, fj);
+        return;
+    }
+
+    for (size_t i = 0; i < hash->numOversized; i++)
+        if (boundsOverlap(bounds, hash->bounds[hash->oversized[i]]))
+            addPair(hash, fi, hash->oversized[i]);
+
+    const int32_t *ci = hash->cells[fi];
+    for (int32_t x = ci[0]; x <= ci[3]; x++)
+        for (int32_t y = ci[1]; y <= ci[4]; y++)
+            for (int32_t z = ci[2]; z <= ci[5]; z++)
+            {
+                const HashBucket *bucket = &hash->buckets[hashCell(x, y, z, hash->numBuckets)];
+                for (uint32_t j = 0; j < bucket->count; j++)
+                    if (boundsOverlap(bounds, bucket->entries[j].bounds))
+                        addPair(hash, fi, bucket->entries[j].face);
+            }
+}
+
+// Rebins queued faces and replaces their candidate pairs
+static int compareFaces(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void rebinFaces(SpatialHash *hash, const Mesh *mesh)
+{
+    if (hash->numRebinned == 0)
+        return;
+    qsort(hash->rebinned, hash->numRebinned, sizeof(uint32_t), compareFaces);
+
+    for (size_t i = 0; i < hash->numRebinned; i++)
+        bindFace(hash, mesh, hash->rebinned[i]);
+    for (size_t i = 0; i < hash->numRebinned; i++)
+        for (int k = 0; k < 3; k++)
+            fitInner(hash, mesh, mesh->indices[3 * hash->rebinned[i] + k]);
+
+    // Drop pairs of rebinned faces, then query them again
+    size_t kept = 0;
+    for (size_t i = 0; i < hash->numPairs; i++)
+        if (!hash->moved[hash->pairs[i].faces[0]] && !hash->moved[hash->pairs[i].faces[1]])
+            hash->pairs[kept++] = hash->pairs[i];
+    hash->numPairs = kept;
+
+    for (size_t i = 0; i < hash->numRebinned; i++)
+        queryFace(hash, mesh, hash->rebinned[i]);
+    for (size_t i = 0; i < hash->numRebinned; i++)
+        hash->moved[hash->rebinned[i]] = 0;
+}
+
+// Empties every bucket and the oversized list
+static void clearGrid(SpatialHash *hash, size_t numFaces)
+{
+    for (size_t i = 0; i < hash->numBuckets; i++)
+        hash->buckets[i].count = 0;
+    for (size_t f = 0; f < numFaces; f++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            hash->cells[f][a] = 0;
+            hash->cells[f][a + 3] = -1;
+        }
+        hash->placement[f] = UNBOUND;
+    }
+    hash->numOversized = 0;
+}
+
+/*
+ * Spatial Hash
+ */
+
+SpatialHash *createSpatialHash(const Mesh *mesh)
+{
+    size_t numFaces = mesh->numIndices / 3;
+
+    SpatialHash *hash = malloc(sizeof(SpatialHash));
+    float edgeLength = meanEdgeLength(mesh);
+    if (!(edgeLength > 0.0f) || !isfinite(edgeLength))
+        edgeLength = 1.0f;
+    hash->cellSize = CELL_SCALE * edgeLength;
+
+    // About two buckets per face keeps chains short
+    hash->numBuckets = 1;
+    while (hash->numBuckets < 2 * numFaces)
+        hash->numBuckets <<= 1;
+    hash->buckets = calloc(hash->numBuckets, sizeof(HashBucket));
+
+    // Faces start out unbinned (empty cell range)
+    hash->cells = malloc((numFaces ? numFaces : 1) * sizeof(*hash->cells));
+    hash->placement = malloc(numFaces ? numFaces : 1);
+    hash->oversized = malloc((numFaces ? numFaces : 1) * sizeof(uint32_t));
+    clearGrid(hash, numFaces);
+
+    hash->bounds = malloc((numFaces ? numFaces : 1) * sizeof(*hash->bounds));
+    hash->longest = calloc(numFaces ? numFaces : 1, sizeof(float));
+    hash->longestSum = 0.0;
+    hash->numLongest = 0;
+    hash->inner = malloc(mesh->numVertices * sizeof(*hash->inner));
+    hash->previous = malloc(mesh->numVertices * sizeof(vec3));
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        glm_vec3_copy(mesh->vertices[v].position, hash->previous[v]);
+    hash->stamps = calloc(numFaces ? numFaces : 1, sizeof(uint32_t));
+    hash->stamp = 0;
+    hash->moved = calloc(numFaces ? numFaces : 1, sizeof(uint8_t));
+    hash->rebinned = malloc((numFaces ? numFaces : 1) * sizeof(uint32_t));
+    hash->numRebinned = 0;
+    hash->pairs = NULL;
+    hash->numPairs = hash->pairCapacity = 0;
+    hash->colliding = calloc(numFaces ? numFaces : 1, sizeof(uint8_t));
+    hash->collisions = malloc((numFaces ? numFaces : 1) * sizeof(uint32_t));
+    hash->numCollisions = 0;
+    hash->skips = 0;
+
+    // Vertices without faces are free to move anywhere
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        fitInner(hash, mesh, (uint32_t)v);
+
+    updateSpatialHash(hash, mesh);
+    hash->binnedLongest = hash->numLongest ? (float)(hash->longestSum / hash->numLongest) : 0.0f;
+
+    return hash;
+}
+
+void destroySpatialHash(SpatialHash *hash)
+{
+    if (!hash)
+        return;
+
+    for (size_t i = 0; i < hash->numBuckets; i++)
+        free(hash->buckets[i].entries);
+    free(hash->buckets);
+    free(hash->cells);
+    free(hash->placement);
+    free(hash->oversized);
+    free(hash->bounds);
+    free(hash->longest);
+    free(hash->inner);
+    free(hash->previous);
+    free(hash->stamps);
+    free(hash->moved);
+    free(hash->rebinned);
+    free(hash->pairs);
+    free(hash->colliding);
+    free(hash->collisions);
+    free(hash);
+}
+
+void updateSpatialHash(SpatialHash *hash, const Mesh *mesh)
+{
+    size_t numFaces = mesh->numIndices / 3;
+
+    for (size_t f = 0; f < numFaces; f++)
+    {
+        hash->moved[f] = 1;
+        hash->rebinned[f] = (uint32_t)f;
+    }
+    hash->numRebinned = numFaces;
+    hash->numPairs = 0;
+
+    rebinFaces(hash, mesh);
+}
+
+// Whether a vertex has moved farther than CHECK_DRIFT mean longest edges since the last full check
+static bool driftedFar(const SpatialHash *hash, const Mesh *mesh)
+{
+    float limit = CHECK_DRIFT * hash->binnedLongest;
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        if (!(glm_vec3_distance2(mesh->vertices[v].position, hash->previous[v]) <= limit * limit))
+            return true;
+    return false;
+}
+
+size_t detectSelfIntersections(SpatialHash *hash, const Mesh *mesh)
+{
+    // Between full checks, only make sure nothing has moved far enough to warrant one early
+    if (hash->skips > 0 && !driftedFar(hash, mesh))
+    {
+        hash->skips--;
+        hash->numRebinned = 0;
+        return hash->numCollisions;
+    }
+    hash->skips = CHECK_INTERVAL - 1;
+
+    // Rebin faces a vertex left
+    hash->numRebinned = 0;
+    for (size_t v = 0; v < mesh->numVertices; v++)
+    {
+        const float *position = mesh->vertices[v].position;
+        if (insideBounds(hash->inner[v], position))
+            continue;
+
+        for (uint32_t i = mesh->faceOffsets[v]; i < mesh->faceOffsets[v + 1]; i++)
+        {
+            uint32_t f = mesh->faces[i];
+            if (hash->moved[f] || insideBounds(hash->bounds[f], position))
+                continue;
+            hash->moved[f] = 1;
+            hash->rebinned[hash->numRebinned++] = f;
+        }
+    }
+
+    // A mesh that grew or shrank a lot is binned again from scratch, at a cell size in proportion
+    float mean = hash->numLongest ? (float)(hash->longestSum / hash->numLongest) : 0.0f;
+    if (mean > 0.0f && hash->binnedLongest > 0.0f &&
+        (mean > SCALE_DRIFT * hash->binnedLongest || SCALE_DRIFT * mean < hash->binnedLongest))
+    {
+        for (size_t i = 0; i < hash->numRebinned; i++)
+            hash->moved[hash->rebinned[i]] = 0;
+        hash->cellSize *= mean / hash->binnedLongest;
+        hash->binnedLongest = mean;
+        clearGrid(hash, mesh->numIndices / 3);
+        updateSpatialHash(hash, mesh);
+    }
+    else
+        rebinFaces(hash, mesh);
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        glm_vec3_copy(mesh->vertices[v].position, hash->previous[v]);
+
+    // Reset previous results
+    for (size_t i = 0; i < hash->numCollisions; i++)
+        hash->colliding[hash->collisions[i]] = 0;
+    hash->numCollisions = 0;
+
+    // Test candidates, unless still apart along the direction they were last found apart along
+    for (size_t i = 0; i < hash->numPairs; i++)
+    {
+        CandidatePair *pair = &hash->pairs[i];
+        uint32_t fi = pair->faces[0], fj = pair->faces[1];
+        if (hash->colliding[fi] && hash->colliding[fj])
+            continue; // nothing new to learn
+
+        const uint32_t *a = &mesh->indices[3 * fi];
+        const uint32_t *b = &mesh->indices[3 * fj];
+        if (projectedGap(mesh, a, b, pair->axis) > 0.0f)
+            continue;
+        if (separatingAxis(mesh, a, b, pair->axis))
+            continue;
+        if (!edgesCross(mesh, a, b) && !edgesCross(mesh, b, a))
+            continue;
+
+        if (!hash->colliding[fi])
+        {
+            hash->colliding[fi] = 1;
+            hash->collisions[hash->numCollisions++] = fi;
+        }
+        if (!hash->colliding[fj])
+        {
+            hash->colliding[fj] = 1;
+            hash->collisions[hash->numCollisions++] = fj;
+        }
+    }
+
+    return hash->numCollisions;
+}
+
+float meanEdgeLength(const Mesh *mesh)
+{
+    if (mesh->numIndices == 0)
+        return 0.0f;
+
+    double sum = 0.0;
+    for (size_t i = 0; i < mesh->numIndices; i += 3)
+        for (int k = 0; k < 3; k++)
+            sum += glm_vec3_distance(mesh->vertices[mesh->indices[i + k]].position,
+                                     mesh->vertices[mesh->indices[i + (k + 1) % 3]].position);
+    return (float)(sum / mesh->numIndices);
+}
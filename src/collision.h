@@ -0,0 +1,139 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "model.h"
+
+#include <stdint.h>
+
+// Spatial hash settings
+#define CELL_SCALE 2.0f    // cell size relative to mean edge length
+#define MARGIN_SCALE 0.1f  // bounds inflation relative to each face's longest edge
+#define SWEEP_SCALE 1.0f   // farthest bounds stretch along their vertices' last motion, relative to the face's longest edge
+#define SWEEP_STEPS 8      // most checks' worth of last motion bounds stretch over
+#define MAX_CELL_SPAN 8    // most cells a face's bounds may span per axis (bigger faces are kept out of the grid)
+#define SCALE_DRIFT 2.0f   // factor the mean longest edge may grow or shrink by before the grid is rebuilt
+#define CHECK_INTERVAL 4   // most calls per full check (the others only measure how far vertices have moved)
+#define CHECK_DRIFT 0.25f  // farthest a vertex may move between full checks, relative to the mean longest edge
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Entry of spatial hash bucket; bounds are kept inline so that scanning a bucket reads contiguous memory.
+ */
+typedef struct
+{
+    uint32_t face;    // face index
+    float bounds[6];  // inflated bounding box of face (min xyz, max xyz)
+} HashEntry;
+
+/**
+ * @brief Bucket of spatial hash (triangles whose bounds overlap cells hashing here), sorted by face.
+ */
+typedef struct
+{
+    HashEntry *entries;       // entries of faces in bucket
+    uint32_t count, capacity; // number of entries, allocated entries
+} HashBucket;
+
+/**
+ * @brief Candidate pair of faces whose bounds overlap.
+ */
+typedef struct
+{
+    uint32_t faces[2]; // faces of pair
+    vec3 axis;         // direction the faces were last found apart along (zero if not yet)
+} CandidatePair;
+
+/**
+ * @brief Uniform spatial hash over mesh triangles, used to detect self-intersections.
+ *
+ * Faces are binned by bounds that cover where their vertices' last motion takes them over the next steps,
+ * inflated by a margin relative to the face's size, and faces whose bounds overlap are cached as candidate
+ * pairs unless they are within two edges of each other. Each check only rebins the faces a vertex has left
+ * and replaces their pairs, and only fully tests pairs that are no longer apart along the axis they were last
+ * found apart along, so its cost follows how much of the mesh moves rather than the mesh's size. Only every
+ * CHECK_INTERVAL-th check does this, unless a vertex has moved CHECK_DRIFT mean longest edges since the last one
+ * that did, so faces that steadily move are rebinned less often and intersections are still found early.
+ */
+struct SpatialHash
+{
+    float cellSize;          // edge length of a cell
+    HashBucket *buckets;     // buckets (power of two many)
+    size_t numBuckets;       // number of buckets
+    int32_t (*cells)[6];     // cell range of each face (min xyz, max xyz; empty unless in the grid)
+    float (*bounds)[6];      // inflated bounding box of each face (min xyz, max xyz; empty if not finite)
+    uint8_t *placement;      // where each face is binned
+    uint32_t *oversized;     // faces too big for the grid
+    size_t numOversized;     // number of oversized faces
+    float *longest;          // longest edge of each face when binned (0 if not finite)
+    double longestSum;       // sum of longest
+    size_t numLongest;       // faces with finite longest edges
+    float binnedLongest;     // mean longest edge when cell size was derived
+    float (*inner)[6];       // intersection of each vertex's faces' bounds (the vertex may move freely inside)
+    vec3 *previous;          // vertex positions at last check
+    uint32_t *stamps;        // last query each face was found by (or found too close to)
+    uint32_t stamp;          // current query
+    uint8_t *moved;          // whether each face is being rebinned
+    uint32_t *rebinned;      // faces rebinned by last check
+    size_t numRebinned;      // number of entries in rebinned
+    CandidatePair *pairs;    // candidate face pairs
+    size_t numPairs;         // number of candidate pairs
+    size_t pairCapacity;     // allocated candidate pairs
+    uint8_t *colliding;      // whether each face intersects another face
+    uint32_t *collisions;    // colliding faces
+    size_t numCollisions;    // number of colliding faces
+    size_t skips;            // calls that may still skip the full check
+};
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates spatial hash for mesh, sized from its mean edge length.
+ *
+ * @param mesh Mesh to create hash for.
+ * @return Initialized spatial hash, binned at current vertex positions.
+ */
+SpatialHash *createSpatialHash(const Mesh *mesh);
+
+/**
+ * @brief Destroys spatial hash and frees space.
+ *
+ * @param hash Spatial hash to destroy (may be NULL).
+ */
+void destroySpatialHash(SpatialHash *hash);
+
+/**
+ * @brief Rebins every face and rebuilds all candidate pairs.
+ *
+ * @param hash Spatial hash to update.
+ * @param mesh Mesh hash was created for.
+ */
+void updateSpatialHash(SpatialHash *hash, const Mesh *mesh);
+
+/**
+ * @brief Finds faces intersecting other faces that are at least two edges away.
+ *
+ * Faces whose bounds a vertex has left are rebinned first, and the whole grid is rebuilt at a new cell size once
+ * the mesh's mean longest edge has grown or shrunk by SCALE_DRIFT. Results are stored in the hash's colliding mask and collision list.
+ * Up to CHECK_INTERVAL - 1 calls in a row keep the last results instead, as long as no vertex has moved more than
+ * CHECK_DRIFT mean longest edges since they were found (the first call after creating the hash always checks).
+ *
+ * @param hash Spatial hash of mesh.
+ * @param mesh Mesh to check.
+ * @return Number of colliding faces.
+ */
+size_t detectSelfIntersections(SpatialHash *hash, const Mesh *mesh);
+
+/**
+ * @brief Computes mean edge length of mesh.
+ *
+ * @param mesh Mesh to measure.
+ * @return Mean edge length (each face edge counted once per face).
+ */
+float meanEdgeLength(const Mesh *mesh);
+
+#endif
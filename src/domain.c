@@ -0,0 +1,264 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+#endif
+
+#include "domain.h"
+#include "cluster.h"
+#include "partition.h"
+#include "numa.h"
+#include "job.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+/*
+ * Shared Memory
+ */
+
+// Barrier of worker processes (lives in shared memory)
+typedef struct
+{
+    pthread_mutex_t lock; // guards everything below
+    pthread_cond_t open;  // signaled when the last worker arrives
+    size_t count;         // workers taking part
+    size_t arrived;       // workers waiting in current round
+    size_t round;         // rounds completed
+} SharedBarrier;
+
+static void initBarrier(SharedBarrier *barrier, size_t count)
+{
+    pthread_mutexattr_t lockAttributes;
+    pthread_mutexattr_init(&lockAttributes);
+    pthread_mutexattr_setpshared(&lockAttributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&barrier->lock, &lockAttributes);
+    pthread_mutexattr_destroy(&lockAttributes);
+
+    pthread_condattr_t openAttributes;
+    pthread_condattr_init(&openAttributes);
+    pthread_condattr_setpshared(&openAttributes, PTHREAD_PROCESS_SHARED);
+    pthread_cond_init(&barrier->open, &openAttributes);
+    pthread_condattr_destroy(&openAttributes);
+
+    barrier->count = count;
+    barrier->arrived = barrier->round = 0;
+}
+
+static void waitBarrier(SharedBarrier *barrier)
+{
+    pthread_mutex_lock(&barrier->lock);
+    size_t round = barrier->round;
+    if (++barrier->arrived == barrier->count)
+    {
+        barrier->arrived = 0;
+        barrier->round++;
+        pthread_cond_broadcast(&barrier->open);
+    }
+    else
+        while (barrier->round == round)
+            pthread_cond_wait(&barrier->open, &barrier->lock);
+    pthread_mutex_unlock(&barrier->lock);
+}
+
+/*
+ * Workers
+ */
+
+// Everything a worker needs (set up before forking, so every worker inherits it)
+typedef struct
+{
+    const Mesh *mesh;         // mesh being flowed (only read)
+    const uint32_t *renumber; // new index of every vertex (parts are contiguous ranges)
+    const uint32_t *original; // vertex at every new index
+    const size_t *offsets;    // first new index of every part (and one past the last part)
+    SharedBarrier *barrier;   // barrier between steps (shared)
+    size_t *halos;            // halo vertices of every worker (shared)
+    float (*positions[2])[3]; // position buffers, in new order (shared)
+    GEOMETRIC_FLOW flow;      // flow computed
+    PRECISION precision;      // arithmetic of sweeps and updates
+    float deltaTime;          // time step
+    size_t steps;             // steps to flow
+    size_t nodes;             // NUMA nodes workers are spread over
+} DomainWork;
+
+// Flows one part (in its own process)
+static void runWorker(const DomainWork *work, size_t domain)
+{
+    // Everything this worker writes is first touched from its node
+    pinToNode(domain % work->nodes);
+    size_t begin = work->offsets[domain], end = work->offsets[domain + 1];
+    uint32_t *halo;
+    size_t numHalo;
+    Mesh *local = cutCluster(work->mesh, work->renumber, work->original, begin, end, &halo, &numHalo);
+    local->precision = work->precision;
+    work->halos[domain] = numHalo;
+
+    size_t numOwned = end - begin;
+    for (size_t i = 0; i < numOwned; i++)
+        glm_vec3_copy(local->vertices[i].position, work->positions[0][begin + i]);
+    waitBarrier(work->barrier);
+
+    for (size_t step = 0; step < work->steps; step++)
+    {
+        // Halo exchange: neighbors' positions of the last step (owned positions are already current)
+        float(*read)[3] = work->positions[step % 2], (*write)[3] = work->positions[1 - step % 2];
+        for (size_t i = 0; i < numHalo; i++)
+            glm_vec3_copy(read[halo[i]], local->vertices[numOwned + i].position);
+
+        stepFlow(local, work->flow, work->deltaTime, NULL);
+        for (size_t i = 0; i < numOwned; i++)
+            glm_vec3_copy(local->vertices[i].position, write[begin + i]);
+        waitBarrier(work->barrier);
+    }
+
+    free(halo);
+    destroyMesh(local);
+}
+
+// Waits for every worker, killing the rest as soon as one fails (they would wait at the barrier forever)
+static bool waitForWorkers(pid_t *workers, size_t count)
+{
+    bool succeeded = true;
+    for (size_t remaining = count; remaining > 0; remaining--)
+    {
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0)
+            return false;
+        for (size_t i = 0; i < count; i++)
+            if (workers[i] == pid)
+                workers[i] = 0;
+        if (succeeded && (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS))
+        {
+            succeeded = false;
+            for (size_t i = 0; i < count; i++)
+                if (workers[i] > 0)
+                    kill(workers[i], SIGKILL);
+        }
+    }
+    return succeeded;
+}
+
+#endif
+
+/*
+ * Flow
+ */
+
+bool flowDomains(Mesh *mesh, GEOMETRIC_FLOW flow, PRECISION precision, float deltaTime, size_t steps,
+                 size_t domains, DomainReport *report)
+{
+#ifdef _WIN32
+    fprintf(stderr, "Error: domain decomposition needs fork, which Windows does not have\n");
+    return false;
+#else
+    size_t numVertices = mesh->numVertices;
+    domains = domains ? domains : 1;
+    domains = domains < numVertices ? domains : (numVertices ? numVertices : 1);
+
+    // Partition, and renumber vertices part by part (keeping their order within each part)
+    double start = wallTime();
+    uint32_t *part = partitionMesh(mesh, domains);
+    size_t *offsets = calloc(domains + 1, sizeof(size_t));
+    for (size_t v = 0; v < numVertices; v++)
+        offsets[part[v] + 1]++;
+    for (size_t d = 0; d < domains; d++)
+        offsets[d + 1] += offsets[d];
+    uint32_t *renumber = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t));
+    uint32_t *original = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t));
+    size_t *fill = malloc(domains * sizeof(size_t));
+    memcpy(fill, offsets, domains * sizeof(size_t));
+    for (size_t v = 0; v < numVertices; v++)
+    {
+        renumber[v] = (uint32_t)fill[part[v]]++;
+        original[renumber[v]] = (uint32_t)v;
+    }
+    free(fill);
+    DomainReport stats = {domains, countNodes(), countCutEdges(mesh, part), 0, wallTime() - start, 0.0};
+    free(part);
+
+    // Shared memory: barrier, halo sizes, and both position buffers (pages are left for workers to touch first)
+    size_t haloBytes = (domains * sizeof(size_t) + 63) / 64 * 64;
+    size_t bufferBytes = (numVertices * 3 * sizeof(float) + 63) / 64 * 64;
+    size_t barrierBytes = (sizeof(SharedBarrier) + 63) / 64 * 64;
+    size_t size = barrierBytes + haloBytes + 2 * bufferBytes;
+    unsigned char *shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        fprintf(stderr, "Error: cannot map %zu bytes of shared memory\n", size);
+        free(offsets);
+        free(renumber);
+        free(original);
+        return false;
+    }
+    DomainWork work = {mesh, renumber, original, offsets, (SharedBarrier *)shared, (size_t *)(shared + barrierBytes),
+                       {(float(*)[3])(shared + barrierBytes + haloBytes),
+                        (float(*)[3])(shared + barrierBytes + haloBytes + bufferBytes)},
+                       flow, precision, deltaTime, steps, stats.nodes};
+    initBarrier(work.barrier, domains);
+
+    // Workers (output is flushed first, so nothing buffered is written twice)
+    start = wallTime();
+    fflush(stdout);
+    fflush(stderr);
+    pid_t *workers = calloc(domains, sizeof(pid_t));
+    bool succeeded = true;
+    for (size_t d = 0; d < domains && succeeded; d++)
+    {
+        workers[d] = fork();
+        if (workers[d] == 0)
+        {
+            runWorker(&work, d);
+            _exit(EXIT_SUCCESS);
+        }
+        if (workers[d] < 0)
+        {
+            fprintf(stderr, "Error: cannot start worker process %zu\n", d);
+            workers[d] = 0;
+            for (size_t i = 0; i < d; i++)
+                kill(workers[i], SIGKILL);
+            succeeded = false;
+        }
+    }
+    size_t started = 0;
+    while (started < domains && workers[started] > 0)
+        started++;
+    succeeded = waitForWorkers(workers, started) && succeeded;
+    stats.flowTime = wallTime() - start;
+    free(workers);
+
+    // Latest positions back into mesh
+    if (succeeded)
+    {
+        const float(*positions)[3] = (const float(*)[3])work.positions[steps % 2];
+        for (size_t v = 0; v < numVertices; v++)
+            glm_vec3_copy((float *)positions[renumber[v]], mesh->vertices[v].position);
+        for (size_t d = 0; d < domains; d++)
+            stats.haloVertices += work.halos[d];
+        mesh->dirtyBegin = 0;
+        mesh->dirtyEnd = numVertices;
+    }
+    else
+        fprintf(stderr, "Error: a worker process failed\n");
+    if (report)
+        *report = stats;
+
+    pthread_mutex_destroy(&work.barrier->lock);
+    pthread_cond_destroy(&work.barrier->open);
+    munmap(shared, size);
+    free(offsets);
+    free(renumber);
+    free(original);
+    return succeeded;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef DOMAIN_H
+#define DOMAIN_H
+
+#include "model.h"
+#include "geometry.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief How a mesh was split across worker processes, and what each phase cost.
+ */
+typedef struct
+{
+    size_t domains;       // worker processes (one per part)
+    size_t nodes;         // NUMA nodes workers were spread over
+    size_t cutEdges;      // edges between parts
+    size_t haloVertices;  // vertices read by a worker that does not own them (summed over workers)
+    double partitionTime; // seconds spent partitioning
+    double flowTime;      // seconds from starting workers until the last one finished
+} DomainReport;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Flows mesh in worker processes, one per part of a graph partition, giving the same positions as an
+ * in-process flow.
+ *
+ * Vertices are partitioned (see partitionMesh) and renumbered so every part is a contiguous range. Positions
+ * live in two buffers of memory shared by all workers, which are forked after partitioning. Each worker pins
+ * itself to a NUMA node (round robin), then cuts its own part out of the mesh (see cutCluster), so its faces,
+ * adjacency, and owned positions are first touched, and placed, on that node. Every step, a worker gathers its
+ * owned and halo positions from one buffer, flows them, and writes its owned positions to the other; a barrier
+ * between steps keeps halos one step behind, exactly as an in-process step sees them. Only positions are written
+ * back to mesh (its curvature and normals are left as they were). Needs fork (not available on Windows).
+ *
+ * @param mesh      Mesh to flow (with adjacency).
+ * @param flow      Flow to compute (mean or Gaussian curvature flow).
+ * @param precision Arithmetic of curvature sweeps and updates (float or mixed).
+ * @param deltaTime Time step.
+ * @param steps     Number of steps.
+ * @param domains   Number of worker processes.
+ * @param report    Destination of partition and timing stats (may be NULL).
+ * @return True if every worker finished.
+ */
+bool flowDomains(Mesh *mesh, GEOMETRIC_FLOW flow, PRECISION precision, float deltaTime, size_t steps,
+                 size_t domains, DomainReport *report);
+
+#endif
@@ -0,0 +1,694 @@
+#include "generate.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Midpoint vertex of an edge, found through an open-addressing table keyed by the edge's endpoints
+typedef struct
+{
+    uint64_t *keys;     // edge (lower endpoint << 32 | higher endpoint, 0 for empty)
+    uint32_t *vertices; // midpoint vertex of edge
+    size_t mask;        // capacity minus one (capacity is a power of two)
+} EdgeTable;
+
+static uint32_t midpoint(EdgeTable *table, Mesh *mesh, uint32_t a, uint32_t b)
+{
+    uint64_t key = a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+    size_t slot = (size_t)(key * 0x9e3779b97f4a7c15ull >> 32) & table->mask;
+    while (table->keys[slot] && table->keys[slot] != key)
+        slot = (slot + 1) & table->mask;
+    if (table->keys[slot])
+        return table->vertices[slot];
+
+    // New vertex, on the unit sphere
+    uint32_t v = (uint32_t)mesh->numVertices++;
+    glm_vec3_add(mesh->vertices[a].position, mesh->vertices[b].position, mesh->vertices[v].position);
+    glm_vec3_normalize(mesh->vertices[v].position);
+    table->keys[slot] = key;
+    table->vertices[slot] = v;
+    return v;
+}
+
+Mesh *createIcosphere(size_t levels)
+{
+    // Final size: V - E + F = 2 on a sphere, and every face has three edges shared by two faces
+    size_t numFaces = 20;
+    for (size_t i = 0; i < levels; i++)
+        numFaces *= 4;
+    size_t numVertices = numFaces / 2 + 2 + 1;
+
+    Mesh *mesh = calloc(1, sizeof(Mesh));
+    mesh->vertices = calloc(numVertices, sizeof(Vertex));
+    mesh->indices = malloc(3 * numFaces * sizeof(uint32_t));
+
+    // Icosahedron (after the dummy vertex 0)
+    const float t = (1.0f + sqrtf(5.0f)) / 2.0f;
+    const float corners[12][3] = {{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t},
+                                  {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+    const uint32_t faces[20][3] = {{0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11}, {1, 5, 9}, {5, 11, 4},
+                                   {11, 10, 2}, {10, 7, 6}, {7, 1, 8}, {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8},
+                                   {3, 8, 9}, {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}};
+    mesh->numVertices = 13;
+    for (int i = 0; i < 12; i++)
+        glm_vec3_normalize_to((float *)corners[i], mesh->vertices[i + 1].position);
+    mesh->numIndices = 60;
+    for (int i = 0; i < 60; i++)
+        mesh->indices[i] = faces[i / 3][i % 3] + 1;
+
+    // Split every face into four around its edge midpoints, level by level (in place, from the last face down)
+    size_t capacity = 1;
+    while (capacity < 2 * 3 * numFaces / 2)
+        capacity *= 2;
+    EdgeTable table = {malloc(capacity * sizeof(uint64_t)), malloc(capacity * sizeof(uint32_t)), capacity - 1};
+    for (size_t level = 0; level < levels; level++)
+    {
+        for (size_t i = 0; i < capacity; i++)
+            table.keys[i] = 0;
+        size_t count = mesh->numIndices / 3;
+        for (size_t f = count; f-- > 0;)
+        {
+            uint32_t a = mesh->indices[3 * f], b = mesh->indices[3 * f + 1], c = mesh->indices[3 * f + 2];
+            uint32_t ab = midpoint(&table, mesh, a, b), bc = midpoint(&table, mesh, b, c);
+            uint32_t ca = midpoint(&table, mesh, c, a);
+            uint32_t split[12] = {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca};
+            for (int k = 0; k < 12; k++)
+                mesh->indices[12 * f + k] = split[k];
+        }
+        mesh->numIndices *= 4;
+    }
+    free(table.keys);
+    free(table.vertices);
+
+    // Adjacency, normals, and curvature, as for a loaded mesh
+    buildAdjacency(mesh);
+    mesh->areas = malloc(mesh->numVertices * sizeof(float));
+    mesh->faceNormals = malloc(mesh->numIndices / 3 * sizeof(vec3));
+    mesh->precision = PRECISION_FLOAT;
+    adviseMesh(mesh);
+    initCurvature(mesh);
+    mesh->dirtyEnd = mesh->numVertices;
+    return mesh;
+}
+
+/*
+ * Parallel Builds
+ */
+
+#define NOISE_CELLS_U 16 // noise lattice cells along the curve of a parametric shape (first octave)
+#define NOISE_CELLS_V 4  // noise lattice cells around its tube (first octave)
+#define NOISE_OCTAVES 3  // octaves of noise, each with twice the cells and half the amplitude
+
+// Runs function over count items in GENERATE_CHUNK chunks, on pool if there is one
+static void runChunks(ThreadPool *pool, TaskFunction function, void *data, size_t count)
+{
+    size_t numChunks = (count + GENERATE_CHUNK - 1) / GENERATE_CHUNK;
+    if (pool)
+        runTasks(pool, function, data, numChunks);
+    else
+        for (size_t i = 0; i < numChunks; i++)
+            function(data, i);
+}
+
+// Items of a chunk
+static void chunkRange(size_t index, size_t count, size_t *begin, size_t *end)
+{
+    *begin = index * GENERATE_CHUNK;
+    *end = *begin + GENERATE_CHUNK < count ? *begin + GENERATE_CHUNK : count;
+}
+
+// Turns counts stored one past each item into offsets of each item (and the total after the last)
+static void sumOffsets(uint32_t *offsets, size_t count)
+{
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; i++)
+        offsets[i + 1] += offsets[i];
+}
+
+// Sorted one-ring of v, collected from its incident faces as buildAdjacency does, returning its size (only the
+// returned entries of ring are ever written)
+static size_t gatherRing(const Mesh *mesh, uint32_t v, uint32_t *ring)
+{
+    size_t count = 0;
+    for (uint32_t i = mesh->faceOffsets[v]; i < mesh->faceOffsets[v + 1]; i++)
+    {
+        const uint32_t *face = &mesh->indices[3 * mesh->faces[i]];
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t n = face[k];
+            if (n == v)
+                continue;
+            size_t j = count;
+            while (j > 0 && ring[j - 1] > n)
+                j--;
+            if (j > 0 && ring[j - 1] == n)
+                continue;
+            memmove(&ring[j + 1], &ring[j], (count - j) * sizeof(uint32_t));
+            ring[j] = n;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Gathers each vertex's one-ring into place (nothing is written past a ring, so chunks never overlap)
+static void ringChunk(void *data, size_t index)
+{
+    Mesh *mesh = data;
+    size_t begin, end;
+    chunkRange(index, mesh->numVertices, &begin, &end);
+    for (size_t v = begin; v < end; v++)
+        gatherRing(mesh, (uint32_t)v, &mesh->ring[mesh->ringOffsets[v]]);
+}
+
+// Builds one-rings of a mesh whose vertex-face lists are built, and whose ring sizes are stored one past each
+// vertex in ringOffsets (generators know them up front, which saves gathering every ring twice)
+static void buildRings(Mesh *mesh, ThreadPool *pool)
+{
+    sumOffsets(mesh->ringOffsets, mesh->numVertices);
+    size_t numRing = mesh->ringOffsets[mesh->numVertices];
+    mesh->ring = malloc((numRing ? numRing : 1) * sizeof(uint32_t));
+    runChunks(pool, ringChunk, mesh, mesh->numVertices);
+}
+
+// Normals, curvature, and upload state of a freshly built mesh, as for a loaded mesh
+static void finishMesh(Mesh *mesh)
+{
+    mesh->areas = malloc(mesh->numVertices * sizeof(float));
+    mesh->faceNormals = malloc((mesh->numIndices / 3 ? mesh->numIndices / 3 : 1) * sizeof(vec3));
+    mesh->precision = PRECISION_FLOAT;
+    adviseMesh(mesh);
+    initCurvature(mesh);
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+}
+
+/*
+ * Loop Subdivision
+ */
+
+// Mesh being subdivided, and what each pass over it needs
+typedef struct
+{
+    const Mesh *coarse; // mesh being subdivided
+    Mesh *fine;         // subdivided mesh
+    uint32_t *upper;    // first ring entry of each coarse vertex above it (its edges are those it is the lower end of)
+    uint32_t *edgeBase; // id of each coarse vertex's first edge
+} Subdivision;
+
+// Corner of face at vertex v
+static int corner(const uint32_t *face, uint32_t v)
+{
+    return face[0] == v ? 0 : face[1] == v ? 1 : 2;
+}
+
+// Next face shared by a and b, advancing cursors through their sorted face lists (UINT32_MAX when none is left)
+static uint32_t nextShared(const Mesh *mesh, uint32_t a, uint32_t b, uint32_t *i, uint32_t *j)
+{
+    uint32_t endA = mesh->faceOffsets[a + 1], endB = mesh->faceOffsets[b + 1];
+    while (*i < endA && *j < endB)
+    {
+        uint32_t fa = mesh->faces[*i], fb = mesh->faces[*j];
+        if (fa == fb)
+        {
+            (*i)++;
+            (*j)++;
+            return fa;
+        }
+        if (fa < fb)
+            (*i)++;
+        else
+            (*j)++;
+    }
+    return UINT32_MAX;
+}
+
+// Number of faces shared by a and b
+static size_t countShared(const Mesh *mesh, uint32_t a, uint32_t b)
+{
+    uint32_t i = mesh->faceOffsets[a], j = mesh->faceOffsets[b];
+    size_t count = 0;
+    while (nextShared(mesh, a, b, &i, &j) != UINT32_MAX)
+        count++;
+    return count;
+}
+
+// New vertex on the edge between a and b
+static uint32_t edgeVertex(const Subdivision *subdivision, uint32_t a, uint32_t b)
+{
+    const Mesh *coarse = subdivision->coarse;
+    uint32_t lo = a < b ? a : b, hi = a < b ? b : a;
+    uint32_t first = subdivision->upper[lo], last = coarse->ringOffsets[lo + 1];
+    while (first < last)
+    {
+        uint32_t middle = first + (last - first) / 2;
+        if (coarse->ring[middle] < hi)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return (uint32_t)coarse->numVertices + subdivision->edgeBase[lo] + (first - subdivision->upper[lo]);
+}
+
+// Finds where each coarse vertex's edges start in its ring, counting them one past the vertex
+static void edgeChunk(void *data, size_t index)
+{
+    Subdivision *subdivision = data;
+    const Mesh *coarse = subdivision->coarse;
+    size_t begin, end;
+    chunkRange(index, coarse->numVertices, &begin, &end);
+    for (size_t v = begin; v < end; v++)
+    {
+        uint32_t first = coarse->ringOffsets[v], last = coarse->ringOffsets[v + 1];
+        while (first < last && coarse->ring[first] < v)
+            first++;
+        subdivision->upper[v] = first;
+        subdivision->edgeBase[v + 1] = last - first;
+    }
+}
+
+// Splits each coarse face into four: one at each corner, then one in the middle
+static void splitChunk(void *data, size_t index)
+{
+    Subdivision *subdivision = data;
+    size_t begin, end;
+    chunkRange(index, subdivision->coarse->numIndices / 3, &begin, &end);
+    for (size_t f = begin; f < end; f++)
+    {
+        const uint32_t *face = &subdivision->coarse->indices[3 * f];
+        uint32_t a = face[0], b = face[1], c = face[2];
+        uint32_t ab = edgeVertex(subdivision, a, b), bc = edgeVertex(subdivision, b, c);
+        uint32_t ca = edgeVertex(subdivision, c, a);
+        uint32_t split[12] = {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca};
+        memcpy(&subdivision->fine->indices[12 * f], split, sizeof(split));
+    }
+}
+
+// Loop's smoothed position of coarse vertex v
+static void evenPosition(const Mesh *coarse, uint32_t v, vec3 dest)
+{
+    // Neighbors along boundary edges (edges of a single face)
+    uint32_t first = coarse->ringOffsets[v], last = coarse->ringOffsets[v + 1], boundary[2];
+    size_t numBoundary = 0;
+    for (uint32_t i = first; i < last; i++)
+        if (countShared(coarse, v, coarse->ring[i]) == 1 && numBoundary++ < 2)
+            boundary[numBoundary - 1] = coarse->ring[i];
+
+    const float *position = coarse->vertices[v].position;
+    double sum[3] = {0.0, 0.0, 0.0}, weight;
+    if (numBoundary == 0 && last > first)
+    {
+        // Interior: 1 - n beta of itself, beta of each neighbor
+        size_t n = last - first;
+        double beta = n == 3 ? 3.0 / 16.0 : 3.0 / (8.0 * n);
+        for (uint32_t i = first; i < last; i++)
+            for (int d = 0; d < 3; d++)
+                sum[d] += beta * coarse->vertices[coarse->ring[i]].position[d];
+        weight = 1.0 - n * beta;
+    }
+    else if (numBoundary == 2)
+    {
+        // Boundary: 3/4 of itself, 1/8 of each boundary neighbor
+        for (int d = 0; d < 3; d++)
+            sum[d] = 0.125 * coarse->vertices[boundary[0]].position[d] + 0.125 * coarse->vertices[boundary[1]].position[d];
+        weight = 0.75;
+    }
+    else
+        weight = 1.0; // corner, or not on any face
+    for (int d = 0; d < 3; d++)
+        dest[d] = (float)(sum[d] + weight * position[d]);
+}
+
+// Loop's position of the new vertex on the edge between a and b, returning the faces sharing the edge
+static size_t oddPosition(const Mesh *coarse, uint32_t a, uint32_t b, vec3 dest)
+{
+    uint32_t i = coarse->faceOffsets[a], j = coarse->faceOffsets[b], face, opposite[2];
+    size_t count = 0;
+    while ((face = nextShared(coarse, a, b, &i, &j)) != UINT32_MAX)
+    {
+        const uint32_t *corners = &coarse->indices[3 * face];
+        if (count < 2)
+            opposite[count] = corners[3 - corner(corners, a) - corner(corners, b)];
+        count++;
+    }
+
+    const float *pa = coarse->vertices[a].position, *pb = coarse->vertices[b].position;
+    for (int d = 0; d < 3; d++)
+        if (count == 2)
+        {
+            const float *pc = coarse->vertices[opposite[0]].position, *pd = coarse->vertices[opposite[1]].position;
+            dest[d] = (float)(0.375 * ((double)pa[d] + pb[d]) + 0.125 * ((double)pc[d] + pd[d]));
+        }
+        else
+            dest[d] = (float)(0.5 * ((double)pa[d] + pb[d])); // boundary (or non-manifold) edge
+    return count;
+}
+
+// Positions, face counts, and ring sizes of each coarse vertex and of the new vertices on its edges
+static void vertexChunk(void *data, size_t index)
+{
+    Subdivision *subdivision = data;
+    const Mesh *coarse = subdivision->coarse;
+    Mesh *fine = subdivision->fine;
+    size_t begin, end;
+    chunkRange(index, coarse->numVertices, &begin, &end);
+    for (size_t v = begin; v < end; v++)
+    {
+        evenPosition(coarse, (uint32_t)v, fine->vertices[v].position);
+        fine->faceOffsets[v + 1] = coarse->faceOffsets[v + 1] - coarse->faceOffsets[v];
+        fine->ringOffsets[v + 1] = coarse->ringOffsets[v + 1] - coarse->ringOffsets[v];
+
+        // Every face on an edge gives its new vertex two corner faces and the middle one, and two neighbors
+        // (on the face's other edges) besides the edge's ends
+        for (uint32_t i = subdivision->upper[v]; i < coarse->ringOffsets[v + 1]; i++)
+        {
+            size_t e = coarse->numVertices + subdivision->edgeBase[v] + (i - subdivision->upper[v]);
+            size_t count = oddPosition(coarse, (uint32_t)v, coarse->ring[i], fine->vertices[e].position);
+            fine->faceOffsets[e + 1] = (uint32_t)(3 * count);
+            fine->ringOffsets[e + 1] = (uint32_t)(2 + 2 * count);
+        }
+    }
+}
+
+// Vertex-face lists of each coarse vertex and of the new vertices on its edges (each comes out sorted)
+static void fillChunk(void *data, size_t index)
+{
+    Subdivision *subdivision = data;
+    const Mesh *coarse = subdivision->coarse;
+    Mesh *fine = subdivision->fine;
+    size_t begin, end;
+    chunkRange(index, coarse->numVertices, &begin, &end);
+    for (size_t v = begin; v < end; v++)
+    {
+        // A coarse vertex keeps the corner face of each of its faces
+        uint32_t *faces = &fine->faces[fine->faceOffsets[v]];
+        for (uint32_t i = coarse->faceOffsets[v]; i < coarse->faceOffsets[v + 1]; i++)
+        {
+            uint32_t f = coarse->faces[i];
+            *faces++ = 4 * f + (uint32_t)corner(&coarse->indices[3 * f], (uint32_t)v);
+        }
+
+        // A new vertex lies on the corner faces at both ends of its edge, and the middle face, of each face on it
+        for (uint32_t i = subdivision->upper[v]; i < coarse->ringOffsets[v + 1]; i++)
+        {
+            uint32_t n = coarse->ring[i], f, a = coarse->faceOffsets[v], b = coarse->faceOffsets[n];
+            size_t e = coarse->numVertices + subdivision->edgeBase[v] + (i - subdivision->upper[v]);
+            faces = &fine->faces[fine->faceOffsets[e]];
+            while ((f = nextShared(coarse, (uint32_t)v, n, &a, &b)) != UINT32_MAX)
+            {
+                uint32_t cv = (uint32_t)corner(&coarse->indices[3 * f], (uint32_t)v);
+                uint32_t cn = (uint32_t)corner(&coarse->indices[3 * f], n);
+                *faces++ = 4 * f + (cv < cn ? cv : cn);
+                *faces++ = 4 * f + (cv < cn ? cn : cv);
+                *faces++ = 4 * f + 3;
+            }
+        }
+    }
+}
+
+// One level of Loop subdivision (positions and adjacency only)
+static Mesh *subdivideOnce(const Mesh *coarse, ThreadPool *pool)
+{
+    // Edges: each vertex numbers those to neighbors above it
+    size_t numCoarse = coarse->numVertices;
+    Subdivision subdivision = {coarse, calloc(1, sizeof(Mesh)), malloc((numCoarse ? numCoarse : 1) * sizeof(uint32_t)),
+                               malloc((numCoarse + 1) * sizeof(uint32_t))};
+    runChunks(pool, edgeChunk, &subdivision, numCoarse);
+    sumOffsets(subdivision.edgeBase, numCoarse);
+
+    // Faces, then positions and adjacency sizes, then vertex-face lists and rings
+    Mesh *fine = subdivision.fine;
+    fine->numVertices = numCoarse + subdivision.edgeBase[numCoarse];
+    fine->numIndices = 4 * coarse->numIndices;
+    fine->vertices = calloc(fine->numVertices, sizeof(Vertex));
+    fine->indices = malloc((fine->numIndices ? fine->numIndices : 1) * sizeof(uint32_t));
+    fine->faceOffsets = malloc((fine->numVertices + 1) * sizeof(uint32_t));
+    fine->ringOffsets = malloc((fine->numVertices + 1) * sizeof(uint32_t));
+    runChunks(pool, splitChunk, &subdivision, coarse->numIndices / 3);
+    runChunks(pool, vertexChunk, &subdivision, numCoarse);
+    sumOffsets(fine->faceOffsets, fine->numVertices);
+    fine->faces = malloc((fine->numIndices ? fine->numIndices : 1) * sizeof(uint32_t));
+    runChunks(pool, fillChunk, &subdivision, numCoarse);
+    buildRings(fine, pool);
+
+    free(subdivision.upper);
+    free(subdivision.edgeBase);
+    return fine;
+}
+
+Mesh *subdivideMesh(const Mesh *mesh, size_t levels, ThreadPool *pool)
+{
+    Mesh *fine = NULL;
+    for (size_t level = 0; level < levels; level++)
+    {
+        Mesh *next = subdivideOnce(fine ? fine : mesh, pool);
+        if (fine)
+            destroyMesh(fine);
+        fine = next;
+    }
+    if (fine)
+        finishMesh(fine);
+    return fine;
+}
+
+/*
+ * Parametric Shapes
+ */
+
+// Grid of a parametric shape being built
+typedef struct
+{
+    Mesh *mesh;
+    SHAPE shape;
+    size_t rows, cols; // quads along the curve and around the tube (both wrap)
+    float noise;       // largest displacement, as a fraction of the tube radius
+} Parametric;
+
+// Point of a shape's curve at t in [0, 2 pi), and the radius of its tube
+static double curvePoint(SHAPE shape, double t, double dest[3])
+{
+    if (shape == SHAPE_KNOT)
+    {
+        dest[0] = (sin(t) + 2.0 * sin(2.0 * t)) / 3.0;
+        dest[1] = (cos(t) - 2.0 * cos(2.0 * t)) / 3.0;
+        dest[2] = -sin(3.0 * t) / 3.0;
+        return 0.15;
+    }
+    dest[0] = cos(t);
+    dest[1] = sin(t);
+    dest[2] = 0.0;
+    return 0.4;
+}
+
+// Lattice value in [-1, 1]
+static double latticeValue(uint32_t x, uint32_t y, uint32_t octave)
+{
+    uint32_t hash = x * 0x8da6b343u ^ y * 0xd8163841u ^ octave * 0xcb1ab31fu;
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    hash *= 0x846ca68bu;
+    hash ^= hash >> 16;
+    return hash / (double)UINT32_MAX * 2.0 - 1.0;
+}
+
+// Smooth noise in [-1, 1] over the unit square, wrapping both ways
+static double periodicNoise(double u, double v)
+{
+    double sum = 0.0, amplitude = 1.0, total = 0.0;
+    for (uint32_t octave = 0; octave < NOISE_OCTAVES; octave++, amplitude *= 0.5)
+    {
+        uint32_t cellsU = NOISE_CELLS_U << octave, cellsV = NOISE_CELLS_V << octave;
+        double x = u * cellsU, y = v * cellsV;
+        uint32_t x0 = (uint32_t)x % cellsU, y0 = (uint32_t)y % cellsV, x1 = (x0 + 1) % cellsU, y1 = (y0 + 1) % cellsV;
+        double fx = x - floor(x), fy = y - floor(y);
+        fx = fx * fx * (3.0 - 2.0 * fx);
+        fy = fy * fy * (3.0 - 2.0 * fy);
+        double bottom = latticeValue(x0, y0, octave) + fx * (latticeValue(x1, y0, octave) - latticeValue(x0, y0, octave));
+        double top = latticeValue(x0, y1, octave) + fx * (latticeValue(x1, y1, octave) - latticeValue(x0, y1, octave));
+        sum += amplitude * (bottom + fy * (top - bottom));
+        total += amplitude;
+    }
+    return sum / total;
+}
+
+// Vertex at row i and column j (rows and columns wrap)
+static uint32_t gridVertex(const Parametric *grid, size_t i, size_t j)
+{
+    return (uint32_t)(1 + i % grid->rows * grid->cols + j % grid->cols);
+}
+
+// Positions and sorted vertex-face lists of grid vertices (every vertex is on six faces)
+static void gridVertexChunk(void *data, size_t index)
+{
+    const Parametric *grid = data;
+    Mesh *mesh = grid->mesh;
+    size_t begin, end;
+    chunkRange(index, grid->rows * grid->cols, &begin, &end);
+    for (size_t q = begin; q < end; q++)
+    {
+        size_t i = q / grid->cols, j = q % grid->cols, rows = grid->rows, cols = grid->cols;
+
+        // Curve frame from central differences (exact enough for placement, and periodic like the curve)
+        double t = 2.0 * GLM_PI * i / rows, h = 1e-4, behind[3], center[3], ahead[3], tangent[3], normal[3], binormal[3];
+        double radius = curvePoint(grid->shape, t, center);
+        curvePoint(grid->shape, t - h, behind);
+        curvePoint(grid->shape, t + h, ahead);
+        double lengthT = 0.0, dotAT = 0.0, lengthN = 0.0;
+        for (int d = 0; d < 3; d++)
+        {
+            tangent[d] = ahead[d] - behind[d];
+            normal[d] = ahead[d] - 2.0 * center[d] + behind[d];
+            lengthT += tangent[d] * tangent[d];
+        }
+        for (int d = 0; d < 3; d++)
+            dotAT += normal[d] * tangent[d] / lengthT;
+        for (int d = 0; d < 3; d++)
+        {
+            normal[d] -= dotAT * tangent[d];
+            lengthN += normal[d] * normal[d];
+        }
+        for (int d = 0; d < 3; d++)
+        {
+            tangent[d] /= sqrt(lengthT);
+            normal[d] /= sqrt(lengthN);
+        }
+        binormal[0] = tangent[1] * normal[2] - tangent[2] * normal[1];
+        binormal[1] = tangent[2] * normal[0] - tangent[0] * normal[2];
+        binormal[2] = tangent[0] * normal[1] - tangent[1] * normal[0];
+
+        double angle = 2.0 * GLM_PI * j / cols;
+        radius *= 1.0 + grid->noise * periodicNoise((double)i / rows, (double)j / cols);
+        uint32_t v = gridVertex(grid, i, j);
+        for (int d = 0; d < 3; d++)
+            mesh->vertices[v].position[d] = (float)(center[d] + radius * (cos(angle) * normal[d] + sin(angle) * binormal[d]));
+
+        // Both faces of its own quad, one of the quad below, both of the one diagonally below, one of the one left
+        size_t below = (i + rows - 1) % rows * cols + j, left = i * cols + (j + cols - 1) % cols;
+        size_t diagonal = (i + rows - 1) % rows * cols + (j + cols - 1) % cols;
+        uint32_t faces[6] = {(uint32_t)(2 * q), (uint32_t)(2 * q + 1), (uint32_t)(2 * below), (uint32_t)(2 * diagonal),
+                             (uint32_t)(2 * diagonal + 1), (uint32_t)(2 * left + 1)};
+        for (int a = 1; a < 6; a++)
+            for (int b = a; b > 0 && faces[b - 1] > faces[b]; b--)
+            {
+                uint32_t swap = faces[b];
+                faces[b] = faces[b - 1];
+                faces[b - 1] = swap;
+            }
+        memcpy(&mesh->faces[6 * q], faces, sizeof(faces));
+    }
+}
+
+// Two faces of each quad, wound so normals face out of the tube
+static void gridFaceChunk(void *data, size_t index)
+{
+    const Parametric *grid = data;
+    size_t begin, end;
+    chunkRange(index, grid->rows * grid->cols, &begin, &end);
+    for (size_t q = begin; q < end; q++)
+    {
+        size_t i = q / grid->cols, j = q % grid->cols;
+        uint32_t v00 = gridVertex(grid, i, j), v10 = gridVertex(grid, i + 1, j);
+        uint32_t v11 = gridVertex(grid, i + 1, j + 1), v01 = gridVertex(grid, i, j + 1);
+        uint32_t quad[6] = {v00, v11, v10, v00, v01, v11};
+        memcpy(&grid->mesh->indices[6 * q], quad, sizeof(quad));
+    }
+}
+
+Mesh *createParametric(SHAPE shape, size_t triangles, float noise, ThreadPool *pool)
+{
+    // Quads about as long as they are wide: the knot's tube is far longer than the torus's for its girth
+    double aspect = shape == SHAPE_KNOT ? 12.0 : 2.5;
+    size_t cols = (size_t)sqrt(triangles / 2.0 / aspect);
+    cols = cols > 3 ? cols : 3;
+    size_t rows = triangles / 2 / cols > 3 ? triangles / 2 / cols : 3;
+
+    Mesh *mesh = calloc(1, sizeof(Mesh));
+    Parametric grid = {mesh, shape, rows, cols, noise};
+    size_t numQuads = rows * cols;
+    mesh->numVertices = numQuads + 1;
+    mesh->numIndices = 6 * numQuads;
+    mesh->vertices = calloc(mesh->numVertices, sizeof(Vertex));
+    mesh->indices = malloc(mesh->numIndices * sizeof(uint32_t));
+    mesh->faceOffsets = malloc((mesh->numVertices + 1) * sizeof(uint32_t));
+    mesh->faces = malloc(mesh->numIndices * sizeof(uint32_t));
+    mesh->ringOffsets = malloc((mesh->numVertices + 1) * sizeof(uint32_t));
+
+    // Six faces and six neighbors per vertex after the dummy (its lists are at the start, so grid vertex q + 1
+    // lists faces from 6q)
+    mesh->faceOffsets[0] = mesh->ringOffsets[1] = 0;
+    for (size_t v = 1; v <= mesh->numVertices; v++)
+        mesh->faceOffsets[v] = (uint32_t)(6 * (v - 1));
+    for (size_t v = 2; v <= mesh->numVertices; v++)
+        mesh->ringOffsets[v] = 6;
+    runChunks(pool, gridFaceChunk, &grid, numQuads);
+    runChunks(pool, gridVertexChunk, &grid, numQuads);
+    buildRings(mesh, pool);
+    finishMesh(mesh);
+    return mesh;
+}
+
+/*
+ * Specifications
+ */
+
+Mesh *generateMesh(const char *spec, ThreadPool *pool)
+{
+    // Name (an .obj path may hold colons, like a drive letter, so its counts start after the extension)
+    const char *extension = strstr(spec, ".obj");
+    const char *colon = strchr(extension ? extension : spec, ':');
+    size_t length = colon ? (size_t)(colon - spec) : strlen(spec);
+    double triangles = 0.0, noise = DEFAULT_NOISE;
+    if (colon && (sscanf(colon + 1, "%lf:%lf", &triangles, &noise) < 1 || triangles < 0.0 || noise < 0.0 || noise >= 1.0))
+    {
+        fprintf(stderr, "Error: invalid mesh specification: %s\n", spec);
+        return NULL;
+    }
+    if (triangles > GENERATE_MAX_TRIANGLES)
+    {
+        fprintf(stderr, "Error: %s asks for more than %u triangles\n", spec, (unsigned)GENERATE_MAX_TRIANGLES);
+        return NULL;
+    }
+
+    // Parametric shapes
+    if ((length == 5 && !strncmp(spec, "torus", 5)) || (length == 4 && !strncmp(spec, "knot", 4)))
+        return createParametric(length == 4 ? SHAPE_KNOT : SHAPE_TORUS, triangles ? (size_t)triangles : DEFAULT_TRIANGLES,
+                                (float)noise, pool);
+
+    // Icosphere: fewest levels reaching the triangles
+    if (length == 9 && !strncmp(spec, "icosphere", 9))
+    {
+        size_t levels = 0;
+        for (double faces = 20.0; faces < triangles && 4.0 * faces <= GENERATE_MAX_TRIANGLES; faces *= 4.0)
+            levels++;
+        return createIcosphere(levels);
+    }
+    if (!extension)
+    {
+        fprintf(stderr, "Error: unknown mesh: %s (expected icosphere, torus, knot, or an .obj file)\n", spec);
+        return NULL;
+    }
+
+    // File, subdivided until it reaches the triangles
+    char *filename = malloc(length + 1);
+    memcpy(filename, spec, length);
+    filename[length] = '\0';
+    Mesh *mesh = malloc(sizeof(Mesh));
+    bool loaded = loadOBJ(filename, mesh);
+    free(filename);
+    if (!loaded)
+    {
+        free(mesh);
+        return NULL;
+    }
+    size_t levels = 0;
+    for (double faces = (double)(mesh->numIndices / 3); faces && faces < triangles && 4.0 * faces <= GENERATE_MAX_TRIANGLES;
+         faces *= 4.0)
+        levels++;
+    if (!levels)
+        return mesh;
+    Mesh *fine = subdivideMesh(mesh, levels, pool);
+    destroyMesh(mesh);
+    return fine;
+}
@@ -0,0 +1,86 @@
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include "model.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Generator settings
+#define GENERATE_CHUNK 16384                    // vertices or faces per task of parallel builds
+#define GENERATE_MAX_TRIANGLES (UINT32_MAX / 3) // most triangles a mesh can index
+#define DEFAULT_TRIANGLES 100000                // triangles of a parametric shape that doesn't give a count
+#define DEFAULT_NOISE 0.1f                      // displacement of a parametric shape that doesn't give one
+
+/*
+ * Enums
+ */
+
+/**
+ * @brief Parametric shapes: tubes swept around closed curves, so their grids wrap both ways.
+ */
+typedef enum
+{
+    SHAPE_TORUS, // tube around a circle
+    SHAPE_KNOT   // tube around a trefoil knot
+} SHAPE;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates a unit icosphere: an icosahedron whose faces are split into four, levels times, with new
+ * vertices pushed out onto the sphere.
+ *
+ * Every level multiplies the faces by four (20 at level 0, about 1.3 million at level 8), so large synthetic
+ * meshes need no file. Like meshes loaded from .obj files, vertex 0 is an unused dummy.
+ *
+ * @param levels Number of subdivisions.
+ * @return Initialized mesh (with adjacency and curvature).
+ */
+Mesh *createIcosphere(size_t levels);
+
+/**
+ * @brief Subdivides mesh with Loop's scheme: every face is split into four around new edge vertices, and
+ * vertices move to the weighted averages of their neighbors that converge to a smooth surface.
+ *
+ * Boundary edges and vertices follow the boundary curve; vertices where more or fewer than two boundary edges
+ * meet stay put. Faces of the new mesh are numbered four per old face, and vertices keep their old indices,
+ * followed by one new vertex per edge. Positions, faces, and adjacency are all built in GENERATE_CHUNK chunks
+ * on pool, straight from the old mesh's adjacency.
+ *
+ * @param mesh   Mesh to subdivide (with adjacency; left untouched).
+ * @param levels Number of subdivisions (at least one).
+ * @param pool   Thread pool to build on (NULL to build on the calling thread).
+ * @return New mesh (with adjacency and curvature).
+ */
+Mesh *subdivideMesh(const Mesh *mesh, size_t levels, ThreadPool *pool);
+
+/**
+ * @brief Creates a parametric shape with about the given number of triangles, its tube radius displaced by
+ * smooth periodic noise.
+ *
+ * @param shape     Shape to create.
+ * @param triangles Triangles to aim for (the grid has at least 3 x 3 quads).
+ * @param noise     Largest displacement, as a fraction of the tube radius (0 for a smooth tube, below 1).
+ * @param pool      Thread pool to build on (NULL to build on the calling thread).
+ * @return Initialized mesh (with adjacency and curvature).
+ */
+Mesh *createParametric(SHAPE shape, size_t triangles, float noise, ThreadPool *pool);
+
+/**
+ * @brief Creates a mesh from a specification of the form NAME[:TRIANGLES[:NOISE]].
+ *
+ * NAME is "icosphere" (subdivided until it has at least TRIANGLES), "torus" or "knot" (parametric shapes of
+ * about TRIANGLES, with noise NOISE), or an .obj file, which is loaded and Loop subdivided until it has at
+ * least TRIANGLES (as loaded without a count). Counts may be written like 1e6.
+ *
+ * @param spec Specification, e.g. "models/torus.obj:1e7" or "knot:1e6:0.2".
+ * @param pool Thread pool to build on (NULL to build on the calling thread).
+ * @return Initialized mesh, or NULL if spec is invalid or its file cannot be loaded.
+ */
+Mesh *generateMesh(const char *spec, ThreadPool *pool);
+
+#endif
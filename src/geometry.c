@@ -1,122 +1,653 @@
-#define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
-
 #include "geometry.h"
 #include "model.h"
+#include "selection.h"
+#include "bvh.h"
+#include "collision.h"
+#include "ricci.h"
+#include "willmore.h"
+#include "arena.h"
 
 #include <cglm/cglm.h>
 
 #include <math.h>
+#include <stdlib.h>
 
 // TODO: Implement MCF ITI method
 // TODO: Add lower bound to flows (maybe)
 
-void computeGeometry(GLFWwindow *window, Model *model, GEOMETRIC_FLOW flow, bool flowing)
+void stepFlow(Mesh *mesh, GEOMETRIC_FLOW flow, float deltaTime, ThreadPool *pool)
 {
-    // Calculate change in time
-    static double lastTime = 0.0;
-    if (lastTime == 0.0)
-        lastTime = glfwGetTime();
-    double currentTime = glfwGetTime();
-    float deltaTime = (float)(currentTime - lastTime);
+    if (flow == MCF_VBM)
+        mcfVBM(mesh, deltaTime, pool);
+    else if (flow == MCF_ITI)
+        mcfITI(mesh, deltaTime);
+    else if (flow == GCF)
+        gcf(mesh, deltaTime, pool);
+    else if (flow == RICCI)
+        ricciFlow(mesh);
+    else if (flow == WILLMORE)
+        willmoreFlow(mesh, pool);
+
+    // Keep picking hierarchy in sync with deformed mesh
+    if (mesh->bvh)
+        refitBVH(mesh->bvh, mesh);
+
+    // Check for self-intersections
+    if (mesh->spatialHash)
+        detectSelfIntersections(mesh->spatialHash, mesh);
+}
+
+/*
+ * Curvature Sweep
+ */
 
-    // Compute flow if enabled
-    if (flowing)
+// Angle between two vectors from the length of their cross product and their dot product (sine >= 0),
+// using a minimax polynomial for atan that is accurate to about 2e-6 radians
+static inline float cornerAngle(float sine, float cosine)
+{
+    float x = fabsf(cosine);
+    float low = sine < x ? sine : x, high = sine < x ? x : sine;
+    float t = high > 0.0f ? low / high : 0.0f;
+    float t2 = t * t;
+    float angle = t * (0.99997726f + t2 * (-0.33262347f + t2 * (0.19354346f + t2 * (-0.11643287f + t2 * (0.05265332f + t2 * -0.01172120f)))));
+    angle = sine > x ? GLM_PI_2f - angle : angle;
+    return cosine < 0.0f ? GLM_PIf - angle : angle;
+}
+
+// Edges, normal, area, and corner angles of a triangle (the face and vertex sweeps both derive them here,
+// so they add exactly the same numbers; area and angles only when Gaussian curvature is swept)
+typedef struct
+{
+    vec3 edges[3];    // edge k runs from vertex k to vertex k + 1
+    vec3 cross;       // cross product of first two edges (area-weighted normal)
+    float doubleArea; // length of cross product
+    float angles[3];  // corner angle at each vertex
+} FaceGeometry;
+
+static void measureFace(const Mesh *mesh, uint32_t f, FaceGeometry *geometry, bool gaussian)
+{
+    const uint32_t *face = &mesh->indices[3 * f];
+
+    // Edges and their shared cross product
+    for (int k = 0; k < 3; k++)
+        glm_vec3_sub(mesh->vertices[face[(k + 1) % 3]].position, mesh->vertices[face[k]].position, geometry->edges[k]);
+    glm_vec3_cross(geometry->edges[0], geometry->edges[1], geometry->cross);
+    if (!gaussian)
+        return;
+    geometry->doubleArea = glm_vec3_norm(geometry->cross);
+
+    // Corner k lies between edge k and the reversed previous edge (the last corner fills up the half turn)
+    geometry->angles[0] = cornerAngle(geometry->doubleArea, -glm_vec3_dot(geometry->edges[0], geometry->edges[2]));
+    geometry->angles[1] = cornerAngle(geometry->doubleArea, -glm_vec3_dot(geometry->edges[1], geometry->edges[0]));
+    geometry->angles[2] = GLM_PIf - geometry->angles[0] - geometry->angles[1];
+}
+
+// Adds a triangle's corner k to the curvature of its vertex v
+static void addCorner(Mesh *mesh, uint32_t v, const FaceGeometry *geometry, int k, bool normals, bool gaussian)
+{
+    const float *next = geometry->edges[k], *prev = geometry->edges[(k + 2) % 3];
+    Vertex *vertex = &mesh->vertices[v];
+
+    // Umbrella Laplacian
+    glm_vec3_add(vertex->curvature, (vec3){next[0] - prev[0], next[1] - prev[1], next[2] - prev[2]}, vertex->curvature);
+
+    // Corner angle (summed here, turned into angle defect later) and barycentric area
+    if (gaussian)
     {
-        if (flow == MCF_VBM)
-            mcfVBM(model->mesh, deltaTime);
-        else if (flow == MCF_ITI)
-            mcfITI(model->mesh, deltaTime);
+        vertex->gaussian += geometry->angles[k];
+        mesh->areas[v] += geometry->doubleArea / 6.0f;
     }
 
-    // Rebind and upload new geometry
-    glBindBuffer(GL_ARRAY_BUFFER, model->mesh->VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, model->mesh->numVertices * sizeof(Vertex), model->mesh->vertices);
+    // Area-weighted normal
+    if (normals)
+        glm_vec3_add(vertex->normal, (float *)geometry->cross, vertex->normal);
+}
+
+// Adds a triangle's contributions to the curvature of its vertices (only active ones if a mask is given)
+static void accumulateFace(Mesh *mesh, uint32_t f, const uint8_t *mask, bool normals, bool gaussian)
+{
+    const uint32_t *face = &mesh->indices[3 * f];
+    FaceGeometry geometry;
+    measureFace(mesh, f, &geometry, gaussian);
 
-    lastTime = currentTime; // update time
+    for (int k = 0; k < 3; k++)
+        if (!mask || mask[face[k]] == ACTIVE)
+            addCorner(mesh, face[k], &geometry, k, normals, gaussian);
 }
 
-void mcfVBM(Mesh *mesh, float deltaTime)
+// Same as accumulateFace for a whole mesh without Gaussian curvature (the sweep of mean curvature flow), keeping
+// edges in registers rather than in a FaceGeometry (the same operations, so the same bits)
+static void accumulateEdges(Mesh *mesh, uint32_t f, bool normals)
 {
-    // Reset all curvature
-    for (size_t i = 0; i < mesh->numVertices; i++)
-        glm_vec3_zero(mesh->vertices[i].curvature);
+    const uint32_t *face = &mesh->indices[3 * f];
+    Vertex *a = &mesh->vertices[face[0]], *b = &mesh->vertices[face[1]], *c = &mesh->vertices[face[2]];
+    vec3 ab, bc, ca;
+    glm_vec3_sub(b->position, a->position, ab);
+    glm_vec3_sub(c->position, b->position, bc);
+    glm_vec3_sub(a->position, c->position, ca);
+
+    // Umbrella Laplacian (next edge minus previous edge at each corner)
+    glm_vec3_add(a->curvature, (vec3){ab[0] - ca[0], ab[1] - ca[1], ab[2] - ca[2]}, a->curvature);
+    glm_vec3_add(b->curvature, (vec3){bc[0] - ab[0], bc[1] - ab[1], bc[2] - ab[2]}, b->curvature);
+    glm_vec3_add(c->curvature, (vec3){ca[0] - bc[0], ca[1] - bc[1], ca[2] - bc[2]}, c->curvature);
 
-    // Calculate curvature
-    for (size_t i = 0; i < mesh->numIndices; i += 3)
+    // Area-weighted normal
+    if (normals)
     {
-        uint32_t v0 = mesh->indices[i];
-        uint32_t v1 = mesh->indices[i + 1];
-        uint32_t v2 = mesh->indices[i + 2];
+        vec3 cross;
+        glm_vec3_cross(ab, bc, cross);
+        glm_vec3_add(a->normal, cross, a->normal);
+        glm_vec3_add(b->normal, cross, b->normal);
+        glm_vec3_add(c->normal, cross, c->normal);
+    }
+}
 
-        vec3 diff;
-        glm_vec3_sub(mesh->vertices[v1].position, mesh->vertices[v0].position, diff);
-        glm_vec3_add(mesh->vertices[v0].curvature, diff, mesh->vertices[v0].curvature);
-        glm_vec3_sub(mesh->vertices[v0].position, mesh->vertices[v1].position, diff);
-        glm_vec3_add(mesh->vertices[v1].curvature, diff, mesh->vertices[v1].curvature);
+// Sweeps without Gaussian curvature leave it and the area as last swept
+static void resetVertex(Mesh *mesh, uint32_t v, bool normals, bool gaussian)
+{
+    glm_vec3_zero(mesh->vertices[v].curvature);
+    if (gaussian)
+    {
+        mesh->vertices[v].gaussian = 0.0f;
+        mesh->areas[v] = 0.0f;
+    }
+    if (normals)
+        glm_vec3_zero(mesh->vertices[v].normal);
+}
 
-        glm_vec3_sub(mesh->vertices[v2].position, mesh->vertices[v1].position, diff);
-        glm_vec3_add(mesh->vertices[v1].curvature, diff, mesh->vertices[v1].curvature);
-        glm_vec3_sub(mesh->vertices[v1].position, mesh->vertices[v2].position, diff);
-        glm_vec3_add(mesh->vertices[v2].curvature, diff, mesh->vertices[v2].curvature);
+// Boundary vertices have one more neighbor than faces, and only half a turn to fill
+static inline bool onBoundary(const Mesh *mesh, uint32_t v)
+{
+    return mesh->ringOffsets[v + 1] - mesh->ringOffsets[v] > mesh->faceOffsets[v + 1] - mesh->faceOffsets[v];
+}
 
-        glm_vec3_sub(mesh->vertices[v0].position, mesh->vertices[v2].position, diff);
-        glm_vec3_add(mesh->vertices[v2].curvature, diff, mesh->vertices[v2].curvature);
-        glm_vec3_sub(mesh->vertices[v2].position, mesh->vertices[v0].position, diff);
-        glm_vec3_add(mesh->vertices[v0].curvature, diff, mesh->vertices[v0].curvature);
+// Turns a vertex's summed corner angles into Gaussian curvature
+static void finishVertex(Mesh *mesh, uint32_t v)
+{
+    float defect = (onBoundary(mesh, v) ? GLM_PIf : 2.0f * GLM_PIf) - mesh->vertices[v].gaussian;
+    mesh->vertices[v].gaussian = mesh->areas[v] > 0.0f ? defect / mesh->areas[v] : 0.0f;
+}
+
+// Computes curvature of one vertex by visiting its faces in ascending order, as the face sweep adds them, so
+// both sweeps give the same bits
+static void gatherVertex(Mesh *mesh, uint32_t v, bool normals, bool gaussian)
+{
+    resetVertex(mesh, v, normals, gaussian);
+    int k = -1;
+    for (uint32_t i = mesh->faceOffsets[v]; i < mesh->faceOffsets[v + 1]; i++)
+    {
+        // Faces listing the vertex more than once (degenerate) appear once per corner, in corner order
+        uint32_t f = mesh->faces[i];
+        const uint32_t *face = &mesh->indices[3 * f];
+        k = i > mesh->faceOffsets[v] && mesh->faces[i - 1] == f ? k + 1 : 0;
+        while (face[k] != v)
+            k++;
+
+        FaceGeometry geometry;
+        measureFace(mesh, f, &geometry, gaussian);
+        addCorner(mesh, v, &geometry, k, normals, gaussian);
     }
+    if (gaussian)
+        finishVertex(mesh, v);
+}
+
+// Same as cornerAngle in double (the polynomial bounds its accuracy, but nothing is rounded to float)
+static inline double cornerAnglePrecise(double sine, double cosine)
+{
+    double x = fabs(cosine);
+    double low = sine < x ? sine : x, high = sine < x ? x : sine;
+    double t = high > 0.0 ? low / high : 0.0;
+    double t2 = t * t;
+    double angle = t * (0.99997726 + t2 * (-0.33262347 + t2 * (0.19354346 + t2 * (-0.11643287 + t2 * (0.05265332 + t2 * -0.01172120)))));
+    angle = sine > x ? GLM_PI_2 - angle : angle;
+    return cosine < 0.0 ? GLM_PI - angle : angle;
+}
+
+// Edges, normal, area, and corner angles of a triangle in double, like measureFace (from double positions under
+// double precision), so the vertex and face sweeps of mixed and double precision add exactly the same numbers
+typedef struct
+{
+    double edges[3][3]; // edge k runs from vertex k to vertex k + 1
+    double cross[3];    // cross product of first two edges (area-weighted normal)
+    double doubleArea;  // length of cross product
+    double angles[3];   // corner angle at each vertex
+} PreciseGeometry;
+
+static void measureFacePrecise(const Mesh *mesh, uint32_t f, PreciseGeometry *geometry, bool gaussian)
+{
+    const uint32_t *face = &mesh->indices[3 * f];
+    const double(*precise)[3] = mesh->precision == PRECISION_DOUBLE ? (const double(*)[3])mesh->precise : NULL;
+
+    // Edges, whose differences no longer cancel in float, and their shared cross product
+    double positions[3][3];
+    for (int c = 0; c < 3; c++)
+        for (int d = 0; d < 3; d++)
+            positions[c][d] = precise ? precise[face[c]][d] : mesh->vertices[face[c]].position[d];
+    for (int c = 0; c < 3; c++)
+        for (int d = 0; d < 3; d++)
+            geometry->edges[c][d] = positions[(c + 1) % 3][d] - positions[c][d];
+    const double(*edges)[3] = (const double(*)[3])geometry->edges;
+    for (int d = 0; d < 3; d++)
+        geometry->cross[d] = edges[0][(d + 1) % 3] * edges[1][(d + 2) % 3] - edges[0][(d + 2) % 3] * edges[1][(d + 1) % 3];
+    if (!gaussian)
+        return;
+    const double *cross = geometry->cross;
+    geometry->doubleArea = sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+    // Corner angles (the last corner fills up the half turn)
+    double dots[2] = {0.0, 0.0};
+    for (int d = 0; d < 3; d++)
+    {
+        dots[0] -= edges[0][d] * edges[2][d];
+        dots[1] -= edges[1][d] * edges[0][d];
+    }
+    geometry->angles[0] = cornerAnglePrecise(geometry->doubleArea, dots[0]);
+    geometry->angles[1] = cornerAnglePrecise(geometry->doubleArea, dots[1]);
+    geometry->angles[2] = GLM_PI - geometry->angles[0] - geometry->angles[1];
+}
+
+// Curvature sums of one vertex in double
+typedef struct
+{
+    double curvature[3], normal[3]; // umbrella Laplacian, area-weighted normal
+    double angles, area;            // corner angles, barycentric area
+} PreciseSums;
+
+static void addCornerPrecise(PreciseSums *sums, const PreciseGeometry *geometry, int k, bool gaussian)
+{
+    for (int d = 0; d < 3; d++)
+    {
+        sums->curvature[d] += geometry->edges[k][d] - geometry->edges[(k + 2) % 3][d];
+        sums->normal[d] += geometry->cross[d];
+    }
+    if (gaussian)
+    {
+        sums->angles += geometry->angles[k];
+        sums->area += geometry->doubleArea / 6.0;
+    }
+}
+
+// Rounds a vertex's sums to float once
+static void finishVertexPrecise(Mesh *mesh, uint32_t v, const PreciseSums *sums, bool normals, bool gaussian)
+{
+    Vertex *vertex = &mesh->vertices[v];
+    glm_vec3_copy((vec3){(float)sums->curvature[0], (float)sums->curvature[1], (float)sums->curvature[2]}, vertex->curvature);
+    if (gaussian)
+    {
+        double defect = (onBoundary(mesh, v) ? GLM_PI : 2.0 * GLM_PI) - sums->angles;
+        vertex->gaussian = sums->area > 0.0 ? (float)(defect / sums->area) : 0.0f;
+        mesh->areas[v] = (float)sums->area;
+    }
+    if (normals)
+        glm_vec3_copy((vec3){(float)sums->normal[0], (float)sums->normal[1], (float)sums->normal[2]}, vertex->normal);
+}
+
+// Computes curvature of one vertex like gatherVertex, but with edges taken and everything summed in double
+// (from double positions under double precision), rounding each result to float once
+static void gatherVertexPrecise(Mesh *mesh, uint32_t v, bool normals, bool gaussian)
+{
+    PreciseSums sums = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, 0.0, 0.0};
+    int k = -1;
+    for (uint32_t i = mesh->faceOffsets[v]; i < mesh->faceOffsets[v + 1]; i++)
+    {
+        uint32_t f = mesh->faces[i];
+        const uint32_t *face = &mesh->indices[3 * f];
+        k = i > mesh->faceOffsets[v] && mesh->faces[i - 1] == f ? k + 1 : 0;
+        while (face[k] != v)
+            k++;
+
+        PreciseGeometry geometry;
+        measureFacePrecise(mesh, f, &geometry, gaussian);
+        addCornerPrecise(&sums, &geometry, k, gaussian);
+    }
+    finishVertexPrecise(mesh, v, &sums, normals, gaussian);
+}
+
+// Computes curvature of whole mesh like gatherVertexPrecise, but visiting every face once and adding it to double
+// sums of its vertices (in ascending face order, so the bits are the same)
+static void sweepPrecise(Mesh *mesh, bool normals, bool gaussian)
+{
+    Arena *scratch = meshArena(mesh);
+    ArenaFrame frame = pushFrame(scratch);
+    PreciseSums *sums = arenaCalloc(scratch, mesh->numVertices, sizeof(PreciseSums));
+
+    for (size_t f = 0; f < mesh->numIndices / 3; f++)
+    {
+        const uint32_t *face = &mesh->indices[3 * f];
+        PreciseGeometry geometry;
+        measureFacePrecise(mesh, (uint32_t)f, &geometry, gaussian);
+        for (int k = 0; k < 3; k++)
+            addCornerPrecise(&sums[face[k]], &geometry, k, gaussian);
+    }
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        finishVertexPrecise(mesh, (uint32_t)v, &sums[v], normals, gaussian);
+
+    popFrame(scratch, frame);
+}
+
+// Brings a double position in line with its float position if something without a double path moved it
+static void syncVertex(Mesh *mesh, size_t v, bool fresh)
+{
+    for (int d = 0; d < 3; d++)
+        if (fresh || (float)mesh->precise[v][d] != mesh->vertices[v].position[d])
+            mesh->precise[v][d] = mesh->vertices[v].position[d];
+}
+
+// Brings double positions in line with float positions that something without a double path moved (another
+// flow, a drag, a restored frame), keeping every double position that still rounds to its float position; with a
+// selection, only its active and halo vertices are checked (once the whole mesh has double positions)
+static void syncPrecise(Mesh *mesh, const Selection *selection)
+{
+    bool fresh = !mesh->precise;
+    if (fresh)
+    {
+        mesh->precise = malloc(mesh->numVertices * sizeof(*mesh->precise));
+        adviseHugePages(mesh->precise, mesh->numVertices * sizeof(*mesh->precise));
+    }
+    if (selection && !fresh)
+    {
+        for (size_t i = 0; i < selection->numActive; i++)
+            syncVertex(mesh, selection->active[i], false);
+        for (size_t i = 0; i < selection->numHalo; i++)
+            syncVertex(mesh, selection->halo[i], false);
+        return;
+    }
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        syncVertex(mesh, v, fresh);
+}
+
+// Moves a vertex by velocity times scale in double (into its double position under double precision), so
+// steps far smaller than the spacing of floats around the vertex still add up
+static void movePrecise(Mesh *mesh, size_t v, const double velocity[3], double scale)
+{
+    float *position = mesh->vertices[v].position;
+    for (int d = 0; d < 3; d++)
+    {
+        double moved = (mesh->precision == PRECISION_DOUBLE ? mesh->precise[v][d] : position[d]) + velocity[d] * scale;
+        if (mesh->precision == PRECISION_DOUBLE)
+            mesh->precise[v][d] = moved;
+        position[d] = (float)moved;
+    }
+}
+
+typedef struct
+{
+    Mesh *mesh;    // mesh being swept
+    bool normals;  // whether normals are recomputed
+    bool gaussian; // whether Gaussian curvature and areas are recomputed
+} SweepTask;
+
+// Computes curvature of one fixed-size chunk of vertices (run on worker threads)
+static void sweepChunk(void *data, size_t index)
+{
+    const SweepTask *task = data;
+    size_t begin = index * SWEEP_CHUNK, end = begin + SWEEP_CHUNK;
+    end = end < task->mesh->numVertices ? end : task->mesh->numVertices;
+    for (size_t v = begin; v < end; v++)
+        if (task->mesh->precision == PRECISION_FLOAT)
+            gatherVertex(task->mesh, (uint32_t)v, task->normals, task->gaussian);
+        else
+            gatherVertexPrecise(task->mesh, (uint32_t)v, task->normals, task->gaussian);
+}
+
+// Computes curvature of whole mesh, or of active vertices only if a selection is given; normals of whole mesh
+// are recomputed along the way if asked for, though not stored per face (only a selection's flows read those, and
+// updateSelection refreshes them and updateFaceNormals keeps them current), and Gaussian curvature and areas if
+// asked for (corner angles cost several times the umbrella Laplacian, and without them faces skip FaceGeometry).
+// With a pool of enough threads, a whole mesh is swept vertex by vertex in chunks of fixed size instead, which
+// computes every face three times but splits without races and without changing a single bit of the result.
+// Mixed or double precision sums in double either way, and a selection's active vertices are gathered one by one.
+static void sweepCurvature(Mesh *mesh, const Selection *selection, bool normals, bool gaussian, ThreadPool *pool)
+{
+    if (mesh->precision == PRECISION_DOUBLE)
+        syncPrecise(mesh, selection);
+    if (selection && mesh->precision != PRECISION_FLOAT)
+    {
+        for (size_t i = 0; i < selection->numActive; i++)
+            gatherVertexPrecise(mesh, selection->active[i], false, gaussian);
+        return;
+    }
+    if (selection)
+    {
+        for (size_t i = 0; i < selection->numActive; i++)
+            resetVertex(mesh, selection->active[i], false, gaussian);
+        for (size_t i = 0; i < selection->numFaces; i++)
+            accumulateFace(mesh, selection->faces[i], selection->mask, false, gaussian);
+        for (size_t i = 0; gaussian && i < selection->numActive; i++)
+            finishVertex(mesh, selection->active[i]);
+        return;
+    }
+
+    SweepTask task = {mesh, normals, gaussian};
+    size_t numChunks = (mesh->numVertices + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+    if (pool && pool->numThreads + 1 >= SWEEP_THREADS && mesh->numVertices > SWEEP_CHUNK)
+    {
+        runTasks(pool, sweepChunk, &task, numChunks);
+        return;
+    }
+    if (mesh->precision != PRECISION_FLOAT)
+    {
+        sweepPrecise(mesh, normals, gaussian);
+        return;
+    }
+
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        resetVertex(mesh, (uint32_t)i, normals, gaussian);
+    for (size_t f = 0; f < mesh->numIndices / 3; f++)
+        if (gaussian)
+            accumulateFace(mesh, (uint32_t)f, NULL, normals, gaussian);
+        else
+            accumulateEdges(mesh, (uint32_t)f, normals);
+    for (size_t i = 0; gaussian && i < mesh->numVertices; i++)
+        finishVertex(mesh, (uint32_t)i);
+}
+
+void computeCurvature(Mesh *mesh)
+{
+    sweepCurvature(mesh, NULL, true, true, NULL);
+}
+
+/*
+ * Flows
+ */
+
+void mcfVBM(Mesh *mesh, float deltaTime, ThreadPool *pool)
+{
+    if (hasSelection(mesh))
+    {
+        mcfVBMSelection(mesh, deltaTime);
+        return;
+    }
+
+    // Calculate curvature and normals (which lag behind by this step's update), and Gaussian curvature only if
+    // the heat map shows it
+    sweepCurvature(mesh, NULL, true, mesh->showGaussian, pool);
 
     for (size_t i = 0; i < mesh->numVertices; i++)
     {
         // Update positions based on curvature
-        vec3 update;
-        glm_vec3_scale(mesh->vertices[i].curvature, deltaTime * 10.0f, update);
-        glm_vec3_add(mesh->vertices[i].position, update, mesh->vertices[i].position);
+        if (mesh->precision == PRECISION_FLOAT)
+        {
+            vec3 update;
+            glm_vec3_scale(mesh->vertices[i].curvature, deltaTime * 10.0f, update);
+            glm_vec3_add(mesh->vertices[i].position, update, mesh->vertices[i].position);
+        }
+        else
+        {
+            const float *curvature = mesh->vertices[i].curvature;
+            movePrecise(mesh, i, (double[3]){curvature[0], curvature[1], curvature[2]}, deltaTime * 10.0);
+        }
 
         // Scale curvature for heat map coloring
         glm_vec3_scale(mesh->vertices[i].curvature, 100.0f, mesh->vertices[i].curvature);
     }
+
+    // Mark whole mesh for upload
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+}
+
+void mcfVBMSelection(Mesh *mesh, float deltaTime)
+{
+    Selection *selection = mesh->selection;
+
+    // Calculate curvature over faces touching active vertices (halo vertices are only read)
+    sweepCurvature(mesh, selection, false, mesh->showGaussian, NULL);
+
+    for (size_t i = 0; i < selection->numActive; i++)
+    {
+        Vertex *vertex = &mesh->vertices[selection->active[i]];
+
+        // Update positions based on curvature
+        if (mesh->precision == PRECISION_FLOAT)
+        {
+            vec3 update;
+            glm_vec3_scale(vertex->curvature, deltaTime * 10.0f, update);
+            glm_vec3_add(vertex->position, update, vertex->position);
+        }
+        else
+        {
+            const float *curvature = vertex->curvature;
+            movePrecise(mesh, selection->active[i], (double[3]){curvature[0], curvature[1], curvature[2]}, deltaTime * 10.0);
+        }
+
+        // Scale curvature for heat map coloring
+        glm_vec3_scale(vertex->curvature, 100.0f, vertex->curvature);
+    }
+
+    // Normals of moved vertices and their one-ring
+    updateFaceNormals(mesh, selection->faces, selection->numFaces);
+
+    // Mark selection for upload
+    mesh->dirtyBegin = selection->dirtyBegin;
+    mesh->dirtyEnd = selection->dirtyEnd;
 }
 
 void mcfITI(Mesh *mesh, float deltaTime)
 {
 }
 
-void computeNormals(Mesh *mesh)
+void gcf(Mesh *mesh, float deltaTime, ThreadPool *pool)
 {
-    // Reset all normals
-    for (size_t i = 0; i < mesh->numVertices; i++)
-        glm_vec3_copy((vec3){0.0f, 0.0f, 0.0f}, mesh->vertices[i].normal);
+    // Calculate curvature and area-weighted normals in one sweep
+    Selection *selection = hasSelection(mesh) ? mesh->selection : NULL;
+    sweepCurvature(mesh, selection, true, true, pool);
 
-    for (size_t i = 0; i < mesh->numIndices / 3; i++)
+    size_t count = selection ? selection->numActive : mesh->numVertices;
+    for (size_t i = 0; i < count; i++)
     {
-        // Grab face indices
-        int v1Index = mesh->indices[3 * i];
-        int v2Index = mesh->indices[3 * i + 1];
-        int v3Index = mesh->indices[3 * i + 2];
+        uint32_t v = selection ? selection->active[i] : (uint32_t)i;
+        Vertex *vertex = &mesh->vertices[v];
 
-        // Grab vertices in face
-        vec3 v1, v2, v3;
-        glm_vec3_copy(mesh->vertices[v1Index].position, v1);
-        glm_vec3_copy(mesh->vertices[v2Index].position, v2);
-        glm_vec3_copy(mesh->vertices[v3Index].position, v3);
+        // Move toward the plane of the one-ring by a fraction of the way that grows with the angle defect, capped so a
+        // vertex never overshoots its ring (which is what made moving by the raw defect blow up): bumps and dents of
+        // either sign flatten, flat and developable regions (no defect) stay, and the step does not depend on scale
+        double defect = fabs((double)vertex->gaussian * mesh->areas[v]);
+        double fraction = fmin(defect * deltaTime * 10.0, GCF_MAX_FRACTION);
+        double faces = mesh->faceOffsets[v + 1] - mesh->faceOffsets[v];
+        const float *normal = vertex->normal, *umbrella = vertex->curvature;
+        double length = sqrt((double)normal[0] * normal[0] + (double)normal[1] * normal[1] + (double)normal[2] * normal[2]);
+        double offset = length > 0.0 && faces > 0.0
+                            ? ((double)umbrella[0] * normal[0] + (double)umbrella[1] * normal[1] + (double)umbrella[2] * normal[2]) /
+                                  (2.0 * faces * length * length)
+                            : 0.0; // distance to the ring's mean edge midpoint along the normal, over the normal's length
+        if (mesh->precision == PRECISION_FLOAT)
+        {
+            vec3 update;
+            glm_vec3_scale(vertex->normal, (float)(offset * fraction), update);
+            glm_vec3_add(vertex->position, update, vertex->position);
+        }
+        else
+            movePrecise(mesh, v, (double[3]){normal[0] * offset, normal[1] * offset, normal[2] * offset}, fraction);
 
-        // Calculate face edges
-        vec3 e1, e2;
-        glm_vec3_sub(v2, v1, e1);
-        glm_vec3_sub(v3, v1, e2);
+        // Scale curvature for heat map coloring
+        glm_vec3_scale(vertex->curvature, 100.0f, vertex->curvature);
+    }
 
-        // Calculate face normal
-        vec3 faceNormal;
-        glm_vec3_crossn(e1, e2, faceNormal);
+    if (selection)
+    {
+        // Normals of moved vertices and their one-ring
+        updateFaceNormals(mesh, selection->faces, selection->numFaces);
 
-        // Add face normal to vertices of face
-        glm_vec3_add(mesh->vertices[v1Index].normal, faceNormal, mesh->vertices[v1Index].normal);
-        glm_vec3_add(mesh->vertices[v2Index].normal, faceNormal, mesh->vertices[v2Index].normal);
-        glm_vec3_add(mesh->vertices[v3Index].normal, faceNormal, mesh->vertices[v3Index].normal);
+        mesh->dirtyBegin = selection->dirtyBegin;
+        mesh->dirtyEnd = selection->dirtyEnd;
+    }
+    else
+    {
+        mesh->dirtyBegin = 0;
+        mesh->dirtyEnd = mesh->numVertices;
     }
+}
+
+void willmoreFlow(Mesh *mesh, ThreadPool *pool)
+{
+    if (!mesh->willmore)
+        mesh->willmore = createWillmore(mesh);
+    stepWillmore(mesh->willmore, mesh);
 
-    // Normalize sums
+    // Curvature and normals of moved mesh in one sweep (Gaussian curvature only for the heat map)
+    sweepCurvature(mesh, NULL, true, mesh->showGaussian, pool);
     for (size_t i = 0; i < mesh->numVertices; i++)
-        glm_vec3_normalize(mesh->vertices[i].normal);
-}
\ No newline at end of file
+        glm_vec3_scale(mesh->vertices[i].curvature, 100.0f, mesh->vertices[i].curvature); // for heat map
+
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+}
+
+void ricciFlow(Mesh *mesh)
+{
+    if (!mesh->ricci)
+        mesh->ricci = createRicci(mesh);
+
+    Ricci *ricci = mesh->ricci;
+    if (ricci->converged || ricci->stalled)
+        return; // a stalled metric is not flat, so it is never laid out
+
+    stepRicci(ricci, mesh);
+    if (!ricci->converged)
+        return;
+
+    // Lay out converged metric in plane through centroid
+    embedRicci(ricci, mesh);
+    vec3 center = {0.0f, 0.0f, 0.0f};
+    double uvCenter[2] = {0.0, 0.0};
+    for (size_t i = 0; i < mesh->numVertices; i++)
+    {
+        glm_vec3_add(center, mesh->vertices[i].position, center);
+        uvCenter[0] += ricci->uvs[i][0];
+        uvCenter[1] += ricci->uvs[i][1];
+    }
+    glm_vec3_scale(center, 1.0f / mesh->numVertices, center);
+    uvCenter[0] /= mesh->numVertices;
+    uvCenter[1] /= mesh->numVertices;
+
+    for (size_t i = 0; i < mesh->numVertices; i++)
+    {
+        mesh->vertices[i].position[0] = center[0] + (float)(ricci->uvs[i][0] - uvCenter[0]);
+        mesh->vertices[i].position[1] = center[1] + (float)(ricci->uvs[i][1] - uvCenter[1]);
+        mesh->vertices[i].position[2] = center[2];
+    }
+
+    computeCurvature(mesh);
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+}
+
+void updateFaceNormals(Mesh *mesh, const uint32_t *faces, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t f = faces[i];
+        const uint32_t *face = &mesh->indices[3 * f];
+
+        // Swap face's previous contribution to its vertices' normals for its current one
+        vec3 e1, e2, cross, change;
+        glm_vec3_sub(mesh->vertices[face[1]].position, mesh->vertices[face[0]].position, e1);
+        glm_vec3_sub(mesh->vertices[face[2]].position, mesh->vertices[face[0]].position, e2);
+        glm_vec3_cross(e1, e2, cross);
+        glm_vec3_sub(cross, mesh->faceNormals[f], change);
+        glm_vec3_copy(cross, mesh->faceNormals[f]);
+        for (int k = 0; k < 3; k++)
+            glm_vec3_add(mesh->vertices[face[k]].normal, change, mesh->vertices[face[k]].normal);
+    }
+}
@@ -2,6 +2,13 @@
 #define GEOMETRY_H
 
 #include "model.h"
+#include "threadpool.h"
+
+// Flow settings
+#define MAX_FLOW_TIME 0.1f   // longest time a flow step may cover (first frame after waiting for events)
+#define SWEEP_CHUNK 4096     // vertices per task when a curvature sweep is split across threads (fixed, so results don't depend on thread count)
+#define SWEEP_THREADS 4      // fewest threads worth splitting a sweep across (split sweeps do three times the arithmetic)
+#define GCF_MAX_FRACTION 0.5 // most of the way to its one-ring's plane a vertex moves in one Gaussian curvature flow step
 
 /*
  * Enums
@@ -13,30 +20,56 @@
 typedef enum
 {
     MCF_VBM, // mean curvature flow (vertex-based method)
-    MCF_ITI  // mean curvature flow (implicit time integration)
+    MCF_ITI, // mean curvature flow (implicit time integration)
+    GCF,     // Gaussian curvature flow
+    RICCI,   // discrete Ricci flow (flattening)
+    WILLMORE // Willmore flow (semi-implicit bi-Laplacian)
 } GEOMETRIC_FLOW;
 
+/**
+ * @brief Quantity shown by heat map (values match heatMap uniform of fragment shader).
+ */
+typedef enum
+{
+    MEAN_CURVATURE,    // magnitude of mean curvature vector
+    GAUSSIAN_CURVATURE // signed Gaussian curvature
+} HEAT_MAP;
+
 /*
  * Function Prototypes
  */
 
 /**
- * @brief Calls for new geometry to be computed and binds it.
+ * @brief Advances flow on mesh by one step and keeps its picking hierarchy and self-intersection checks in sync.
+ *
+ * Makes no OpenGL calls (changed vertices are only marked dirty), so different meshes may be stepped on
+ * different threads at once. Results are bitwise the same with or without a pool, whatever its size.
  *
- * @param window  GLFW window.
- * @param model   Model to compute flow on.
- * @param flow    Type of flow to compute.
- * @param flowing Whether to compute new geometry or not.
+ * @param mesh      Mesh to compute flow on.
+ * @param flow      Type of flow to compute.
+ * @param deltaTime Time since last step (ignored by time-independent flows).
+ * @param pool      Idle pool to split curvature sweeps of large meshes across (NULL to stay on calling thread).
  */
-void computeGeometry(GLFWwindow *window, Model *model, GEOMETRIC_FLOW flow, bool flowing);
+void stepFlow(Mesh *mesh, GEOMETRIC_FLOW flow, float deltaTime, ThreadPool *pool);
 
 /**
  * @brief Computes mean curvature flow (vertex-based method) on given mesh.
  *
  * @param mesh      Mesh to compute flow on.
  * @param deltaTime Time since last update.
+ * @param pool      Idle pool to split curvature sweep across (NULL to stay on calling thread).
  */
-void mcfVBM(Mesh *mesh, float deltaTime);
+void mcfVBM(Mesh *mesh, float deltaTime, ThreadPool *pool);
+
+/**
+ * @brief Computes mean curvature flow (vertex-based method) on the selected region of given mesh.
+ *
+ * Only faces touching active vertices are visited, so cost scales with the selection.
+ *
+ * @param mesh      Mesh to compute flow on (must have a selection).
+ * @param deltaTime Time since last update.
+ */
+void mcfVBMSelection(Mesh *mesh, float deltaTime);
 
 /**
  * @brief Computes mean curvature flow (implicit time integration) on given mesh.
@@ -47,10 +80,60 @@ void mcfVBM(Mesh *mesh, float deltaTime);
 void mcfITI(Mesh *mesh, float deltaTime);
 
 /**
- * @brief Computes normals of given mesh.
+ * @brief Computes Gaussian curvature flow on given mesh (or its selected region).
+ *
+ * Each vertex moves along its normal toward the plane of its one-ring, by a fraction of the way proportional to its
+ * angle defect (integrated Gaussian curvature) and the time step, capped at GCF_MAX_FRACTION so steps stay stable.
+ *
+ * @param mesh      Mesh to compute flow on.
+ * @param deltaTime Time since last update.
+ * @param pool      Idle pool to split curvature sweep across (NULL to stay on calling thread).
+ */
+void gcf(Mesh *mesh, float deltaTime, ThreadPool *pool);
+
+/**
+ * @brief Computes Willmore flow on given mesh with a fixed implicit step.
+ *
+ * Steps are unconditionally stable, so one is taken per call regardless of time passed. Selections are
+ * ignored.
+ *
+ * @param mesh Mesh to compute flow on.
+ * @param pool Idle pool to split curvature sweep across (NULL to stay on calling thread).
+ */
+void willmoreFlow(Mesh *mesh, ThreadPool *pool);
+
+/**
+ * @brief Computes discrete Ricci flow on given mesh, flattening it once the metric converges.
+ *
+ * Takes one Newton step per call (independent of time); the converged metric is laid out in the plane
+ * through the mesh's centroid. Selections are ignored.
+ *
+ * @param mesh Mesh to compute flow on.
+ */
+void ricciFlow(Mesh *mesh);
+
+/**
+ * @brief Computes mean curvature vectors, Gaussian curvatures, vertex areas, and normals of given mesh.
+ *
+ * All four come out of a single sweep over the triangles, which computes each triangle's edges and
+ * cross product once and derives the umbrella Laplacian, corner angles, area, and normal from them.
+ * Every vertex sums its triangles in ascending order, which fixes the rounding of the result. Meshes of
+ * mixed or double precision take differences and sums in double (see PRECISION).
+ *
+ * @param mesh Mesh to compute curvature of.
+ */
+void computeCurvature(Mesh *mesh);
+
+/**
+ * @brief Brings vertex normals up to date after the given faces' vertices moved.
+ *
+ * Vertex normals are unnormalized sums of their faces' area-weighted normals, so each face's last
+ * contribution is swapped for its current one; only the given faces are visited.
  *
- * @param mesh Mesh to compute normals for.
+ * @param mesh  Mesh to update normals of.
+ * @param faces Indices of faces that may have changed.
+ * @param count Number of faces.
  */
-void computeNormals(Mesh *mesh);
+void updateFaceNormals(Mesh *mesh, const uint32_t *faces, size_t count);
 
 #endif
\ No newline at end of file
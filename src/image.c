@@ -0,0 +1,272 @@
+#include "image.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STORED_BLOCK 65535 // largest stored deflate block
+
+/*
+ * PNG
+ */
+
+static uint32_t crcTable[256];
+
+static void initCRC(void)
+{
+    if (crcTable[1])
+        return;
+    for (uint32_t n = 0; n < 256; n++)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++)
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crcTable[n] = c;
+    }
+}
+
+static uint32_t updateCRC(uint32_t crc, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void putBigEndian(uint8_t *dest, uint32_t value)
+{
+    dest[0] = (uint8_t)(value >> 24);
+    dest[1] = (uint8_t)(value >> 16);
+    dest[2] = (uint8_t)(value >> 8);
+    dest[3] = (uint8_t)value;
+}
+
+// Writes a chunk: length, type, data, and CRC of type and data
+static void writeChunk(FILE *file, const char *type, const uint8_t *data, size_t size)
+{
+    uint8_t header[8], footer[4];
+    putBigEndian(header, (uint32_t)size);
+    memcpy(header + 4, type, 4);
+    putBigEndian(footer, ~updateCRC(updateCRC(0xFFFFFFFFu, header + 4, 4), data, size));
+    fwrite(header, 1, 8, file);
+    fwrite(data, 1, size, file);
+    fwrite(footer, 1, 4, file);
+}
+
+bool writePNG(const char *filename, const uint8_t *pixels, const uint8_t palette[256][3], size_t width, size_t height)
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error writing PNG file: %s\n", filename);
+        return false;
+    }
+    initCRC();
+
+    // Scanlines (filter type 0, then RGB) and their Adler-32 checksum
+    size_t rowSize = 1 + 3 * width, rawSize = rowSize * height;
+    uint8_t *raw = malloc(rawSize ? rawSize : 1);
+    uint32_t a = 1, b = 0;
+    for (size_t y = 0; y < height; y++)
+    {
+        uint8_t *row = &raw[y * rowSize];
+        row[0] = 0;
+        for (size_t x = 0; x < width; x++)
+            memcpy(&row[1 + 3 * x], palette[pixels[y * width + x]], 3);
+        for (size_t i = 0; i < rowSize; i++)
+        {
+            a = (a + row[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+
+    // zlib stream of stored blocks
+    size_t numBlocks = rawSize / STORED_BLOCK + 1;
+    size_t dataSize = 2 + 5 * numBlocks + rawSize + 4;
+    uint8_t *data = malloc(dataSize), *c = data;
+    *c++ = 0x78; // deflate, 32K window
+    *c++ = 0x01; // no preset dictionary, fastest (header is a multiple of 31)
+    for (size_t offset = 0; offset < rawSize || c == data + 2; offset += STORED_BLOCK)
+    {
+        size_t size = rawSize - offset < STORED_BLOCK ? rawSize - offset : STORED_BLOCK;
+        *c++ = offset + size == rawSize; // final block flag
+        *c++ = (uint8_t)size;
+        *c++ = (uint8_t)(size >> 8);
+        *c++ = (uint8_t)~size;
+        *c++ = (uint8_t)(~size >> 8);
+        memcpy(c, &raw[offset], size);
+        c += size;
+    }
+    putBigEndian(c, (b << 16) | a);
+    c += 4;
+
+    // Signature, header, image data, end
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t header[13];
+    putBigEndian(header, (uint32_t)width);
+    putBigEndian(header + 4, (uint32_t)height);
+    header[8] = 8;  // bit depth
+    header[9] = 2;  // RGB
+    header[10] = 0; // deflate
+    header[11] = 0; // adaptive filtering
+    header[12] = 0; // no interlacing
+    fwrite(signature, 1, 8, file);
+    writeChunk(file, "IHDR", header, sizeof(header));
+    writeChunk(file, "IDAT", data, (size_t)(c - data));
+    writeChunk(file, "IEND", NULL, 0);
+
+    free(raw);
+    free(data);
+    bool written = !ferror(file);
+    written &= !fclose(file);
+    if (!written)
+        fprintf(stderr, "Error writing PNG file: %s\n", filename);
+    return written;
+}
+
+/*
+ * GIF
+ */
+
+// Packs LZW codes least significant bit first into sub-blocks of at most 255 bytes
+typedef struct
+{
+    FILE *file;
+    uint8_t block[255];
+    size_t size;
+    uint32_t bits;
+    int count;
+} CodeWriter;
+
+static void putCode(CodeWriter *writer, uint32_t code, int width)
+{
+    writer->bits |= code << writer->count;
+    writer->count += width;
+    while (writer->count >= 8)
+    {
+        writer->block[writer->size++] = (uint8_t)writer->bits;
+        writer->bits >>= 8;
+        writer->count -= 8;
+        if (writer->size == sizeof(writer->block))
+        {
+            fputc((int)writer->size, writer->file);
+            fwrite(writer->block, 1, writer->size, writer->file);
+            writer->size = 0;
+        }
+    }
+}
+
+static void putShort(FILE *file, size_t value)
+{
+    fputc((int)(value & 0xFF), file);
+    fputc((int)((value >> 8) & 0xFF), file);
+}
+
+GifWriter *createGif(const char *filename, const uint8_t palette[256][3], size_t width, size_t height, unsigned delay)
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error writing GIF file: %s\n", filename);
+        return NULL;
+    }
+
+    GifWriter *gif = malloc(sizeof(GifWriter));
+    gif->file = file;
+    gif->width = width;
+    gif->height = height;
+    gif->delay = delay;
+
+    // Header, screen with global palette, and endless looping
+    fwrite("GIF89a", 1, 6, file);
+    putShort(file, width);
+    putShort(file, height);
+    fputc(0xF7, file); // global palette of 256 colors, 8 bits per channel
+    fputc(0, file);    // background color
+    fputc(0, file);    // square pixels
+    fwrite(palette, 3, 256, file);
+    fwrite("\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00", 1, 19, file);
+
+    return gif;
+}
+
+void writeGifFrame(GifWriter *gif, const uint8_t *pixels)
+{
+    FILE *file = gif->file;
+
+    // Frame delay, then an image covering the whole screen
+    fwrite("\x21\xF9\x04\x04", 1, 4, file); // graphic control, frames stay in place until replaced
+    putShort(file, gif->delay);
+    fputc(0, file); // no transparency
+    fputc(0, file);
+    fputc(0x2C, file);
+    putShort(file, 0);
+    putShort(file, 0);
+    putShort(file, gif->width);
+    putShort(file, gif->height);
+    fputc(0, file); // global palette, not interlaced
+    fputc(8, file); // LZW minimum code size
+
+    // LZW: dictionary maps (prefix code, next index) to codes, in an open-addressed hash table
+    const uint32_t clear = 256, end = 257;
+    CodeWriter writer = {file, {0}, 0, 0, 0};
+    size_t count = gif->width * gif->height;
+    uint32_t next = end + 1;
+    int width = 9;
+    memset(gif->keys, 0, sizeof(gif->keys));
+    putCode(&writer, clear, width);
+
+    uint32_t prefix = count ? pixels[0] : 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        uint32_t key = (prefix << 8 | pixels[i]) + 1; // 0 marks empty slots
+        size_t slot = (key * 2654435761u) & (2 * GIF_MAX_CODE - 1);
+        while (gif->keys[slot] && gif->keys[slot] != key)
+            slot = (slot + 1) & (2 * GIF_MAX_CODE - 1);
+        if (gif->keys[slot])
+        {
+            prefix = gif->codes[slot];
+            continue;
+        }
+
+        // New string: emit its prefix and remember it (starting over once the last code is taken)
+        putCode(&writer, prefix, width);
+        gif->keys[slot] = key;
+        gif->codes[slot] = (uint16_t)next;
+        if (next == (1u << width))
+            width++;
+        if (++next == GIF_MAX_CODE)
+        {
+            putCode(&writer, clear, width);
+            memset(gif->keys, 0, sizeof(gif->keys));
+            next = end + 1;
+            width = 9;
+        }
+        prefix = pixels[i];
+    }
+    if (count)
+        putCode(&writer, prefix, width);
+    putCode(&writer, end, width);
+
+    // Remaining bits, last sub-block, and block terminator
+    if (writer.count > 0)
+        putCode(&writer, 0, 8 - writer.count);
+    if (writer.size)
+    {
+        fputc((int)writer.size, file);
+        fwrite(writer.block, 1, writer.size, file);
+    }
+    fputc(0, file);
+}
+
+bool closeGif(GifWriter *gif)
+{
+    if (!gif)
+        return true;
+
+    fputc(0x3B, gif->file); // trailer
+    bool written = !ferror(gif->file);
+    written &= !fclose(gif->file);
+    if (!written)
+        fprintf(stderr, "Error writing GIF file\n");
+    free(gif);
+    return written;
+}
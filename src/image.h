@@ -0,0 +1,74 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// GIF settings
+#define GIF_MAX_CODE 4096 // LZW dictionary size (codes of at most 12 bits)
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Writer of an animated, looping GIF with one 256-color palette shared by every frame.
+ */
+typedef struct
+{
+    FILE *file;                       // GIF being written
+    size_t width, height;             // frame size
+    unsigned delay;                   // time each frame is shown (hundredths of a second)
+    uint32_t keys[2 * GIF_MAX_CODE];  // LZW dictionary keys (prefix code and next index, 0 for empty slots)
+    uint16_t codes[2 * GIF_MAX_CODE]; // LZW code of each key
+} GifWriter;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Writes palette-indexed image as an 8-bit RGB PNG.
+ *
+ * Image data is stored uncompressed (in stored deflate blocks), which keeps writing frames cheap.
+ *
+ * @param filename PNG file.
+ * @param pixels   Palette index of each pixel (rows top first).
+ * @param palette  RGB color of each index.
+ * @param width    Image width.
+ * @param height   Image height.
+ * @return True if file was written.
+ */
+bool writePNG(const char *filename, const uint8_t *pixels, const uint8_t palette[256][3], size_t width, size_t height);
+
+/**
+ * @brief Starts an animated GIF.
+ *
+ * @param filename GIF file.
+ * @param palette  RGB color of each index (shared by every frame).
+ * @param width    Frame width.
+ * @param height   Frame height.
+ * @param delay    Time each frame is shown (hundredths of a second).
+ * @return GIF writer, or NULL if the file cannot be created.
+ */
+GifWriter *createGif(const char *filename, const uint8_t palette[256][3], size_t width, size_t height, unsigned delay);
+
+/**
+ * @brief Appends a frame to a GIF (LZW compressed).
+ *
+ * @param gif    GIF to write to.
+ * @param pixels Palette index of each pixel (rows top first).
+ */
+void writeGifFrame(GifWriter *gif, const uint8_t *pixels);
+
+/**
+ * @brief Ends GIF, closes its file, and frees space.
+ *
+ * @param gif GIF to close (may be NULL).
+ * @return True if everything was written.
+ */
+bool closeGif(GifWriter *gif);
+
+#endif
@@ -0,0 +1,783 @@
+#include "job.h"
+#include "model.h"
+#include "geometry.h"
+#include "scene.h"
+#include "batch.h"
+#include "checkpoint.h"
+#include "recording.h"
+#include "render.h"
+#include "image.h"
+#include "camera.h"
+#include "cluster.h"
+#include "domain.h"
+#include "numa.h"
+#include "ricci.h"
+#include "willmore.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Determinism is a build choice (--help says which this binary made)
+#ifdef FAST_BUILD
+#define BUILD_MODE "use fused multiply-adds and native instructions (\"make fast\"), so results vary between machines"
+#else
+#define BUILD_MODE "give the same bits on any thread count and x86-64 machine (\"make fast\" trades that for speed)"
+#endif
+
+#define USAGE                                                                                      \
+    "Usage: app [options] [mesh.obj ...]\n"                                                        \
+    "  -f, --flow NAME      flow to compute: mcf, gcf, willmore, ricci (default mcf)\n"             \
+    "  -t, --step SECONDS   fixed time step of mcf and gcf (default: frame time, or 0.01 when headless)\n" \
+    "  -P, --precision NAME arithmetic of flows: float, mixed (double sums), double (default float)\n" \
+    "  -n, --steps COUNT    steps before flows stop (default: no limit; required when headless)\n" \
+    "  -j, --threads COUNT  threads stepping flows, including the main one (default: all cores)\n"  \
+    "  -H, --headless       run without a window and exit when flows stop\n"                       \
+    "      --pin            pin flow threads to NUMA nodes\n"                                       \
+    "      --huge-pages     back big mesh arrays with 2 MB pages where the system allows\n"         \
+    "  -o, --output PATH    write flowed meshes to PATH (.obj file, or directory for several)\n"    \
+    "  -c, --checkpoint FILE\n"                                                                    \
+    "                       save flow state to FILE periodically, and resume from it if it exists\n" \
+    "  -i, --interval COUNT steps between checkpoints (default 100)\n"                             \
+    "  -r, --record FILE    record every step of the flows to FILE\n"                               \
+    "  -p, --play FILE      play back a recording instead of running flows\n"                       \
+    "      --render PATH    render every step to PATH (.gif file, or directory of .png frames)\n"    \
+    "      --out-of-core FILE\n"                                                                   \
+    "                       flow a single mesh from cluster FILE (written first if missing) in bounded memory\n" \
+    "      --domains COUNT  flow each mesh in COUNT worker processes, one per part of a partition\n"  \
+    "      --job FILE       run every job of FILE back to back (implies --headless)\n"              \
+    "      --batch PATH     flow every mesh of a directory or manifest on its own (implies --headless)\n" \
+    "  -h, --help           show this message\n"                                                  \
+    "Flows of this build " BUILD_MODE "\n"
+
+/*
+ * Helpers
+ */
+
+double wallTime(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static char *copyString(const char *string)
+{
+    size_t length = strlen(string) + 1;
+    char *copy = malloc(length);
+    memcpy(copy, string, length);
+    return copy;
+}
+
+static void usageError(const char *message, const char *argument)
+{
+    fprintf(stderr, "Error: %s%s%s\n%s", message, argument ? ": " : "", argument ? argument : "", USAGE);
+    exit(EXIT_FAILURE);
+}
+
+static Job *appendJob(Options *options)
+{
+    options->jobs = realloc(options->jobs, (options->numJobs + 1) * sizeof(Job));
+    Job *job = &options->jobs[options->numJobs++];
+    *job = (Job){NULL, 0, MCF_VBM, 0.0f, 0, NULL, NULL, CHECKPOINT_INTERVAL, NULL, NULL, PRECISION_FLOAT, NULL, 0};
+    return job;
+}
+
+static void appendInput(Job *job, const char *input)
+{
+    job->inputs = realloc(job->inputs, (job->numInputs + 1) * sizeof(char *));
+    job->inputs[job->numInputs++] = copyString(input);
+}
+
+// Parses non-negative integer (whole string must be used)
+static bool parseCount(const char *string, size_t *count)
+{
+    char *end;
+    unsigned long long value = strtoull(string, &end, 10);
+    if (end == string || *end || string[0] == '-')
+        return false;
+    *count = (size_t)value;
+    return true;
+}
+
+// Parses non-negative number (whole string must be used)
+static bool parseStep(const char *string, float *step)
+{
+    char *end;
+    float value = strtof(string, &end);
+    if (end == string || *end || !(value >= 0.0f))
+        return false;
+    *step = value;
+    return true;
+}
+
+bool parseFlow(const char *name, GEOMETRIC_FLOW *flow)
+{
+    if (!strcmp(name, "mcf"))
+        *flow = MCF_VBM;
+    else if (!strcmp(name, "gcf"))
+        *flow = GCF;
+    else if (!strcmp(name, "willmore"))
+        *flow = WILLMORE;
+    else if (!strcmp(name, "ricci"))
+        *flow = RICCI;
+    else
+        return false;
+    return true;
+}
+
+bool parsePrecision(const char *name, PRECISION *precision)
+{
+    if (!strcmp(name, "float"))
+        *precision = PRECISION_FLOAT;
+    else if (!strcmp(name, "mixed"))
+        *precision = PRECISION_MIXED;
+    else if (!strcmp(name, "double"))
+        *precision = PRECISION_DOUBLE;
+    else
+        return false;
+    return true;
+}
+
+/*
+ * Command Line
+ */
+
+void parseArguments(int argc, char **argv, Options *options)
+{
+    *options = (Options){NULL, 0, 0, false, false, NULL, false, false};
+    Job job = {NULL, 0, MCF_VBM, 0.0f, 0, NULL, NULL, CHECKPOINT_INTERVAL, NULL, NULL, PRECISION_FLOAT, NULL, 0};
+    const char *jobFile = NULL, *batchPath = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (arg[0] != '-')
+        {
+            appendInput(&job, arg);
+            continue;
+        }
+
+        // Flags
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+        {
+            printf("%s", USAGE);
+            exit(EXIT_SUCCESS);
+        }
+        if (!strcmp(arg, "-H") || !strcmp(arg, "--headless"))
+        {
+            options->headless = true;
+            continue;
+        }
+        if (!strcmp(arg, "--pin"))
+        {
+            options->pin = true;
+            continue;
+        }
+        if (!strcmp(arg, "--huge-pages"))
+        {
+            options->hugePages = true;
+            continue;
+        }
+
+        // Options with a value
+        static const char *const valueOptions[] = {"-f", "--flow", "-t", "--step", "-P", "--precision", "-n", "--steps", "-j", "--threads",
+                                                   "-o", "--output", "-c", "--checkpoint", "-i", "--interval", "-r", "--record",
+                                                   "-p", "--play", "--render", "--out-of-core", "--domains", "--job", "--batch"};
+        bool known = false;
+        for (size_t j = 0; j < sizeof(valueOptions) / sizeof(valueOptions[0]); j++)
+            known |= !strcmp(arg, valueOptions[j]);
+        if (!known)
+            usageError("unknown option", arg);
+        if (i + 1 == argc)
+            usageError("missing value", arg);
+        const char *value = argv[++i];
+        if (!strcmp(arg, "-f") || !strcmp(arg, "--flow"))
+        {
+            if (!parseFlow(value, &job.flow))
+                usageError("unknown flow", value);
+        }
+        else if (!strcmp(arg, "-t") || !strcmp(arg, "--step"))
+        {
+            if (!parseStep(value, &job.step))
+                usageError("invalid step", value);
+        }
+        else if (!strcmp(arg, "-P") || !strcmp(arg, "--precision"))
+        {
+            if (!parsePrecision(value, &job.precision))
+                usageError("unknown precision", value);
+        }
+        else if (!strcmp(arg, "-n") || !strcmp(arg, "--steps"))
+        {
+            if (!parseCount(value, &job.steps))
+                usageError("invalid step count", value);
+        }
+        else if (!strcmp(arg, "-j") || !strcmp(arg, "--threads"))
+        {
+            if (!parseCount(value, &options->threads))
+                usageError("invalid thread count", value);
+        }
+        else if (!strcmp(arg, "-o") || !strcmp(arg, "--output"))
+        {
+            free(job.output);
+            job.output = copyString(value);
+        }
+        else if (!strcmp(arg, "-c") || !strcmp(arg, "--checkpoint"))
+        {
+            free(job.checkpoint);
+            job.checkpoint = copyString(value);
+        }
+        else if (!strcmp(arg, "-i") || !strcmp(arg, "--interval"))
+        {
+            if (!parseCount(value, &job.interval) || !job.interval)
+                usageError("invalid checkpoint interval", value);
+        }
+        else if (!strcmp(arg, "-r") || !strcmp(arg, "--record"))
+        {
+            free(job.record);
+            job.record = copyString(value);
+        }
+        else if (!strcmp(arg, "-p") || !strcmp(arg, "--play"))
+        {
+            free(options->play);
+            options->play = copyString(value);
+        }
+        else if (!strcmp(arg, "--render"))
+        {
+            free(job.render);
+            job.render = copyString(value);
+        }
+        else if (!strcmp(arg, "--out-of-core"))
+        {
+            free(job.outOfCore);
+            job.outOfCore = copyString(value);
+        }
+        else if (!strcmp(arg, "--domains"))
+        {
+            if (!parseCount(value, &job.domains) || !job.domains)
+                usageError("invalid domain count", value);
+        }
+        else if (!strcmp(arg, "--job"))
+            jobFile = value;
+        else
+            batchPath = value;
+    }
+
+    // Batch takes its settings from the command line (along with any inputs given there)
+    if (batchPath)
+    {
+        if (job.checkpoint || job.record || job.render || job.outOfCore || job.domains > 1)
+            usageError("batches cannot be checkpointed, recorded, rendered, or flowed out of core or in domains", NULL);
+        listBatch(batchPath, &job);
+        if (!job.numInputs)
+            usageError("no meshes found in batch", batchPath);
+        options->batch = options->headless = true;
+    }
+
+    // Job given on command line comes first
+    if (job.numInputs)
+        *appendJob(options) = job;
+    else
+    {
+        free(job.output);
+        free(job.checkpoint);
+        free(job.record);
+        free(job.render);
+        free(job.outOfCore);
+    }
+
+    if (jobFile)
+    {
+        parseJobFile(jobFile, options);
+        options->headless = true;
+    }
+
+    // Playback shows a recording in the window, nothing else
+    if (options->play && (options->headless || options->numJobs))
+        usageError("playback cannot be combined with inputs, jobs, or headless mode", options->play);
+
+    // Headless jobs must end
+    if (options->headless && !options->numJobs)
+        usageError("headless mode needs input meshes or a job file", NULL);
+    for (size_t i = 0; i < options->numJobs; i++)
+        if (options->headless && !options->jobs[i].steps)
+            usageError("headless jobs need a step count", options->jobs[i].inputs[0]);
+        else if (!options->headless && options->jobs[i].render)
+            usageError("rendering needs headless mode", options->jobs[i].render);
+
+    // Willmore and Ricci flows take fixed implicit or Newton steps, so a time step would be silently ignored
+    for (size_t i = 0; i < options->numJobs; i++)
+        if (options->jobs[i].step > 0.0f && (options->jobs[i].flow == WILLMORE || options->jobs[i].flow == RICCI))
+            usageError("willmore and ricci flows take fixed steps and cannot be given a time step", options->jobs[i].inputs[0]);
+
+    // Out-of-core flows step one mesh's clusters on their own, with nothing else attached
+    for (size_t i = 0; i < options->numJobs; i++)
+    {
+        const Job *job = &options->jobs[i];
+        if (!job->outOfCore)
+            continue;
+        if (!options->headless || job->numInputs != 1)
+            usageError("out-of-core flows need headless mode and a single input", job->outOfCore);
+        if (job->flow != MCF_VBM && job->flow != GCF)
+            usageError("out-of-core flows support mcf and gcf only", job->outOfCore);
+        if (job->precision == PRECISION_DOUBLE)
+            usageError("out-of-core flows support float and mixed precision only", job->outOfCore);
+        if (job->checkpoint || job->record || job->render)
+            usageError("out-of-core flows cannot be checkpointed (the cluster file is resumed), recorded, or rendered",
+                       job->outOfCore);
+    }
+
+    // So do flows split into domains, in worker processes
+    for (size_t i = 0; i < options->numJobs; i++)
+    {
+        const Job *job = &options->jobs[i];
+        if (job->domains < 2)
+            continue;
+        if (!options->headless || job->outOfCore)
+            usageError("flows split into domains need headless mode, and cannot run out of core", job->inputs[0]);
+        if (job->flow != MCF_VBM && job->flow != GCF)
+            usageError("flows split into domains support mcf and gcf only", job->inputs[0]);
+        if (job->precision == PRECISION_DOUBLE)
+            usageError("flows split into domains support float and mixed precision only", job->inputs[0]);
+        if (job->checkpoint || job->record || job->render)
+            usageError("flows split into domains cannot be checkpointed, recorded, or rendered", job->inputs[0]);
+    }
+}
+
+/*
+ * Job Files
+ */
+
+// Reads a quoted string at *cursor into dest (no escapes), advancing cursor past it
+static bool readString(char **cursor, char *dest, size_t size)
+{
+    char *c = *cursor;
+    if (*c != '"')
+        return false;
+    char *end = strchr(c + 1, '"');
+    if (!end || (size_t)(end - c - 1) >= size)
+        return false;
+
+    memcpy(dest, c + 1, end - c - 1);
+    dest[end - c - 1] = '\0';
+    *cursor = end + 1;
+    return true;
+}
+
+static char *skipSpace(char *c)
+{
+    while (isspace((unsigned char)*c))
+        c++;
+    return c;
+}
+
+static void jobFileError(const char *filename, size_t line, const char *message)
+{
+    fprintf(stderr, "Error in job file %s (line %zu): %s\n", filename, line, message);
+    exit(EXIT_FAILURE);
+}
+
+void parseJobFile(const char *filename, Options *options)
+{
+    FILE *file = fopen(filename, "r");
+    if (!file)
+    {
+        fprintf(stderr, "Error opening job file: %s\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    char line[MAX_LINE], key[MAX_LINE], string[MAX_LINE];
+    size_t lineNumber = 0;
+    Job *job = NULL; // job of current [[job]] table (NULL at top level)
+    while (fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+
+        // Strip comment (outside of strings) and surrounding space
+        bool quoted = false;
+        for (char *c = line; *c; c++)
+        {
+            quoted ^= *c == '"';
+            if (*c == '#' && !quoted)
+            {
+                *c = '\0';
+                break;
+            }
+        }
+        char *c = skipSpace(line);
+        size_t length = strlen(c);
+        while (length && isspace((unsigned char)c[length - 1]))
+            c[--length] = '\0';
+        if (!length)
+            continue;
+
+        // Table header
+        if (!strcmp(c, "[[job]]"))
+        {
+            job = appendJob(options);
+            continue;
+        }
+        if (*c == '[')
+            jobFileError(filename, lineNumber, "only [[job]] tables are supported");
+
+        // Key and value
+        size_t keyLength = strcspn(c, " \t=");
+        memcpy(key, c, keyLength);
+        key[keyLength] = '\0';
+        c = skipSpace(c + keyLength);
+        if (*c != '=')
+            jobFileError(filename, lineNumber, "expected key = value");
+        c = skipSpace(c + 1);
+
+        if (!job)
+        {
+            if (strcmp(key, "threads"))
+                jobFileError(filename, lineNumber, "unknown top-level key (keys of jobs belong under [[job]])");
+            if (!parseCount(c, &options->threads))
+                jobFileError(filename, lineNumber, "invalid thread count");
+        }
+        else if (!strcmp(key, "input"))
+        {
+            bool array = *c == '[';
+            c = array ? skipSpace(c + 1) : c;
+            do
+            {
+                if (array && *c == ']')
+                    break;
+                if (!readString(&c, string, sizeof(string)))
+                    jobFileError(filename, lineNumber, "expected quoted path");
+                appendInput(job, string);
+                c = skipSpace(c);
+            } while (array && *c == ',' && (c = skipSpace(c + 1)));
+            if (array && *c++ != ']')
+                jobFileError(filename, lineNumber, "unterminated array");
+            if (*skipSpace(c))
+                jobFileError(filename, lineNumber, "unexpected text after value");
+        }
+        else if (!strcmp(key, "precision"))
+        {
+            if (!readString(&c, string, sizeof(string)) || *skipSpace(c) || !parsePrecision(string, &job->precision))
+                jobFileError(filename, lineNumber, "expected \"float\", \"mixed\", or \"double\"");
+        }
+        else if (!strcmp(key, "flow") || !strcmp(key, "output") || !strcmp(key, "checkpoint") || !strcmp(key, "record") ||
+                 !strcmp(key, "render") || !strcmp(key, "out_of_core"))
+        {
+            if (!readString(&c, string, sizeof(string)) || *skipSpace(c))
+                jobFileError(filename, lineNumber, "expected quoted string");
+            if (key[0] == 'f' && !parseFlow(string, &job->flow))
+                jobFileError(filename, lineNumber, "unknown flow");
+            if (key[0] == 'o')
+            {
+                free(job->output);
+                job->output = copyString(string);
+            }
+            if (key[0] == 'c')
+            {
+                free(job->checkpoint);
+                job->checkpoint = copyString(string);
+            }
+            if (!strcmp(key, "record"))
+            {
+                free(job->record);
+                job->record = copyString(string);
+            }
+            if (!strcmp(key, "render"))
+            {
+                free(job->render);
+                job->render = copyString(string);
+            }
+            if (!strcmp(key, "out_of_core"))
+            {
+                free(job->outOfCore);
+                job->outOfCore = copyString(string);
+            }
+        }
+        else if (!strcmp(key, "step"))
+        {
+            if (!parseStep(c, &job->step))
+                jobFileError(filename, lineNumber, "invalid step");
+        }
+        else if (!strcmp(key, "steps"))
+        {
+            if (!parseCount(c, &job->steps))
+                jobFileError(filename, lineNumber, "invalid step count");
+        }
+        else if (!strcmp(key, "interval"))
+        {
+            if (!parseCount(c, &job->interval) || !job->interval)
+                jobFileError(filename, lineNumber, "invalid checkpoint interval");
+        }
+        else if (!strcmp(key, "domains"))
+        {
+            if (!parseCount(c, &job->domains) || !job->domains)
+                jobFileError(filename, lineNumber, "invalid domain count");
+        }
+        else
+            jobFileError(filename, lineNumber, "unknown job key");
+    }
+    fclose(file);
+
+    for (size_t i = 0; i < options->numJobs; i++)
+        if (!options->jobs[i].numInputs)
+        {
+            fprintf(stderr, "Error in job file %s: job %zu has no input\n", filename, i + 1);
+            exit(EXIT_FAILURE);
+        }
+}
+
+void destroyOptions(Options *options)
+{
+    for (size_t i = 0; i < options->numJobs; i++)
+    {
+        Job *job = &options->jobs[i];
+        for (size_t j = 0; j < job->numInputs; j++)
+            free(job->inputs[j]);
+        free(job->inputs);
+        free(job->output);
+        free(job->checkpoint);
+        free(job->record);
+        free(job->render);
+        free(job->outOfCore);
+    }
+    free(options->jobs);
+    free(options->play);
+    options->play = NULL;
+    options->jobs = NULL;
+    options->numJobs = 0;
+}
+
+/*
+ * Running Jobs
+ */
+
+void loadJob(Scene *scene, const Job *job)
+{
+    // Meshes whose sweeps are split across the pool are placed on the nodes of the threads sweeping them
+    bool place = countNodes() > 1 && job->numInputs <= scene->pool->numThreads;
+    clearScene(scene);
+    for (size_t i = 0; i < job->numInputs; i++)
+    {
+        Mesh *mesh = createMesh(job->inputs[i]);
+        if (place)
+            placeMesh(mesh, scene->pool);
+        SceneEntry *entry = addModel(scene, createModel(mesh), job->flow);
+        entry->model->mesh->precision = job->precision;
+        entry->flowing = true;
+        entry->maxSteps = job->steps;
+    }
+}
+
+char *outputPath(const Job *job, size_t input)
+{
+    if (!job->output)
+        return NULL;
+
+    // A single input may go to a file; otherwise output is a directory and files keep their input names
+    size_t length = strlen(job->output);
+    bool single = job->numInputs == 1 && length > 4 && !strcmp(job->output + length - 4, ".obj");
+
+    const char *name = job->inputs[input];
+    for (const char *c = job->inputs[input]; *c; c++)
+        if (*c == '/' || *c == '\\')
+            name = c + 1;
+
+    char *path = malloc(length + strlen(name) + 2);
+    if (single)
+        strcpy(path, job->output);
+    else
+        sprintf(path, "%s/%s", job->output, name);
+    return path;
+}
+
+bool exportJob(const Scene *scene, const Job *job)
+{
+    bool written = true;
+    for (size_t i = 0; job->output && i < scene->numEntries; i++)
+    {
+        char *path = outputPath(job, i);
+        written &= exportOBJ(scene->entries[i].model->mesh, path);
+        free(path);
+    }
+    return written;
+}
+
+// Renders scene from the rotate camera's path and appends it to the job's GIF, or writes it as the next PNG of its directory
+static bool renderFrame(Renderer *renderer, GifWriter *gif, const Scene *scene, const Job *job, size_t frame)
+{
+    Camera camera = {.fov = INIT_FOV};
+    mat4 projection, view;
+    orbitCamera(&camera, (float *)scene->center, INIT_RADIUS, (double)frame / RENDER_FPS,
+                (float)renderer->width / (float)renderer->height, projection, view);
+    renderScene(renderer, scene, view, projection);
+    if (gif)
+    {
+        writeGifFrame(gif, renderer->pixels);
+        return true;
+    }
+
+    char *path = malloc(strlen(job->render) + 32);
+    sprintf(path, "%s/frame_%05zu.png", job->render, frame);
+    bool written = writePNG(path, renderer->pixels, (const uint8_t(*)[3])renderer->palette, renderer->width, renderer->height);
+    free(path);
+    return written;
+}
+
+// Flows job's single input out of core from its cluster file, streaming the input into it first unless the file
+// exists already (in which case the flow resumes from the steps the file holds)
+static bool runOutOfCore(const Scene *scene, const Job *job)
+{
+    double start = wallTime();
+    FILE *existing = fopen(job->outOfCore, "rb");
+    if (existing)
+    {
+        fclose(existing);
+        printf("%s: resuming from %s\n", job->inputs[0], job->outOfCore);
+    }
+    else if (!convertClusters(job->inputs[0], job->outOfCore, CLUSTER_VERTICES))
+        return false;
+
+    ClusteredMesh *clustered = openClusters(job->outOfCore, job->flow, job->precision);
+    if (!clustered)
+    {
+        fprintf(stderr, "Error opening cluster file: %s\n", job->outOfCore);
+        return false;
+    }
+    double loaded = wallTime();
+
+    float step = job->step > 0.0f ? job->step : DEFAULT_STEP;
+    size_t steps = 0;
+    for (; clustered->header->steps < job->steps; steps++)
+        stepClusters(clustered, step, scene->pool);
+    double flowed = wallTime();
+
+    char *path = outputPath(job, 0);
+    bool written = !path || exportClusters(clustered, path);
+    free(path);
+
+    size_t numClusters = (size_t)clustered->header->numClusters;
+    printf("%s: out of core, %zu cluster%s, %zu steps, load %.3f s, flow %.3f s (%.3f ms/step)\n", job->inputs[0],
+           numClusters, numClusters > 1 ? "s" : "", steps, loaded - start, flowed - loaded,
+           steps ? (flowed - loaded) * 1e3 / steps : 0.0);
+    closeClusters(clustered);
+    return written;
+}
+
+// Flows each of job's inputs in worker processes, one per domain, and writes it out
+static bool runDomains(const Job *job)
+{
+    bool written = true;
+    float step = job->step > 0.0f ? job->step : DEFAULT_STEP;
+    for (size_t i = 0; i < job->numInputs; i++)
+    {
+        double start = wallTime();
+        Mesh *mesh = createMesh(job->inputs[i]);
+        double loaded = wallTime();
+
+        DomainReport report;
+        bool flowed = flowDomains(mesh, job->flow, job->precision, step, job->steps, job->domains, &report);
+        char *path = outputPath(job, i);
+        written &= flowed && (!path || exportOBJ(mesh, path));
+        free(path);
+        destroyMesh(mesh);
+
+        printf("%s: %zu domains on %zu node%s, %zu cut edges, %zu halo vertices, %zu steps, load %.3f s, "
+               "partition %.3f s, flow %.3f s (%.3f ms/step)\n",
+               job->inputs[i], report.domains, report.nodes, report.nodes > 1 ? "s" : "", report.cutEdges,
+               report.haloVertices, job->steps, loaded - start, report.partitionTime, report.flowTime,
+               job->steps ? report.flowTime * 1e3 / job->steps : 0.0);
+    }
+    return written;
+}
+
+bool runJob(Scene *scene, const Job *job)
+{
+    if (job->outOfCore)
+        return runOutOfCore(scene, job);
+    if (job->domains > 1)
+        return runDomains(job);
+
+    double start = wallTime();
+    bool resumed = job->checkpoint && restoreCheckpoint(scene, job->checkpoint, job->steps);
+    if (resumed)
+        printf("%s: resuming from %s\n", job->inputs[0], job->checkpoint);
+    else
+        loadJob(scene, job);
+    double loaded = wallTime();
+
+    // Checkpoints are written in the background while flows go on; recordings get the starting state and every step
+    Checkpointer *checkpointer = job->checkpoint ? createCheckpointer(job->checkpoint) : NULL;
+    Recorder *recorder = job->record ? createRecorder(job->record, scene) : NULL;
+    if (recorder)
+        recordFrame(recorder, scene);
+
+    // Renders get the starting state and every step too, one frame per step
+    Renderer *renderer = NULL;
+    GifWriter *gif = NULL;
+    bool rendered = true;
+    if (job->render)
+    {
+        renderer = createRenderer(RENDER_WIDTH, RENDER_HEIGHT);
+        size_t length = strlen(job->render);
+        if (length > 4 && !strcmp(job->render + length - 4, ".gif"))
+            rendered = (gif = createGif(job->render, (const uint8_t(*)[3])renderer->palette, renderer->width,
+                                        renderer->height, 100 / RENDER_FPS)) != NULL;
+        rendered = rendered && renderFrame(renderer, gif, scene, job, 0);
+    }
+
+    float step = job->step > 0.0f ? job->step : DEFAULT_STEP;
+    for (size_t i = 1; stepScene(scene, step); i++)
+    {
+        if (recorder)
+            recordFrame(recorder, scene);
+        if (renderer && rendered)
+            rendered = renderFrame(renderer, gif, scene, job, i);
+        if (checkpointer && i % job->interval == 0)
+            saveCheckpoint(checkpointer, scene);
+    }
+    if (checkpointer)
+        saveCheckpoint(checkpointer, scene);
+    destroyCheckpointer(checkpointer);
+    double flowed = wallTime();
+
+    bool recorded = !job->record || (recorder && closeRecorder(recorder));
+    rendered = closeGif(gif) && rendered;
+    destroyRenderer(renderer);
+    bool written = exportJob(scene, job) && recorded && rendered;
+
+    size_t steps = 0;
+    for (size_t i = 0; i < scene->numEntries; i++)
+        steps += scene->entries[i].steps;
+    printf("%s%s: %zu model%s, %zu steps, load %.3f s, flow %.3f s (%.3f ms/step)\n", job->inputs[0],
+           job->numInputs > 1 ? " ..." : "", job->numInputs, job->numInputs > 1 ? "s" : "", steps, loaded - start,
+           flowed - loaded, steps ? (flowed - loaded) * 1e3 / steps : 0.0);
+
+    // Where vertices ended up, against the nodes of the threads sweeping them
+    for (size_t i = 0; countNodes() > 1 && i < scene->numEntries; i++)
+    {
+        NumaReport report = measurePlacement(scene->entries[i].model->mesh, scene->pool);
+        size_t known = report.localPages + report.remotePages;
+        printf("%s: %zu vertex pages local to their thread's node, %zu remote (%.1f%% local)\n", job->inputs[i],
+               report.localPages, report.remotePages, known ? 100.0 * report.localPages / known : 0.0);
+    }
+
+    // Willmore steps left with approximate solutions, which even a refreshed operator didn't get to converge
+    for (size_t i = 0; i < scene->numEntries; i++)
+    {
+        const Willmore *willmore = scene->entries[i].model->mesh->willmore;
+        if (willmore && willmore->unconverged)
+            printf("%s: %zu Willmore steps stopped at the solver's iteration limit\n", job->inputs[i], willmore->unconverged);
+    }
+
+    // Ricci flows whose Newton steps stopped reducing the error, which leave their meshes unflattened
+    for (size_t i = 0; i < scene->numEntries; i++)
+    {
+        const Ricci *ricci = scene->entries[i].model->mesh->ricci;
+        if (ricci && ricci->stalled)
+            printf("%s: Ricci flow stalled after %zu Newton steps at curvature error %.3e\n", job->inputs[i], ricci->iterations,
+                   ricci->error);
+    }
+
+    return written;
+}
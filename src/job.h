@@ -0,0 +1,159 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include "geometry.h"
+#include "scene.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Job settings
+#define DEFAULT_STEP 0.01f // time step of headless jobs that don't give one
+#define MAX_LINE 1024      // longest line of a job file
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Meshes to flow together and what to do with them.
+ */
+typedef struct
+{
+    char **inputs;       // .obj files to load (one model each)
+    size_t numInputs;    // number of inputs
+    GEOMETRIC_FLOW flow; // flow computed on every model
+    float step;          // fixed time step (0 for frame time, or DEFAULT_STEP when headless)
+    size_t steps;        // steps before flows stop (0 for no limit)
+    char *output;        // .obj file (single input) or directory to write flowed meshes to (NULL for none)
+    char *checkpoint;    // file flow state is saved to and resumed from (NULL for none)
+    size_t interval;     // steps between checkpoints
+    char *record;        // file every step of the flows is recorded to (NULL for none)
+    char *render;        // .gif file or directory of .png frames every step is rendered to (NULL for none)
+    PRECISION precision; // arithmetic of every model's curvature sweeps and explicit updates
+    char *outOfCore;     // cluster file the single input is flowed from out of core (NULL to flow in memory)
+    size_t domains;      // worker processes each input is partitioned across (0 or 1 to flow in this process)
+} Job;
+
+/**
+ * @brief Settings of a run, from the command line and optionally a job file.
+ */
+typedef struct
+{
+    Job *jobs;      // jobs to run in order (a window only shows the first)
+    size_t numJobs; // number of jobs
+    size_t threads; // threads stepping flows, including the main one (0 for one per processor)
+    bool headless;  // whether to run jobs without a window
+    bool batch;     // whether first job is a batch (its inputs are flowed independently, one per thread)
+    char *play;     // recording to play back in the window instead of running jobs (NULL for none)
+    bool pin;       // whether threads stepping flows are pinned to NUMA nodes (see pinThreadPool)
+    bool hugePages; // whether big mesh arrays ask for huge pages (see useHugePages)
+} Options;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Parses command line (printing usage and exiting on errors or --help).
+ *
+ * A job file (--job) adds its jobs after the one given on the command line (if any inputs were) and
+ * implies headless mode. A batch (--batch) adds its meshes to the command line's job and makes it a batch.
+ *
+ * @param argc    Number of arguments.
+ * @param argv    Arguments.
+ * @param options Destination of options.
+ */
+void parseArguments(int argc, char **argv, Options *options);
+
+/**
+ * @brief Parses job file, appending its jobs to options (exits on errors).
+ *
+ * Job files are a subset of TOML: top-level keys (threads) followed by [[job]] tables with the keys
+ * input (string or array of strings), flow, step, steps, output, checkpoint, interval, and record, e.g.
+ *
+ *     threads = 4
+ *
+ *     [[job]]
+ *     input = ["models/hand.obj", "models/torus.obj"]
+ *     flow = "willmore"
+ *     steps = 100
+ *     output = "out"
+ *
+ * @param filename Job file.
+ * @param options  Options to add jobs and settings to.
+ */
+void parseJobFile(const char *filename, Options *options);
+
+/**
+ * @brief Destroys options' jobs and frees space.
+ *
+ * @param options Options to clear.
+ */
+void destroyOptions(Options *options);
+
+/**
+ * @brief Parses flow name (mcf, gcf, willmore, ricci).
+ *
+ * @param name Name of flow.
+ * @param flow Destination of flow.
+ * @return True if name is known.
+ */
+bool parseFlow(const char *name, GEOMETRIC_FLOW *flow);
+
+/**
+ * @brief Parses precision name (float, mixed, double).
+ *
+ * @param name      Name of precision.
+ * @param precision Destination of precision.
+ * @return True if name is known.
+ */
+bool parsePrecision(const char *name, PRECISION *precision);
+
+/**
+ * @brief Loads job's meshes into scene (replacing its models) with their flows running.
+ *
+ * @param scene Scene to load into.
+ * @param job   Job to load.
+ */
+void loadJob(Scene *scene, const Job *job);
+
+/**
+ * @brief Gives path job's flowed input is written to.
+ *
+ * @param job   Job input belongs to.
+ * @param input Index of input.
+ * @return Allocated path (free after use), or NULL if job has no output.
+ */
+char *outputPath(const Job *job, size_t input);
+
+/**
+ * @brief Writes scene's meshes to job's output (nothing if it has none).
+ *
+ * @param scene Scene holding job's models, in input order.
+ * @param job   Job scene was loaded from.
+ * @return True if every mesh was written.
+ */
+bool exportJob(const Scene *scene, const Job *job);
+
+/**
+ * @brief Runs job without a window: loads it, steps its flows until they stop, and exports the results.
+ *
+ * Jobs with a recording record their loaded meshes and every step after. Jobs with a checkpoint resume from it if it exists, and save to it every interval steps (in the
+ * background) and once their flows stop. Out-of-core jobs flow their mesh from its cluster file instead of the scene,
+ * and resume from the steps it holds; jobs split into domains flow each mesh in worker processes instead. The scene's thread pool and allocations carry over from job to job.
+ *
+ * @param scene Scene to run job in.
+ * @param job   Job to run (needs a step limit).
+ * @return True if job ran and its results were written.
+ */
+bool runJob(Scene *scene, const Job *job);
+
+/**
+ * @brief Wall clock time in seconds (headless runs have no GLFW timer).
+ *
+ * @return Current time.
+ */
+double wallTime(void);
+
+#endif
@@ -0,0 +1,114 @@
+#include "loader.h"
+#include "model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Publishes progress of the file being loaded
+static void reportProgress(void *data, float progress)
+{
+    Loader *loader = data;
+    pthread_mutex_lock(&loader->lock);
+    loader->progress = progress;
+    pthread_mutex_unlock(&loader->lock);
+}
+
+static void *loaderMain(void *argument)
+{
+    Loader *loader = argument;
+    for (size_t i = 0; i < loader->numFiles; i++)
+    {
+        pthread_mutex_lock(&loader->lock);
+        bool cancelled = loader->cancelled;
+        loader->progress = 0.0f;
+        pthread_mutex_unlock(&loader->lock);
+        if (cancelled)
+            break;
+
+        // Load without holding the lock (only progress reports take it)
+        Mesh *mesh = malloc(sizeof(Mesh));
+        if (!loadOBJWithProgress(loader->filenames[i], mesh, reportProgress, loader))
+        {
+            free(mesh);
+            mesh = NULL;
+        }
+
+        pthread_mutex_lock(&loader->lock);
+        loader->meshes[i] = mesh;
+        loader->numLoaded++;
+        pthread_mutex_unlock(&loader->lock);
+    }
+
+    return NULL;
+}
+
+Loader *createLoader(char *const *filenames, size_t count)
+{
+    Loader *loader = malloc(sizeof(Loader));
+    loader->filenames = malloc(count * sizeof(char *));
+    loader->meshes = calloc(count, sizeof(Mesh *));
+    loader->numFiles = count;
+    loader->numLoaded = loader->numTaken = 0;
+    loader->progress = 0.0f;
+    loader->cancelled = false;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t length = strlen(filenames[i]) + 1;
+        loader->filenames[i] = malloc(length);
+        memcpy(loader->filenames[i], filenames[i], length);
+    }
+
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_create(&loader->thread, NULL, loaderMain, loader);
+
+    return loader;
+}
+
+void destroyLoader(Loader *loader)
+{
+    if (!loader)
+        return;
+
+    pthread_mutex_lock(&loader->lock);
+    loader->cancelled = true;
+    pthread_mutex_unlock(&loader->lock);
+    pthread_join(loader->thread, NULL);
+
+    for (size_t i = 0; i < loader->numFiles; i++)
+    {
+        if (loader->meshes[i])
+            destroyMesh(loader->meshes[i]);
+        free(loader->filenames[i]);
+    }
+    pthread_mutex_destroy(&loader->lock);
+    free(loader->filenames);
+    free(loader->meshes);
+    free(loader);
+}
+
+bool pollLoader(Loader *loader, size_t *index, Mesh **mesh)
+{
+    pthread_mutex_lock(&loader->lock);
+    bool ready = loader->numTaken < loader->numLoaded;
+    if (ready)
+    {
+        *index = loader->numTaken;
+        *mesh = loader->meshes[loader->numTaken];
+        loader->meshes[loader->numTaken++] = NULL;
+    }
+    pthread_mutex_unlock(&loader->lock);
+
+    return ready;
+}
+
+bool queryLoader(Loader *loader, size_t *index, float *progress)
+{
+    pthread_mutex_lock(&loader->lock);
+    bool loading = loader->numLoaded < loader->numFiles && !loader->cancelled;
+    *index = loader->numLoaded;
+    *progress = loader->progress;
+    pthread_mutex_unlock(&loader->lock);
+
+    return loading;
+}
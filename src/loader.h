@@ -0,0 +1,75 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "model.h"
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Background thread loading meshes (parsing, adjacency, and curvature) one after another.
+ *
+ * Meshes are handed out in file order as soon as each is ready, so the render loop keeps running and
+ * can show progress while later files are still loading.
+ */
+typedef struct
+{
+    pthread_t thread;     // loading thread
+    pthread_mutex_t lock; // guards everything below
+    char **filenames;     // files to load (copies)
+    Mesh **meshes;        // loaded meshes (NULL if loading failed or mesh was handed out)
+    size_t numFiles;      // number of files
+    size_t numLoaded;     // files finished loading (successfully or not)
+    size_t numTaken;      // files handed out by pollLoader
+    float progress;       // progress of file being loaded
+    bool cancelled;       // whether loading should stop after the current file
+} Loader;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Starts loading files on a new thread.
+ *
+ * @param filenames Files to load.
+ * @param count     Number of files.
+ * @return Loader (running).
+ */
+Loader *createLoader(char *const *filenames, size_t count);
+
+/**
+ * @brief Stops loader after the file it is working on, destroys it and any meshes not handed out, and
+ * frees space.
+ *
+ * @param loader Loader to destroy (may be NULL).
+ */
+void destroyLoader(Loader *loader);
+
+/**
+ * @brief Hands out the next file's mesh if it has finished loading (files are handed out in order).
+ *
+ * @param loader Loader to poll.
+ * @param index  Destination of file's index.
+ * @param mesh   Destination of loaded mesh (NULL if file failed to load).
+ * @return True if a file was handed out.
+ */
+bool pollLoader(Loader *loader, size_t *index, Mesh **mesh);
+
+/**
+ * @brief Reports what loader is working on.
+ *
+ * @param loader   Loader to query.
+ * @param index    Destination of index of file being loaded.
+ * @param progress Destination of its progress in [0, 1].
+ * @return True if loader is still loading.
+ */
+bool queryLoader(Loader *loader, size_t *index, float *progress);
+
+#endif
@@ -5,6 +5,14 @@
 #include "fast_obj.h"
 
 #include "model.h"
+#include "geometry.h"
+#include "selection.h"
+#include "bvh.h"
+#include "collision.h"
+#include "ricci.h"
+#include "willmore.h"
+#include "weld.h"
+#include "arena.h"
 
 #include <cglm/cglm.h>
 
@@ -12,6 +20,7 @@
 #include <stdio.h>
 #include <stddef.h>
 #include <string.h>
+#include <math.h>
 
 // TODO: Make initCurvature more accurate
 
@@ -39,46 +48,53 @@ Mesh *createMesh(const char *filename)
     Mesh *mesh = malloc(sizeof(Mesh));
 
     // OBJ
-    loadOBJ(filename, mesh);
-
-    // VAO
-    glGenVertexArrays(1, &mesh->VAO);
-    glBindVertexArray(mesh->VAO);
-
-    // VBO
-    glGenBuffers(1, &mesh->VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * VERTEX_LIMIT, NULL, GL_DYNAMIC_DRAW);
-
-    // Attributes
-    glEnableVertexAttribArray(0); // position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, position));
-    glEnableVertexAttribArray(1); // normal
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(2); // curvature
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, curvature));
-
-    // IBO
-    glCreateBuffers(1, &mesh->IBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->IBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh->numIndices * sizeof(uint32_t), mesh->indices, GL_STATIC_DRAW);
+    if (!loadOBJ(filename, mesh))
+        exit(EXIT_FAILURE);
 
     return mesh;
 }
 
 void destroyMesh(Mesh *mesh)
 {
-    // Delete buffers
-    glDeleteVertexArrays(1, &(mesh->VAO));
-    glDeleteBuffers(1, &(mesh->VBO));
-    glDeleteBuffers(1, &(mesh->IBO));
-
     // Free memory
+    destroySelection(mesh->selection);
+    destroyBVH(mesh->bvh);
+    destroySpatialHash(mesh->spatialHash);
+    destroyRicci(mesh->ricci);
+    destroyWillmore(mesh->willmore);
+    destroyArena(mesh->arena);
+    free(mesh->precise);
     free(mesh->vertices);
     free(mesh->indices);
+    free(mesh->faceOffsets);
+    free(mesh->faces);
+    free(mesh->ringOffsets);
+    free(mesh->ring);
+    free(mesh->areas);
+    free(mesh->faceNormals);
     free(mesh);
 }
 
+Arena *meshArena(Mesh *mesh)
+{
+    if (!mesh->arena)
+        mesh->arena = createArena();
+    return mesh->arena;
+}
+
+void adviseMesh(Mesh *mesh)
+{
+    size_t numVertices = mesh->numVertices, numIndices = mesh->numIndices;
+    adviseHugePages(mesh->vertices, numVertices * sizeof(Vertex));
+    adviseHugePages(mesh->areas, numVertices * sizeof(float));
+    if (mesh->precise)
+        adviseHugePages(mesh->precise, numVertices * sizeof(*mesh->precise));
+    adviseHugePages(mesh->indices, numIndices * sizeof(uint32_t));
+    adviseHugePages(mesh->faces, numIndices * sizeof(uint32_t));
+    adviseHugePages(mesh->ring, mesh->ringOffsets[numVertices] * sizeof(uint32_t));
+    adviseHugePages(mesh->faceNormals, numIndices / 3 * sizeof(vec3));
+}
+
 void computeModelMatrix(Model *model, mat4 *dest)
 {
     mat4 modelMatrix;
@@ -99,23 +115,225 @@ void computeModelMatrix(Model *model, mat4 *dest)
     glm_mat4_copy(modelMatrix, *dest);
 }
 
-void loadOBJ(const char *filename, Mesh *mesh)
+/*
+ * Loading
+ */
+
+// File read by fast_obj while reporting progress
+typedef struct
+{
+    FILE *file;  // open file
+    long size;   // size of file in bytes
+    long read;   // bytes read so far
+    bool report; // whether reads are reported (only the .obj itself, not material libraries)
+} ProgressFile;
+
+// Progress reporting of one load
+typedef struct
+{
+    ProgressFunction report; // reporting function
+    void *data;              // data passed to reporting function
+    bool opened;             // whether the .obj has been opened (files opened after it are material libraries)
+} ProgressContext;
+
+static void *openProgressFile(const char *path, void *userData)
+{
+    ProgressContext *context = userData;
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    ProgressFile *progressFile = malloc(sizeof(ProgressFile));
+    progressFile->file = file;
+    progressFile->size = fseek(file, 0, SEEK_END) ? 0 : ftell(file);
+    progressFile->read = 0;
+    progressFile->report = !context->opened;
+    context->opened = true;
+    fseek(file, 0, SEEK_SET);
+    return progressFile;
+}
+
+static void closeProgressFile(void *file, void *userData)
+{
+    ProgressFile *progressFile = file;
+    fclose(progressFile->file);
+    free(progressFile);
+}
+
+static size_t readProgressFile(void *file, void *dst, size_t bytes, void *userData)
+{
+    ProgressContext *context = userData;
+    ProgressFile *progressFile = file;
+    size_t read = fread(dst, 1, bytes, progressFile->file);
+
+    progressFile->read += (long)read;
+    if (progressFile->report && progressFile->size > 0)
+        context->report(context->data, PARSE_PROGRESS * (float)progressFile->read / (float)progressFile->size);
+    return read;
+}
+
+static unsigned long sizeProgressFile(void *file, void *userData)
+{
+    return (unsigned long)((ProgressFile *)file)->size;
+}
+
+// Number of triangles faces split into (faces with fewer than three corners are skipped), and most corners of a face
+static size_t countTriangles(const fastObjMesh *obj, size_t *maxCorners)
 {
-    // Load OBJ
-    fastObjMesh *obj = fast_obj_read(filename);
+    size_t count = 0;
+    *maxCorners = 0;
+    for (unsigned int f = 0; f < obj->face_count; f++)
+    {
+        size_t corners = obj->face_vertices[f];
+        count += corners >= 3 ? corners - 2 : 0;
+        *maxCorners = corners > *maxCorners ? corners : *maxCorners;
+    }
+    return count;
+}
+
+// Twice the signed area of a triangle of projected corners (positive if counterclockwise)
+static float signedArea(const float (*points)[2], uint32_t a, uint32_t b, uint32_t c)
+{
+    return (points[b][0] - points[a][0]) * (points[c][1] - points[a][1]) -
+           (points[b][1] - points[a][1]) * (points[c][0] - points[a][0]);
+}
+
+// Whether a point lies inside or on triangle abc (counterclockwise)
+static bool pointInTriangle(const float (*points)[2], uint32_t p, uint32_t a, uint32_t b, uint32_t c)
+{
+    return signedArea(points, a, b, p) >= 0.0f && signedArea(points, b, c, p) >= 0.0f &&
+           signedArea(points, c, a, p) >= 0.0f;
+}
+
+uint32_t *triangulatePolygon(const float (*positions)[3], const uint32_t *face, size_t corners, uint32_t *dest,
+                             float (*points)[2], uint32_t *remaining)
+{
+    // Project onto the coordinate plane facing the normal most, oriented so that the polygon runs counterclockwise
+    vec3 normal = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < corners; i++)
+    {
+        const float *p = positions[i], *q = positions[(i + 1) % corners];
+        normal[0] += (p[1] - q[1]) * (p[2] + q[2]);
+        normal[1] += (p[2] - q[2]) * (p[0] + q[0]);
+        normal[2] += (p[0] - q[0]) * (p[1] + q[1]);
+    }
+    int axis = fabsf(normal[0]) > fabsf(normal[1]) ? (fabsf(normal[0]) > fabsf(normal[2]) ? 0 : 2)
+                                                   : (fabsf(normal[1]) > fabsf(normal[2]) ? 1 : 2);
+    int u = (axis + 1) % 3, w = (axis + 2) % 3;
+    if (normal[axis] < 0.0f)
+    {
+        int swap = u;
+        u = w;
+        w = swap;
+    }
+
+    // A convex polygon has no reflex corners, so every corner is an ear and it becomes a fan without a single point test
+    bool convex = true;
+    for (size_t i = 0; i < corners; i++)
+    {
+        points[i][0] = positions[i][u];
+        points[i][1] = positions[i][w];
+        remaining[i] = (uint32_t)i;
+    }
+    for (size_t i = 0; i < corners; i++)
+        convex = convex && signedArea(points, (uint32_t)((i + corners - 1) % corners), (uint32_t)i,
+                                      (uint32_t)((i + 1) % corners)) >= 0.0f;
+
+    // Clip ears, moving on from each clipped corner so that convex stretches cost one test per corner
+    size_t count = corners, i = 1, misses = 0;
+    while (count > 3 && misses < count)
+    {
+        uint32_t a = remaining[(i + count - 1) % count], b = remaining[i % count], c = remaining[(i + 1) % count];
+        bool ear = signedArea(points, a, b, c) > 0.0f;
+        for (size_t j = 0; ear && !convex && j < count; j++)
+        {
+            uint32_t p = remaining[j];
+            ear = p == a || p == b || p == c || !pointInTriangle(points, p, a, b, c);
+        }
+
+        if (!ear)
+        {
+            i = (i + 1) % count;
+            misses++;
+            continue;
+        }
+        *dest++ = face[a];
+        *dest++ = face[b];
+        *dest++ = face[c];
+        memmove(&remaining[i % count], &remaining[i % count + 1], (count - i % count - 1) * sizeof(uint32_t));
+        count--;
+        i %= count;
+        misses = 0;
+    }
+
+    // Last triangle (or the rest as a fan)
+    for (size_t j = 1; j + 1 < count; j++)
+    {
+        *dest++ = face[remaining[0]];
+        *dest++ = face[remaining[j]];
+        *dest++ = face[remaining[j + 1]];
+    }
+    return dest;
+}
+
+// Writes triangles of every face to indices (sized by countTriangles)
+static void triangulateFaces(const fastObjMesh *obj, size_t maxCorners, uint32_t *indices)
+{
+    float(*points)[2] = malloc((maxCorners ? maxCorners : 1) * sizeof(*points));
+    float(*positions)[3] = malloc((maxCorners ? maxCorners : 1) * sizeof(*positions));
+    uint32_t *corners = malloc((maxCorners ? maxCorners : 1) * sizeof(uint32_t));
+    uint32_t *remaining = malloc((maxCorners ? maxCorners : 1) * sizeof(uint32_t));
+    const fastObjIndex *face = obj->indices;
+    for (unsigned int f = 0; f < obj->face_count; f++)
+    {
+        size_t count = obj->face_vertices[f];
+        if (count == 3)
+        {
+            for (int k = 0; k < 3; k++)
+                *indices++ = face[k].p;
+        }
+        else if (count > 3)
+        {
+            for (size_t k = 0; k < count; k++)
+            {
+                corners[k] = face[k].p;
+                memcpy(positions[k], &obj->positions[3 * face[k].p], sizeof(positions[k]));
+            }
+            indices = triangulatePolygon((const float(*)[3])positions, corners, count, indices, points, remaining);
+        }
+        face += count;
+    }
+    free(points);
+    free(positions);
+    free(corners);
+    free(remaining);
+}
+
+bool loadOBJ(const char *filename, Mesh *mesh)
+{
+    return loadOBJWithProgress(filename, mesh, NULL, NULL);
+}
+
+bool loadOBJWithProgress(const char *filename, Mesh *mesh, ProgressFunction report, void *data)
+{
+    // Load OBJ (through reporting file callbacks if progress is wanted)
+    ProgressContext context = {report, data, false};
+    fastObjCallbacks callbacks = {openProgressFile, closeProgressFile, readProgressFile, sizeProgressFile};
+    fastObjMesh *obj = report ? fast_obj_read_with_callbacks(filename, &callbacks, &context) : fast_obj_read(filename);
     if (!obj)
     {
         fprintf(stderr, "Error loading OBJ file: %s\n", filename);
-        exit(EXIT_FAILURE);
+        return false;
     }
 
-    // Grab geometry stats
+    // Grab geometry stats (quads and polygons are split into triangles)
+    size_t maxCorners;
     mesh->numVertices = obj->position_count;
-    mesh->numIndices = obj->face_count * 3;
+    mesh->numIndices = 3 * countTriangles(obj, &maxCorners);
 
     // Allocate memory
     mesh->vertices = malloc(mesh->numVertices * sizeof(Vertex));
-    mesh->indices = malloc(mesh->numIndices * sizeof(uint32_t));
+    mesh->indices = malloc((mesh->numIndices ? mesh->numIndices : 1) * sizeof(uint32_t));
 
     // Copy vertices
     for (unsigned int i = 0; i < obj->position_count; ++i)
@@ -125,49 +343,226 @@ void loadOBJ(const char *filename, Mesh *mesh)
         mesh->vertices[i].position[2] = obj->positions[3 * i + 2];
     }
 
-    // Copy indices (converting to 0-based)
-    for (unsigned int i = 0; i < obj->face_count; ++i)
+    // Triangulate faces straight into indices
+    triangulateFaces(obj, maxCorners, mesh->indices);
+
+    // Weld split seams and duplicated positions (so flows see one connected surface)
+    WeldReport weld = weldMesh(mesh, WELD_EPSILON, NULL);
+    if (weld.mergedVertices || weld.degenerateFaces || weld.duplicateFaces)
+        printf("%s: welded %zu vertices, dropped %zu degenerate and %zu duplicate faces\n", filename,
+               weld.mergedVertices, weld.degenerateFaces, weld.duplicateFaces);
+
+    // Adjacency (needed by curvature sweep)
+    buildAdjacency(mesh);
+    mesh->areas = malloc(mesh->numVertices * sizeof(float));
+    mesh->faceNormals = malloc(mesh->numIndices / 3 * sizeof(vec3));
+    mesh->precise = NULL;
+    adviseMesh(mesh); // before the first sweep touches the new arrays
+    if (report)
+        report(data, ADJACENCY_PROGRESS);
+
+    // Initialize normals and curvatures (in one sweep, which reads the precision)
+    mesh->precision = PRECISION_FLOAT;
+    mesh->showGaussian = false;
+    initCurvature(mesh);
+    if (report)
+        report(data, 1.0f);
+
+    // Selection and upload state
+    mesh->selection = NULL;
+    mesh->bvh = NULL;
+    mesh->spatialHash = NULL;
+    mesh->ricci = NULL;
+    mesh->willmore = NULL;
+    mesh->arena = NULL;
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+
+    fast_obj_destroy(obj);
+    return true;
+}
+
+bool streamOBJ(const char *filename, VertexFunction vertex, PolygonFunction polygon, void *data)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
     {
-        mesh->indices[3 * i + 0] = obj->indices[3 * i + 0].p;
-        mesh->indices[3 * i + 1] = obj->indices[3 * i + 1].p;
-        mesh->indices[3 * i + 2] = obj->indices[3 * i + 2].p;
+        fprintf(stderr, "Error loading OBJ file: %s\n", filename);
+        return false;
     }
 
-    // Initialize normals and curvatures
-    for (size_t i = 0; i < mesh->numVertices; i++)
-        glm_vec3_zero(mesh->vertices[i].normal);
-    initCurvature(mesh);
+    // Blocks are read like fast_obj reads them: whole lines are parsed, and the rest is carried over to the next block
+    char *buffer = malloc(2 * BUFFER_SIZE);
+    size_t capacity = 16, numVertices = 1; // fast_obj's dummy vertex 0 counts towards relative indices
+    uint32_t *corners = malloc(capacity * sizeof(uint32_t));
+    char *start = buffer;
+    bool parsed = true;
+    for (;;)
+    {
+        size_t read = fread(start, 1, BUFFER_SIZE, file);
+        if (read == 0 && start == buffer)
+            break;
+        if (read < BUFFER_SIZE && (read == 0 || start[read - 1] != '\n'))
+            start[read++] = '\n';
+        char *end = start + read, *last = end;
+        while (last > buffer && *--last != '\n')
+            ;
+        if (*last++ != '\n' || end - last >= BUFFER_SIZE)
+        {
+            parsed = false; // a line longer than a block
+            break;
+        }
+
+        for (const char *p = buffer; p != last; p = skip_line(p))
+        {
+            p = skip_whitespace(p);
+            if ((p[0] != 'v' && p[0] != 'f') || (p[1] != ' ' && p[1] != '\t'))
+                continue;
+
+            // Position (colors are ignored)
+            if (*p == 'v')
+            {
+                float position[3];
+                p += 2;
+                for (int k = 0; k < 3; k++)
+                    p = parse_float(p, &position[k]);
+                vertex(data, position);
+                numVertices++;
+                continue;
+            }
+
+            // Polygon, with relative indices resolved against the vertices so far (faces with an index of 0 are
+            // skipped, and so are faces of fewer than three corners)
+            size_t count = 0;
+            p = skip_whitespace(p + 2);
+            while (!is_newline(*p))
+            {
+                int v = 0, t;
+                p = parse_int(p, &v);
+                if (*p == '/')
+                {
+                    p++;
+                    if (*p != '/')
+                        p = parse_int(p, &t);
+                    if (*p == '/')
+                        p = parse_int(p + 1, &t);
+                }
+                if (v == 0)
+                {
+                    count = 0;
+                    break;
+                }
+
+                if (count == capacity)
+                    corners = realloc(corners, (capacity *= 2) * sizeof(uint32_t));
+                corners[count++] = v < 0 ? (uint32_t)(numVertices - (size_t)-(int64_t)v) : (uint32_t)v;
+                p = skip_whitespace(p);
+            }
+            if (count >= 3)
+                polygon(data, corners, count);
+        }
+
+        memmove(buffer, last, (size_t)(end - last));
+        start = buffer + (end - last);
+    }
+    free(buffer);
+    free(corners);
 
-    fast_obj_destroy(obj);
+    parsed = parsed && !ferror(file);
+    fclose(file);
+    if (!parsed)
+        fprintf(stderr, "Error loading OBJ file: %s\n", filename);
+    return parsed;
 }
 
-void initCurvature(Mesh *mesh)
+bool exportOBJ(const Mesh *mesh, const char *filename)
 {
-    // Calculate initial mean curvature vectors
+    FILE *file = fopen(filename, "w");
+    if (!file)
+    {
+        fprintf(stderr, "Error writing OBJ file: %s\n", filename);
+        return false;
+    }
+
+    // Vertices (skipping fast_obj's dummy vertex, so that indices stay 1-based as loaded)
+    for (size_t i = 1; i < mesh->numVertices; i++)
+    {
+        const float *position = mesh->vertices[i].position;
+        fprintf(file, "v %.9g %.9g %.9g\n", position[0], position[1], position[2]);
+    }
+
+    // Faces
     for (size_t i = 0; i < mesh->numIndices; i += 3)
+        fprintf(file, "f %u %u %u\n", mesh->indices[i], mesh->indices[i + 1], mesh->indices[i + 2]);
+
+    bool written = !ferror(file);
+    if (fclose(file) != 0 || !written)
     {
-        uint32_t v0 = mesh->indices[i];
-        uint32_t v1 = mesh->indices[i + 1];
-        uint32_t v2 = mesh->indices[i + 2];
-
-        vec3 diff;
-        glm_vec3_sub(mesh->vertices[v1].position, mesh->vertices[v0].position, diff);
-        glm_vec3_add(mesh->vertices[v0].curvature, diff, mesh->vertices[v0].curvature);
-        glm_vec3_sub(mesh->vertices[v0].position, mesh->vertices[v1].position, diff);
-        glm_vec3_add(mesh->vertices[v1].curvature, diff, mesh->vertices[v1].curvature);
-
-        glm_vec3_sub(mesh->vertices[v2].position, mesh->vertices[v1].position, diff);
-        glm_vec3_add(mesh->vertices[v1].curvature, diff, mesh->vertices[v1].curvature);
-        glm_vec3_sub(mesh->vertices[v1].position, mesh->vertices[v2].position, diff);
-        glm_vec3_add(mesh->vertices[v2].curvature, diff, mesh->vertices[v2].curvature);
-
-        glm_vec3_sub(mesh->vertices[v0].position, mesh->vertices[v2].position, diff);
-        glm_vec3_add(mesh->vertices[v2].curvature, diff, mesh->vertices[v2].curvature);
-        glm_vec3_sub(mesh->vertices[v2].position, mesh->vertices[v0].position, diff);
-        glm_vec3_add(mesh->vertices[v0].curvature, diff, mesh->vertices[v0].curvature);
+        fprintf(stderr, "Error writing OBJ file: %s\n", filename);
+        return false;
     }
+    return true;
+}
+
+void buildAdjacency(Mesh *mesh)
+{
+    size_t numFaces = mesh->numIndices / 3;
+
+    // Count faces incident to each vertex
+    mesh->faceOffsets = calloc(mesh->numVertices + 1, sizeof(uint32_t));
+    for (size_t i = 0; i < mesh->numIndices; i++)
+        mesh->faceOffsets[mesh->indices[i] + 1]++;
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        mesh->faceOffsets[i + 1] += mesh->faceOffsets[i];
+
+    // Fill vertex-face lists (faces end up in ascending order)
+    mesh->faces = malloc(mesh->numIndices * sizeof(uint32_t));
+    uint32_t *fill = malloc(mesh->numVertices * sizeof(uint32_t));
+    memcpy(fill, mesh->faceOffsets, mesh->numVertices * sizeof(uint32_t));
+    for (size_t f = 0; f < numFaces; f++)
+        for (int k = 0; k < 3; k++)
+            mesh->faces[fill[mesh->indices[3 * f + k]]++] = (uint32_t)f;
+    free(fill);
+
+    // Collect one-ring neighbors from incident faces (at most two per face)
+    mesh->ringOffsets = malloc((mesh->numVertices + 1) * sizeof(uint32_t));
+    mesh->ring = malloc(2 * mesh->numIndices * sizeof(uint32_t));
+    size_t count = 0;
+    for (size_t v = 0; v < mesh->numVertices; v++)
+    {
+        mesh->ringOffsets[v] = (uint32_t)count;
+        size_t start = count;
+        for (uint32_t i = mesh->faceOffsets[v]; i < mesh->faceOffsets[v + 1]; i++)
+        {
+            const uint32_t *face = &mesh->indices[3 * mesh->faces[i]];
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t n = face[k];
+                if (n == v)
+                    continue;
+
+                // Insertion sort, skipping duplicates (rings are small)
+                size_t j = count;
+                while (j > start && mesh->ring[j - 1] > n)
+                    j--;
+                if (j > start && mesh->ring[j - 1] == n)
+                    continue;
+                memmove(&mesh->ring[j + 1], &mesh->ring[j], (count - j) * sizeof(uint32_t));
+                mesh->ring[j] = n;
+                count++;
+            }
+        }
+    }
+    mesh->ringOffsets[mesh->numVertices] = (uint32_t)count;
+    mesh->ring = realloc(mesh->ring, (count ? count : 1) * sizeof(uint32_t));
+}
+
+void initCurvature(Mesh *mesh)
+{
+    // Calculate initial mean curvature vectors, Gaussian curvatures, and normals
+    computeCurvature(mesh);
 
     // Scale curvature for heat map coloring
     for (size_t i = 0; i < mesh->numVertices; i++)
         glm_vec3_scale(mesh->vertices[i].curvature, 1000.0f, mesh->vertices[i].curvature);
-}
\ No newline at end of file
+}
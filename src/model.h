@@ -6,9 +6,6 @@
 
 #include <cglm/cglm.h>
 
-// Vertex management settings
-#define VERTEX_LIMIT 50000
-
 // Model init settings
 #define INIT_MODEL_POSITION \
     (vec3) { 0.0f, 0.0f, 0.0f }
@@ -17,6 +14,24 @@
 #define INIT_SCALE \
     (vec3) { 1.0f, 1.0f, 1.0f }
 
+// Loading progress settings (parsing reports up to PARSE_PROGRESS as the file is read)
+#define PARSE_PROGRESS 0.8f     // progress once file is parsed
+#define ADJACENCY_PROGRESS 0.9f // progress once adjacency is built (curvature comes last)
+
+/*
+ * Enums
+ */
+
+/**
+ * @brief Arithmetic of whole-mesh curvature sweeps and explicit flow updates.
+ */
+typedef enum
+{
+    PRECISION_FLOAT, // float storage and arithmetic (fastest)
+    PRECISION_MIXED, // float storage, double differences and sums
+    PRECISION_DOUBLE // double positions and arithmetic (float positions are rounded copies for drawing)
+} PRECISION;
+
 /*
  * Structs
  */
@@ -24,18 +39,54 @@
 typedef struct
 {
     vec3 position;  // vertex's position
-    vec3 normal;    // vertex's normal
+    vec3 normal;    // vertex's normal (sum of area-weighted face normals, not normalized)
     vec3 curvature; // discrete analogue to curvature (or sometimes vector of flow movement)
+    float gaussian; // discrete analogue to Gaussian curvature (angle defect over vertex area)
 } Vertex;
 
+typedef struct Selection Selection;     // see selection.h
+typedef struct BVH BVH;                 // see bvh.h
+typedef struct SpatialHash SpatialHash; // see collision.h
+typedef struct Ricci Ricci;             // see ricci.h
+typedef struct Willmore Willmore;       // see willmore.h
+typedef struct Arena Arena;             // see arena.h
+
 typedef struct
 {
-    Vertex *vertices;               // vertices of obj
-    uint32_t *indices;              // indices of vertices
-    GLuint VAO, VBO, IBO;           // buffers
-    size_t numIndices, numVertices; // geometry stats
+    Vertex *vertices;                // vertices of obj
+    uint32_t *indices;               // indices of vertices
+    uint32_t *faceOffsets, *faces;   // faces incident to each vertex (CSR, indexed by vertex)
+    uint32_t *ringOffsets, *ring;    // one-ring neighbors of each vertex (CSR, sorted, indexed by vertex)
+    float *areas;                    // barycentric area of each vertex (from last curvature sweep)
+    vec3 *faceNormals;               // area-weighted normal of each face, as last summed into vertex normals (selection faces only)
+    Selection *selection;            // active region of flow (NULL for whole mesh)
+    BVH *bvh;                        // triangle hierarchy for picking (NULL until first pick)
+    SpatialHash *spatialHash;        // self-intersection detection (NULL when disabled)
+    Ricci *ricci;                    // Ricci flow state (NULL until Ricci flow runs)
+    Willmore *willmore;              // Willmore flow state (NULL until Willmore flow runs)
+    Arena *arena;                    // temporaries of steps and solvers (NULL until a step needs one)
+    PRECISION precision;             // arithmetic of curvature sweeps and explicit updates
+    bool showGaussian;               // whether flows that don't need Gaussian curvature sweep it anyway (for the heat map)
+    double (*precise)[3];            // double positions (NULL until a double precision sweep runs)
+    size_t dirtyBegin, dirtyEnd;     // range of vertices to upload
+    size_t numIndices, numVertices;  // geometry stats
 } Mesh;
 
+/**
+ * @brief Receives progress of a load in [0, 1] (called on the loading thread).
+ */
+typedef void (*ProgressFunction)(void *data, float progress);
+
+/**
+ * @brief Receives each vertex position of a streamed .obj file, in file order.
+ */
+typedef void (*VertexFunction)(void *data, const float position[3]);
+
+/**
+ * @brief Receives each polygon of a streamed .obj file, in file order, as vertex indices (1-based, as loaded).
+ */
+typedef void (*PolygonFunction)(void *data, const uint32_t *corners, size_t count);
+
 typedef struct
 {
     Mesh *mesh;          // mesh
@@ -65,7 +116,9 @@ Model *createModel(Mesh *mesh);
 void destroyModel(Model *model);
 
 /**
- * @brief Creates mesh and binds buffers.
+ * @brief Creates mesh from .obj file (no OpenGL objects are created; meshes are drawn through a Scene).
+ *
+ * Exits if the file cannot be loaded.
  *
  * @param filename .obj filename.
  * @return Initialized mesh.
@@ -79,6 +132,23 @@ Mesh *createMesh(const char *filename);
  */
 void destroyMesh(Mesh *mesh);
 
+/**
+ * @brief Gets the arena of mesh's per-step temporaries, creating it on first use.
+ *
+ * @param mesh Mesh being stepped.
+ * @return Arena of mesh.
+ */
+Arena *meshArena(Mesh *mesh);
+
+/**
+ * @brief Asks for huge pages behind mesh's big per-vertex and per-face arrays (see adviseHugePages).
+ *
+ * Called wherever those arrays are allocated; does nothing unless huge pages are enabled.
+ *
+ * @param mesh Mesh whose arrays to advise.
+ */
+void adviseMesh(Mesh *mesh);
+
 /**
  * @brief Computes model matrix for use in MVP.
  *
@@ -91,9 +161,67 @@ void computeModelMatrix(Model *model, mat4 *dest);
  * @brief Loads .obj file into mesh.
  *
  * @param filename Name of file to load.
- * @param mesh     Mesh to load data into.
+ * @param mesh     Mesh to load data into (left untouched if loading fails).
+ * @return True if file was loaded.
+ */
+bool loadOBJ(const char *filename, Mesh *mesh);
+
+/**
+ * @brief Loads .obj file into mesh, reporting progress along the way.
+ *
+ * @param filename Name of file to load.
+ * @param mesh     Mesh to load data into (left untouched if loading fails).
+ * @param report   Function receiving progress (NULL for none).
+ * @param data     Data passed to report.
+ * @return True if file was loaded.
+ */
+bool loadOBJWithProgress(const char *filename, Mesh *mesh, ProgressFunction report, void *data);
+
+/**
+ * @brief Reads .obj file line by line, passing on its vertices and polygons without keeping them.
+ *
+ * Numbers are parsed exactly as loadOBJ parses them, and relative indices are resolved against the vertices
+ * read so far, but nothing is triangulated, welded, or checked (indices may lie past the last vertex), and
+ * memory stays at one block of the file however large it is.
+ *
+ * @param filename Name of file to read.
+ * @param vertex   Function receiving each vertex.
+ * @param polygon  Function receiving each face of at least three corners.
+ * @param data     Data passed to vertex and polygon.
+ * @return True if the whole file was read.
+ */
+bool streamOBJ(const char *filename, VertexFunction vertex, PolygonFunction polygon, void *data);
+
+/**
+ * @brief Splits a polygon into corners - 2 triangles by clipping ears, keeping its winding, as loadOBJ splits
+ * faces. Polygons without a valid ear left (self-intersecting or degenerate) are finished as a fan.
+ *
+ * @param positions Position of each corner.
+ * @param face      Vertex index of each corner.
+ * @param corners   Number of corners (at least three).
+ * @param dest      Destination of the triangles' vertex indices (3 * (corners - 2) of them).
+ * @param points    Scratch space of corners projected points.
+ * @param remaining Scratch space of corners indices.
+ * @return One past the last index written.
+ */
+uint32_t *triangulatePolygon(const float (*positions)[3], const uint32_t *face, size_t corners, uint32_t *dest,
+                             float (*points)[2], uint32_t *remaining);
+
+/**
+ * @brief Writes mesh to .obj file (positions and faces).
+ *
+ * @param mesh     Mesh to write.
+ * @param filename Name of file to write.
+ * @return True if file was written.
+ */
+bool exportOBJ(const Mesh *mesh, const char *filename);
+
+/**
+ * @brief Builds vertex-face and vertex-vertex adjacency of mesh.
+ *
+ * @param mesh Mesh to build adjacency for.
  */
-void loadOBJ(const char *filename, Mesh *mesh);
+void buildAdjacency(Mesh *mesh);
 
 /**
  * @brief Initializes curvature of mesh.
@@ -0,0 +1,263 @@
+#ifndef _WIN32
+#define _GNU_SOURCE // sched_setaffinity, pthread_setaffinity_np, syscall
+#endif
+
+#include "numa.h"
+#include "geometry.h"
+#include "arena.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_PATH "/sys/devices/system/node/node%zu/cpulist" // processors of each node (Linux)
+#define PAGE_BATCH 4096                                      // pages looked up per system call
+
+/*
+ * Nodes
+ */
+
+size_t countNodes(void)
+{
+#ifdef _WIN32
+    ULONG highest;
+    return GetNumaHighestNodeNumber(&highest) ? (size_t)highest + 1 : 1;
+#elif defined(__linux__)
+    size_t count = 0;
+    char path[64];
+    while (true)
+    {
+        snprintf(path, sizeof(path), NODE_PATH, count);
+        FILE *file = fopen(path, "r");
+        if (!file)
+            break;
+        fclose(file);
+        count++;
+    }
+    return count ? count : 1;
+#else
+    return 1;
+#endif
+}
+
+#if defined(__linux__)
+// Processors of a node, from a list like "0-15,32-47"
+static bool nodeProcessors(size_t node, cpu_set_t *set)
+{
+    char path[64];
+    snprintf(path, sizeof(path), NODE_PATH, node);
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return false;
+
+    CPU_ZERO(set);
+    unsigned first, last;
+    while (fscanf(file, "%u", &first) == 1)
+    {
+        last = first;
+        if (fscanf(file, "-%u", &last) != 1)
+            last = first;
+        for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, set);
+        if (fgetc(file) != ',')
+            break;
+    }
+    fclose(file);
+    return CPU_COUNT(set) > 0;
+}
+#endif
+
+// Restricts a thread to the processors of a node
+static bool pinThread(pthread_t thread, size_t node)
+{
+    node %= countNodes();
+#ifdef _WIN32
+    ULONGLONG mask;
+    return GetNumaNodeProcessorMask((UCHAR)node, &mask) && mask &&
+           SetThreadAffinityMask(pthread_gethandle(thread), (DWORD_PTR)mask);
+#elif defined(__linux__)
+    cpu_set_t set;
+    return nodeProcessors(node, &set) && pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+#else
+    (void)thread;
+    (void)node;
+    return false;
+#endif
+}
+
+bool pinToNode(size_t node)
+{
+    return pinThread(pthread_self(), node);
+}
+
+/*
+ * Thread Pools
+ */
+
+size_t workerNode(const ThreadPool *pool, size_t worker)
+{
+    return worker * countNodes() / (pool->numThreads + 1);
+}
+
+bool pinThreadPool(ThreadPool *pool)
+{
+    bool pinned = true;
+    for (size_t i = 0; i < pool->numThreads; i++)
+        pinned &= pinThread(pool->workers[i].thread, workerNode(pool, i));
+    return pinToNode(workerNode(pool, pool->numThreads)) && pinned;
+}
+
+/*
+ * Placement
+ */
+
+// Old arrays of a mesh being placed, and the new arrays they are copied into
+typedef struct
+{
+    const Mesh *from;
+    Mesh *to;
+    size_t numChunks;
+} Placement;
+
+// Copies count elements of size bytes from offset on
+static void copyRange(void *dest, const void *source, size_t offset, size_t count, size_t size)
+{
+    memcpy((unsigned char *)dest + offset * size, (const unsigned char *)source + offset * size, count * size);
+}
+
+// Copies one chunk of vertices, their adjacency, and their share of faces (run on worker threads)
+static void placeChunk(void *data, size_t index)
+{
+    const Placement *placement = data;
+    const Mesh *from = placement->from;
+    Mesh *to = placement->to;
+    size_t begin = index * SWEEP_CHUNK, end = begin + SWEEP_CHUNK;
+    end = end < from->numVertices ? end : from->numVertices;
+    size_t last = index + 1 == placement->numChunks; // last chunk also takes the closing offsets
+
+    copyRange(to->vertices, from->vertices, begin, end - begin, sizeof(Vertex));
+    copyRange(to->areas, from->areas, begin, end - begin, sizeof(float));
+    if (from->precise)
+        copyRange(to->precise, from->precise, begin, end - begin, sizeof(*from->precise));
+    copyRange(to->faceOffsets, from->faceOffsets, begin, end - begin + last, sizeof(uint32_t));
+    copyRange(to->ringOffsets, from->ringOffsets, begin, end - begin + last, sizeof(uint32_t));
+    copyRange(to->faces, from->faces, from->faceOffsets[begin], from->faceOffsets[end] - from->faceOffsets[begin],
+              sizeof(uint32_t));
+    copyRange(to->ring, from->ring, from->ringOffsets[begin], from->ringOffsets[end] - from->ringOffsets[begin],
+              sizeof(uint32_t));
+
+    size_t numFaces = from->numIndices / 3;
+    size_t firstFace = numFaces * index / placement->numChunks, endFace = numFaces * (index + 1) / placement->numChunks;
+    copyRange(to->indices, from->indices, 3 * firstFace, 3 * (endFace - firstFace), sizeof(uint32_t));
+    copyRange(to->faceNormals, from->faceNormals, firstFace, endFace - firstFace, sizeof(vec3));
+}
+
+void placeMesh(Mesh *mesh, ThreadPool *pool)
+{
+    // Fresh arrays (large ones are mapped lazily, so nothing is placed until a worker writes it)
+    Mesh from = *mesh;
+    size_t numVertices = mesh->numVertices, numIndices = mesh->numIndices, numRing = mesh->ringOffsets[numVertices];
+    mesh->vertices = malloc((numVertices ? numVertices : 1) * sizeof(Vertex));
+    mesh->areas = malloc((numVertices ? numVertices : 1) * sizeof(float));
+    mesh->precise = from.precise ? malloc((numVertices ? numVertices : 1) * sizeof(*mesh->precise)) : NULL;
+    mesh->faceOffsets = malloc((numVertices + 1) * sizeof(uint32_t));
+    mesh->ringOffsets = malloc((numVertices + 1) * sizeof(uint32_t));
+    mesh->faces = malloc((numIndices ? numIndices : 1) * sizeof(uint32_t));
+    mesh->ring = malloc((numRing ? numRing : 1) * sizeof(uint32_t));
+    mesh->indices = malloc((numIndices ? numIndices : 1) * sizeof(uint32_t));
+    mesh->faceNormals = malloc((numIndices / 3 ? numIndices / 3 : 1) * sizeof(vec3));
+    adviseMesh(mesh); // before workers touch the new arrays, so pages are huge from the start
+
+    // Chunks must stay with the workers that place them, here and in every sweep after (a stolen chunk would be
+    // copied or swept from another node)
+    pool->keepRanges = true;
+    Placement placement = {&from, mesh, (numVertices + SWEEP_CHUNK - 1) / SWEEP_CHUNK};
+    runTasks(pool, placeChunk, &placement, placement.numChunks);
+
+    free(from.vertices);
+    free(from.areas);
+    free(from.precise);
+    free(from.faceOffsets);
+    free(from.ringOffsets);
+    free(from.faces);
+    free(from.ring);
+    free(from.indices);
+    free(from.faceNormals);
+}
+
+// Finds the node of each page (-1 where unknown), returning false if the system cannot say at all
+static bool pageNodes(void **pages, size_t count, int *nodes)
+{
+#ifdef _WIN32
+    for (size_t i = 0; i < count; i++)
+    {
+        PSAPI_WORKING_SET_EX_INFORMATION info = {pages[i]};
+        bool valid = QueryWorkingSetEx(GetCurrentProcess(), &info, sizeof(info)) && info.VirtualAttributes.Valid;
+        nodes[i] = valid ? (int)info.VirtualAttributes.Node : -1;
+    }
+    return true;
+#elif defined(__linux__) && defined(SYS_move_pages)
+    // move_pages without destinations only reports where pages are
+    return syscall(SYS_move_pages, 0, count, pages, NULL, nodes, 0) == 0;
+#else
+    (void)pages;
+    (void)count;
+    (void)nodes;
+    return false;
+#endif
+}
+
+NumaReport measurePlacement(const Mesh *mesh, const ThreadPool *pool)
+{
+#ifdef _WIN32
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    size_t page = system.dwPageSize;
+#else
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    NumaReport report = {0, 0, 0};
+    uintptr_t base = (uintptr_t)mesh->vertices, end = (uintptr_t)(mesh->vertices + mesh->numVertices);
+    size_t numChunks = (mesh->numVertices + SWEEP_CHUNK - 1) / SWEEP_CHUNK, numWorkers = pool->numThreads + 1;
+    void *pages[PAGE_BATCH];
+    int nodes[PAGE_BATCH];
+    for (uintptr_t address = base / page * page; address < end; address += (uintptr_t)PAGE_BATCH * page)
+    {
+        size_t count = 0;
+        for (; count < PAGE_BATCH && address + count * page < end; count++)
+            pages[count] = (void *)(address + count * page);
+        if (!pageNodes(pages, count, nodes))
+        {
+            report.unknownPages += count;
+            continue;
+        }
+
+        // Owner of a page: the worker runTasks deals the chunk of its first vertex to
+        for (size_t i = 0; i < count; i++)
+        {
+            uintptr_t first = (uintptr_t)pages[i] > base ? (uintptr_t)pages[i] : base;
+            size_t chunk = (first - base) / sizeof(Vertex) / SWEEP_CHUNK, worker = 0;
+            while (worker + 1 < numWorkers && numChunks * (worker + 1) / numWorkers <= chunk)
+                worker++;
+            if (nodes[i] < 0)
+                report.unknownPages++;
+            else if ((size_t)nodes[i] == workerNode(pool, worker))
+                report.localPages++;
+            else
+                report.remotePages++;
+        }
+    }
+    return report;
+}
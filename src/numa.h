@@ -0,0 +1,89 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include "model.h"
+#include "threadpool.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Where the pages of a mesh's per-vertex arrays lie, against the nodes of the threads that sweep them.
+ */
+typedef struct
+{
+    size_t localPages;   // pages on the node of the worker owning them
+    size_t remotePages;  // pages on another node
+    size_t unknownPages; // pages never touched, or whose node the system would not say
+} NumaReport;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Counts NUMA nodes with processors.
+ *
+ * @return Number of nodes (1 where the system does not say).
+ */
+size_t countNodes(void);
+
+/**
+ * @brief Restricts calling thread to the processors of a NUMA node, so memory it touches first is placed there.
+ *
+ * @param node Node to run on (taken modulo the number of nodes).
+ * @return True if thread was pinned.
+ */
+bool pinToNode(size_t node);
+
+/**
+ * @brief Node a worker of pool belongs to: workers are split into one contiguous block per node, like the
+ * contiguous ranges of tasks runTasks deals them, so neighboring tasks share a node.
+ *
+ * @param pool   Thread pool.
+ * @param worker Worker (the calling thread's slot is last).
+ * @return Node of worker.
+ */
+size_t workerNode(const ThreadPool *pool, size_t worker);
+
+/**
+ * @brief Pins every worker of pool, and the calling thread (whose slot is last), to its node (see workerNode).
+ *
+ * @param pool Thread pool to pin.
+ * @return True if every thread was pinned.
+ */
+bool pinThreadPool(ThreadPool *pool);
+
+/**
+ * @brief Moves the arrays of mesh into fresh memory first touched by the workers of pool that will sweep them.
+ *
+ * Arrays are copied in SWEEP_CHUNK vertex chunks on the pool, so runTasks deals each chunk to the same worker
+ * here as in a split curvature sweep: per-vertex arrays, and the adjacency and faces of each chunk's vertices
+ * (in proportion), land on that worker's node. The pool keeps ranges from then on, so idle workers no longer
+ * steal chunks from other nodes, and pinning the pool first keeps workers on their nodes afterwards.
+ * Nothing about the mesh changes but its addresses, so it must be placed before selections, hierarchies, or
+ * solver state are built on it (right after loading).
+ *
+ * @param mesh Mesh to place.
+ * @param pool Thread pool that will sweep mesh.
+ */
+void placeMesh(Mesh *mesh, ThreadPool *pool);
+
+/**
+ * @brief Finds the node of every page of mesh's vertices and checks it against the node of the worker that
+ * sweeps it (see workerNode).
+ *
+ * The worker sweeping a page is the one runTasks deals its chunk to, which holds while the pool keeps ranges
+ * (see placeMesh); a pool that steals may sweep any chunk anywhere.
+ *
+ * @param mesh Mesh to check.
+ * @param pool Thread pool that sweeps mesh.
+ * @return Local, remote, and unknown pages (all unknown where the system cannot say).
+ */
+NumaReport measurePlacement(const Mesh *mesh, const ThreadPool *pool);
+
+#endif
@@ -0,0 +1,151 @@
+#include "partition.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// State shared by every bisection of one partitioning
+typedef struct
+{
+    const Mesh *mesh;
+    uint32_t *part;    // part of every vertex (the first part of its region until the region is split)
+    uint8_t *side;     // side of every vertex in the current bisection
+    uint32_t *visited; // last search to reach every vertex
+    uint32_t search;   // current search
+    uint32_t *queue;   // breadth-first queue
+    uint32_t *scratch; // vertices of a region while splitting it into its two sides
+} Partitioner;
+
+// Searches region breadth-first from start, putting up to limit vertices on side 0 (ignoring the rest);
+// returns the last vertex taken
+static uint32_t growSide(Partitioner *partitioner, uint32_t start, size_t limit, size_t *grown)
+{
+    const Mesh *mesh = partitioner->mesh;
+    uint32_t region = partitioner->part[start], last = start;
+    size_t head = 0, tail = 0;
+    partitioner->visited[start] = partitioner->search;
+    partitioner->queue[tail++] = start;
+    while (head < tail && *grown < limit)
+    {
+        uint32_t v = last = partitioner->queue[head++];
+        partitioner->side[v] = 0;
+        ++*grown;
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+        {
+            uint32_t n = mesh->ring[i];
+            if (partitioner->part[n] == region && partitioner->visited[n] != partitioner->search)
+            {
+                partitioner->visited[n] = partitioner->search;
+                partitioner->queue[tail++] = n;
+            }
+        }
+    }
+    return last;
+}
+
+// Splits a region of count vertices into parts, numbered from the region's part up
+static void bisectRegion(Partitioner *partitioner, uint32_t *region, size_t count, size_t parts)
+{
+    if (parts < 2 || count < 2)
+        return;
+
+    const Mesh *mesh = partitioner->mesh;
+    uint32_t label = partitioner->part[region[0]];
+    size_t lowParts = parts / 2;
+    size_t sizes[2] = {0, count};
+    size_t target = count * lowParts / parts;
+    size_t limits[2] = {(size_t)((float)target * PARTITION_IMBALANCE) + 1,
+                        (size_t)((float)(count - target) * PARTITION_IMBALANCE) + 1};
+
+    // Pseudo-peripheral vertex: the last one reached from an arbitrary start (nothing is kept on side 0)
+    for (size_t i = 0; i < count; i++)
+        partitioner->side[region[i]] = 1;
+    partitioner->search++;
+    size_t reached = 0;
+    uint32_t start = growSide(partitioner, region[0], count, &reached);
+    for (size_t i = 0; i < count; i++)
+        partitioner->side[region[i]] = 1;
+
+    // Grow side 0 from there, seeding again in every component the search did not reach
+    partitioner->search++;
+    for (size_t i = 0; sizes[0] < target; i++)
+    {
+        uint32_t seed = i == 0 ? start : region[i - 1];
+        if (partitioner->visited[seed] != partitioner->search)
+            growSide(partitioner, seed, target, &sizes[0]);
+    }
+    sizes[1] = count - sizes[0];
+
+    // Move boundary vertices with more neighbors across than on their own side (each move shrinks the cut)
+    for (int pass = 0; pass < PARTITION_PASSES; pass++)
+    {
+        size_t moved = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint32_t v = region[i];
+            int gain = 0;
+            for (uint32_t j = mesh->ringOffsets[v]; j < mesh->ringOffsets[v + 1]; j++)
+            {
+                uint32_t n = mesh->ring[j];
+                if (partitioner->part[n] == label)
+                    gain += partitioner->side[n] != partitioner->side[v] ? 1 : -1;
+            }
+            uint8_t to = 1 - partitioner->side[v];
+            if (gain > 0 && sizes[to] + 1 <= limits[to])
+            {
+                partitioner->side[v] = to;
+                sizes[to]++;
+                sizes[1 - to]--;
+                moved++;
+            }
+        }
+        if (!moved)
+            break;
+    }
+
+    // Side 1 takes the upper parts, and each side is split on its own (keeping vertices in order)
+    size_t low = 0, high = sizes[0];
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t v = region[i];
+        if (partitioner->side[v])
+        {
+            partitioner->part[v] = label + (uint32_t)lowParts;
+            partitioner->scratch[high++] = v;
+        }
+        else
+            partitioner->scratch[low++] = v;
+    }
+    memcpy(region, partitioner->scratch, count * sizeof(uint32_t));
+    bisectRegion(partitioner, region, sizes[0], lowParts);
+    bisectRegion(partitioner, region + sizes[0], sizes[1], parts - lowParts);
+}
+
+uint32_t *partitionMesh(const Mesh *mesh, size_t parts)
+{
+    size_t numVertices = mesh->numVertices ? mesh->numVertices : 1;
+    Partitioner partitioner = {mesh, calloc(numVertices, sizeof(uint32_t)), malloc(numVertices),
+                               calloc(numVertices, sizeof(uint32_t)), 0, malloc(numVertices * sizeof(uint32_t)),
+                               malloc(numVertices * sizeof(uint32_t))};
+
+    uint32_t *region = malloc(numVertices * sizeof(uint32_t));
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        region[v] = (uint32_t)v;
+    bisectRegion(&partitioner, region, mesh->numVertices, parts);
+
+    free(region);
+    free(partitioner.side);
+    free(partitioner.visited);
+    free(partitioner.queue);
+    free(partitioner.scratch);
+    return partitioner.part;
+}
+
+size_t countCutEdges(const Mesh *mesh, const uint32_t *part)
+{
+    size_t count = 0;
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+            count += mesh->ring[i] > v && part[mesh->ring[i]] != part[v];
+    return count;
+}
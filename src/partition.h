@@ -0,0 +1,41 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "model.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Partitioning settings
+#define PARTITION_IMBALANCE 1.03f // largest part allowed relative to an even split
+#define PARTITION_PASSES 8        // boundary refinement passes after each bisection (fewer if nothing moves)
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Splits the vertices of mesh into parts of nearly equal size with few edges between them.
+ *
+ * Parts come from recursive bisection of the one-ring graph, as in METIS without its coarsening: each bisection
+ * grows one side breadth-first from a pseudo-peripheral vertex until it holds its share of vertices (seeding
+ * again in every component the search does not reach), then refines the boundary by moving vertices with more
+ * neighbors across it than on their own side, as long as no side grows past PARTITION_IMBALANCE. The result
+ * depends only on the mesh.
+ *
+ * @param mesh  Mesh to partition (with adjacency).
+ * @param parts Number of parts.
+ * @return Part of every vertex (caller frees).
+ */
+uint32_t *partitionMesh(const Mesh *mesh, size_t parts);
+
+/**
+ * @brief Counts edges of mesh whose endpoints lie in different parts.
+ *
+ * @param mesh Mesh that was partitioned.
+ * @param part Part of every vertex.
+ * @return Number of cut edges.
+ */
+size_t countCutEdges(const Mesh *mesh, const uint32_t *part);
+
+#endif
@@ -0,0 +1,575 @@
+#include "recording.h"
+#include "model.h"
+#include "scene.h"
+#include "bvh.h"
+
+#include <cglm/cglm.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RECORDING_MAGIC "GFRC"     // first bytes of every recording
+#define RECORDING_END "GFRE"       // last bytes of recordings with a seek table
+#define RECORDING_VERSION 1        // format version (files of other versions are rejected)
+#define FRAME_KEY 'K'              // frame of whole positions
+#define FRAME_DELTA 'D'            // frame of differences from the previous frame
+#define FRAME_TABLE 'T'            // seek table (after the last frame)
+#define FRAME_HEADER 25            // bytes before a frame's payload (type, step, time, payload size)
+
+/*
+ * Bit Streams
+ */
+
+// Writes bits least significant first into a buffer sized for the worst case up front
+typedef struct
+{
+    unsigned char *data;
+    size_t size;
+    uint64_t bits;
+    int count;
+} BitWriter;
+
+// Reads bits least significant first (past the end, it reads zeros and flags an overrun)
+typedef struct
+{
+    const unsigned char *data;
+    size_t size, position;
+    uint64_t bits;
+    int count;
+    bool overrun;
+} BitReader;
+
+static void putBits(BitWriter *writer, uint64_t value, int count)
+{
+    writer->bits |= value << writer->count;
+    writer->count += count;
+    while (writer->count >= 8)
+    {
+        writer->data[writer->size++] = (unsigned char)writer->bits;
+        writer->bits >>= 8;
+        writer->count -= 8;
+    }
+}
+
+static void flushBits(BitWriter *writer)
+{
+    if (writer->count > 0)
+        writer->data[writer->size++] = (unsigned char)writer->bits;
+    writer->bits = 0;
+    writer->count = 0;
+}
+
+static uint32_t getBits(BitReader *reader, int count)
+{
+    while (reader->count < count)
+    {
+        if (reader->position < reader->size)
+            reader->bits |= (uint64_t)reader->data[reader->position++] << reader->count;
+        else
+            reader->overrun = true;
+        reader->count += 8;
+    }
+    uint32_t value = (uint32_t)(reader->bits & ((1ull << count) - 1));
+    reader->bits >>= count;
+    reader->count -= count;
+    return value;
+}
+
+// Maps signed deltas to unsigned ones, small magnitudes first (0, -1, 1, -2, ...)
+static inline uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)((value >> 1) ^ (0u - (value & 1)));
+}
+
+// Rice code: quotient in unary, then k remainder bits (quotients of RICE_ESCAPE or more store the value raw)
+static void putRice(BitWriter *writer, uint32_t value, int k)
+{
+    uint32_t quotient = value >> k;
+    if (quotient < RICE_ESCAPE)
+    {
+        putBits(writer, (1ull << quotient) - 1, (int)quotient + 1);
+        putBits(writer, value & ((1ull << k) - 1), k);
+    }
+    else
+    {
+        putBits(writer, (1ull << RICE_ESCAPE) - 1, RICE_ESCAPE);
+        putBits(writer, value, 32);
+    }
+}
+
+static uint32_t getRice(BitReader *reader, int k)
+{
+    uint32_t quotient = 0;
+    while (quotient < RICE_ESCAPE && getBits(reader, 1))
+        quotient++;
+    if (quotient == RICE_ESCAPE)
+        return getBits(reader, 32);
+    return (quotient << k) | getBits(reader, k);
+}
+
+// Rice parameter close to the optimum for geometric data (log2 of the mean value)
+static int riceParameter(const uint32_t *values, size_t count)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++)
+        sum += values[i];
+    uint64_t mean = count ? sum / count : 0;
+
+    int k = 0;
+    while (k < 31 && (2ull << k) <= mean)
+        k++;
+    return k;
+}
+
+/*
+ * Recorder
+ */
+
+static bool writeBytes(Recorder *recorder, const void *data, size_t size)
+{
+    recorder->size += size;
+    return fwrite(data, 1, size, recorder->file) == size;
+}
+
+static bool writeCount(Recorder *recorder, size_t count)
+{
+    uint64_t value = count;
+    return writeBytes(recorder, &value, sizeof(value));
+}
+
+static int32_t quantize(float position, float quantum)
+{
+    float q = roundf(position / quantum);
+    return q >= 2147483520.0f ? INT32_MAX : q <= -2147483520.0f ? INT32_MIN : (int32_t)q;
+}
+
+Recorder *createRecorder(const char *filename, const Scene *scene)
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error creating recording: %s\n", filename);
+        return NULL;
+    }
+
+    Recorder *recorder = calloc(1, sizeof(Recorder));
+    recorder->file = file;
+    for (size_t i = 0; i < scene->numEntries; i++)
+        recorder->numVertices += scene->entries[i].model->mesh->numVertices;
+
+    // Grid from the extent of the first frame
+    vec3 low = {INFINITY, INFINITY, INFINITY}, high = {-INFINITY, -INFINITY, -INFINITY};
+    for (size_t i = 0; i < scene->numEntries; i++)
+    {
+        const Mesh *mesh = scene->entries[i].model->mesh;
+        for (size_t v = 0; v < mesh->numVertices; v++)
+        {
+            glm_vec3_minv(low, mesh->vertices[v].position, low);
+            glm_vec3_maxv(high, mesh->vertices[v].position, high);
+        }
+    }
+    float diagonal = recorder->numVertices ? glm_vec3_distance(low, high) : 0.0f;
+    recorder->quantum = diagonal > 0.0f ? diagonal * RECORD_QUANTUM : RECORD_QUANTUM;
+
+    size_t count = 3 * recorder->numVertices;
+    recorder->previous = calloc(count ? count : 1, sizeof(int32_t));
+    recorder->current = calloc(count ? count : 1, sizeof(int32_t));
+    recorder->deltas = malloc((recorder->numVertices ? recorder->numVertices : 1) * sizeof(uint32_t));
+    recorder->capacity = 8 * count + 16; // worst case: every value escaped
+    recorder->bytes = malloc(recorder->capacity);
+
+    // Header and faces
+    uint32_t version = RECORDING_VERSION, keyframes = RECORD_KEYFRAMES;
+    writeBytes(recorder, RECORDING_MAGIC, 4);
+    writeBytes(recorder, &version, sizeof(version));
+    writeBytes(recorder, &recorder->quantum, sizeof(recorder->quantum));
+    writeBytes(recorder, &keyframes, sizeof(keyframes));
+    writeCount(recorder, scene->numEntries);
+    for (size_t i = 0; i < scene->numEntries; i++)
+    {
+        writeCount(recorder, scene->entries[i].model->mesh->numVertices);
+        writeCount(recorder, scene->entries[i].model->mesh->numIndices);
+    }
+    for (size_t i = 0; i < scene->numEntries; i++)
+    {
+        const Mesh *mesh = scene->entries[i].model->mesh;
+        writeBytes(recorder, mesh->indices, mesh->numIndices * sizeof(uint32_t));
+    }
+
+    return recorder;
+}
+
+void recordFrame(Recorder *recorder, const Scene *scene)
+{
+    // Quantize positions of all models, and take the furthest flow along as the frame's step
+    uint64_t step = 0;
+    double time = 0.0;
+    int32_t *current = recorder->current;
+    for (size_t i = 0, j = 0; i < scene->numEntries; i++)
+    {
+        const SceneEntry *entry = &scene->entries[i];
+        const Mesh *mesh = entry->model->mesh;
+        for (size_t v = 0; v < mesh->numVertices; v++, j++)
+            for (int c = 0; c < 3; c++)
+                current[3 * j + c] = quantize(mesh->vertices[v].position[c], recorder->quantum);
+        step = entry->steps > step ? entry->steps : step;
+        time = entry->time > time ? entry->time : time;
+    }
+
+    // Keyframe (positions as they are) or deltas (one coordinate plane at a time, as planes vary alike)
+    size_t n = recorder->numVertices;
+    unsigned char type = recorder->numFrames % RECORD_KEYFRAMES ? FRAME_DELTA : FRAME_KEY;
+    size_t size;
+    if (type == FRAME_KEY)
+    {
+        size = 3 * n * sizeof(int32_t);
+        memcpy(recorder->bytes, current, size);
+    }
+    else
+    {
+        BitWriter writer = {recorder->bytes, 3, 0, 0};
+        for (int c = 0; c < 3; c++)
+        {
+            // Differences wrap around on overflow, and wrap back when decoded
+            uint32_t *deltas = recorder->deltas;
+            for (size_t v = 0; v < n; v++)
+                deltas[v] = zigzag((int32_t)((uint32_t)current[3 * v + c] - (uint32_t)recorder->previous[3 * v + c]));
+            int k = riceParameter(deltas, n);
+            recorder->bytes[c] = (unsigned char)k;
+            for (size_t v = 0; v < n; v++)
+                putRice(&writer, deltas[v], k);
+        }
+        flushBits(&writer);
+        size = writer.size;
+    }
+
+    // Frame (its offset goes to the seek table)
+    if (recorder->numFrames == recorder->frameCapacity)
+    {
+        recorder->frameCapacity = recorder->frameCapacity ? 2 * recorder->frameCapacity : 64;
+        recorder->offsets = realloc(recorder->offsets, recorder->frameCapacity * sizeof(uint64_t));
+        recorder->steps = realloc(recorder->steps, recorder->frameCapacity * sizeof(uint64_t));
+        recorder->times = realloc(recorder->times, recorder->frameCapacity * sizeof(double));
+    }
+    recorder->offsets[recorder->numFrames] = recorder->size;
+    recorder->steps[recorder->numFrames] = step;
+    recorder->times[recorder->numFrames] = time;
+    recorder->numFrames++;
+    recorder->rawBytes += 3 * n * sizeof(float);
+
+    writeBytes(recorder, &type, 1);
+    writeBytes(recorder, &step, sizeof(step));
+    writeBytes(recorder, &time, sizeof(time));
+    writeCount(recorder, size);
+    writeBytes(recorder, recorder->bytes, size);
+
+    // Current frame is the base of the next one
+    recorder->current = recorder->previous;
+    recorder->previous = current;
+}
+
+bool closeRecorder(Recorder *recorder)
+{
+    if (!recorder)
+        return true;
+
+    // Seek table, then its offset so players can find it from the end
+    uint64_t tableOffset = recorder->size;
+    unsigned char type = FRAME_TABLE;
+    writeBytes(recorder, &type, 1);
+    writeCount(recorder, recorder->numFrames);
+    writeBytes(recorder, recorder->offsets, recorder->numFrames * sizeof(uint64_t));
+    writeBytes(recorder, recorder->steps, recorder->numFrames * sizeof(uint64_t));
+    writeBytes(recorder, recorder->times, recorder->numFrames * sizeof(double));
+    writeBytes(recorder, &tableOffset, sizeof(tableOffset));
+    writeBytes(recorder, RECORDING_END, 4);
+
+    bool written = !ferror(recorder->file);
+    written &= !fclose(recorder->file);
+    if (written)
+        printf("Recorded %zu frames: %.2f MB (%.1f%% of float positions)\n", recorder->numFrames, recorder->size / 1048576.0,
+               recorder->rawBytes ? 100.0 * recorder->size / recorder->rawBytes : 0.0);
+    else
+        fprintf(stderr, "Error writing recording\n");
+
+    free(recorder->previous);
+    free(recorder->current);
+    free(recorder->deltas);
+    free(recorder->offsets);
+    free(recorder->steps);
+    free(recorder->times);
+    free(recorder->bytes);
+    free(recorder);
+    return written;
+}
+
+/*
+ * Player
+ */
+
+static bool readBytes(Player *player, void *dest, size_t size)
+{
+    return fread(dest, 1, size, player->file) == size;
+}
+
+static bool readCount(Player *player, size_t *count)
+{
+    uint64_t value;
+    if (!readBytes(player, &value, sizeof(value)) || value > SIZE_MAX)
+        return false;
+    *count = (size_t)value;
+    return true;
+}
+
+static void appendFrame(Player *player, uint64_t offset, uint64_t step, double time, size_t *capacity)
+{
+    if (player->numFrames == *capacity)
+    {
+        *capacity = *capacity ? 2 * *capacity : 64;
+        player->offsets = realloc(player->offsets, *capacity * sizeof(uint64_t));
+        player->steps = realloc(player->steps, *capacity * sizeof(uint64_t));
+        player->times = realloc(player->times, *capacity * sizeof(double));
+    }
+    player->offsets[player->numFrames] = offset;
+    player->steps[player->numFrames] = step;
+    player->times[player->numFrames] = time;
+    player->numFrames++;
+}
+
+// Reads seek table from end of file, or rebuilds it by walking frames if the recording was cut short
+static bool readSeekTable(Player *player, uint64_t firstFrame)
+{
+    size_t capacity = 0;
+    char end[4];
+    uint64_t tableOffset;
+    unsigned char type;
+    if (!fseek(player->file, -12, SEEK_END) && readBytes(player, &tableOffset, sizeof(tableOffset)) && readBytes(player, end, 4) &&
+        !memcmp(end, RECORDING_END, 4) && !fseek(player->file, (long)tableOffset, SEEK_SET) && readBytes(player, &type, 1) &&
+        type == FRAME_TABLE && readCount(player, &capacity))
+    {
+        player->offsets = malloc((capacity ? capacity : 1) * sizeof(uint64_t));
+        player->steps = malloc((capacity ? capacity : 1) * sizeof(uint64_t));
+        player->times = malloc((capacity ? capacity : 1) * sizeof(double));
+        player->numFrames = capacity;
+        return readBytes(player, player->offsets, capacity * sizeof(uint64_t)) &&
+               readBytes(player, player->steps, capacity * sizeof(uint64_t)) &&
+               readBytes(player, player->times, capacity * sizeof(double));
+    }
+
+    // Walk frame headers, keeping only frames whose payload is complete
+    uint64_t offset = firstFrame;
+    fseek(player->file, 0, SEEK_END);
+    uint64_t fileSize = (uint64_t)ftell(player->file);
+    fseek(player->file, (long)offset, SEEK_SET);
+    uint64_t step;
+    double time;
+    size_t size;
+    while (readBytes(player, &type, 1) && (type == FRAME_KEY || type == FRAME_DELTA) && readBytes(player, &step, sizeof(step)) &&
+           readBytes(player, &time, sizeof(time)) && readCount(player, &size) && offset + FRAME_HEADER + size <= fileSize)
+    {
+        appendFrame(player, offset, step, time, &capacity);
+        offset += FRAME_HEADER + size;
+        fseek(player->file, (long)offset, SEEK_SET);
+    }
+    return true;
+}
+
+Player *openPlayer(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Error opening recording: %s\n", filename);
+        return NULL;
+    }
+
+    Player *player = calloc(1, sizeof(Player));
+    player->file = file;
+
+    // Header and faces
+    char magic[4];
+    uint32_t version, keyframes;
+    bool valid = readBytes(player, magic, 4) && !memcmp(magic, RECORDING_MAGIC, 4) && readBytes(player, &version, sizeof(version)) &&
+                 version == RECORDING_VERSION && readBytes(player, &player->quantum, sizeof(player->quantum)) &&
+                 readBytes(player, &keyframes, sizeof(keyframes)) && keyframes &&
+                 readCount(player, &player->numModels) && player->numModels < (1u << 20);
+    player->keyframes = valid ? keyframes : 1;
+    if (valid)
+    {
+        player->numVertices = calloc(player->numModels + 1, sizeof(size_t));
+        player->numIndices = calloc(player->numModels + 1, sizeof(size_t));
+        player->indices = calloc(player->numModels + 1, sizeof(uint32_t *));
+    }
+    for (size_t i = 0; valid && i < player->numModels; i++)
+    {
+        valid = readCount(player, &player->numVertices[i]) && readCount(player, &player->numIndices[i]) &&
+                player->numIndices[i] % 3 == 0 && player->numVertices[i] <= UINT32_MAX && player->numIndices[i] <= UINT32_MAX;
+        player->totalVertices += valid ? player->numVertices[i] : 0;
+    }
+    uint64_t offset = 24 + 16 * (uint64_t)player->numModels;
+    for (size_t i = 0; valid && i < player->numModels; i++)
+    {
+        player->indices[i] = malloc((player->numIndices[i] ? player->numIndices[i] : 1) * sizeof(uint32_t));
+        valid = readBytes(player, player->indices[i], player->numIndices[i] * sizeof(uint32_t));
+        for (size_t j = 0; valid && j < player->numIndices[i]; j++)
+            valid = player->indices[i][j] < player->numVertices[i];
+        offset += player->numIndices[i] * sizeof(uint32_t);
+    }
+
+    valid = valid && readSeekTable(player, offset) && player->numFrames;
+    if (!valid)
+    {
+        fprintf(stderr, "Error reading recording: %s\n", filename);
+        closePlayer(player);
+        return NULL;
+    }
+
+    size_t count = 3 * player->totalVertices;
+    player->positions = calloc(count ? count : 1, sizeof(int32_t));
+    player->capacity = 8 * count + 16;
+    player->bytes = malloc(player->capacity);
+    player->frame = player->numFrames;
+    return player;
+}
+
+void closePlayer(Player *player)
+{
+    if (!player)
+        return;
+
+    for (size_t i = 0; player->indices && i < player->numModels; i++)
+        free(player->indices[i]);
+    free(player->numVertices);
+    free(player->numIndices);
+    free(player->indices);
+    free(player->positions);
+    free(player->offsets);
+    free(player->steps);
+    free(player->times);
+    free(player->bytes);
+    fclose(player->file);
+    free(player);
+}
+
+// Decodes one frame on top of the previous one (or from scratch for keyframes)
+static bool decodeFrame(Player *player, size_t frame)
+{
+    unsigned char type;
+    uint64_t step;
+    double time;
+    size_t size;
+    if (fseek(player->file, (long)player->offsets[frame], SEEK_SET) || !readBytes(player, &type, 1) ||
+        type != (frame % player->keyframes ? FRAME_DELTA : FRAME_KEY) || !readBytes(player, &step, sizeof(step)) ||
+        !readBytes(player, &time, sizeof(time)) || !readCount(player, &size) || size > player->capacity ||
+        !readBytes(player, player->bytes, size))
+        return false;
+
+    size_t n = player->totalVertices;
+    if (type == FRAME_KEY)
+    {
+        if (size != 3 * n * sizeof(int32_t))
+            return false;
+        memcpy(player->positions, player->bytes, size);
+        return true;
+    }
+
+    if (size < 3 || player->bytes[0] > 31 || player->bytes[1] > 31 || player->bytes[2] > 31)
+        return false;
+    BitReader reader = {player->bytes, size, 3, 0, 0, false};
+    for (int c = 0; c < 3; c++)
+        for (size_t v = 0; v < n; v++)
+        {
+            int32_t delta = unzigzag(getRice(&reader, player->bytes[c]));
+            player->positions[3 * v + c] = (int32_t)((uint32_t)player->positions[3 * v + c] + (uint32_t)delta);
+        }
+    return !reader.overrun;
+}
+
+bool seekPlayer(Player *player, size_t frame)
+{
+    if (frame >= player->numFrames)
+        return false;
+    if (frame == player->frame)
+        return true;
+
+    // Continue from current frame when no keyframe lies in between, otherwise restart from the keyframe
+    size_t keyframe = frame - frame % player->keyframes;
+    size_t start = player->frame < frame && player->frame >= keyframe ? player->frame + 1 : keyframe;
+    for (size_t f = start; f <= frame; f++)
+    {
+        if (!decodeFrame(player, f))
+        {
+            player->frame = player->numFrames;
+            return false;
+        }
+    }
+
+    player->frame = frame;
+    return true;
+}
+
+size_t findFrame(const Player *player, uint64_t step)
+{
+    size_t low = 0, high = player->numFrames;
+    while (high - low > 1)
+    {
+        size_t middle = (low + high) / 2;
+        if (player->steps[middle] <= step)
+            low = middle;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// First vertex of model in a frame
+static size_t firstVertex(const Player *player, size_t model)
+{
+    size_t first = 0;
+    for (size_t i = 0; i < model; i++)
+        first += player->numVertices[i];
+    return first;
+}
+
+static void copyPositions(const Player *player, size_t model, Mesh *mesh)
+{
+    const int32_t *positions = &player->positions[3 * firstVertex(player, model)];
+    for (size_t v = 0; v < mesh->numVertices; v++)
+        for (int c = 0; c < 3; c++)
+            mesh->vertices[v].position[c] = (float)positions[3 * v + c] * player->quantum;
+}
+
+Mesh *createPlayerMesh(const Player *player, size_t model)
+{
+    Mesh *mesh = calloc(1, sizeof(Mesh));
+    mesh->numVertices = player->numVertices[model];
+    mesh->numIndices = player->numIndices[model];
+    mesh->vertices = malloc((mesh->numVertices ? mesh->numVertices : 1) * sizeof(Vertex));
+    mesh->indices = malloc((mesh->numIndices ? mesh->numIndices : 1) * sizeof(uint32_t));
+    memcpy(mesh->indices, player->indices[model], mesh->numIndices * sizeof(uint32_t));
+    copyPositions(player, model, mesh);
+
+    buildAdjacency(mesh);
+    mesh->areas = malloc((mesh->numVertices ? mesh->numVertices : 1) * sizeof(float));
+    mesh->faceNormals = malloc((mesh->numIndices ? mesh->numIndices / 3 : 1) * sizeof(vec3));
+    initCurvature(mesh);
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+    return mesh;
+}
+
+void applyFrame(const Player *player, size_t model, Mesh *mesh)
+{
+    copyPositions(player, model, mesh);
+    initCurvature(mesh);
+    if (mesh->bvh)
+        refitBVH(mesh->bvh, mesh);
+    mesh->dirtyBegin = 0;
+    mesh->dirtyEnd = mesh->numVertices;
+}
@@ -0,0 +1,155 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include "model.h"
+#include "scene.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Recording settings
+#define RECORD_QUANTUM 1e-5f  // position quantum relative to the bounding box diagonal of the first frame
+#define RECORD_KEYFRAMES 32   // frames between keyframes (bounds the decoding work of a seek)
+#define RICE_ESCAPE 24        // unary length after which a delta is stored raw
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Streaming writer of a flow animation: every frame holds the positions of all models of a scene.
+ *
+ * Positions are quantized to a fixed grid. Every RECORD_KEYFRAMES-th frame is a keyframe storing them
+ * whole; the frames between store each coordinate's difference from the previous frame, zigzag mapped
+ * and Rice coded with a parameter fitted per frame and axis. Deltas are exact on the grid, so errors
+ * never accumulate along a run of deltas. Frames are appended as they come, and a seek table is added
+ * when the recorder is closed (files cut short are still playable, just slower to open).
+ */
+typedef struct
+{
+    FILE *file;            // container being written
+    size_t numVertices;    // vertices per frame (all models)
+    float quantum;         // grid spacing of positions
+    int32_t *previous;     // quantized positions of last frame
+    int32_t *current;      // quantized positions of frame being written
+    uint32_t *deltas;      // zigzag deltas of one coordinate of every vertex (staging)
+    uint64_t *offsets;     // file offset of each frame
+    uint64_t *steps;       // flow step of each frame
+    double *times;         // flow time of each frame
+    size_t numFrames;      // frames written
+    size_t frameCapacity;  // allocated frame entries
+    unsigned char *bytes;  // encoded frame (staging)
+    size_t capacity;       // allocated bytes
+    size_t rawBytes;       // size frames would take as float positions
+    uint64_t size;         // bytes written so far
+} Recorder;
+
+/**
+ * @brief Reader of a recording that can seek to any frame.
+ *
+ * Seeking decodes forward from the nearest keyframe at or before the frame (or from the current frame
+ * if that is closer), so playing frames in order decodes one delta per frame.
+ */
+typedef struct
+{
+    FILE *file;           // container being read
+    size_t numModels;     // models in recording
+    size_t *numVertices;  // vertices of each model
+    size_t *numIndices;   // indices of each model
+    uint32_t **indices;   // faces of each model
+    size_t totalVertices; // vertices per frame (all models)
+    float quantum;        // grid spacing of positions
+    size_t keyframes;     // frames between keyframes
+    int32_t *positions;   // quantized positions of current frame
+    uint64_t *offsets;    // file offset of each frame
+    uint64_t *steps;      // flow step of each frame
+    double *times;        // flow time of each frame
+    size_t numFrames;     // frames in recording
+    size_t frame;         // current frame (numFrames before the first seek)
+    unsigned char *bytes; // encoded frame (staging)
+    size_t capacity;      // allocated bytes
+} Player;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Starts recording a scene's models (their faces are written once, up front).
+ *
+ * @param filename Recording to write.
+ * @param scene    Scene to record (its models must not change while recording).
+ * @return Recorder, or NULL if the file cannot be created.
+ */
+Recorder *createRecorder(const char *filename, const Scene *scene);
+
+/**
+ * @brief Appends current positions of scene's models as a frame.
+ *
+ * @param recorder Recorder to write with.
+ * @param scene    Scene recorder was created for.
+ */
+void recordFrame(Recorder *recorder, const Scene *scene);
+
+/**
+ * @brief Writes seek table, closes file, reports its size, and frees space.
+ *
+ * @param recorder Recorder to close (may be NULL).
+ * @return True if everything was written.
+ */
+bool closeRecorder(Recorder *recorder);
+
+/**
+ * @brief Opens a recording for playback.
+ *
+ * @param filename Recording to read.
+ * @return Player (not at any frame yet), or NULL if the file is not a readable recording.
+ */
+Player *openPlayer(const char *filename);
+
+/**
+ * @brief Closes recording and frees space.
+ *
+ * @param player Player to close (may be NULL).
+ */
+void closePlayer(Player *player);
+
+/**
+ * @brief Decodes a frame.
+ *
+ * @param player Player to seek.
+ * @param frame  Frame to decode (less than numFrames).
+ * @return True if frame was decoded.
+ */
+bool seekPlayer(Player *player, size_t frame);
+
+/**
+ * @brief Finds last frame at or before a flow step.
+ *
+ * @param player Player to search.
+ * @param step   Flow step.
+ * @return Index of frame (0 if every frame comes later).
+ */
+size_t findFrame(const Player *player, uint64_t step);
+
+/**
+ * @brief Creates mesh of one of the recording's models at the current frame.
+ *
+ * @param player Player at a frame.
+ * @param model  Index of model.
+ * @return Initialized mesh.
+ */
+Mesh *createPlayerMesh(const Player *player, size_t model);
+
+/**
+ * @brief Copies model's positions at current frame into its mesh, updating curvature and marking every vertex dirty.
+ *
+ * @param player Player at a frame.
+ * @param model  Index of model.
+ * @param mesh   Mesh created for model.
+ */
+void applyFrame(const Player *player, size_t model, Mesh *mesh);
+
+#endif
@@ -0,0 +1,377 @@
+#include "render.h"
+#include "collision.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define BACKGROUND 0  // palette index of background
+#define HIGHLIGHT 1   // palette index of highlighted faces
+#define LINE_WIDTH 0.5f // half width of wireframe lines (pixels)
+
+Renderer *createRenderer(size_t width, size_t height)
+{
+    Renderer *renderer = calloc(1, sizeof(Renderer));
+    renderer->width = width;
+    renderer->height = height;
+    renderer->tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    renderer->tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    renderer->pixels = malloc(width * height);
+    renderer->depth = malloc(width * height * sizeof(float));
+    renderer->binOffsets = malloc((renderer->tilesX * renderer->tilesY + 1) * sizeof(uint32_t));
+    renderer->heatMap = MEAN_CURVATURE;
+
+    // Background and highlight of the viewer, then its blue to red heat map as a ramp
+    memcpy(renderer->palette[BACKGROUND], (uint8_t[3]){43, 41, 43}, 3);
+    memcpy(renderer->palette[HIGHLIGHT], (uint8_t[3]){255, 255, 0}, 3);
+    for (int i = RENDER_RAMP; i < 256; i++)
+    {
+        float t = (float)(i - RENDER_RAMP) / (255 - RENDER_RAMP);
+        renderer->palette[i][0] = (uint8_t)lroundf(255.0f * t);
+        renderer->palette[i][1] = 0;
+        renderer->palette[i][2] = (uint8_t)lroundf(255.0f * (1.0f - t));
+    }
+
+    return renderer;
+}
+
+void destroyRenderer(Renderer *renderer)
+{
+    if (!renderer)
+        return;
+
+    free(renderer->pixels);
+    free(renderer->depth);
+    free(renderer->clip);
+    free(renderer->triangles);
+    free(renderer->binOffsets);
+    free(renderer->bins);
+    free(renderer);
+}
+
+/*
+ * Setup
+ */
+
+// Sets up triangle of clip space vertices (false if it is degenerate, off screen, or reaches behind the near plane)
+static bool setupTriangle(const Renderer *renderer, const Mesh *mesh, const uint32_t *face, ScreenTriangle *triangle)
+{
+    float x[3], y[3];
+    for (int k = 0; k < 3; k++)
+    {
+        const float *clip = renderer->clip[face[k]];
+        if (!(clip[3] > 0.0f))
+            return false;
+
+        // Viewport transform (rows top first, depth range [0, 1] like the viewer's)
+        float w = 1.0f / clip[3];
+        x[k] = (clip[0] * w * 0.5f + 0.5f) * (float)renderer->width;
+        y[k] = (0.5f - clip[1] * w * 0.5f) * (float)renderer->height;
+        triangle->z[k] = clip[2] * w * 0.5f + 0.5f;
+        triangle->w[k] = w;
+        glm_vec3_scale(mesh->vertices[face[k]].curvature, w, triangle->curvature[k]);
+        triangle->gaussian[k] = mesh->vertices[face[k]].gaussian * w;
+    }
+
+    // Edge functions, flipped so the inside is positive whatever the winding
+    for (int k = 0; k < 3; k++)
+    {
+        int i = (k + 1) % 3, j = (k + 2) % 3;
+        triangle->a[k] = y[i] - y[j];
+        triangle->b[k] = x[j] - x[i];
+        triangle->c[k] = x[i] * y[j] - x[j] * y[i];
+    }
+    float area = triangle->a[0] * x[0] + triangle->b[0] * y[0] + triangle->c[0];
+    if (!(fabsf(area) > 0.0f))
+        return false;
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        triangle->a[k] *= sign;
+        triangle->b[k] *= sign;
+        triangle->c[k] = sign * triangle->c[k] + 0.5f * (triangle->a[k] + triangle->b[k]); // sample pixel centers
+        triangle->inverseLength[k] = 1.0f / sqrtf(triangle->a[k] * triangle->a[k] + triangle->b[k] * triangle->b[k]);
+    }
+    triangle->inverseArea = 1.0f / fabsf(area);
+
+    // Pixels the triangle (widened by wireframe lines) may touch, clamped to the image before rounding
+    float minX = fminf(fminf(x[0], x[1]), x[2]) - 1.0f, maxX = fmaxf(fmaxf(x[0], x[1]), x[2]) + 1.0f;
+    float minY = fminf(fminf(y[0], y[1]), y[2]) - 1.0f, maxY = fmaxf(fmaxf(y[0], y[1]), y[2]) + 1.0f;
+    float lastX = (float)renderer->width - 1.0f, lastY = (float)renderer->height - 1.0f;
+    if (maxX < 0.0f || maxY < 0.0f || minX > lastX || minY > lastY)
+        return false;
+    triangle->bounds[0] = (int32_t)fmaxf(minX, 0.0f);
+    triangle->bounds[1] = (int32_t)fmaxf(minY, 0.0f);
+    triangle->bounds[2] = (int32_t)fminf(maxX, lastX);
+    triangle->bounds[3] = (int32_t)fminf(maxY, lastY);
+    return true;
+}
+
+// Sets up every triangle of the scene in draw order
+static void setupScene(Renderer *renderer, const Scene *scene, mat4 view, mat4 projection)
+{
+    size_t numFaces = 0;
+    for (size_t i = 0; i < scene->numEntries; i++)
+        numFaces += scene->entries[i].model->mesh->numIndices / 3;
+    if (numFaces > renderer->triangleCapacity)
+    {
+        renderer->triangleCapacity = numFaces;
+        renderer->triangles = realloc(renderer->triangles, numFaces * sizeof(ScreenTriangle));
+    }
+
+    mat4 viewProjection;
+    glm_mat4_mul(projection, view, viewProjection);
+    renderer->numTriangles = 0;
+    for (size_t i = 0; i < scene->numEntries; i++)
+    {
+        Model *model = scene->entries[i].model;
+        const Mesh *mesh = model->mesh;
+        if (mesh->numVertices > renderer->clipCapacity)
+        {
+            renderer->clipCapacity = mesh->numVertices;
+            renderer->clip = realloc(renderer->clip, mesh->numVertices * sizeof(vec4));
+        }
+
+        // Each vertex is transformed once, however many faces share it
+        mat4 modelMatrix, mvp;
+        computeModelMatrix(model, &modelMatrix);
+        glm_mat4_mul(viewProjection, modelMatrix, mvp);
+        for (size_t j = 0; j < mesh->numVertices; j++)
+        {
+            vec4 position;
+            glm_vec4(mesh->vertices[j].position, 1.0f, position);
+            glm_mat4_mulv(mvp, position, renderer->clip[j]);
+        }
+
+        const SpatialHash *hash = mesh->spatialHash;
+        for (size_t f = 0; f < mesh->numIndices / 3; f++)
+        {
+            ScreenTriangle *triangle = &renderer->triangles[renderer->numTriangles];
+            if (!setupTriangle(renderer, mesh, &mesh->indices[3 * f], triangle))
+                continue;
+            triangle->highlight = hash && hash->numCollisions && hash->colliding[f];
+            renderer->numTriangles++;
+        }
+    }
+}
+
+// Lists triangles overlapping each tile, keeping draw order within every tile
+static void binTriangles(Renderer *renderer)
+{
+    size_t numTiles = renderer->tilesX * renderer->tilesY;
+    uint32_t *offsets = renderer->binOffsets;
+    memset(offsets, 0, (numTiles + 1) * sizeof(uint32_t));
+    for (size_t i = 0; i < renderer->numTriangles; i++)
+    {
+        const int32_t *bounds = renderer->triangles[i].bounds;
+        for (int32_t ty = bounds[1] / TILE_SIZE; ty <= bounds[3] / TILE_SIZE; ty++)
+            for (int32_t tx = bounds[0] / TILE_SIZE; tx <= bounds[2] / TILE_SIZE; tx++)
+                offsets[ty * renderer->tilesX + tx + 1]++;
+    }
+    for (size_t t = 0; t < numTiles; t++)
+        offsets[t + 1] += offsets[t];
+
+    if (offsets[numTiles] > renderer->binCapacity)
+    {
+        renderer->binCapacity = offsets[numTiles];
+        renderer->bins = realloc(renderer->bins, renderer->binCapacity * sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < renderer->numTriangles; i++)
+    {
+        const int32_t *bounds = renderer->triangles[i].bounds;
+        for (int32_t ty = bounds[1] / TILE_SIZE; ty <= bounds[3] / TILE_SIZE; ty++)
+            for (int32_t tx = bounds[0] / TILE_SIZE; tx <= bounds[2] / TILE_SIZE; tx++)
+                renderer->bins[offsets[ty * renderer->tilesX + tx]++] = (uint32_t)i;
+    }
+
+    // Filling advanced every offset to the end of its bin; shift them back
+    memmove(offsets + 1, offsets, numTiles * sizeof(uint32_t));
+    offsets[0] = 0;
+}
+
+/*
+ * Rasterization
+ */
+
+// Colors a covered pixel from its edge function values
+static uint8_t shadePixel(const Renderer *renderer, const ScreenTriangle *triangle, const float edges[3])
+{
+    // Perspective-correct interpolation: attributes and 1 / w are linear in screen space
+    float weights[3], w = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        weights[k] = edges[k] * triangle->inverseArea;
+        w += weights[k] * triangle->w[k];
+    }
+
+    float t;
+    if (renderer->heatMap == GAUSSIAN_CURVATURE)
+    {
+        float gaussian = 0.0f;
+        for (int k = 0; k < 3; k++)
+            gaussian += weights[k] * triangle->gaussian[k];
+        t = 0.5f + atanf(gaussian / w) / GLM_PIf;
+    }
+    else
+    {
+        vec3 curvature = GLM_VEC3_ZERO_INIT;
+        for (int k = 0; k < 3; k++)
+            for (int d = 0; d < 3; d++)
+                curvature[d] += weights[k] * triangle->curvature[k][d];
+        t = glm_vec3_norm(curvature) / w;
+    }
+
+    // Colors past either end of the ramp saturate, as they do in the framebuffer
+    t = t > 0.0f ? (t < 1.0f ? t : 1.0f) : 0.0f;
+    return (uint8_t)(RENDER_RAMP + (int)(t * (255 - RENDER_RAMP) + 0.5f));
+}
+
+// Draws a triangle's wireframe (or fills it in the highlight color) into a tile's buffers
+static void drawTriangle(const Renderer *renderer, const ScreenTriangle *triangle, bool fill, int32_t originX, int32_t originY,
+                         uint8_t *pixels, float *depth)
+{
+    const float *a = triangle->a, *b = triangle->b, *c = triangle->c, *z = triangle->z;
+    int32_t x0 = (triangle->bounds[0] > originX ? triangle->bounds[0] : originX) - originX;
+    int32_t y0 = (triangle->bounds[1] > originY ? triangle->bounds[1] : originY) - originY;
+    int32_t x1 = (triangle->bounds[2] < originX + TILE_SIZE - 1 ? triangle->bounds[2] : originX + TILE_SIZE - 1) - originX;
+    int32_t y1 = (triangle->bounds[3] < originY + TILE_SIZE - 1 ? triangle->bounds[3] : originY + TILE_SIZE - 1) - originY;
+
+    // Depth is interpolated like any other linear attribute
+    float zA = 0.0f, zB = 0.0f, zC = 0.0f;
+    for (int k = 0; k < 3; k++)
+    {
+        float scale = z[k] * triangle->inverseArea;
+        zA += a[k] * scale;
+        zB += b[k] * scale;
+        zC += c[k] * scale;
+    }
+
+    for (int32_t y = y0; y <= y1; y++)
+    {
+        float py = (float)(originY + y);
+        float rows[3] = {b[0] * py + c[0], b[1] * py + c[1], b[2] * py + c[2]};
+        float zRow = zB * py + zC;
+        uint8_t *pixelRow = &pixels[y * TILE_SIZE];
+        float *depthRow = &depth[y * TILE_SIZE];
+
+#ifdef __SSE2__
+        // Four pixels at a time (tiles are a multiple of four wide, so groups stay inside the tile)
+        const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const __m128 lineWidth = _mm_set1_ps(LINE_WIDTH), negativeLineWidth = _mm_set1_ps(-LINE_WIDTH), zero = _mm_setzero_ps();
+        const __m128 first = _mm_set1_ps((float)x0), last = _mm_set1_ps((float)x1);
+        for (int32_t x = x0 & ~3; x <= x1; x += 4)
+        {
+            __m128 local = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+            __m128 px = _mm_add_ps(local, _mm_set1_ps((float)originX));
+            __m128 edges[3], mask = _mm_and_ps(_mm_cmpge_ps(local, first), _mm_cmple_ps(local, last));
+            for (int k = 0; k < 3; k++)
+                edges[k] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[k]), px), _mm_set1_ps(rows[k]));
+            if (fill)
+            {
+                for (int k = 0; k < 3; k++)
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(edges[k], zero));
+            }
+            else
+            {
+                // Within half a line of an edge, and not beyond any other edge by more than that
+                __m128 nearest = _mm_set1_ps(INFINITY);
+                for (int k = 0; k < 3; k++)
+                {
+                    __m128 distance = _mm_mul_ps(edges[k], _mm_set1_ps(triangle->inverseLength[k]));
+                    mask = _mm_and_ps(mask, _mm_cmpge_ps(distance, negativeLineWidth));
+                    nearest = _mm_min_ps(nearest, distance);
+                }
+                mask = _mm_and_ps(mask, _mm_cmple_ps(nearest, lineWidth));
+            }
+            if (!_mm_movemask_ps(mask))
+                continue;
+
+            // Depth test (less, within the depth range)
+            __m128 depths = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(zA), px), _mm_set1_ps(zRow));
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(depths, zero));
+            mask = _mm_and_ps(mask, _mm_cmplt_ps(depths, _mm_loadu_ps(&depthRow[x])));
+            int covered = _mm_movemask_ps(mask);
+            if (!covered)
+                continue;
+
+            float values[3][4], zs[4];
+            for (int k = 0; k < 3; k++)
+                _mm_storeu_ps(values[k], edges[k]);
+            _mm_storeu_ps(zs, depths);
+            for (int l = 0; l < 4; l++)
+                if (covered & (1 << l))
+                {
+                    float pixelEdges[3] = {values[0][l], values[1][l], values[2][l]};
+                    depthRow[x + l] = zs[l];
+                    pixelRow[x + l] = fill ? HIGHLIGHT : shadePixel(renderer, triangle, pixelEdges);
+                }
+        }
+#else
+        for (int32_t x = x0; x <= x1; x++)
+        {
+            float px = (float)(originX + x), edges[3], nearest = INFINITY;
+            bool inside = true;
+            for (int k = 0; k < 3; k++)
+            {
+                edges[k] = a[k] * px + rows[k];
+                float distance = edges[k] * triangle->inverseLength[k];
+                inside &= fill ? edges[k] >= 0.0f : distance >= -LINE_WIDTH;
+                nearest = fminf(nearest, distance);
+            }
+            if (!inside || (!fill && nearest > LINE_WIDTH))
+                continue;
+
+            float pixelDepth = zA * px + zRow;
+            if (pixelDepth < 0.0f || !(pixelDepth < depthRow[x]))
+                continue;
+            depthRow[x] = pixelDepth;
+            pixelRow[x] = fill ? HIGHLIGHT : shadePixel(renderer, triangle, edges);
+        }
+#endif
+    }
+}
+
+// Renders one tile: wireframe of every triangle overlapping it, then highlighted faces on top (like the viewer)
+static void renderTile(void *data, size_t index)
+{
+    Renderer *renderer = data;
+    int32_t originX = (int32_t)(index % renderer->tilesX) * TILE_SIZE;
+    int32_t originY = (int32_t)(index / renderer->tilesX) * TILE_SIZE;
+
+    uint8_t pixels[TILE_SIZE * TILE_SIZE];
+    float depth[TILE_SIZE * TILE_SIZE];
+    memset(pixels, BACKGROUND, sizeof(pixels));
+    for (size_t i = 0; i < TILE_SIZE * TILE_SIZE; i++)
+        depth[i] = 1.0f;
+
+    const uint32_t *bin = &renderer->bins[renderer->binOffsets[index]];
+    size_t binSize = renderer->binOffsets[index + 1] - renderer->binOffsets[index];
+    for (int pass = 0; pass < 2; pass++)
+        for (size_t i = 0; i < binSize; i++)
+        {
+            const ScreenTriangle *triangle = &renderer->triangles[bin[i]];
+            if (!pass || triangle->highlight)
+                drawTriangle(renderer, triangle, pass, originX, originY, pixels, depth);
+        }
+
+    // Copy the part of the tile inside the image
+    size_t width = renderer->width - originX < TILE_SIZE ? renderer->width - originX : TILE_SIZE;
+    size_t height = renderer->height - originY < TILE_SIZE ? renderer->height - originY : TILE_SIZE;
+    for (size_t y = 0; y < height; y++)
+    {
+        size_t offset = (originY + y) * renderer->width + originX;
+        memcpy(&renderer->pixels[offset], &pixels[y * TILE_SIZE], width);
+        memcpy(&renderer->depth[offset], &depth[y * TILE_SIZE], width * sizeof(float));
+    }
+}
+
+void renderScene(Renderer *renderer, const Scene *scene, mat4 view, mat4 projection)
+{
+    setupScene(renderer, scene, view, projection);
+    binTriangles(renderer);
+    runTasks(scene->pool, renderTile, renderer, renderer->tilesX * renderer->tilesY);
+}
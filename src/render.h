@@ -0,0 +1,100 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "scene.h"
+#include "geometry.h"
+
+#include <cglm/cglm.h>
+
+#include <stdint.h>
+
+// Rendering settings
+#define TILE_SIZE 32          // edge length of the square tiles rendered as one task (pixels)
+#define RENDER_WIDTH 800      // headless frame width
+#define RENDER_HEIGHT 600     // headless frame height
+#define RENDER_FPS 25         // frame rate of rendered animations (camera time advances 1 / RENDER_FPS per frame)
+#define RENDER_RAMP 2         // first palette index of the heat map ramp (after background and highlight)
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Triangle in screen space, set up for edge function rasterization.
+ *
+ * Edge function k is positive on the inner side of the edge opposite vertex k and zero on it; scaled by
+ * the reciprocal of twice the area it becomes vertex k's barycentric coordinate, and scaled by the
+ * reciprocal of the edge's length it becomes the distance to the edge in pixels.
+ */
+typedef struct
+{
+    float a[3], b[3], c[3];  // edge function k is a[k] x + b[k] y + c[k] at pixel center (x, y)
+    float inverseLength[3];  // reciprocal of each edge's length
+    float inverseArea;       // reciprocal of twice the triangle's area
+    float z[3];              // depth of each vertex (0 near to 1 far)
+    float w[3];              // reciprocal clip w of each vertex (for perspective-correct attributes)
+    vec3 curvature[3];       // curvature of each vertex, divided by its clip w
+    float gaussian[3];       // Gaussian curvature of each vertex, divided by its clip w
+    int32_t bounds[4];       // pixel bounds (min x, min y, max x, max y, inclusive)
+    bool highlight;          // whether triangle is also filled in the highlight color (over the wireframe)
+} ScreenTriangle;
+
+/**
+ * @brief Software renderer reproducing the viewer's look (wireframe colored by a curvature heat map,
+ * self-intersecting faces filled in yellow) without a GPU.
+ *
+ * Triangles are transformed and binned into tiles, then tiles are rasterized in parallel on the scene's
+ * thread pool, four pixels at a time with SIMD edge functions. Each tile walks its triangles in draw
+ * order with a depth test, so images don't depend on the number of threads. Pixels are palette indices:
+ * background, highlight, and a ramp of heat map colors, which is exactly what GIF frames store.
+ */
+typedef struct
+{
+    size_t width, height;         // image size
+    size_t tilesX, tilesY;        // tiles across and down
+    uint8_t *pixels;              // palette index of each pixel (rows top first)
+    float *depth;                 // depth of each pixel
+    uint8_t palette[256][3];      // RGB color of each index
+    HEAT_MAP heatMap;             // quantity shown by heat map
+    vec4 *clip;                   // clip space position of each vertex of the model being set up (staging)
+    size_t clipCapacity;          // allocated clip positions
+    ScreenTriangle *triangles;    // triangles of current frame, in draw order
+    size_t numTriangles;          // number of triangles
+    size_t triangleCapacity;      // allocated triangles
+    uint32_t *binOffsets, *bins;  // triangles overlapping each tile (CSR, indexed by tile)
+    size_t binCapacity;           // allocated bin entries
+} Renderer;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates renderer with the viewer's background and heat map colors.
+ *
+ * @param width  Image width.
+ * @param height Image height.
+ * @return Initialized renderer.
+ */
+Renderer *createRenderer(size_t width, size_t height);
+
+/**
+ * @brief Destroys renderer and frees space.
+ *
+ * @param renderer Renderer to destroy (may be NULL).
+ */
+void destroyRenderer(Renderer *renderer);
+
+/**
+ * @brief Renders every model of a scene into the renderer's pixels.
+ *
+ * Triangles reaching behind the near plane are skipped rather than clipped.
+ *
+ * @param renderer   Renderer to draw with.
+ * @param scene      Scene to draw (its thread pool rasterizes tiles).
+ * @param view       View matrix.
+ * @param projection Projection matrix.
+ */
+void renderScene(Renderer *renderer, const Scene *scene, mat4 view, mat4 projection);
+
+#endif
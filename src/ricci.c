@@ -0,0 +1,664 @@
+#include "ricci.h"
+#include "sparse.h"
+#include "model.h"
+
+#include <cglm/cglm.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#define NO_FACE UINT32_MAX // missing neighbor across an edge
+
+/*
+ * Helpers
+ */
+
+// Index of edge between two adjacent vertices (edges are numbered by lower vertex, then by upper vertex)
+static uint32_t findEdge(const Mesh *mesh, const uint32_t *edgeStarts, uint32_t a, uint32_t b)
+{
+    uint32_t lo = a < b ? a : b, hi = a < b ? b : a;
+
+    // Upper neighbors of lo are the tail of its sorted ring
+    uint32_t first = mesh->ringOffsets[lo], last = mesh->ringOffsets[lo + 1];
+    uint32_t begin = first, end = last;
+    while (begin < end)
+    {
+        uint32_t mid = (begin + end) / 2;
+        if (mesh->ring[mid] <= lo)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+    uint32_t tail = begin;
+    end = last;
+    while (begin < end)
+    {
+        uint32_t mid = (begin + end) / 2;
+        if (mesh->ring[mid] < hi)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+    return edgeStarts[lo] + (begin - tail);
+}
+
+static double cross2(const double *a, const double *b)
+{
+    return a[0] * b[1] - a[1] * b[0];
+}
+
+// Angle between sides a and b of a triangle with third side c
+static double cornerAngle(double a, double b, double c)
+{
+    return acos(fmin(fmax((a * a + b * b - c * c) / (2.0 * a * b), -1.0), 1.0));
+}
+
+// Direction in the plane of edge k of face f, given that of edge 0 (turning clockwise if the face is mirrored)
+static double edgeDirection(const Ricci *ricci, uint32_t f, double heading, int k)
+{
+    const double *lengths = ricci->lengths;
+    const uint32_t *edges = &ricci->faceEdges[3 * f];
+    double turn = ricci->mirrored[f] ? -1.0 : 1.0;
+    for (int j = 1; j <= k; j++)
+        heading += turn * (GLM_PI - cornerAngle(lengths[edges[j - 1]], lengths[edges[j]], lengths[edges[(j + 1) % 3]]));
+    return heading;
+}
+
+// Computes edge lengths, curvature, and largest curvature error at given conformal factors, and
+// optionally the Hessian; fails if any triangle becomes degenerate
+static bool evaluateMetric(Ricci *ricci, const Mesh *mesh, const double *u, bool assemble)
+{
+    for (size_t e = 0; e < ricci->numEdges; e++)
+    {
+        double ri = exp(u[ricci->edges[e][0]]), rj = exp(u[ricci->edges[e][1]]);
+        double squared = ri * ri + rj * rj + 2.0 * ri * rj * ricci->inversive[e];
+        if (!(squared > 0.0))
+            return false;
+        ricci->lengths[e] = sqrt(squared);
+    }
+
+    // Sum corner angles (curvature holds angle sums until the end)
+    memset(ricci->curvature, 0, mesh->numVertices * sizeof(double));
+    if (assemble)
+        clearSparseMatrix(ricci->hessian);
+
+    for (size_t f = 0; f < mesh->numIndices / 3; f++)
+    {
+        if (ricci->punctured[f])
+            continue;
+
+        const uint32_t *face = &mesh->indices[3 * f];
+        double lij = ricci->lengths[ricci->faceEdges[3 * f]];
+        double ljk = ricci->lengths[ricci->faceEdges[3 * f + 1]];
+        double lki = ricci->lengths[ricci->faceEdges[3 * f + 2]];
+        if (lij >= ljk + lki || ljk >= lki + lij || lki >= lij + ljk)
+            return false;
+
+        // Law of cosines
+        double ci = (lij * lij + lki * lki - ljk * ljk) / (2.0 * lij * lki);
+        double cj = (lij * lij + ljk * ljk - lki * lki) / (2.0 * lij * ljk);
+        double ai = acos(fmin(fmax(ci, -1.0), 1.0)), aj = acos(fmin(fmax(cj, -1.0), 1.0));
+        ricci->curvature[face[0]] += ai;
+        ricci->curvature[face[1]] += aj;
+        ricci->curvature[face[2]] += GLM_PI - ai - aj;
+
+        if (!assemble)
+            continue;
+
+        // Power center of the three circles, with vertex i at the origin and j on the x axis
+        double ri = exp(u[face[0]]), rj = exp(u[face[1]]), rk = exp(u[face[2]]);
+        double vi[2] = {0.0, 0.0}, vj[2] = {lij, 0.0}, vk[2] = {lki * ci, lki * sin(ai)};
+        double center[2];
+        center[0] = (lij * lij + ri * ri - rj * rj) / (2.0 * lij);
+        center[1] = (lki * lki + ri * ri - rk * rk - 2.0 * center[0] * vk[0]) / (2.0 * vk[1]);
+
+        // Signed distances from power center to edges (positive towards the opposite vertex)
+        double dj[2] = {center[0] - vj[0], center[1] - vj[1]}, edgeJK[2] = {vk[0] - vj[0], vk[1] - vj[1]};
+        double dk[2] = {center[0] - vk[0], center[1] - vk[1]}, edgeKI[2] = {vi[0] - vk[0], vi[1] - vk[1]};
+        double hij = center[1];
+        double hjk = cross2(edgeJK, dj) / ljk;
+        double hki = cross2(edgeKI, dk) / lki;
+
+        // d(angle at i)/d(u_j) = h_ij / l_ij, and so on
+        addEdgeWeight(ricci->hessian, face[0], face[1], hij / lij);
+        addEdgeWeight(ricci->hessian, face[1], face[2], hjk / ljk);
+        addEdgeWeight(ricci->hessian, face[2], face[0], hki / lki);
+    }
+
+    // Angle defects
+    ricci->error = ricci->norm = 0.0;
+    for (size_t v = 0; v < mesh->numVertices; v++)
+    {
+        if (ricci->component[v] == UINT32_MAX)
+        {
+            ricci->curvature[v] = ricci->target[v]; // isolated or left out
+            continue;
+        }
+        ricci->curvature[v] = (ricci->boundary[v] ? GLM_PI : 2.0 * GLM_PI) - ricci->curvature[v];
+        if (ricci->boundary[v])
+            continue; // held, curvature free
+        double error = ricci->target[v] - ricci->curvature[v];
+        ricci->error = fmax(ricci->error, fabs(error));
+        ricci->norm += error * error;
+    }
+
+    return true;
+}
+
+// Punctures faces around seed ring by ring until at least count faces are gone
+static void punctureHole(Ricci *ricci, const Mesh *mesh, uint32_t seed, size_t count, uint32_t *queue, uint8_t *visited)
+{
+    size_t head = 0, tail = 0, punctured = 0;
+    queue[tail++] = seed;
+    visited[seed] = 1;
+    while (head < tail)
+    {
+        // Whole rings at a time, so that the hole stays round
+        size_t ring = tail;
+        for (; head < ring; head++)
+        {
+            uint32_t v = queue[head];
+            for (uint32_t i = mesh->faceOffsets[v]; i < mesh->faceOffsets[v + 1]; i++)
+            {
+                punctured += !ricci->punctured[mesh->faces[i]];
+                ricci->punctured[mesh->faces[i]] = 1;
+            }
+            for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+            {
+                if (visited[mesh->ring[i]])
+                    continue;
+                visited[mesh->ring[i]] = 1;
+                queue[tail++] = mesh->ring[i];
+            }
+        }
+        if (punctured >= count)
+            break;
+    }
+}
+
+// Finds the faces on either side of each edge among faces left in the metric (NO_FACE where there is none)
+static void findEdgeFaces(const Ricci *ricci, const Mesh *mesh, uint32_t (*edgeFaces)[2])
+{
+    for (size_t e = 0; e < ricci->numEdges; e++)
+        edgeFaces[e][0] = edgeFaces[e][1] = NO_FACE;
+    for (size_t f = 0; f < mesh->numIndices / 3; f++)
+    {
+        if (ricci->punctured[f])
+            continue;
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t e = ricci->faceEdges[3 * f + k];
+            edgeFaces[e][edgeFaces[e][0] == NO_FACE ? 0 : 1] = (uint32_t)f;
+        }
+    }
+}
+
+// Grows a topological disk from seed face breadth-first: a face joins across one edge if it brings a new vertex, or
+// across two if it fills the notch between them, so the disk never closes around a handle or touches itself at a
+// vertex (faces left over are where its boundary meets itself, along a cut graph); vertices of other disks are off limits
+static void growDisk(const Ricci *ricci, const Mesh *mesh, const uint32_t (*edgeFaces)[2], uint32_t seed, uint32_t disk,
+                     uint32_t *diskOf, uint8_t *inDisk, uint32_t *queue)
+{
+    size_t head = 0, tail = 0;
+    queue[tail++] = seed;
+    while (head < tail)
+    {
+        uint32_t f = queue[head++];
+        if (inDisk[f])
+            continue;
+
+        const uint32_t *face = &mesh->indices[3 * f];
+        int shared = 0, claimed = 0;
+        bool foreign = false;
+        for (int k = 0; k < 3; k++)
+        {
+            const uint32_t *sides = edgeFaces[ricci->faceEdges[3 * f + k]];
+            uint32_t g = sides[0] == f ? sides[1] : sides[0];
+            shared += g != NO_FACE && inDisk[g];
+            claimed += diskOf[face[k]] == disk;
+            foreign |= diskOf[face[k]] != UINT32_MAX && diskOf[face[k]] != disk;
+        }
+        if (foreign || !((shared == 0 && claimed == 0) || (shared == 1 && claimed == 2) || shared == 2))
+            continue; // may join later, once a neighbor has
+
+        inDisk[f] = 1;
+        for (int k = 0; k < 3; k++)
+        {
+            diskOf[face[k]] = disk;
+            const uint32_t *sides = edgeFaces[ricci->faceEdges[3 * f + k]];
+            uint32_t g = sides[0] == f ? sides[1] : sides[0];
+            if (g != NO_FACE && !inDisk[g])
+                queue[tail++] = g;
+        }
+    }
+}
+
+/*
+ * Ricci Flow
+ */
+
+Ricci *createRicci(const Mesh *mesh)
+{
+    size_t numVertices = mesh->numVertices, numFaces = mesh->numIndices / 3;
+    Ricci *ricci = malloc(sizeof(Ricci));
+
+    // Edges from upper halves of one-rings
+    uint32_t *edgeStarts = malloc(numVertices * sizeof(uint32_t));
+    ricci->numEdges = 0;
+    for (size_t v = 0; v < numVertices; v++)
+    {
+        edgeStarts[v] = (uint32_t)ricci->numEdges;
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+            if (mesh->ring[i] > v)
+                ricci->numEdges++;
+    }
+    ricci->edges = malloc((ricci->numEdges ? ricci->numEdges : 1) * sizeof(*ricci->edges));
+    for (size_t v = 0, e = 0; v < numVertices; v++)
+    {
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+        {
+            if (mesh->ring[i] <= v)
+                continue;
+            ricci->edges[e][0] = (uint32_t)v;
+            ricci->edges[e++][1] = mesh->ring[i];
+        }
+    }
+
+    ricci->faceEdges = malloc((numFaces ? 3 * numFaces : 1) * sizeof(uint32_t));
+    for (size_t f = 0; f < numFaces; f++)
+        for (int k = 0; k < 3; k++)
+            ricci->faceEdges[3 * f + k] = findEdge(mesh, edgeStarts, mesh->indices[3 * f + k], mesh->indices[3 * f + (k + 1) % 3]);
+    free(edgeStarts);
+
+    // Connected components (breadth-first over one-rings)
+    ricci->component = malloc(numVertices * sizeof(uint32_t));
+    uint32_t *first = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t)); // first vertex of each component
+    ricci->numComponents = 0;
+    for (size_t v = 0; v < numVertices; v++)
+        ricci->component[v] = UINT32_MAX;
+    uint32_t *queue = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t));
+    for (size_t seed = 0; seed < numVertices; seed++)
+    {
+        if (ricci->component[seed] != UINT32_MAX || mesh->faceOffsets[seed + 1] == mesh->faceOffsets[seed])
+            continue;
+
+        uint32_t c = (uint32_t)ricci->numComponents++;
+        first[c] = (uint32_t)seed;
+        size_t head = 0, tail = 0;
+        queue[tail++] = (uint32_t)seed;
+        ricci->component[seed] = c;
+        while (head < tail)
+        {
+            uint32_t v = queue[head++];
+            for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+            {
+                if (ricci->component[mesh->ring[i]] != UINT32_MAX)
+                    continue;
+                ricci->component[mesh->ring[i]] = c;
+                queue[tail++] = mesh->ring[i];
+            }
+        }
+    }
+
+    // Euler characteristic, size, and boundary edges of each component
+    size_t numComponents = ricci->numComponents;
+    long *euler = calloc(numComponents ? numComponents : 1, sizeof(long));
+    size_t *componentFaces = calloc(numComponents ? numComponents : 1, sizeof(size_t));
+    size_t *boundaryEdges = calloc(numComponents ? numComponents : 1, sizeof(size_t));
+    uint8_t *edgeFaces = calloc(ricci->numEdges ? ricci->numEdges : 1, sizeof(uint8_t));
+    for (size_t v = 0; v < numVertices; v++)
+        if (ricci->component[v] != UINT32_MAX)
+            euler[ricci->component[v]]++;
+    for (size_t e = 0; e < ricci->numEdges; e++)
+        euler[ricci->component[ricci->edges[e][0]]]--;
+    for (size_t f = 0; f < numFaces; f++)
+    {
+        euler[ricci->component[mesh->indices[3 * f]]]++;
+        componentFaces[ricci->component[mesh->indices[3 * f]]]++;
+        for (int k = 0; k < 3; k++)
+            edgeFaces[ricci->faceEdges[3 * f + k]] += edgeFaces[ricci->faceEdges[3 * f + k]] < UINT8_MAX;
+    }
+    for (size_t e = 0; e < ricci->numEdges; e++)
+        if (edgeFaces[e] == 1)
+            boundaryEdges[ricci->component[ricci->edges[e][0]]]++;
+
+    // Components with non-manifold edges have no flat metric, so they are left out entirely
+    ricci->punctured = calloc(numFaces ? numFaces : 1, sizeof(uint8_t));
+    uint8_t *excluded = calloc(numComponents ? numComponents : 1, sizeof(uint8_t));
+    for (size_t e = 0; e < ricci->numEdges; e++)
+        if (edgeFaces[e] > 2)
+            excluded[ricci->component[ricci->edges[e][0]]] = 1;
+    for (size_t f = 0; f < numFaces; f++)
+        if (excluded[ricci->component[mesh->indices[3 * f]]])
+            ricci->punctured[f] = 1;
+
+    // Closed components that cannot be flat get a hole punctured around their first vertex
+    uint8_t *visited = calloc(numVertices, sizeof(uint8_t));
+    for (size_t c = 0; c < numComponents; c++)
+        if (!excluded[c] && !boundaryEdges[c] && euler[c] != 0)
+            punctureHole(ricci, mesh, first[c], (size_t)(RICCI_HOLE * componentFaces[c]), queue, visited);
+    free(visited);
+    free(excluded);
+    free(first);
+    free(euler);
+    free(componentFaces);
+    free(boundaryEdges);
+
+    // What remains of each component is cut into topological disks, so that a flat metric can be unfolded without
+    // wrapping around a handle; faces left out of every disk are punctured along with the holes
+    uint32_t (*sides)[2] = malloc((ricci->numEdges ? ricci->numEdges : 1) * sizeof(*sides));
+    findEdgeFaces(ricci, mesh, sides);
+    uint32_t *diskOf = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t));
+    uint8_t *inDisk = calloc(numFaces ? numFaces : 1, sizeof(uint8_t));
+    uint32_t *faceQueue = malloc((3 * numFaces + 1) * sizeof(uint32_t)); // faces are queued once per neighbor joining
+    for (size_t v = 0; v < numVertices; v++)
+        diskOf[v] = UINT32_MAX;
+    ricci->seeds = malloc((numFaces ? numFaces : 1) * sizeof(uint32_t));
+    size_t numDisks = 0;
+    for (size_t f = 0; f < numFaces; f++)
+    {
+        const uint32_t *face = &mesh->indices[3 * f];
+        if (ricci->punctured[f] || diskOf[face[0]] != UINT32_MAX || diskOf[face[1]] != UINT32_MAX ||
+            diskOf[face[2]] != UINT32_MAX)
+            continue;
+        growDisk(ricci, mesh, (const uint32_t(*)[2])sides, (uint32_t)f, (uint32_t)numDisks, diskOf, inDisk, faceQueue);
+        ricci->seeds[numDisks++] = (uint32_t)f;
+    }
+    for (size_t f = 0; f < numFaces; f++)
+        ricci->punctured[f] |= !inDisk[f];
+    free(sides);
+    free(inDisk);
+    free(faceQueue);
+    free(queue);
+
+    // Disks take the place of components, and vertices without remaining faces are left out
+    memcpy(ricci->component, diskOf, numVertices * sizeof(uint32_t));
+    ricci->numComponents = numDisks;
+    free(diskOf);
+    memset(edgeFaces, 0, ricci->numEdges * sizeof(uint8_t));
+    for (size_t f = 0; f < numFaces; f++)
+        if (!ricci->punctured[f])
+            for (int k = 0; k < 3; k++)
+                edgeFaces[ricci->faceEdges[3 * f + k]]++;
+
+    // Boundary vertices, which hold their initial factors so that boundary edges keep their lengths (their curvature
+    // is left free, which also keeps long cuts from having to turn in a prescribed way)
+    ricci->boundary = calloc(numVertices, sizeof(uint8_t));
+    for (size_t e = 0; e < ricci->numEdges; e++)
+        if (edgeFaces[e] == 1)
+            ricci->boundary[ricci->edges[e][0]] = ricci->boundary[ricci->edges[e][1]] = 1;
+    free(edgeFaces);
+
+    // Target curvature: flat inside
+    ricci->target = calloc(numVertices, sizeof(double));
+
+    // Circle radii from a third of the mean incident edge length, inversive distances from initial lengths
+    ricci->u = calloc(numVertices, sizeof(double));
+    uint32_t *degree = calloc(numVertices, sizeof(uint32_t));
+    for (size_t e = 0; e < ricci->numEdges; e++)
+    {
+        double length = glm_vec3_distance(mesh->vertices[ricci->edges[e][0]].position, mesh->vertices[ricci->edges[e][1]].position);
+        for (int k = 0; k < 2; k++)
+        {
+            ricci->u[ricci->edges[e][k]] += length;
+            degree[ricci->edges[e][k]]++;
+        }
+    }
+    for (size_t v = 0; v < numVertices; v++)
+        ricci->u[v] = degree[v] && ricci->u[v] > 0.0 ? log(ricci->u[v] / (3.0 * degree[v])) : 0.0;
+    free(degree);
+
+    ricci->inversive = malloc((ricci->numEdges ? ricci->numEdges : 1) * sizeof(double));
+    for (size_t e = 0; e < ricci->numEdges; e++)
+    {
+        double ri = exp(ricci->u[ricci->edges[e][0]]), rj = exp(ricci->u[ricci->edges[e][1]]);
+        double length = glm_vec3_distance(mesh->vertices[ricci->edges[e][0]].position, mesh->vertices[ricci->edges[e][1]].position);
+        ricci->inversive[e] = (length * length - ri * ri - rj * rj) / (2.0 * ri * rj);
+    }
+
+    ricci->curvature = malloc(numVertices * sizeof(double));
+    ricci->lengths = malloc((ricci->numEdges ? ricci->numEdges : 1) * sizeof(double));
+    ricci->step = calloc(numVertices, sizeof(double));
+    ricci->residual = malloc(numVertices * sizeof(double));
+    ricci->hessian = createMeshMatrix(mesh);
+    ricci->uvs = calloc(numVertices, sizeof(*ricci->uvs));
+    ricci->mirrored = calloc(numFaces ? numFaces : 1, sizeof(uint8_t));
+    ricci->iterations = ricci->solverIterations = 0;
+
+    // Curvature of initial metric (which reproduces the mesh's edge lengths)
+    evaluateMetric(ricci, mesh, ricci->u, false);
+    ricci->converged = ricci->error < RICCI_TOLERANCE;
+    ricci->stalled = false;
+
+    return ricci;
+}
+
+void destroyRicci(Ricci *ricci)
+{
+    if (!ricci)
+        return;
+
+    free(ricci->edges);
+    free(ricci->faceEdges);
+    free(ricci->punctured);
+    free(ricci->boundary);
+    free(ricci->component);
+    free(ricci->seeds);
+    free(ricci->inversive);
+    free(ricci->u);
+    free(ricci->target);
+    free(ricci->curvature);
+    free(ricci->lengths);
+    free(ricci->step);
+    free(ricci->residual);
+    destroySparseMatrix(ricci->hessian);
+    free(ricci->uvs);
+    free(ricci->mirrored);
+    free(ricci);
+}
+
+double stepRicci(Ricci *ricci, Mesh *mesh)
+{
+    size_t numVertices = mesh->numVertices;
+    if (ricci->converged || ricci->stalled)
+        return ricci->error;
+
+    // Hessian and curvature error at current metric
+    evaluateMetric(ricci, mesh, ricci->u, true);
+    double norm = ricci->norm;
+    for (size_t v = 0; v < numVertices; v++)
+        ricci->residual[v] = ricci->target[v] - ricci->curvature[v];
+
+    // Boundary vertices (which fix each component's scale) and isolated vertices keep their factors
+    for (size_t v = 0; v < numVertices; v++)
+    {
+        double *diagonal = sparseEntry(ricci->hessian, (uint32_t)v, (uint32_t)v);
+        if (*diagonal == 0.0)
+        {
+            *diagonal = 1.0;
+            ricci->residual[v] = 0.0;
+        }
+        if (!ricci->boundary[v])
+            continue;
+        for (uint32_t i = ricci->hessian->rowOffsets[v]; i < ricci->hessian->rowOffsets[v + 1]; i++)
+        {
+            uint32_t n = ricci->hessian->columns[i];
+            ricci->hessian->values[i] = n == v ? 1.0 : 0.0;
+            if (n != v)
+                *sparseEntry(ricci->hessian, n, (uint32_t)v) = 0.0;
+        }
+        ricci->residual[v] = 0.0;
+    }
+
+    // Newton step
+    memset(ricci->step, 0, numVertices * sizeof(double));
+    ricci->solverIterations = solveConjugateGradient(ricci->hessian, NULL, ricci->residual, ricci->step, RICCI_CG_TOLERANCE, RICCI_CG_ITERATIONS,
+                                                    meshArena(mesh));
+
+    // Halve step until metric stays valid and squared error goes down
+    Arena *scratch = meshArena(mesh);
+    ArenaFrame frame = pushFrame(scratch);
+    double *trial = arenaAlloc(scratch, numVertices * sizeof(double));
+    double scale = 1.0;
+    bool accepted = false;
+    for (int attempt = 0; attempt < RICCI_LINE_SEARCH && !accepted; attempt++, scale *= 0.5)
+    {
+        for (size_t v = 0; v < numVertices; v++)
+            trial[v] = ricci->u[v] + scale * ricci->step[v];
+        accepted = evaluateMetric(ricci, mesh, trial, false) && ricci->norm < norm;
+    }
+    if (accepted)
+        memcpy(ricci->u, trial, numVertices * sizeof(double));
+    else
+        evaluateMetric(ricci, mesh, ricci->u, false); // stuck; keep current metric
+    popFrame(scratch, frame);
+
+    ricci->iterations++;
+    ricci->converged = ricci->error < RICCI_TOLERANCE;
+    ricci->stalled = !accepted && !ricci->converged;
+    return ricci->error;
+}
+
+void embedRicci(Ricci *ricci, const Mesh *mesh)
+{
+    size_t numVertices = mesh->numVertices, numFaces = mesh->numIndices / 3;
+
+    // Faces on either side of each edge
+    uint32_t (*edgeFaces)[2] = malloc((ricci->numEdges ? ricci->numEdges : 1) * sizeof(*edgeFaces));
+    findEdgeFaces(ricci, mesh, edgeFaces);
+
+    uint8_t *placed = calloc(numVertices, sizeof(uint8_t));
+    uint8_t *visited = calloc(numFaces ? numFaces : 1, sizeof(uint8_t));
+    uint32_t *queue = malloc((numFaces ? numFaces : 1) * sizeof(uint32_t));
+    uint32_t *members = malloc((numVertices ? numVertices : 1) * sizeof(uint32_t));
+    double *heading = malloc((numFaces ? numFaces : 1) * sizeof(double)); // direction of edge 0 of each unfolded face
+    memset(ricci->uvs, 0, numVertices * sizeof(*ricci->uvs));
+    memset(ricci->mirrored, 0, numFaces * sizeof(uint8_t));
+
+    double offset = 0.0;
+    for (size_t c = 0; c < ricci->numComponents; c++)
+    {
+        // Seed with the face the disk was grown from, vertex 0 at origin and vertex 1 along x
+        uint32_t seed = ricci->seeds[c];
+        const uint32_t *face = &mesh->indices[3 * seed];
+        double lij = ricci->lengths[ricci->faceEdges[3 * seed]];
+        double ljk = ricci->lengths[ricci->faceEdges[3 * seed + 1]];
+        double lki = ricci->lengths[ricci->faceEdges[3 * seed + 2]];
+        double x = (lij * lij + lki * lki - ljk * ljk) / (2.0 * lij);
+        ricci->uvs[face[0]][0] = ricci->uvs[face[0]][1] = 0.0;
+        ricci->uvs[face[1]][0] = lij;
+        ricci->uvs[face[1]][1] = 0.0;
+        ricci->uvs[face[2]][0] = x;
+        ricci->uvs[face[2]][1] = sqrt(fmax(lki * lki - x * x, 0.0));
+        size_t numMembers = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            placed[face[k]] = 1;
+            members[numMembers++] = face[k];
+        }
+
+        // Unfold neighbors breadth-first, carrying the direction of each face's first edge rather than taking it from
+        // placed vertices (whose differences lose digits where the metric shrinks), and mirroring faces whose winding
+        // disagrees with their neighbor's so each new vertex lands across the shared edge
+        size_t head = 0, tail = 0;
+        queue[tail++] = seed;
+        visited[seed] = 1;
+        heading[seed] = 0.0;
+        ricci->mirrored[seed] = 0;
+        while (head < tail)
+        {
+            uint32_t f = queue[head++];
+            const uint32_t *from = &mesh->indices[3 * f];
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t e = ricci->faceEdges[3 * f + k];
+                uint32_t g = edgeFaces[e][0] == f ? edgeFaces[e][1] : edgeFaces[e][0];
+                if (g == NO_FACE || visited[g])
+                    continue;
+                visited[g] = 1;
+                queue[tail++] = g;
+
+                // Vertex of g opposite the shared edge, and direction of the shared edge from vp to vq
+                const uint32_t *other = &mesh->indices[3 * g];
+                int m = 0;
+                while (ricci->faceEdges[3 * g + (m + 1) % 3] != e)
+                    m++;
+                uint32_t vc = other[m], vp = other[(m + 1) % 3];
+                bool consistent = vp == from[(k + 1) % 3];
+                double direction = edgeDirection(ricci, f, heading[f], k) + (consistent ? GLM_PI : 0.0);
+                ricci->mirrored[g] = ricci->mirrored[f] ^ !consistent;
+                heading[g] = remainder(direction - edgeDirection(ricci, g, 0.0, (m + 1) % 3), 2.0 * GLM_PI);
+                if (placed[vc])
+                    continue;
+
+                double lpq = ricci->lengths[e];
+                double lqc = ricci->lengths[ricci->faceEdges[3 * g + (m + 2) % 3]];
+                double lcp = ricci->lengths[ricci->faceEdges[3 * g + m]];
+                direction += (ricci->mirrored[g] ? -1.0 : 1.0) * cornerAngle(lpq, lcp, lqc);
+                ricci->uvs[vc][0] = ricci->uvs[vp][0] + lcp * cos(direction);
+                ricci->uvs[vc][1] = ricci->uvs[vp][1] + lcp * sin(direction);
+                placed[vc] = 1;
+                members[numMembers++] = vc;
+            }
+        }
+
+        // Place component right of previous ones
+        double minX = DBL_MAX, maxX = -DBL_MAX;
+        for (size_t i = 0; i < numMembers; i++)
+        {
+            minX = fmin(minX, ricci->uvs[members[i]][0]);
+            maxX = fmax(maxX, ricci->uvs[members[i]][0]);
+        }
+        for (size_t i = 0; i < numMembers; i++)
+            ricci->uvs[members[i]][0] += offset - minX;
+        offset += (maxX - minX) * 1.1;
+    }
+
+    // Vertices of punctured holes sit at the mean of their placed neighbors, filled from the rim inwards
+    size_t head = 0, tail = 0;
+    for (size_t v = 0; v < numVertices; v++)
+    {
+        if (placed[v])
+            continue;
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+        {
+            if (placed[mesh->ring[i]] != 1)
+                continue;
+            placed[v] = 2; // queued
+            members[tail++] = (uint32_t)v;
+            break;
+        }
+    }
+    while (head < tail)
+    {
+        uint32_t v = members[head++];
+        int count = 0;
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+        {
+            uint32_t n = mesh->ring[i];
+            if (placed[n] == 1)
+            {
+                ricci->uvs[v][0] += ricci->uvs[n][0];
+                ricci->uvs[v][1] += ricci->uvs[n][1];
+                count++;
+            }
+            else if (!placed[n])
+            {
+                placed[n] = 2;
+                members[tail++] = n;
+            }
+        }
+        ricci->uvs[v][0] /= count;
+        ricci->uvs[v][1] /= count;
+        placed[v] = 1;
+    }
+
+    free(edgeFaces);
+    free(placed);
+    free(visited);
+    free(queue);
+    free(members);
+    free(heading);
+}
@@ -0,0 +1,101 @@
+#ifndef RICCI_H
+#define RICCI_H
+
+#include "model.h"
+#include "sparse.h"
+
+#include <cglm/cglm.h>
+
+#include <stdint.h>
+
+// Solver settings
+#define RICCI_TOLERANCE 1e-6        // largest curvature error at convergence
+#define RICCI_CG_TOLERANCE 1e-10    // relative residual of Newton systems
+#define RICCI_CG_ITERATIONS 2000    // iteration limit of Newton systems
+#define RICCI_LINE_SEARCH 16        // step halvings before giving up on a Newton step
+#define RICCI_HOLE 0.01             // fraction of faces punctured from closed components that cannot be flat
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Discrete Ricci flow on the inversive distance circle packing metric of a mesh.
+ *
+ * Each vertex carries a circle of radius exp(u) and each edge the inversive distance of its two
+ * circles, fixed from the mesh's initial edge lengths, so the metric is determined by the conformal
+ * factors u alone. Closed components with nonzero Euler characteristic get a small hole punctured,
+ * and what remains of every component is cut into topological disks along a cut graph (components
+ * with non-manifold edges are left out). Newton's method then drives the angle-defect curvature of
+ * inner vertices to zero while boundary vertices hold their factors, after which faces are unfolded
+ * into the plane.
+ */
+struct Ricci
+{
+    size_t numEdges;          // number of edges
+    uint32_t (*edges)[2];     // vertices of each edge (lower index first)
+    uint32_t *faceEdges;      // edge k of each face (runs from its vertex k to vertex k + 1)
+    uint8_t *punctured;       // whether each face is left out of the metric
+    uint8_t *boundary;        // whether each vertex lies on a boundary (after puncturing and cutting)
+    uint32_t *component;      // disk of each vertex (UINT32_MAX if left out)
+    uint32_t *seeds;          // face each disk was grown and is unfolded from
+    size_t numComponents;     // number of disks
+    double *inversive;        // inversive distance of each edge
+    double *u;                // conformal factor (log of circle radius) of each vertex
+    double *target;           // target curvature of each vertex (zero; boundary vertices are held instead)
+    double *curvature;        // current curvature of each vertex
+    double *lengths;          // current length of each edge
+    double *step;             // last Newton step
+    double *residual;         // curvature error (right-hand side of Newton system)
+    SparseMatrix *hessian;    // derivative of curvature with respect to conformal factors
+    double (*uvs)[2];         // planar embedding of each vertex (after embedRicci)
+    uint8_t *mirrored;        // whether each face winds clockwise in the embedding (where the mesh's winding flips)
+    double error;             // largest curvature error
+    double norm;              // sum of squared curvature errors
+    size_t iterations;        // Newton iterations taken
+    size_t solverIterations;  // conjugate gradient iterations of last Newton step
+    bool converged;           // whether error is below RICCI_TOLERANCE
+    bool stalled;             // whether the last Newton step failed to reduce the error (no further steps are taken)
+};
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Sets up Ricci flow on mesh from its current edge lengths.
+ *
+ * @param mesh Mesh to flatten.
+ * @return Initialized flow state (not yet iterated).
+ */
+Ricci *createRicci(const Mesh *mesh);
+
+/**
+ * @brief Destroys Ricci flow state and frees space.
+ *
+ * @param ricci State to destroy (may be NULL).
+ */
+void destroyRicci(Ricci *ricci);
+
+/**
+ * @brief Takes one damped Newton step towards the target curvature (none once converged or stalled).
+ *
+ * @param ricci State to advance.
+ * @param mesh  Mesh state was created for.
+ * @return Largest curvature error after the step.
+ */
+double stepRicci(Ricci *ricci, Mesh *mesh);
+
+/**
+ * @brief Lays out faces in the plane with the edge lengths of the current metric.
+ *
+ * Faces are unfolded breadth-first from each disk's seed face, in double precision and carrying the
+ * direction of each face rather than deriving it from placed vertices; disks are placed side by side,
+ * and vertices inside punctured holes and cuts are filled in from their rims.
+ *
+ * @param ricci State to embed (results go to uvs).
+ * @param mesh  Mesh state was created for.
+ */
+void embedRicci(Ricci *ricci, const Mesh *mesh);
+
+#endif
@@ -0,0 +1,356 @@
+#include <glad/glad.h>
+
+#include "scene.h"
+#include "model.h"
+#include "geometry.h"
+#include "collision.h"
+
+#include <cglm/cglm.h>
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+Scene *createScene(size_t numThreads)
+{
+    Scene *scene = calloc(1, sizeof(Scene));
+    scene->pool = createThreadPool(numThreads);
+    return scene;
+}
+
+void destroyScene(Scene *scene)
+{
+    // Buffers (scenes never uploaded have none, and need no OpenGL context)
+    if (scene->VAO)
+    {
+        glDeleteVertexArrays(1, &scene->VAO);
+        glDeleteBuffers(1, &scene->VBO);
+        glDeleteBuffers(1, &scene->IBO);
+        glDeleteBuffers(1, &scene->drawBuffer);
+        glDeleteBuffers(1, &scene->modelBuffer);
+    }
+    if (scene->highlightBuffer)
+        glDeleteBuffers(1, &scene->highlightBuffer);
+
+    for (size_t i = 0; i < scene->numEntries; i++)
+        destroyModel(scene->entries[i].model);
+    destroyThreadPool(scene->pool);
+    free(scene->entries);
+    free(scene->modelBlocks);
+    free(scene->highlights);
+    free(scene);
+}
+
+void clearScene(Scene *scene)
+{
+    for (size_t i = 0; i < scene->numEntries; i++)
+        destroyModel(scene->entries[i].model);
+    scene->numEntries = scene->numPlaced = scene->numResident = 0;
+    scene->numVertices = scene->numIndices = scene->uploadedBytes = 0;
+    scene->width = 0.0f;
+    glm_vec3_zero(scene->center);
+}
+
+SceneEntry *addModel(Scene *scene, Model *model, GEOMETRIC_FLOW flow)
+{
+    if (scene->numEntries == scene->capacity)
+    {
+        scene->capacity = scene->capacity ? 2 * scene->capacity : 4;
+        scene->entries = realloc(scene->entries, scene->capacity * sizeof(SceneEntry));
+    }
+
+    // Horizontal extent of mesh (isolated vertices, like fast_obj's dummy, don't count)
+    Mesh *mesh = model->mesh;
+    float minX = 0.0f, maxX = 0.0f;
+    bool first = true;
+    for (size_t v = 0; v < mesh->numVertices; v++)
+    {
+        if (mesh->faceOffsets[v] == mesh->faceOffsets[v + 1])
+            continue;
+        float x = mesh->vertices[v].position[0];
+        minX = first || x < minX ? x : minX;
+        maxX = first || x > maxX ? x : maxX;
+        first = false;
+    }
+    minX *= model->scale[0];
+    maxX *= model->scale[0];
+
+    // Append to row of models (first model stays where it is) and recenter row
+    float rowBegin = model->position[0] + minX;
+    if (scene->numEntries)
+    {
+        rowBegin = scene->center[0] - 0.5f * scene->width;
+        model->position[0] = scene->center[0] + 0.5f * scene->width + MODEL_GAP - minX;
+    }
+    scene->width = model->position[0] + maxX - rowBegin;
+    glm_vec3_copy(model->position, scene->center);
+    scene->center[0] = rowBegin + 0.5f * scene->width;
+
+    SceneEntry *entry = &scene->entries[scene->numEntries++];
+    entry->model = model;
+    entry->flow = flow;
+    entry->flowing = false;
+    entry->steps = entry->maxSteps = 0;
+    entry->time = 0.0;
+    entry->numCollisions = 0;
+    entry->baseVertex = entry->firstIndex = 0;
+
+    return entry;
+}
+
+// Steps one model's flow, splitting its sweeps across a pool if one is given
+static void stepModel(Scene *scene, SceneEntry *entry, ThreadPool *pool)
+{
+    if (!entry->flowing)
+        return;
+
+    stepFlow(entry->model->mesh, entry->flow, scene->deltaTime, pool);
+    entry->time += scene->deltaTime;
+    if (++entry->steps >= entry->maxSteps && entry->maxSteps)
+        entry->flowing = false;
+}
+
+// Steps one model's flow (run on worker threads)
+static void stepEntry(void *data, size_t index)
+{
+    Scene *scene = data;
+    stepModel(scene, &scene->entries[index], NULL);
+}
+
+bool stepScene(Scene *scene, float deltaTime)
+{
+    size_t flowing = 0;
+    for (size_t i = 0; i < scene->numEntries; i++)
+        flowing += scene->entries[i].flowing;
+    if (!flowing)
+        return false;
+
+    // Models too few to keep every thread busy are stepped one by one, each across the whole pool
+    scene->deltaTime = deltaTime;
+    if (flowing <= scene->pool->numThreads)
+        for (size_t i = 0; i < scene->numEntries; i++)
+            stepModel(scene, &scene->entries[i], scene->pool);
+    else
+        runTasks(scene->pool, stepEntry, scene, scene->numEntries);
+    return true;
+}
+
+// Points a vertex attribute at a member of Vertex
+static void setAttribute(GLuint vao, GLuint index, GLint size, size_t offset)
+{
+    glEnableVertexArrayAttrib(vao, index);
+    glVertexArrayAttribFormat(vao, index, size, GL_FLOAT, GL_FALSE, (GLuint)offset);
+    glVertexArrayAttribBinding(vao, index, 0);
+}
+
+// Replaces buffer by a larger one, keeping its used bytes (copied on the GPU, so nothing waits on the CPU)
+static void growBuffer(GLuint *buffer, size_t used, size_t size)
+{
+    GLuint grown;
+    glCreateBuffers(1, &grown);
+    glNamedBufferData(grown, size, NULL, GL_DYNAMIC_DRAW);
+    if (*buffer && used)
+        glCopyNamedBufferSubData(*buffer, grown, 0, 0, used);
+    if (*buffer)
+        glDeleteBuffers(1, buffer);
+    *buffer = grown;
+}
+
+// Capacity holding needed elements, at least doubling old capacity so that repeated growth stays linear
+static size_t grownCapacity(size_t needed, size_t capacity)
+{
+    return needed > 2 * capacity ? needed : 2 * capacity;
+}
+
+// Gives models added since the last upload space at the ends of the arenas (growing them by doubling)
+static void placeModels(Scene *scene)
+{
+    // Vertex layout (created with the first models)
+    if (!scene->VAO)
+    {
+        glCreateVertexArrays(1, &scene->VAO);
+        setAttribute(scene->VAO, 0, 3, offsetof(Vertex, position));  // position
+        setAttribute(scene->VAO, 1, 3, offsetof(Vertex, normal));    // normal
+        setAttribute(scene->VAO, 2, 3, offsetof(Vertex, curvature)); // curvature
+        setAttribute(scene->VAO, 3, 1, offsetof(Vertex, gaussian));  // Gaussian curvature
+    }
+
+    size_t numVertices = scene->numVertices, numIndices = scene->numIndices;
+    for (size_t i = scene->numPlaced; i < scene->numEntries; i++)
+    {
+        SceneEntry *entry = &scene->entries[i];
+        entry->baseVertex = (uint32_t)numVertices;
+        entry->firstIndex = (uint32_t)numIndices;
+        numVertices += entry->model->mesh->numVertices;
+        numIndices += entry->model->mesh->numIndices;
+    }
+
+    // Arenas
+    if (numVertices > scene->vertexCapacity || numIndices > scene->indexCapacity)
+    {
+        if (numVertices > scene->vertexCapacity)
+        {
+            scene->vertexCapacity = grownCapacity(numVertices, scene->vertexCapacity);
+            growBuffer(&scene->VBO, scene->numVertices * sizeof(Vertex), scene->vertexCapacity * sizeof(Vertex));
+        }
+        if (numIndices > scene->indexCapacity)
+        {
+            scene->indexCapacity = grownCapacity(numIndices, scene->indexCapacity);
+            growBuffer(&scene->IBO, scene->numIndices * sizeof(uint32_t), scene->indexCapacity * sizeof(uint32_t));
+        }
+        glVertexArrayVertexBuffer(scene->VAO, 0, scene->VBO, 0, sizeof(Vertex));
+        glVertexArrayElementBuffer(scene->VAO, scene->IBO);
+    }
+    scene->numVertices = numVertices;
+    scene->numIndices = numIndices;
+
+    // Draw commands and model matrices
+    if (scene->numEntries > scene->modelCapacity)
+    {
+        scene->modelCapacity = grownCapacity(scene->numEntries, scene->modelCapacity);
+        growBuffer(&scene->drawBuffer, scene->numResident * sizeof(DrawCommand), scene->modelCapacity * sizeof(DrawCommand));
+        growBuffer(&scene->modelBuffer, scene->numPlaced * sizeof(ModelBlock), scene->modelCapacity * sizeof(ModelBlock));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MODEL_BINDING, scene->modelBuffer);
+        scene->modelBlocks = realloc(scene->modelBlocks, scene->modelCapacity * sizeof(ModelBlock));
+    }
+
+    // New model matrices are written by the next upload, as zeroed blocks never match a real model matrix
+    memset(&scene->modelBlocks[scene->numPlaced], 0, (scene->numEntries - scene->numPlaced) * sizeof(ModelBlock));
+    scene->numPlaced = scene->numEntries;
+}
+
+// Uploads up to UPLOAD_BUDGET bytes of placed models (vertices, then indices), making models drawable once complete
+static bool uploadModels(Scene *scene)
+{
+    bool uploaded = false;
+    size_t budget = UPLOAD_BUDGET;
+    while (budget && scene->numResident < scene->numPlaced)
+    {
+        SceneEntry *entry = &scene->entries[scene->numResident];
+        Mesh *mesh = entry->model->mesh;
+        size_t vertexBytes = mesh->numVertices * sizeof(Vertex), indexBytes = mesh->numIndices * sizeof(uint32_t);
+
+        // Chunks read current vertices, so earlier changes need no separate upload (later ones are marked again)
+        if (scene->uploadedBytes == 0)
+            mesh->dirtyBegin = mesh->dirtyEnd = 0;
+
+        size_t size;
+        if (scene->uploadedBytes < vertexBytes)
+        {
+            size = vertexBytes - scene->uploadedBytes;
+            if (size > budget)
+                size = budget;
+            glNamedBufferSubData(scene->VBO, entry->baseVertex * sizeof(Vertex) + scene->uploadedBytes, size,
+                                 (const char *)mesh->vertices + scene->uploadedBytes);
+        }
+        else
+        {
+            size_t offset = scene->uploadedBytes - vertexBytes;
+            size = indexBytes - offset;
+            if (size > budget)
+                size = budget;
+            glNamedBufferSubData(scene->IBO, entry->firstIndex * sizeof(uint32_t) + offset, size, (const char *)mesh->indices + offset);
+        }
+        scene->uploadedBytes += size;
+        budget -= size;
+        uploaded = true;
+
+        // Complete models get their draw command
+        if (scene->uploadedBytes == vertexBytes + indexBytes)
+        {
+            DrawCommand command = {(GLuint)mesh->numIndices, 1, entry->firstIndex, (GLint)entry->baseVertex, (GLuint)scene->numResident};
+            glNamedBufferSubData(scene->drawBuffer, scene->numResident * sizeof(DrawCommand), sizeof(DrawCommand), &command);
+            scene->numResident++;
+            scene->uploadedBytes = 0;
+        }
+    }
+
+    return uploaded;
+}
+
+bool uploadScene(Scene *scene)
+{
+    if (scene->numPlaced < scene->numEntries)
+        placeModels(scene);
+    bool uploaded = uploadModels(scene);
+
+    // Changed vertices of drawable models
+    for (size_t i = 0; i < scene->numResident; i++)
+    {
+        SceneEntry *entry = &scene->entries[i];
+        Mesh *mesh = entry->model->mesh;
+        if (mesh->dirtyEnd <= mesh->dirtyBegin)
+            continue;
+
+        glNamedBufferSubData(scene->VBO,
+                             (entry->baseVertex + mesh->dirtyBegin) * sizeof(Vertex),
+                             (mesh->dirtyEnd - mesh->dirtyBegin) * sizeof(Vertex),
+                             &mesh->vertices[mesh->dirtyBegin]);
+        mesh->dirtyBegin = mesh->dirtyEnd = 0;
+        uploaded = true;
+    }
+
+    // Changed model matrices (all written at once)
+    bool moved = false;
+    for (size_t i = 0; i < scene->numPlaced; i++)
+    {
+        mat4 m;
+        computeModelMatrix(scene->entries[i].model, &m);
+        ModelBlock *block = &scene->modelBlocks[i];
+        if (!memcmp(m, block->model, sizeof(mat4)))
+            continue;
+
+        glm_mat4_copy(m, block->model);
+        glm_mat4_inv(m, block->normal);
+        glm_mat4_transpose(block->normal);
+        moved = true;
+    }
+    if (moved)
+        glNamedBufferSubData(scene->modelBuffer, 0, scene->numPlaced * sizeof(ModelBlock), scene->modelBlocks);
+
+    return uploaded || moved;
+}
+
+void drawScene(const Scene *scene)
+{
+    if (!scene->numResident)
+        return;
+
+    glBindVertexArray(scene->VAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene->drawBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL, (GLsizei)scene->numResident, 0);
+}
+
+void drawHighlights(Scene *scene)
+{
+    // One command per colliding face (of drawable models)
+    scene->numHighlights = 0;
+    for (size_t i = 0; i < scene->numResident; i++)
+    {
+        const SceneEntry *entry = &scene->entries[i];
+        const SpatialHash *hash = entry->model->mesh->spatialHash;
+        if (!hash || !hash->numCollisions)
+            continue;
+
+        if (scene->numHighlights + hash->numCollisions > scene->highlightCapacity)
+        {
+            while (scene->numHighlights + hash->numCollisions > scene->highlightCapacity)
+                scene->highlightCapacity = scene->highlightCapacity ? 2 * scene->highlightCapacity : 256;
+            scene->highlights = realloc(scene->highlights, scene->highlightCapacity * sizeof(DrawCommand));
+
+            glDeleteBuffers(1, &scene->highlightBuffer);
+            glCreateBuffers(1, &scene->highlightBuffer);
+            glNamedBufferData(scene->highlightBuffer, scene->highlightCapacity * sizeof(DrawCommand), NULL, GL_STREAM_DRAW);
+        }
+
+        for (size_t j = 0; j < hash->numCollisions; j++)
+            scene->highlights[scene->numHighlights++] = (DrawCommand){3, 1, entry->firstIndex + 3 * hash->collisions[j], (GLint)entry->baseVertex, (GLuint)i};
+    }
+    if (!scene->numHighlights)
+        return;
+
+    glNamedBufferSubData(scene->highlightBuffer, 0, scene->numHighlights * sizeof(DrawCommand), scene->highlights);
+    glBindVertexArray(scene->VAO);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene->highlightBuffer);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL, (GLsizei)scene->numHighlights, 0);
+}
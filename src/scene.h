@@ -0,0 +1,166 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <glad/glad.h>
+
+#include "model.h"
+#include "geometry.h"
+#include "shader.h"
+#include "threadpool.h"
+
+#include <cglm/cglm.h>
+
+#include <stdint.h>
+
+// Layout settings
+#define MODEL_GAP 0.5f // space left between neighboring models (world space)
+
+// Upload settings
+#define UPLOAD_BUDGET (4 << 20) // most bytes of new models uploaded per frame
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Arguments of one indirect indexed draw (layout fixed by glMultiDrawElementsIndirect).
+ */
+typedef struct
+{
+    GLuint count;         // number of indices
+    GLuint instanceCount; // number of instances (always 1)
+    GLuint firstIndex;    // first index in index arena
+    GLint baseVertex;     // added to every index (first vertex of mesh in vertex arena)
+    GLuint baseInstance;  // model the draw belongs to (selects ModelBlock in shaders)
+} DrawCommand;
+
+/**
+ * @brief Model of a scene along with the state of its flow.
+ */
+typedef struct
+{
+    Model *model;          // model (scene owns it and its mesh)
+    GEOMETRIC_FLOW flow;   // flow computed on model
+    bool flowing;          // whether model's flow is running
+    size_t steps;          // flow steps taken
+    size_t maxSteps;       // steps after which flow stops (0 for no limit)
+    double time;           // flow time covered by steps taken
+    size_t numCollisions;  // self-intersecting faces last reported
+    uint32_t baseVertex;   // first vertex of mesh in vertex arena
+    uint32_t firstIndex;   // first index of mesh in index arena
+} SceneEntry;
+
+/**
+ * @brief Models drawn together from shared vertex and index arenas.
+ *
+ * Every model is one command of a single glMultiDrawElementsIndirect call, so adding a model costs one
+ * command and one ModelBlock instead of its own buffers, bindings, and draw call. Flows of all models are
+ * stepped in parallel on a thread pool, and only their dirty vertex ranges are uploaded afterwards.
+ *
+ * Added models are appended to the arenas (which grow by doubling, copying on the GPU) and uploaded a
+ * few megabytes per frame; a model is drawn once all of it has arrived, so adding a large mesh never
+ * stalls a frame.
+ */
+typedef struct
+{
+    SceneEntry *entries;       // models of scene
+    size_t numEntries;         // number of models
+    size_t capacity;           // allocated entries
+    vec3 center;               // center of models' row (world space)
+    float width;               // width of models' row (world space)
+    ThreadPool *pool;          // workers flows are stepped on
+    float deltaTime;           // time step of current flow batch
+    size_t numPlaced;          // models given space in arenas
+    size_t numResident;        // models fully uploaded (drawn)
+    size_t uploadedBytes;      // bytes of first non-resident model uploaded so far (vertices, then indices)
+    GLuint VAO;                // vertex layout of arenas
+    GLuint VBO, IBO;           // vertex and index arenas
+    size_t numVertices;        // vertices in use in vertex arena
+    size_t numIndices;         // indices in use in index arena
+    size_t vertexCapacity;     // vertices allocated in vertex arena
+    size_t indexCapacity;      // indices allocated in index arena
+    GLuint drawBuffer;         // one DrawCommand per resident model
+    GLuint modelBuffer;        // one ModelBlock per placed model
+    size_t modelCapacity;      // models draw and model buffers have room for
+    ModelBlock *modelBlocks;   // model matrices as last uploaded
+    GLuint highlightBuffer;    // DrawCommands of highlighted faces
+    DrawCommand *highlights;   // highlighted face commands (staging)
+    size_t numHighlights;      // number of highlighted faces
+    size_t highlightCapacity;  // allocated highlight commands (in staging and buffer)
+} Scene;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates empty scene.
+ *
+ * @param numThreads Number of threads stepping flows, including the caller (0 for one per processor).
+ * @return Initialized scene.
+ */
+Scene *createScene(size_t numThreads);
+
+/**
+ * @brief Destroys scene, its models, and their meshes, and frees space.
+ *
+ * @param scene Scene to destroy.
+ */
+void destroyScene(Scene *scene);
+
+/**
+ * @brief Destroys scene's models and their meshes, keeping its thread pool and allocations for new models.
+ *
+ * @param scene Scene to clear.
+ */
+void clearScene(Scene *scene);
+
+/**
+ * @brief Adds model to the end of the scene's row of models (moving it there) and takes ownership of it.
+ *
+ * Model is uploaded over the next frames and drawn once all of it has arrived.
+ *
+ * @param scene Scene to add to.
+ * @param model Model to add.
+ * @param flow  Flow to compute on model.
+ * @return Entry of added model.
+ */
+SceneEntry *addModel(Scene *scene, Model *model, GEOMETRIC_FLOW flow);
+
+/**
+ * @brief Steps every running flow of the scene, spreading models across the thread pool.
+ *
+ * When fewer models flow than there are threads, models are stepped in turn with their curvature sweeps
+ * split across the pool instead. Either way, results don't depend on the number of threads.
+ *
+ * Flows stop by themselves once they reach their step limit.
+ *
+ * @param scene     Scene to step.
+ * @param deltaTime Time since last step.
+ * @return True if any flow ran.
+ */
+bool stepScene(Scene *scene, float deltaTime);
+
+/**
+ * @brief Uploads part of any newly added models, changed vertices, and changed model matrices.
+ *
+ * @param scene Scene to upload.
+ * @return True if anything was uploaded.
+ */
+bool uploadScene(Scene *scene);
+
+/**
+ * @brief Draws all resident models with one indirect multi-draw.
+ *
+ * @param scene Scene to draw (uploaded).
+ */
+void drawScene(const Scene *scene);
+
+/**
+ * @brief Draws self-intersecting faces of all models with one indirect multi-draw.
+ *
+ * @param scene Scene to draw (uploaded).
+ */
+void drawHighlights(Scene *scene);
+
+#endif
@@ -0,0 +1,190 @@
+#include "selection.h"
+#include "model.h"
+#include "arena.h"
+
+#include <cglm/cglm.h>
+
+#include <stdlib.h>
+
+#define VISITED 0x80 // temporary mask bit used while growing regions
+
+Selection *createSelection(Mesh *mesh)
+{
+    size_t numFaces = mesh->numIndices / 3;
+
+    Selection *selection = malloc(sizeof(Selection));
+    selection->mask = calloc(mesh->numVertices, sizeof(uint8_t));
+    selection->faceMask = calloc(numFaces, sizeof(uint8_t));
+    selection->active = malloc(mesh->numVertices * sizeof(uint32_t));
+    selection->halo = malloc(mesh->numVertices * sizeof(uint32_t));
+    selection->faces = malloc(numFaces * sizeof(uint32_t));
+    selection->numActive = selection->numHalo = selection->numFaces = 0;
+    selection->dirtyBegin = selection->dirtyEnd = 0;
+
+    return selection;
+}
+
+void destroySelection(Selection *selection)
+{
+    if (!selection)
+        return;
+
+    free(selection->mask);
+    free(selection->faceMask);
+    free(selection->active);
+    free(selection->halo);
+    free(selection->faces);
+    free(selection);
+}
+
+void clearSelection(Mesh *mesh)
+{
+    Selection *selection = mesh->selection;
+    if (!selection)
+        return;
+
+    // Only touch what was selected
+    for (size_t i = 0; i < selection->numActive; i++)
+        selection->mask[selection->active[i]] = UNSELECTED;
+    for (size_t i = 0; i < selection->numHalo; i++)
+        selection->mask[selection->halo[i]] = UNSELECTED;
+    for (size_t i = 0; i < selection->numFaces; i++)
+        selection->faceMask[selection->faces[i]] = 0;
+
+    selection->numActive = selection->numHalo = selection->numFaces = 0;
+    selection->dirtyBegin = selection->dirtyEnd = 0;
+}
+
+void selectVertex(Mesh *mesh, uint32_t vertex)
+{
+    if (!mesh->selection)
+        mesh->selection = createSelection(mesh);
+
+    Selection *selection = mesh->selection;
+    if ((selection->mask[vertex] & ~VISITED) == ACTIVE)
+        return;
+
+    selection->mask[vertex] = (selection->mask[vertex] & VISITED) | ACTIVE;
+    selection->active[selection->numActive++] = vertex;
+}
+
+// Sums a vertex's normal afresh from its faces' current normals, which become their last contributions (whole-mesh
+// sweeps don't store them), so updateFaceNormals swaps what the vertex's normal actually holds
+static void refreshNormal(Mesh *mesh, uint32_t v)
+{
+    glm_vec3_zero(mesh->vertices[v].normal);
+    for (uint32_t i = mesh->faceOffsets[v]; i < mesh->faceOffsets[v + 1]; i++)
+    {
+        uint32_t f = mesh->faces[i];
+        const uint32_t *face = &mesh->indices[3 * f];
+        vec3 e1, e2;
+        glm_vec3_sub(mesh->vertices[face[1]].position, mesh->vertices[face[0]].position, e1);
+        glm_vec3_sub(mesh->vertices[face[2]].position, mesh->vertices[face[0]].position, e2);
+        glm_vec3_cross(e1, e2, mesh->faceNormals[f]);
+        glm_vec3_add(mesh->vertices[v].normal, mesh->faceNormals[f], mesh->vertices[v].normal);
+    }
+}
+
+void selectRegion(Mesh *mesh, uint32_t seed, float radius)
+{
+    selectVertex(mesh, seed);
+    Selection *selection = mesh->selection;
+
+    // Breadth-first search over one-rings, bounded by distance from seed
+    Arena *scratch = meshArena(mesh);
+    ArenaFrame frame = pushFrame(scratch);
+    uint32_t *queue = arenaAlloc(scratch, mesh->numVertices * sizeof(uint32_t));
+    size_t head = 0, tail = 0;
+    queue[tail++] = seed;
+    selection->mask[seed] |= VISITED;
+
+    float radius2 = radius * radius;
+    while (head < tail)
+    {
+        uint32_t v = queue[head++];
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+        {
+            uint32_t n = mesh->ring[i];
+            if (selection->mask[n] & VISITED)
+                continue;
+            if (glm_vec3_distance2(mesh->vertices[n].position, mesh->vertices[seed].position) > radius2)
+                continue;
+
+            selection->mask[n] |= VISITED;
+            selectVertex(mesh, n);
+            queue[tail++] = n;
+        }
+    }
+
+    // Clear visited bits
+    for (size_t i = 0; i < tail; i++)
+        selection->mask[queue[i]] &= ~VISITED;
+    popFrame(scratch, frame);
+
+    updateSelection(mesh);
+
+    // Every face the selection's flows update touches only active and halo vertices
+    for (size_t i = 0; i < selection->numActive; i++)
+        refreshNormal(mesh, selection->active[i]);
+    for (size_t i = 0; i < selection->numHalo; i++)
+        refreshNormal(mesh, selection->halo[i]);
+}
+
+void updateSelection(Mesh *mesh)
+{
+    Selection *selection = mesh->selection;
+    if (!selection)
+        return;
+
+    // Reset previous halo (some of which may have been selected since) and faces
+    for (size_t i = 0; i < selection->numHalo; i++)
+        if (selection->mask[selection->halo[i]] == HALO)
+            selection->mask[selection->halo[i]] = UNSELECTED;
+    for (size_t i = 0; i < selection->numFaces; i++)
+        selection->faceMask[selection->faces[i]] = 0;
+    selection->numHalo = selection->numFaces = 0;
+
+    size_t begin = mesh->numVertices, end = 0;
+    for (size_t i = 0; i < selection->numActive; i++)
+    {
+        uint32_t v = selection->active[i];
+        if (v < begin)
+            begin = v;
+        if (v + 1 > end)
+            end = v + 1;
+
+        // Halo (one-ring of active vertices)
+        for (uint32_t j = mesh->ringOffsets[v]; j < mesh->ringOffsets[v + 1]; j++)
+        {
+            uint32_t n = mesh->ring[j];
+            if (selection->mask[n] != UNSELECTED)
+                continue;
+
+            selection->mask[n] = HALO;
+            selection->halo[selection->numHalo++] = n;
+            if (n < begin)
+                begin = n;
+            if (n + 1 > end)
+                end = n + 1;
+        }
+
+        // Faces touching active vertices
+        for (uint32_t j = mesh->faceOffsets[v]; j < mesh->faceOffsets[v + 1]; j++)
+        {
+            uint32_t f = mesh->faces[j];
+            if (selection->faceMask[f])
+                continue;
+
+            selection->faceMask[f] = 1;
+            selection->faces[selection->numFaces++] = f;
+        }
+    }
+
+    selection->dirtyBegin = selection->numActive ? begin : 0;
+    selection->dirtyEnd = selection->numActive ? end : 0;
+}
+
+bool hasSelection(const Mesh *mesh)
+{
+    return mesh->selection && mesh->selection->numActive > 0;
+}
@@ -0,0 +1,108 @@
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include "model.h"
+
+#include <cglm/cglm.h>
+
+#include <stdint.h>
+
+/*
+ * Enums
+ */
+
+/**
+ * @brief Per-vertex selection state.
+ */
+typedef enum
+{
+    UNSELECTED, // ignored by flow
+    HALO,       // one-ring of active region (read by flow, not moved)
+    ACTIVE      // moved by flow
+} SELECTION_STATE;
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Region of a mesh that flows are restricted to.
+ *
+ * The mask is the only per-vertex array; everything else is a compact list, so
+ * updating and flowing a selection costs time proportional to its size rather
+ * than the mesh's.
+ */
+struct Selection
+{
+    uint8_t *mask;               // SELECTION_STATE of each vertex
+    uint8_t *faceMask;           // whether each face is in the face list
+    uint32_t *active;            // active vertices
+    uint32_t *halo;              // halo vertices
+    uint32_t *faces;             // faces touching an active vertex
+    size_t numActive, numHalo;   // vertex list sizes
+    size_t numFaces;             // face list size
+    size_t dirtyBegin, dirtyEnd; // range of vertices covered by active and halo vertices
+};
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates an empty selection for mesh.
+ *
+ * @param mesh Mesh to select from.
+ * @return Initialized selection.
+ */
+Selection *createSelection(Mesh *mesh);
+
+/**
+ * @brief Destroys selection and frees space.
+ *
+ * @param selection Selection to destroy (may be NULL).
+ */
+void destroySelection(Selection *selection);
+
+/**
+ * @brief Deselects all vertices of mesh's selection.
+ *
+ * @param mesh Mesh to clear selection of.
+ */
+void clearSelection(Mesh *mesh);
+
+/**
+ * @brief Adds vertex to mesh's selection, creating the selection if needed.
+ *
+ * @param mesh   Mesh to select from.
+ * @param vertex Index of vertex to select.
+ */
+void selectVertex(Mesh *mesh, uint32_t vertex);
+
+/**
+ * @brief Selects connected vertices within radius of a seed vertex.
+ *
+ * Normals of the selection's active and halo vertices are summed afresh from their faces (whole-mesh sweeps don't
+ * store face normals), so the selection's flows can keep them current.
+ *
+ * @param mesh   Mesh to select from.
+ * @param seed   Index of vertex to grow region from.
+ * @param radius Maximum distance from seed vertex.
+ */
+void selectRegion(Mesh *mesh, uint32_t seed, float radius);
+
+/**
+ * @brief Rebuilds halo, face list, and dirty range from active vertices.
+ *
+ * @param mesh Mesh whose selection to update.
+ */
+void updateSelection(Mesh *mesh);
+
+/**
+ * @brief Checks whether flows on mesh are restricted to a selection.
+ *
+ * @param mesh Mesh to check.
+ * @return True if mesh has active vertices.
+ */
+bool hasSelection(const Mesh *mesh);
+
+#endif
@@ -100,4 +100,24 @@ GLuint createShaderProgram(const char *vertexFilePath, const char *fragmentFileP
     glDeleteShader(fragmentShader);
 
     return shaderProgram;
-}
\ No newline at end of file
+}
+
+GLuint createUniformBuffer(GLsizeiptr size, GLuint binding)
+{
+    GLuint buffer;
+    glCreateBuffers(1, &buffer);
+    glNamedBufferStorage(buffer, size, NULL, GL_DYNAMIC_STORAGE_BIT);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+
+    return buffer;
+}
+
+void updateMatrixBlock(GLuint buffer, mat4 v, mat4 p)
+{
+    MatrixBlock block;
+    glm_mat4_copy(v, block.view);
+    glm_mat4_copy(p, block.projection);
+    glm_mat4_mul(p, v, block.viewProjection);
+
+    glNamedBufferSubData(buffer, 0, sizeof(MatrixBlock), &block);
+}
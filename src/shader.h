@@ -3,6 +3,37 @@
 
 #include <glad/glad.h>
 
+#include <cglm/cglm.h>
+
+// Buffer block bindings (must match shaders)
+#define MATRIX_BINDING 0 // binding point of per-frame matrix block (uniform buffer)
+#define MODEL_BINDING 1  // binding point of per-model matrix array (shader storage buffer)
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Per-frame matrices, laid out as the shaders' std140 Matrices block (all members are whole mat4s,
+ * so no padding is needed).
+ */
+typedef struct
+{
+    mat4 view;           // world to camera
+    mat4 projection;     // camera to clip
+    mat4 viewProjection; // projection * view (precomputed once per frame)
+} MatrixBlock;
+
+/**
+ * @brief Per-model matrices, laid out as an element of the shaders' std430 Models array (indexed by the
+ * draw's base instance).
+ */
+typedef struct
+{
+    mat4 model;  // model to world
+    mat4 normal; // inverse transpose of model (upper 3x3 used)
+} ModelBlock;
+
 /*
  * Function Prototypes
  */
@@ -33,4 +64,22 @@ GLuint compileShader(const char *shaderSource, GLenum shaderType);
  */
 GLuint createShaderProgram(const char *vertexFilePath, const char *fragmentFilePath);
 
+/**
+ * @brief Creates uniform buffer and binds it to a uniform block binding point for good.
+ *
+ * @param size    Size of buffer in bytes.
+ * @param binding Binding point (as declared by the shaders' block).
+ * @return Uniform buffer, updatable with glNamedBufferSubData.
+ */
+GLuint createUniformBuffer(GLsizeiptr size, GLuint binding);
+
+/**
+ * @brief Fills matrix block (including derived matrices) and uploads it with a single buffer write.
+ *
+ * @param buffer Uniform buffer created for a MatrixBlock.
+ * @param v      View matrix.
+ * @param p      Projection matrix.
+ */
+void updateMatrixBlock(GLuint buffer, mat4 v, mat4 p);
+
 #endif
\ No newline at end of file
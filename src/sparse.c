@@ -0,0 +1,270 @@
+#include "sparse.h"
+#include "model.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+SparseMatrix *createMeshMatrix(const Mesh *mesh)
+{
+    size_t n = mesh->numVertices;
+
+    SparseMatrix *matrix = malloc(sizeof(SparseMatrix));
+    matrix->numRows = n;
+    matrix->numValues = n + mesh->ringOffsets[n];
+    matrix->rowOffsets = malloc((n + 1) * sizeof(uint32_t));
+    matrix->columns = malloc(matrix->numValues * sizeof(uint32_t));
+    matrix->values = calloc(matrix->numValues, sizeof(double));
+
+    // Each row is the vertex's sorted one-ring with the vertex itself merged in
+    size_t count = 0;
+    for (size_t v = 0; v < n; v++)
+    {
+        matrix->rowOffsets[v] = (uint32_t)count;
+        bool diagonal = false;
+        for (uint32_t i = mesh->ringOffsets[v]; i < mesh->ringOffsets[v + 1]; i++)
+        {
+            if (!diagonal && mesh->ring[i] > v)
+            {
+                matrix->columns[count++] = (uint32_t)v;
+                diagonal = true;
+            }
+            matrix->columns[count++] = mesh->ring[i];
+        }
+        if (!diagonal)
+            matrix->columns[count++] = (uint32_t)v;
+    }
+    matrix->rowOffsets[n] = (uint32_t)count;
+
+    return matrix;
+}
+
+void destroySparseMatrix(SparseMatrix *matrix)
+{
+    if (!matrix)
+        return;
+
+    free(matrix->rowOffsets);
+    free(matrix->columns);
+    free(matrix->values);
+    free(matrix);
+}
+
+void clearSparseMatrix(SparseMatrix *matrix)
+{
+    memset(matrix->values, 0, matrix->numValues * sizeof(double));
+}
+
+double *sparseEntry(SparseMatrix *matrix, uint32_t row, uint32_t column)
+{
+    // Binary search of row's sorted columns
+    uint32_t lo = matrix->rowOffsets[row], hi = matrix->rowOffsets[row + 1];
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (matrix->columns[mid] < column)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < matrix->rowOffsets[row + 1] && matrix->columns[lo] == column ? &matrix->values[lo] : NULL;
+}
+
+void addEdgeWeight(SparseMatrix *matrix, uint32_t i, uint32_t j, double weight)
+{
+    *sparseEntry(matrix, i, i) += weight;
+    *sparseEntry(matrix, j, j) += weight;
+    *sparseEntry(matrix, i, j) -= weight;
+    *sparseEntry(matrix, j, i) -= weight;
+}
+
+void multiplySparse(const SparseMatrix *matrix, const double *x, double *dest)
+{
+    for (size_t i = 0; i < matrix->numRows; i++)
+    {
+        double sum = 0.0;
+        for (uint32_t j = matrix->rowOffsets[i]; j < matrix->rowOffsets[i + 1]; j++)
+            sum += matrix->values[j] * x[matrix->columns[j]];
+        dest[i] = sum;
+    }
+}
+
+SparseMatrix *createLowerMatrix(const SparseMatrix *matrix)
+{
+    size_t n = matrix->numRows;
+
+    SparseMatrix *lower = malloc(sizeof(SparseMatrix));
+    lower->numRows = n;
+    lower->rowOffsets = malloc((n + 1) * sizeof(uint32_t));
+
+    // Rows are sorted, so the lower part of each is a prefix
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++)
+        for (uint32_t j = matrix->rowOffsets[i]; j < matrix->rowOffsets[i + 1] && matrix->columns[j] <= i; j++)
+            count++;
+    lower->numValues = count;
+    lower->columns = malloc((count ? count : 1) * sizeof(uint32_t));
+    lower->values = calloc(count ? count : 1, sizeof(double));
+
+    count = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        lower->rowOffsets[i] = (uint32_t)count;
+        for (uint32_t j = matrix->rowOffsets[i]; j < matrix->rowOffsets[i + 1] && matrix->columns[j] <= i; j++)
+            lower->columns[count++] = matrix->columns[j];
+    }
+    lower->rowOffsets[n] = (uint32_t)count;
+
+    return lower;
+}
+
+// Attempts incomplete Cholesky factorization with diagonal scaled by 1 + shift
+static bool tryIncompleteCholesky(const SparseMatrix *matrix, SparseMatrix *factor, double shift)
+{
+    for (size_t i = 0; i < factor->numRows; i++)
+    {
+        uint32_t begin = factor->rowOffsets[i], end = factor->rowOffsets[i + 1];
+        if (begin == end || factor->columns[end - 1] != i)
+            return false; // missing diagonal
+
+        // Copy lower part of row i of matrix (same columns as factor row)
+        for (uint32_t j = begin, a = matrix->rowOffsets[i]; j < end; j++, a++)
+            factor->values[j] = matrix->values[a];
+        factor->values[end - 1] *= 1.0 + shift;
+
+        for (uint32_t j = begin; j < end; j++)
+        {
+            uint32_t k = factor->columns[j];
+
+            // Dot product of rows i and k over columns below k (both sorted, so merge)
+            uint32_t p = begin, q = factor->rowOffsets[k], qEnd = factor->rowOffsets[k + 1] - 1;
+            double sum = 0.0;
+            while (p < j && q < qEnd)
+            {
+                if (factor->columns[p] < factor->columns[q])
+                    p++;
+                else if (factor->columns[p] > factor->columns[q])
+                    q++;
+                else
+                    sum += factor->values[p++] * factor->values[q++];
+            }
+
+            if (k < i)
+            {
+                factor->values[j] = (factor->values[j] - sum) / factor->values[qEnd];
+                continue;
+            }
+
+            double pivot = factor->values[j] - sum;
+            if (!(pivot > 0.0))
+                return false;
+            factor->values[j] = sqrt(pivot);
+        }
+    }
+    return true;
+}
+
+bool factorIncompleteCholesky(const SparseMatrix *matrix, SparseMatrix *factor)
+{
+    // Shift diagonal further until no pivot breaks down
+    for (double shift = 0.0; shift < 1.0; shift = shift ? 2.0 * shift : 1e-3)
+        if (tryIncompleteCholesky(matrix, factor, shift))
+            return true;
+    return false;
+}
+
+// Applies preconditioner z = (F F^T)^-1 r with lower triangular factor F, or z = D^-1 r without one
+static void precondition(const SparseMatrix *factor, const double *inverse, const double *r, double *z, size_t n)
+{
+    if (!factor)
+    {
+        for (size_t i = 0; i < n; i++)
+            z[i] = inverse[i] * r[i];
+        return;
+    }
+
+    // Forward substitution F y = r (y is stored in z)
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t end = factor->rowOffsets[i + 1] - 1;
+        double sum = r[i];
+        for (uint32_t j = factor->rowOffsets[i]; j < end; j++)
+            sum -= factor->values[j] * z[factor->columns[j]];
+        z[i] = sum / factor->values[end];
+    }
+
+    // Backward substitution F^T z = y, column by column
+    for (size_t i = n; i-- > 0;)
+    {
+        uint32_t end = factor->rowOffsets[i + 1] - 1;
+        z[i] /= factor->values[end];
+        for (uint32_t j = factor->rowOffsets[i]; j < end; j++)
+            z[factor->columns[j]] -= factor->values[j] * z[i];
+    }
+}
+
+static double dot(const double *a, const double *b, size_t n)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+size_t solveConjugateGradient(const SparseMatrix *matrix, const SparseMatrix *factor, const double *b, double *x, double tolerance, size_t maxIterations,
+                              Arena *scratch)
+{
+    size_t n = matrix->numRows;
+    ArenaFrame frame = pushFrame(scratch);
+    double *r = arenaAlloc(scratch, n * sizeof(double)); // residual
+    double *z = arenaAlloc(scratch, n * sizeof(double)); // preconditioned residual
+    double *p = arenaAlloc(scratch, n * sizeof(double)); // search direction
+    double *q = arenaAlloc(scratch, n * sizeof(double)); // matrix times search direction
+    double *inverse = NULL;                              // inverse of diagonal (without factor)
+
+    if (!factor)
+    {
+        inverse = arenaAlloc(scratch, n * sizeof(double));
+        for (size_t i = 0; i < n; i++)
+        {
+            const double *d = sparseEntry((SparseMatrix *)matrix, (uint32_t)i, (uint32_t)i);
+            inverse[i] = d && *d != 0.0 ? 1.0 / *d : 1.0;
+        }
+    }
+
+    // r = b - Ax, z = M^-1 r, p = z
+    multiplySparse(matrix, x, q);
+    for (size_t i = 0; i < n; i++)
+        r[i] = b[i] - q[i];
+    precondition(factor, inverse, r, z, n);
+    memcpy(p, z, n * sizeof(double));
+
+    double threshold = tolerance * tolerance * dot(b, b, n);
+    double rz = dot(r, z, n);
+    size_t iteration = 0;
+    while (iteration < maxIterations && dot(r, r, n) > threshold)
+    {
+        multiplySparse(matrix, p, q);
+        double pq = dot(p, q, n);
+        if (pq <= 0.0)
+            break; // not positive definite along p
+
+        double alpha = rz / pq;
+        for (size_t i = 0; i < n; i++)
+        {
+            x[i] += alpha * p[i];
+            r[i] -= alpha * q[i];
+        }
+        precondition(factor, inverse, r, z, n);
+
+        double next = dot(r, z, n);
+        double beta = next / rz;
+        rz = next;
+        for (size_t i = 0; i < n; i++)
+            p[i] = z[i] + beta * p[i];
+        iteration++;
+    }
+
+    popFrame(scratch, frame);
+    return iteration;
+}
@@ -0,0 +1,118 @@
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "model.h"
+#include "arena.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Square sparse matrix in compressed sparse row form (columns sorted within each row).
+ *
+ * Matrices over mesh vertices share the sparsity pattern of the mesh (each vertex and its one-ring),
+ * so the pattern is built once and only the values change between assemblies.
+ */
+typedef struct
+{
+    size_t numRows;       // number of rows (and columns)
+    uint32_t *rowOffsets; // start of each row in columns and values (numRows + 1 entries)
+    uint32_t *columns;    // column of each stored entry
+    double *values;       // value of each stored entry
+    size_t numValues;     // number of stored entries
+} SparseMatrix;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates matrix with one row per vertex of mesh and entries for each vertex and its one-ring.
+ *
+ * @param mesh Mesh whose adjacency gives the sparsity pattern.
+ * @return Initialized matrix (all stored values zero).
+ */
+SparseMatrix *createMeshMatrix(const Mesh *mesh);
+
+/**
+ * @brief Destroys matrix and frees space.
+ *
+ * @param matrix Matrix to destroy (may be NULL).
+ */
+void destroySparseMatrix(SparseMatrix *matrix);
+
+/**
+ * @brief Sets all stored values of matrix to zero, keeping its pattern.
+ *
+ * @param matrix Matrix to clear.
+ */
+void clearSparseMatrix(SparseMatrix *matrix);
+
+/**
+ * @brief Finds stored entry of matrix.
+ *
+ * @param matrix Matrix to search.
+ * @param row    Row of entry.
+ * @param column Column of entry.
+ * @return Pointer to value of entry, or NULL if entry is not in pattern.
+ */
+double *sparseEntry(SparseMatrix *matrix, uint32_t row, uint32_t column);
+
+/**
+ * @brief Adds weight of edge between two vertices to a Laplacian-like matrix (w on diagonals, -w off them).
+ *
+ * @param matrix Matrix to add to (pattern must contain all four entries).
+ * @param i      First vertex of edge.
+ * @param j      Second vertex of edge.
+ * @param weight Weight of edge.
+ */
+void addEdgeWeight(SparseMatrix *matrix, uint32_t i, uint32_t j, double weight);
+
+/**
+ * @brief Multiplies matrix with vector.
+ *
+ * @param matrix Matrix to multiply.
+ * @param x      Vector to multiply (numRows entries).
+ * @param dest   Destination of product (numRows entries, must not alias x).
+ */
+void multiplySparse(const SparseMatrix *matrix, const double *x, double *dest);
+
+/**
+ * @brief Creates matrix with the lower triangular part (including diagonal) of another's pattern.
+ *
+ * @param matrix Matrix whose pattern to copy (rows sorted, diagonal stored).
+ * @return Initialized matrix (all stored values zero).
+ */
+SparseMatrix *createLowerMatrix(const SparseMatrix *matrix);
+
+/**
+ * @brief Computes incomplete Cholesky factor (no fill-in) of symmetric positive definite matrix.
+ *
+ * If a pivot breaks down, the diagonal is scaled up slightly and factorization starts over.
+ *
+ * @param matrix System matrix.
+ * @param factor Destination of factor, created by createLowerMatrix from matrix.
+ * @return True if factorization succeeded.
+ */
+bool factorIncompleteCholesky(const SparseMatrix *matrix, SparseMatrix *factor);
+
+/**
+ * @brief Solves symmetric positive definite system with preconditioned conjugate gradients.
+ *
+ * @param matrix        System matrix.
+ * @param factor        Incomplete Cholesky factor of matrix, or NULL for Jacobi preconditioning.
+ * @param b             Right-hand side.
+ * @param x             Initial guess, overwritten with solution.
+ * @param tolerance     Residual norm to reach, relative to norm of b.
+ * @param maxIterations Maximum number of iterations.
+ * @param scratch       Arena the solver's vectors are allocated from (in a frame popped before returning).
+ * @return Number of iterations taken.
+ */
+size_t solveConjugateGradient(const SparseMatrix *matrix, const SparseMatrix *factor, const double *b, double *x, double tolerance, size_t maxIterations,
+                              Arena *scratch);
+
+#endif
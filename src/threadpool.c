@@ -0,0 +1,191 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // sysconf
+#endif
+
+#include "threadpool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <stdlib.h>
+
+// Takes the next task of a worker's own range
+static bool takeTask(Worker *worker, size_t *task)
+{
+    pthread_mutex_lock(&worker->lock);
+    bool found = worker->begin < worker->end;
+    if (found)
+        *task = worker->begin++;
+    pthread_mutex_unlock(&worker->lock);
+    return found;
+}
+
+// Moves the back half of another worker's range into an (empty) worker's range
+static bool stealTasks(ThreadPool *pool, Worker *thief)
+{
+    size_t numWorkers = pool->numThreads + 1;
+    size_t self = (size_t)(thief - pool->workers);
+    for (size_t i = 1; i < numWorkers; i++)
+    {
+        Worker *victim = &pool->workers[(self + i) % numWorkers];
+
+        pthread_mutex_lock(&victim->lock);
+        size_t begin = victim->begin, end = victim->end;
+        size_t middle = begin + (end - begin) / 2; // a single task left is taken whole
+        if (begin < end)
+            victim->end = middle;
+        pthread_mutex_unlock(&victim->lock);
+
+        if (begin < end)
+        {
+            pthread_mutex_lock(&thief->lock);
+            thief->begin = middle;
+            thief->end = end;
+            pthread_mutex_unlock(&thief->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs tasks until neither the worker nor anyone it could steal from has any left (only its own if ranges are kept)
+static void work(Worker *worker)
+{
+    ThreadPool *pool = worker->pool;
+    size_t task;
+    do
+    {
+        while (takeTask(worker, &task))
+            pool->function(pool->data, task);
+    } while (!pool->keepRanges && stealTasks(pool, worker));
+}
+
+static void *workerMain(void *argument)
+{
+    Worker *worker = argument;
+    ThreadPool *pool = worker->pool;
+
+    size_t batch = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        while (!pool->stopping && pool->batch == batch)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->stopping)
+            break;
+        batch = pool->batch;
+        pthread_mutex_unlock(&pool->lock);
+
+        work(worker);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+ThreadPool *createThreadPool(size_t numThreads)
+{
+    // Threads to spawn (the caller is one of the threads asked for)
+    numThreads = (numThreads ? numThreads : countProcessors()) - 1;
+
+    ThreadPool *pool = malloc(sizeof(ThreadPool));
+    pool->workers = malloc((numThreads + 1) * sizeof(Worker));
+    pool->numThreads = numThreads;
+    pool->function = NULL;
+    pool->data = NULL;
+    pool->batch = pool->busy = 0;
+    pool->keepRanges = false;
+    pool->stopping = false;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 0; i <= numThreads; i++)
+    {
+        Worker *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->begin = worker->end = 0;
+        pthread_mutex_init(&worker->lock, NULL);
+    }
+    for (size_t i = 0; i < numThreads; i++)
+        pthread_create(&pool->workers[i].thread, NULL, workerMain, &pool->workers[i]);
+
+    return pool;
+}
+
+void destroyThreadPool(ThreadPool *pool)
+{
+    if (!pool)
+        return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->numThreads; i++)
+        pthread_join(pool->workers[i].thread, NULL);
+    for (size_t i = 0; i <= pool->numThreads; i++)
+        pthread_mutex_destroy(&pool->workers[i].lock);
+
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+void runTasks(ThreadPool *pool, TaskFunction function, void *data, size_t count)
+{
+    // Not worth waking anyone for
+    if (pool->numThreads == 0 || count < 2)
+    {
+        for (size_t i = 0; i < count; i++)
+            function(data, i);
+        return;
+    }
+
+    // Deal out contiguous ranges (threads are still asleep, so no worker locks are needed)
+    size_t numWorkers = pool->numThreads + 1;
+    for (size_t i = 0; i < numWorkers; i++)
+    {
+        pool->workers[i].begin = count * i / numWorkers;
+        pool->workers[i].end = count * (i + 1) / numWorkers;
+    }
+
+    // Post batch and work along in the last slot
+    pthread_mutex_lock(&pool->lock);
+    pool->function = function;
+    pool->data = data;
+    pool->busy = pool->numThreads;
+    pool->batch++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    work(&pool->workers[pool->numThreads]);
+
+    // Wait for threads to finish the tasks they took
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+size_t countProcessors(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    long count = (long)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (size_t)count : 1;
+}
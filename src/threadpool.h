@@ -0,0 +1,89 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Function run for each task index of a batch.
+ */
+typedef void (*TaskFunction)(void *data, size_t index);
+
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * @brief Worker of thread pool, owning a range of the current batch's task indices.
+ *
+ * The owner takes tasks from the front of its range; idle workers steal the back half of another
+ * worker's range, so batches of uneven tasks (e.g. meshes of different sizes) still balance, unless the pool
+ * keeps ranges (then every task runs on the worker it was dealt to).
+ */
+typedef struct
+{
+    ThreadPool *pool;     // owning pool
+    pthread_t thread;     // thread running worker (unused for the calling thread's slot)
+    pthread_mutex_t lock; // guards range
+    size_t begin, end;    // task indices still owned
+} Worker;
+
+/**
+ * @brief Fixed set of threads that run batches of indexed tasks; the calling thread works along.
+ */
+struct ThreadPool
+{
+    Worker *workers;       // workers (last slot belongs to the thread calling runTasks)
+    size_t numThreads;     // spawned threads (number of workers minus one)
+    pthread_mutex_t lock;  // guards batch state below
+    pthread_cond_t start;  // signaled when a batch is posted (or pool stops)
+    pthread_cond_t done;   // signaled when last spawned thread leaves a batch
+    TaskFunction function; // task of current batch
+    void *data;            // data passed to task
+    size_t batch;          // number of batches posted so far
+    size_t busy;           // spawned threads still working on current batch
+    bool keepRanges;       // whether workers only run the ranges they are dealt (no stealing, e.g. for NUMA placement)
+    bool stopping;         // whether threads should exit
+};
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Creates thread pool.
+ *
+ * @param numThreads Number of threads to work with, including the caller (0 for one per processor).
+ * @return Initialized thread pool.
+ */
+ThreadPool *createThreadPool(size_t numThreads);
+
+/**
+ * @brief Stops threads, destroys thread pool, and frees space.
+ *
+ * @param pool Thread pool to destroy (may be NULL).
+ */
+void destroyThreadPool(ThreadPool *pool);
+
+/**
+ * @brief Runs function for every index in [0, count) across the pool and waits for all of them.
+ *
+ * @param pool     Thread pool to run on.
+ * @param function Task to run (must be safe to run concurrently for different indices).
+ * @param data     Data passed to every task.
+ * @param count    Number of tasks.
+ */
+void runTasks(ThreadPool *pool, TaskFunction function, void *data, size_t count);
+
+/**
+ * @brief Counts online processors.
+ *
+ * @return Number of processors (at least 1).
+ */
+size_t countProcessors(void);
+
+#endif
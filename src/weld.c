@@ -0,0 +1,327 @@
+#include "weld.h"
+#include "model.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Helpers
+ */
+
+// Lower-numbered vertices found within epsilon of vertices of one chunk
+typedef struct
+{
+    uint32_t (*pairs)[2];  // (lower vertex, vertex) pairs
+    size_t count, capacity; // number of pairs, allocated pairs
+} WeldPairs;
+
+// State shared by the chunks of one weld
+typedef struct
+{
+    Mesh *mesh;                  // mesh being welded
+    vec3 low;                    // low corner of bounding box
+    float cellSize;              // edge length of a cell
+    float distance;              // welding distance
+    float margin;                // distance from a cell's side within which its neighbor is searched
+    size_t numBuckets;           // buckets (power of two many)
+    int32_t (*cells)[3];         // cell of each vertex
+    uint32_t *buckets;           // bucket of each vertex
+    uint32_t *bucketOffsets;     // vertices in each bucket (CSR, ascending vertices)
+    uint32_t *bucketVertices;    // vertices of all buckets
+    WeldPairs *pairs;            // pairs found by each vertex chunk
+    uint32_t *remap;             // new index of each vertex
+    uint8_t *keep;               // whether each face survives
+} WeldTask;
+
+static size_t hashCell(int32_t x, int32_t y, int32_t z, size_t numBuckets)
+{
+    uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+    return h & (numBuckets - 1);
+}
+
+// Cell of a coordinate along one axis (coordinates that are not finite or far out of range land in cell 0)
+static int32_t cellCoordinate(float coordinate, float low, float cellSize)
+{
+    float t = (coordinate - low) / cellSize;
+    return t >= 0.0f && t < 2.0e9f ? (int32_t)t : 0;
+}
+
+static size_t countChunks(size_t count)
+{
+    return (count + WELD_CHUNK - 1) / WELD_CHUNK;
+}
+
+static void runChunks(ThreadPool *pool, TaskFunction function, WeldTask *task, size_t count)
+{
+    if (pool)
+    {
+        runTasks(pool, function, task, countChunks(count));
+        return;
+    }
+    for (size_t i = 0; i < countChunks(count); i++)
+        function(task, i);
+}
+
+// Finds cell and bucket of every vertex of one chunk
+static void binChunk(void *data, size_t index)
+{
+    WeldTask *task = data;
+    size_t begin = index * WELD_CHUNK, end = begin + WELD_CHUNK;
+    end = end < task->mesh->numVertices ? end : task->mesh->numVertices;
+    for (size_t v = begin; v < end; v++)
+    {
+        const float *position = task->mesh->vertices[v].position;
+        for (int a = 0; a < 3; a++)
+            task->cells[v][a] = cellCoordinate(position[a], task->low[a], task->cellSize);
+        task->buckets[v] = (uint32_t)hashCell(task->cells[v][0], task->cells[v][1], task->cells[v][2], task->numBuckets);
+    }
+}
+
+static void addPair(WeldPairs *pairs, uint32_t lower, uint32_t vertex)
+{
+    if (pairs->count == pairs->capacity)
+    {
+        pairs->capacity = pairs->capacity ? 2 * pairs->capacity : 64;
+        pairs->pairs = realloc(pairs->pairs, pairs->capacity * sizeof(*pairs->pairs));
+    }
+    pairs->pairs[pairs->count][0] = lower;
+    pairs->pairs[pairs->count][1] = vertex;
+    pairs->count++;
+}
+
+// Pairs every vertex of one chunk with each lower-numbered vertex within welding distance
+static void searchChunk(void *data, size_t index)
+{
+    WeldTask *task = data;
+    const Vertex *vertices = task->mesh->vertices;
+    float distance2 = task->distance * task->distance;
+    size_t begin = index * WELD_CHUNK, end = begin + WELD_CHUNK;
+    end = end < task->mesh->numVertices ? end : task->mesh->numVertices;
+    for (size_t v = begin > 0 ? begin : 1; v < end; v++)
+    {
+        // Neighboring cells are only searched on sides the vertex is close to
+        const int32_t *cell = task->cells[v];
+        int32_t range[3][2];
+        for (int a = 0; a < 3; a++)
+        {
+            float offset = vertices[v].position[a] - task->low[a] - (float)cell[a] * task->cellSize;
+            range[a][0] = offset < task->margin ? cell[a] - 1 : cell[a];
+            range[a][1] = task->cellSize - offset < task->margin ? cell[a] + 1 : cell[a];
+        }
+
+        for (int32_t x = range[0][0]; x <= range[0][1]; x++)
+            for (int32_t y = range[1][0]; y <= range[1][1]; y++)
+                for (int32_t z = range[2][0]; z <= range[2][1]; z++)
+                {
+                    size_t bucket = hashCell(x, y, z, task->numBuckets);
+                    for (uint32_t i = task->bucketOffsets[bucket]; i < task->bucketOffsets[bucket + 1]; i++)
+                    {
+                        uint32_t u = task->bucketVertices[i];
+                        if (u >= v)
+                            break; // buckets are sorted
+                        const int32_t *other = task->cells[u];
+                        if (u == 0 || other[0] != x || other[1] != y || other[2] != z)
+                            continue; // dummy vertex, or another cell hashing to the same bucket
+                        if (glm_vec3_distance2((float *)vertices[u].position, (float *)vertices[v].position) <= distance2)
+                            addPair(&task->pairs[index], u, (uint32_t)v);
+                    }
+                }
+    }
+}
+
+// Remaps corners of every face of one chunk and drops faces left with a repeated corner
+static void remapChunk(void *data, size_t index)
+{
+    WeldTask *task = data;
+    uint32_t *indices = task->mesh->indices;
+    size_t numFaces = task->mesh->numIndices / 3;
+    size_t begin = index * WELD_CHUNK, end = begin + WELD_CHUNK;
+    end = end < numFaces ? end : numFaces;
+    for (size_t f = begin; f < end; f++)
+    {
+        uint32_t *face = &indices[3 * f];
+        for (int k = 0; k < 3; k++)
+            face[k] = task->remap[face[k]];
+        task->keep[f] = face[0] != face[1] && face[1] != face[2] && face[2] != face[0];
+    }
+}
+
+// Root of a vertex's group, halving the path along the way
+static uint32_t findRoot(uint32_t *parents, uint32_t v)
+{
+    while (parents[v] != v)
+    {
+        parents[v] = parents[parents[v]];
+        v = parents[v];
+    }
+    return v;
+}
+
+// Sorts corners of a face in ascending order
+static void sortCorners(const uint32_t *face, uint32_t *sorted)
+{
+    uint32_t low = face[0] < face[1] ? face[0] : face[1], high = face[0] < face[1] ? face[1] : face[0];
+    sorted[0] = face[2] < low ? face[2] : low;
+    sorted[1] = face[2] < low ? low : (face[2] < high ? face[2] : high);
+    sorted[2] = face[2] < high ? high : face[2];
+}
+
+/*
+ * Welding
+ */
+
+WeldReport weldMesh(Mesh *mesh, float epsilon, ThreadPool *pool)
+{
+    WeldReport report = {0, 0, 0};
+    size_t numVertices = mesh->numVertices, numFaces = mesh->numIndices / 3;
+    if (numVertices < 2)
+        return report;
+
+    // Cells far larger than the welding distance (vertex 0 is fast_obj's dummy and stays out of the bounds)
+    WeldTask task = {.mesh = mesh};
+    vec3 high;
+    glm_vec3_copy(mesh->vertices[1].position, task.low);
+    glm_vec3_copy(mesh->vertices[1].position, high);
+    for (size_t v = 2; v < numVertices; v++)
+    {
+        glm_vec3_minv(task.low, mesh->vertices[v].position, task.low);
+        glm_vec3_maxv(high, mesh->vertices[v].position, high);
+    }
+    float diagonal = glm_vec3_distance(task.low, high);
+    task.distance = epsilon * diagonal;
+    task.cellSize = WELD_CELL_SCALE * (task.distance > 0.0f ? task.distance : WELD_EPSILON * diagonal);
+    task.cellSize = task.cellSize > 0.0f ? task.cellSize : 1.0f;
+    task.margin = task.distance > 0.0f ? task.distance + task.cellSize * 1e-3f : 0.0f; // rounding of cells
+
+    // Bin vertices, then lay buckets out in one array (vertices ascending within each bucket)
+    task.numBuckets = 1;
+    while (task.numBuckets < numVertices)
+        task.numBuckets <<= 1;
+    task.cells = malloc(numVertices * sizeof(*task.cells));
+    task.buckets = malloc(numVertices * sizeof(uint32_t));
+    runChunks(pool, binChunk, &task, numVertices);
+
+    task.bucketOffsets = calloc(task.numBuckets + 1, sizeof(uint32_t));
+    for (size_t v = 0; v < numVertices; v++)
+        task.bucketOffsets[task.buckets[v] + 1]++;
+    for (size_t b = 0; b < task.numBuckets; b++)
+        task.bucketOffsets[b + 1] += task.bucketOffsets[b];
+    task.bucketVertices = malloc(numVertices * sizeof(uint32_t));
+    uint32_t *fill = malloc(task.numBuckets * sizeof(uint32_t));
+    memcpy(fill, task.bucketOffsets, task.numBuckets * sizeof(uint32_t));
+    for (size_t v = 0; v < numVertices; v++)
+        task.bucketVertices[fill[task.buckets[v]]++] = (uint32_t)v;
+    free(fill);
+
+    // Find close pairs, then join them into groups rooted at their lowest vertex (chunks in order, so the
+    // groups never depend on how chunks were split across threads)
+    task.pairs = calloc(countChunks(numVertices), sizeof(WeldPairs));
+    runChunks(pool, searchChunk, &task, numVertices);
+
+    uint32_t *parents = malloc(numVertices * sizeof(uint32_t));
+    for (size_t v = 0; v < numVertices; v++)
+        parents[v] = (uint32_t)v;
+    for (size_t c = 0; c < countChunks(numVertices); c++)
+    {
+        for (size_t i = 0; i < task.pairs[c].count; i++)
+        {
+            uint32_t a = findRoot(parents, task.pairs[c].pairs[i][0]), b = findRoot(parents, task.pairs[c].pairs[i][1]);
+            if (a != b)
+                parents[a > b ? a : b] = a < b ? a : b;
+        }
+        free(task.pairs[c].pairs);
+    }
+    free(task.pairs);
+    free(task.cells);
+    free(task.buckets);
+    free(task.bucketOffsets);
+    free(task.bucketVertices);
+
+    // Number surviving vertices in order (parents never come after their children, so one ascending pass
+    // resolves every root, and roots are numbered before the rest of their group)
+    for (size_t v = 0; v < numVertices; v++)
+        parents[v] = parents[parents[v]];
+    task.remap = parents;
+    size_t count = 0;
+    for (size_t v = 0; v < numVertices; v++)
+    {
+        uint32_t root = parents[v];
+        if (root == v)
+        {
+            mesh->vertices[count] = mesh->vertices[v];
+            task.remap[v] = (uint32_t)count++;
+        }
+        else
+            task.remap[v] = task.remap[root];
+    }
+    report.mergedVertices = numVertices - count;
+
+    // Remap faces, dropping degenerate faces, then duplicates of earlier faces
+    task.keep = malloc((numFaces ? numFaces : 1) * sizeof(uint8_t));
+    runChunks(pool, remapChunk, &task, numFaces);
+
+    // Duplicates share their lowest corner, so only faces listed under the same lowest corner are compared
+    uint32_t *faceOffsets = calloc(count + 1, sizeof(uint32_t));
+    for (size_t f = 0; f < numFaces; f++)
+    {
+        uint32_t sorted[3];
+        sortCorners(&mesh->indices[3 * f], sorted);
+        if (task.keep[f])
+            faceOffsets[sorted[0] + 1]++;
+        else
+            report.degenerateFaces++;
+    }
+    for (size_t v = 0; v < count; v++)
+        faceOffsets[v + 1] += faceOffsets[v];
+    uint32_t *faces = malloc((numFaces ? numFaces : 1) * sizeof(uint32_t));
+    fill = malloc(count * sizeof(uint32_t));
+    memcpy(fill, faceOffsets, count * sizeof(uint32_t));
+    for (size_t f = 0; f < numFaces; f++)
+    {
+        uint32_t sorted[3];
+        sortCorners(&mesh->indices[3 * f], sorted);
+        if (task.keep[f])
+            faces[fill[sorted[0]]++] = (uint32_t)f;
+    }
+    free(fill);
+
+    for (size_t v = 0; v < count; v++)
+    {
+        for (uint32_t i = faceOffsets[v]; i < faceOffsets[v + 1]; i++)
+        {
+            uint32_t sorted[3];
+            sortCorners(&mesh->indices[3 * faces[i]], sorted);
+            for (uint32_t j = faceOffsets[v]; j < i; j++)
+            {
+                uint32_t other[3];
+                sortCorners(&mesh->indices[3 * faces[j]], other);
+                if (task.keep[faces[j]] && sorted[1] == other[1] && sorted[2] == other[2])
+                {
+                    task.keep[faces[i]] = 0; // faces are listed in order, so the earlier one stays
+                    report.duplicateFaces++;
+                    break;
+                }
+            }
+        }
+    }
+    free(faceOffsets);
+    free(faces);
+
+    size_t numKept = 0;
+    for (size_t f = 0; f < numFaces; f++)
+        if (task.keep[f])
+            memmove(&mesh->indices[3 * numKept++], &mesh->indices[3 * f], 3 * sizeof(uint32_t));
+    free(task.keep);
+    free(task.remap);
+
+    // Shrink arrays to what survived
+    if (count < numVertices)
+        mesh->vertices = realloc(mesh->vertices, count * sizeof(Vertex));
+    if (numKept < numFaces)
+        mesh->indices = realloc(mesh->indices, (numKept ? 3 * numKept : 1) * sizeof(uint32_t));
+    mesh->numVertices = count;
+    mesh->numIndices = 3 * numKept;
+
+    return report;
+}
@@ -0,0 +1,53 @@
+#ifndef WELD_H
+#define WELD_H
+
+#include "model.h"
+#include "threadpool.h"
+
+#include <stddef.h>
+
+// Welding settings
+#define WELD_EPSILON 1e-6f    // distance within which vertices are welded, relative to bounding box diagonal
+#define WELD_CELL_SCALE 64.0f // cell size relative to welding distance (vertices near a cell's side search its neighbor)
+#define WELD_CHUNK 16384      // vertices (or faces) per welding task
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief What welding a mesh changed.
+ */
+typedef struct
+{
+    size_t mergedVertices;  // vertices welded into another vertex (and removed)
+    size_t degenerateFaces; // faces dropped because two of their corners are the same vertex
+    size_t duplicateFaces;  // faces dropped because an earlier face has the same corners
+} WeldReport;
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Welds vertices of mesh that lie within epsilon of each other, remapping indices and dropping faces.
+ *
+ * Vertices are binned in a spatial hash with cells much larger than epsilon, and every vertex is joined
+ * (union-find) with each lower-numbered vertex within epsilon, in its own cell and in those neighboring cells
+ * whose sides it lies within epsilon of. Each welded group keeps the position of its lowest-numbered vertex,
+ * and surviving vertices and faces keep their order, so a mesh without duplicates comes out unchanged. Faces
+ * left with a repeated corner, and faces with the same corners as an earlier face (in either orientation),
+ * are dropped. Binning, searching, and remapping run in chunks of fixed size on the pool (if any), and the
+ * result does not depend on the number of threads.
+ *
+ * Only positions and indices are touched, so adjacency and curvature must be built afterwards. The dummy
+ * vertex 0 is never welded.
+ *
+ * @param mesh    Mesh to weld.
+ * @param epsilon Welding distance relative to the bounding box diagonal (0 welds identical positions only).
+ * @param pool    Thread pool to run chunks on (NULL runs them on the calling thread).
+ * @return What was merged and dropped.
+ */
+WeldReport weldMesh(Mesh *mesh, float epsilon, ThreadPool *pool);
+
+#endif
@@ -0,0 +1,220 @@
+#include "willmore.h"
+#include "sparse.h"
+#include "model.h"
+
+#include <cglm/cglm.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Helpers
+ */
+
+// Creates pattern of L M^-1 L (each vertex's two-ring, sorted) from pattern of L
+static SparseMatrix *createSquaredPattern(const SparseMatrix *laplacian)
+{
+    size_t n = laplacian->numRows;
+    SparseMatrix *matrix = malloc(sizeof(SparseMatrix));
+    matrix->numRows = n;
+    matrix->rowOffsets = malloc((n + 1) * sizeof(uint32_t));
+
+    // Rows are gathered with a marker per column, then sorted
+    uint32_t *marker = malloc(n * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++)
+        marker[i] = UINT32_MAX;
+    size_t capacity = 4 * laplacian->numValues + n, count = 0;
+    uint32_t *columns = malloc(capacity * sizeof(uint32_t));
+    for (size_t i = 0; i < n; i++)
+    {
+        matrix->rowOffsets[i] = (uint32_t)count;
+        for (uint32_t a = laplacian->rowOffsets[i]; a < laplacian->rowOffsets[i + 1]; a++)
+        {
+            uint32_t k = laplacian->columns[a];
+            for (uint32_t b = laplacian->rowOffsets[k]; b < laplacian->rowOffsets[k + 1]; b++)
+            {
+                uint32_t j = laplacian->columns[b];
+                if (marker[j] == i)
+                    continue;
+                marker[j] = (uint32_t)i;
+                if (count == capacity)
+                    columns = realloc(columns, (capacity *= 2) * sizeof(uint32_t));
+                columns[count++] = j;
+            }
+        }
+
+        // Insertion sort (rows are short)
+        for (size_t a = matrix->rowOffsets[i] + 1; a < count; a++)
+        {
+            uint32_t column = columns[a];
+            size_t b = a;
+            for (; b > matrix->rowOffsets[i] && columns[b - 1] > column; b--)
+                columns[b] = columns[b - 1];
+            columns[b] = column;
+        }
+    }
+    matrix->rowOffsets[n] = (uint32_t)count;
+    free(marker);
+
+    matrix->numValues = count;
+    matrix->columns = realloc(columns, (count ? count : 1) * sizeof(uint32_t));
+    matrix->values = calloc(count ? count : 1, sizeof(double));
+    return matrix;
+}
+
+/*
+ * Willmore Flow
+ */
+
+Willmore *createWillmore(Mesh *mesh)
+{
+    size_t n = mesh->numVertices;
+    Willmore *willmore = malloc(sizeof(Willmore));
+
+    willmore->laplacian = createMeshMatrix(mesh);
+    willmore->mass = malloc(n * sizeof(double));
+    willmore->system = createSquaredPattern(willmore->laplacian);
+    willmore->factor = createLowerMatrix(willmore->system);
+    willmore->rhs = malloc(n * sizeof(double));
+    willmore->solution = malloc(n * sizeof(double));
+    willmore->steps = willmore->solverIterations = willmore->unconverged = 0;
+
+    refreshWillmore(willmore, mesh);
+    return willmore;
+}
+
+void destroyWillmore(Willmore *willmore)
+{
+    if (!willmore)
+        return;
+
+    destroySparseMatrix(willmore->laplacian);
+    destroySparseMatrix(willmore->system);
+    destroySparseMatrix(willmore->factor);
+    free(willmore->mass);
+    free(willmore->rhs);
+    free(willmore->solution);
+    free(willmore);
+}
+
+void refreshWillmore(Willmore *willmore, Mesh *mesh)
+{
+    size_t n = mesh->numVertices;
+    SparseMatrix *laplacian = willmore->laplacian, *system = willmore->system;
+
+    // Cotangent weights and barycentric masses
+    clearSparseMatrix(laplacian);
+    memset(willmore->mass, 0, n * sizeof(double));
+    for (size_t f = 0; f < mesh->numIndices / 3; f++)
+    {
+        const uint32_t *face = &mesh->indices[3 * f];
+        vec3 edges[3], cross;
+        for (int k = 0; k < 3; k++)
+            glm_vec3_sub(mesh->vertices[face[(k + 1) % 3]].position, mesh->vertices[face[k]].position, edges[k]);
+        glm_vec3_cross(edges[0], edges[1], cross);
+        double doubleArea = glm_vec3_norm(cross);
+        if (doubleArea <= 0.0)
+            continue;
+
+        // Corner opposite edge k is between edges k + 1 and k + 2 (clamped so needles don't dominate the system)
+        for (int k = 0; k < 3; k++)
+        {
+            double cotangent = -glm_vec3_dot(edges[(k + 1) % 3], edges[(k + 2) % 3]) / doubleArea;
+            cotangent = fmin(fmax(cotangent, 0.0), WILLMORE_MAX_COTANGENT);
+            addEdgeWeight(laplacian, face[k], face[(k + 1) % 3], 0.5 * cotangent);
+            willmore->mass[face[k]] += doubleArea / 6.0;
+        }
+    }
+
+    // Step relative to current resolution (the flow is fourth order), and masses floored relative to the mean
+    double totalMass = 0.0;
+    size_t massive = 0;
+    for (size_t i = 0; i < n; i++)
+        if (willmore->mass[i] > 0.0)
+        {
+            totalMass += willmore->mass[i];
+            massive++;
+        }
+    double meanMass = massive ? totalMass / massive : 1.0;
+    willmore->timeStep = WILLMORE_STEP * meanMass * meanMass;
+    for (size_t i = 0; i < n; i++)
+        if (willmore->mass[i] <= 0.0)
+            willmore->mass[i] = 1.0; // isolated vertex (its Laplacian row is empty)
+        else if (willmore->mass[i] < WILLMORE_MIN_MASS * meanMass)
+            willmore->mass[i] = WILLMORE_MIN_MASS * meanMass;
+
+    // M + dt L M^-1 L, one row at a time through a dense scatter of the row's columns
+    Arena *scratch = meshArena(mesh);
+    ArenaFrame frame = pushFrame(scratch);
+    double *row = arenaCalloc(scratch, n, sizeof(double));
+    for (size_t i = 0; i < n; i++)
+    {
+        for (uint32_t a = laplacian->rowOffsets[i]; a < laplacian->rowOffsets[i + 1]; a++)
+        {
+            uint32_t k = laplacian->columns[a];
+            double scale = willmore->timeStep * laplacian->values[a] / willmore->mass[k];
+            for (uint32_t b = laplacian->rowOffsets[k]; b < laplacian->rowOffsets[k + 1]; b++)
+                row[laplacian->columns[b]] += scale * laplacian->values[b];
+        }
+        row[i] += willmore->mass[i];
+
+        for (uint32_t a = system->rowOffsets[i]; a < system->rowOffsets[i + 1]; a++)
+        {
+            system->values[a] = row[system->columns[a]];
+            row[system->columns[a]] = 0.0;
+        }
+    }
+    popFrame(scratch, frame);
+
+    willmore->factored = factorIncompleteCholesky(system, willmore->factor);
+}
+
+// Solves each coordinate's system from current positions into positions (3 per vertex), returning whether all converged
+static bool solvePositions(Willmore *willmore, Mesh *mesh, double *positions)
+{
+    bool converged = true;
+    for (int c = 0; c < 3; c++)
+    {
+        for (size_t i = 0; i < mesh->numVertices; i++)
+        {
+            willmore->solution[i] = mesh->vertices[i].position[c];
+            willmore->rhs[i] = willmore->mass[i] * willmore->solution[i];
+        }
+        size_t iterations = solveConjugateGradient(willmore->system, willmore->factored ? willmore->factor : NULL,
+                                                   willmore->rhs, willmore->solution, WILLMORE_CG_TOLERANCE,
+                                                   WILLMORE_CG_ITERATIONS, meshArena(mesh));
+        willmore->solverIterations += iterations;
+        converged = converged && iterations < WILLMORE_CG_ITERATIONS;
+        for (size_t i = 0; i < mesh->numVertices; i++)
+            positions[3 * i + c] = willmore->solution[i];
+    }
+    return converged;
+}
+
+void stepWillmore(Willmore *willmore, Mesh *mesh)
+{
+    bool refreshed = willmore->steps && willmore->steps % WILLMORE_REFRESH == 0;
+    if (refreshed)
+        refreshWillmore(willmore, mesh);
+
+    // An operator that has fallen too far behind the mesh is refreshed early, and the step solved again
+    Arena *scratch = meshArena(mesh);
+    ArenaFrame frame = pushFrame(scratch);
+    double *positions = arenaAlloc(scratch, 3 * mesh->numVertices * sizeof(double));
+    willmore->solverIterations = 0;
+    bool converged = solvePositions(willmore, mesh, positions);
+    if (!converged && !refreshed)
+    {
+        refreshWillmore(willmore, mesh);
+        converged = solvePositions(willmore, mesh, positions);
+    }
+    willmore->unconverged += !converged;
+
+    for (size_t i = 0; i < mesh->numVertices; i++)
+        for (int c = 0; c < 3; c++)
+            mesh->vertices[i].position[c] = (float)positions[3 * i + c];
+    popFrame(scratch, frame);
+
+    willmore->steps++;
+}
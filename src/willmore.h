@@ -0,0 +1,91 @@
+#ifndef WILLMORE_H
+#define WILLMORE_H
+
+#include "model.h"
+#include "sparse.h"
+
+#include <stdint.h>
+
+// Solver settings
+#define WILLMORE_STEP 0.1           // time step in units of squared mean vertex area (about mean edge length to the fourth power)
+#define WILLMORE_REFRESH 50         // steps between reassembling operator from current positions
+#define WILLMORE_CG_TOLERANCE 1e-8  // relative residual of each step's systems
+#define WILLMORE_CG_ITERATIONS 500  // iteration limit of each step's systems
+#define WILLMORE_MAX_COTANGENT 2.0  // largest cotangent weight of a corner (corners under about 27 degrees count as 27)
+#define WILLMORE_MIN_MASS 0.2       // smallest lumped mass of a vertex, relative to the mean
+
+/*
+ * Structs
+ */
+
+/**
+ * @brief Semi-implicit Willmore (bi-Laplacian) flow state.
+ *
+ * Each step solves (M + dt L M^-1 L) x' = M x for all three coordinates, where L is the cotangent
+ * Laplacian and M the lumped (barycentric) mass matrix. The system matrix and its incomplete Cholesky
+ * factor are kept across steps and only refreshed from the deformed mesh every WILLMORE_REFRESH steps;
+ * the sparsity patterns (one-ring for L, two-ring for the system) are built once.
+ *
+ * Thin parts of a mesh (such as the struts of a lattice) shrink under the flow into needle-shaped
+ * triangles, whose huge cotangents and tiny masses would make each refreshed system much harder to
+ * solve than the last. Cotangents are therefore clamped to [0, WILLMORE_MAX_COTANGENT], masses
+ * floored at WILLMORE_MIN_MASS times the mean, and dt scaled with the squared mean vertex area at
+ * every refresh, so the systems stay about as well conditioned as the first.
+ */
+struct Willmore
+{
+    SparseMatrix *laplacian; // cotangent Laplacian (positive semidefinite)
+    double *mass;            // lumped mass of each vertex (1 for isolated vertices)
+    SparseMatrix *system;    // M + dt L M^-1 L
+    SparseMatrix *factor;    // incomplete Cholesky factor of system
+    bool factored;           // whether factor is valid (steps fall back to Jacobi preconditioning if not)
+    double timeStep;         // dt (set from mean vertex area at every refresh)
+    double *rhs, *solution;  // right-hand side and solution of one coordinate
+    size_t steps;            // steps taken
+    size_t solverIterations; // conjugate gradient iterations of last step (all coordinates and attempts)
+    size_t unconverged;      // steps since creation whose systems hit WILLMORE_CG_ITERATIONS even after a refresh
+};
+
+/*
+ * Function Prototypes
+ */
+
+/**
+ * @brief Sets up Willmore flow on mesh, assembling and factoring its operator at current positions.
+ *
+ * @param mesh Mesh to flow.
+ * @return Initialized flow state.
+ */
+Willmore *createWillmore(Mesh *mesh);
+
+/**
+ * @brief Destroys Willmore flow state and frees space.
+ *
+ * @param willmore State to destroy (may be NULL).
+ */
+void destroyWillmore(Willmore *willmore);
+
+/**
+ * @brief Reassembles cotangent weights, masses, time step, system, and factor from current positions.
+ *
+ * If the factorization breaks down even with its diagonal shifted, steps are preconditioned with the
+ * system's diagonal instead until the next refresh.
+ *
+ * @param willmore State to refresh.
+ * @param mesh     Mesh state was created for.
+ */
+void refreshWillmore(Willmore *willmore, Mesh *mesh);
+
+/**
+ * @brief Takes one implicit step, moving vertex positions (normals and curvatures are not updated).
+ *
+ * If a system hits WILLMORE_CG_ITERATIONS, the operator no longer fits the mesh: it is refreshed and the
+ * step solved again. Should that fail too, the step still moves to the last iterate and is counted in
+ * unconverged.
+ *
+ * @param willmore State to advance (refreshed first every WILLMORE_REFRESH steps).
+ * @param mesh     Mesh to move.
+ */
+void stepWillmore(Willmore *willmore, Mesh *mesh);
+
+#endif